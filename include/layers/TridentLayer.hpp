@@ -29,27 +29,50 @@
 #include <kognac/stringscol.h>
 #include <dblayer.hpp>
 
+#include <mutex>
+
 #define COUNTHINT_MAX 1
 #define SMALLREL 20
 #define LIMIT_SAMPLE 100
 
+class TridentLayer;
+
 class TridentScan : public DBLayer::Scan {
     private:
         const DBLayer::Aggr_t a;
         const int perm;
         PairItr *itr;
+        //Every scan reads with its own querier, borrowed from the layer,
+        //so that scans can run on different threads
+        TridentLayer &layer;
         Querier *q;
         DBLayer::Hint *hint;
         size_t countHint;
 
+        //Scans that return all three fields are read in batches
+        bool batched;
+        std::unique_ptr<int64_t[]> batch;
+        int64_t *batchKeys, *batchValues1, *batchValues2;
+        size_t batchSize, batchPos;
+
+        //If > 0, first() skips the rows where the first unconstrained
+        //column is smaller than this value
+        uint64_t rangeStart;
+        //Whether the unconstrained iterator can jump to a key (-1 = not
+        //checked yet)
+        int canSeekKey;
+
+        bool readFirst(const int nconstrained);
+
+        bool readFirstInRange(const int nconstrained);
+
+        bool fillBatch();
+
+        void applyHintOnBatch();
+
     public:
         TridentScan(const int perm, const DBLayer::Aggr_t a,
-                Querier *q, DBLayer::Hint *hint) : a(a), perm(perm),
-        itr(NULL),
-        q(q),
-        hint(hint),
-        countHint(0) {
-        }
+                TridentLayer &layer, DBLayer::Hint *hint);
 
         uint64_t getValue1();
 
@@ -69,6 +92,8 @@ class TridentScan : public DBLayer::Scan {
 
         bool first(uint64_t, bool, uint64_t, bool, uint64_t, bool);
 
+        bool setRangeStart(uint64_t start, bool constrained);
+
         ~TridentScan();
 };
 
@@ -78,6 +103,10 @@ class TridentLayer : public DBLayer {
         DictMgmt *dict;
         std::unique_ptr<Querier> q;
         bool bifSampl;
+
+        //Queriers lent to the scans
+        std::mutex queriersLock;
+        std::vector<std::unique_ptr<Querier>> freeQueriers;
         const int nindices;
 
         //Used to translate IDs back to strings
@@ -194,6 +223,11 @@ class TridentLayer : public DBLayer {
                 ::Type::ID& type,
                 unsigned& subType);
 
+		DDLEXPORT void lookupByIds(const std::vector<uint64_t>& ids,
+                std::string& texts,
+                std::vector<std::pair<size_t, size_t>>& positions,
+                std::vector<::Type::ID>& types);
+
         DDLEXPORT uint64_t getNextId();
 
         DDLEXPORT double getScanCost(DBLayer::DataOrder order,
@@ -245,6 +279,12 @@ class TridentLayer : public DBLayer {
             return q.get();
         }
 
+        //A querier is not thread-safe. These two methods lend a querier
+        //that is not used by anyone else (it is created if needed)
+        Querier *acquireQuerier();
+
+        void releaseQuerier(Querier *querier);
+
         KB *getKB() {
             return &kb;
         }
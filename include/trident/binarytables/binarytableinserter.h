@@ -72,6 +72,12 @@ class BinaryTableInserter {
             return 2;
         }
 
+        uint64_t writeBytes(char *bytes, const int size) {
+            manager->append(bytes, size);
+            currentPos += size;
+            return size;
+        }
+
         string getRootDir();
 
         void writeLong(const uint8_t nbytes, const int64_t v);
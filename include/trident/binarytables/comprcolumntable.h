@@ -0,0 +1,179 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _COMPRCOLUMNTABLE_H
+#define _COMPRCOLUMNTABLE_H
+
+#include <trident/binarytables/newtable.h>
+#include <trident/utils/blockcodec.h>
+#include <trident/kb/consts.h>
+
+#include <assert.h>
+
+/*
+ * Table whose rows are compressed in blocks of COMPR_BLOCK_ROWS rows with
+ * BlockCodec. Layout:
+ * <block 0> ... <block n-1>
+ * <directory: for each block, the first row (bytesPerFirstEntry +
+ * bytesPerSecondEntry bytes) and the position of the block
+ * (bytesPerOffset bytes)>
+ * <trailer: nTerms (5 bytes), nUniqueFirstTerms (5 bytes), position of the
+ * directory (5 bytes), bytesPerFirstEntry, bytesPerSecondEntry,
+ * bytesPerOffset, codec>
+ * The trailer is at the end so that the table can be written while the
+ * rows arrive. The directory is used to search the blocks, and only one
+ * block at the time is decoded, in a buffer owned by the iterator.
+ */
+#define COMPRTABLE_TRAILER_SIZE 19
+
+class ComprColumnTable: public AbsNewTable {
+    private:
+        const char *start;
+        const char *directory;
+        uint8_t bytesPerFirstEntry, bytesPerSecondEntry, bytesPerOffset;
+        uint8_t bytesDirEntry;
+        int codec;
+        int64_t nTerms, nUniqueFirstTerms, nBlocks;
+
+        //Rows are identified by their position in the table
+        int64_t startRow, endRow;
+        int64_t row; //Next row to read
+        int64_t currentRow; //Row of the current values
+        int64_t currentValue1, currentValue2;
+        int64_t count;
+        bool isSecondColumnIgnored;
+
+        int64_t savedRow, savedCurrentRow;
+        int64_t savedCurrentValue1, savedCurrentValue2, savedCount;
+
+        //Decoded block
+        int64_t loadedBlock;
+        int64_t values1[COMPR_BLOCK_ROWS];
+        int64_t values2[COMPR_BLOCK_ROWS];
+        char scratch[COMPR_BLOCK_ROWS * 16];
+
+        const char *getDirEntry(const int64_t block) const {
+            return directory + block * bytesDirEntry;
+        }
+
+        void loadBlock(const int64_t block);
+
+        int64_t getValue1At(const int64_t r) {
+            loadBlock(r / COMPR_BLOCK_ROWS);
+            return values1[r % COMPR_BLOCK_ROWS];
+        }
+
+        //Returns the first row in [from, to) that is not smaller than
+        //(c1, c2), or "to" if there is none
+        int64_t searchRow(const int64_t from, const int64_t to,
+                const int64_t c1, const int64_t c2);
+
+    public:
+        ComprColumnTable() : loadedBlock(-1) {
+        }
+
+        char getReaderSize1() const {
+            return bytesPerFirstEntry;
+        }
+
+        char getReaderSize2() const {
+            return bytesPerSecondEntry;
+        }
+
+        char getReaderCountSize() const {
+            return 0;
+        }
+
+        int64_t getValue1() {
+            return currentValue1;
+        }
+
+        int64_t getValue2() {
+            return currentValue2;
+        }
+
+        int64_t getCount() {
+            return count;
+        }
+
+        void clear() {
+        }
+
+        bool hasNext() {
+            return row < endRow;
+        }
+
+        void next() {
+            currentRow = row;
+            loadBlock(row / COMPR_BLOCK_ROWS);
+            currentValue1 = values1[row % COMPR_BLOCK_ROWS];
+            currentValue2 = values2[row % COMPR_BLOCK_ROWS];
+            row++;
+            if (isSecondColumnIgnored) {
+                count = 1;
+                while (row < endRow && getValue1At(row) == currentValue1) {
+                    row++;
+                    count++;
+                }
+            }
+        }
+
+        size_t nextBlock(int64_t *v1, int64_t *v2, size_t n);
+
+        uint64_t getCardinality();
+
+        uint64_t estCardinality() {
+            return row < endRow ? endRow - row : 1;
+        }
+
+        void setup(const char* start, const char *end);
+
+        void setup(int64_t c1, const char* start, const char *end);
+
+        void setup(int64_t c1, int64_t c2, const char* start, const char *end);
+
+        void moveto(const int64_t c1, const int64_t c2);
+
+        void mark() {
+            savedRow = row;
+            savedCurrentRow = currentRow;
+            savedCurrentValue1 = currentValue1;
+            savedCurrentValue2 = currentValue2;
+            savedCount = count;
+        }
+
+        void reset(const char i) {
+            row = savedRow;
+            currentRow = savedCurrentRow;
+            currentValue1 = savedCurrentValue1;
+            currentValue2 = savedCurrentValue2;
+            count = savedCount;
+        }
+
+        void ignoreSecondColumn();
+
+        int getTypeItr() {
+            return COMPRCOLUMN_ITR;
+        }
+};
+
+#endif
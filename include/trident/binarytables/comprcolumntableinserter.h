@@ -0,0 +1,73 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _COMPRCOLUMNTABLEINSERTER_H
+#define _COMPRCOLUMNTABLEINSERTER_H
+
+#include <trident/binarytables/binarytableinserter.h>
+#include <trident/kb/consts.h>
+
+#include <vector>
+
+//Writes the tables read by ComprColumnTable. The blocks are compressed
+//and written as soon as they are full, so only the directory is kept in
+//memory.
+class ComprColumnTableInserter: public BinaryTableInserter {
+private:
+    int codec;
+
+    int64_t values1[COMPR_BLOCK_ROWS];
+    int64_t values2[COMPR_BLOCK_ROWS];
+    size_t nvalues;
+    std::vector<char> buffer;
+
+    //First row and position of every block
+    std::vector<int64_t> dirValues1;
+    std::vector<int64_t> dirValues2;
+    std::vector<uint64_t> dirOffsets;
+
+    int64_t nTerms, nUniqueFirstTerms, prevel1;
+    uint64_t largestElement1, largestElement2;
+    uint64_t written;
+
+    void flushBlock();
+
+public:
+    ComprColumnTableInserter() : codec(BLOCKCODEC_PFOR) {
+    }
+
+    void setCodec(const int codec) {
+        this->codec = codec;
+    }
+
+    int getType() {
+        return COMPRCOLUMN_ITR;
+    }
+
+    void startAppend();
+
+    void append(int64_t t1, int64_t t2);
+
+    void stopAppend();
+};
+
+#endif
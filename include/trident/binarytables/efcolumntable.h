@@ -0,0 +1,183 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _EFCOLUMNTABLE_H
+#define _EFCOLUMNTABLE_H
+
+#include <trident/binarytables/newtable.h>
+#include <trident/utils/eliasfano.h>
+#include <trident/kb/consts.h>
+
+#include <kognac/utils.h>
+
+#include <assert.h>
+
+/*
+ * Column table for large tables with many distinct first terms. The second
+ * column is stored as in NewColumnTable, but the directory of the first
+ * column is encoded with Elias-Fano instead of a list of fixed-width
+ * entries. Layout:
+ * <second column: nTerms values of bytesPerSecondEntry bytes>
+ * <EF of the distinct first terms>
+ * <EF of the row where each first term starts>
+ * <trailer: nTerms (5 bytes), nUniqueFirstTerms (5 bytes), position of the
+ * first EF (5 bytes), position of the second EF (5 bytes),
+ * bytesPerSecondEntry>
+ * A first term is found with nextGEQ on the first sequence, and the range
+ * of its rows with two selects on the second one.
+ */
+#define EFTABLE_TRAILER_SIZE 21
+
+class EFColumnTable: public AbsNewTable {
+    private:
+        const char *start;
+        uint8_t bytesPerSecondEntry;
+        int64_t nTerms, nUniqueFirstTerms;
+        EliasFano values;
+        EliasFano starts;
+
+        //Rows are identified by their position in the table
+        int64_t startRow, endRow;
+        int64_t row; //Next row to read
+        int64_t currentRow; //Row of the current values
+        int64_t currentValue1, currentValue2;
+        int64_t count;
+        bool isSecondColumnIgnored;
+
+        //Group (i.e., rows with the same first term) that contains "row"
+        int64_t group, groupBegin, groupEnd, groupValue;
+
+        int64_t savedRow, savedCurrentRow;
+        int64_t savedCurrentValue1, savedCurrentValue2, savedCount;
+
+        int64_t getValue2At(const int64_t r) const {
+            return Utils::decode_longFixedBytes(start + r * bytesPerSecondEntry,
+                    bytesPerSecondEntry);
+        }
+
+        void loadGroup(const int64_t g);
+
+        //Makes sure that the current group contains the row r
+        void seekGroup(const int64_t r) {
+            if (r >= groupBegin && r < groupEnd) {
+                return;
+            }
+            if (r == groupEnd) {
+                loadGroup(group + 1);
+            } else {
+                loadGroup(starts.nextGEQ(r + 1) - 1);
+            }
+        }
+
+        //Returns the first row in [from, to) that is not smaller than
+        //(c1, c2), or "to" if there is none
+        int64_t searchRow(const int64_t from, const int64_t to,
+                const int64_t c1, const int64_t c2);
+
+    public:
+        EFColumnTable() : group(-1), groupBegin(0), groupEnd(0) {
+        }
+
+        char getReaderSize1() const {
+            return 0;
+        }
+
+        char getReaderSize2() const {
+            return bytesPerSecondEntry;
+        }
+
+        char getReaderCountSize() const {
+            return 0;
+        }
+
+        int64_t getValue1() {
+            return currentValue1;
+        }
+
+        int64_t getValue2() {
+            return currentValue2;
+        }
+
+        int64_t getCount() {
+            return count;
+        }
+
+        void clear() {
+        }
+
+        bool hasNext() {
+            return row < endRow;
+        }
+
+        void next() {
+            currentRow = row;
+            seekGroup(row);
+            currentValue1 = groupValue;
+            currentValue2 = getValue2At(row);
+            row++;
+            if (isSecondColumnIgnored) {
+                const int64_t last = std::min(groupEnd, endRow);
+                count = 1 + last - row;
+                row = last;
+            }
+        }
+
+        size_t nextBlock(int64_t *v1, int64_t *v2, size_t n);
+
+        uint64_t getCardinality();
+
+        uint64_t estCardinality() {
+            return row < endRow ? endRow - row : 1;
+        }
+
+        void setup(const char* start, const char *end);
+
+        void setup(int64_t c1, const char* start, const char *end);
+
+        void setup(int64_t c1, int64_t c2, const char* start, const char *end);
+
+        void moveto(const int64_t c1, const int64_t c2);
+
+        void mark() {
+            savedRow = row;
+            savedCurrentRow = currentRow;
+            savedCurrentValue1 = currentValue1;
+            savedCurrentValue2 = currentValue2;
+            savedCount = count;
+        }
+
+        void reset(const char i) {
+            row = savedRow;
+            currentRow = savedCurrentRow;
+            currentValue1 = savedCurrentValue1;
+            currentValue2 = savedCurrentValue2;
+            count = savedCount;
+        }
+
+        void ignoreSecondColumn();
+
+        int getTypeItr() {
+            return EFCOLUMN_ITR;
+        }
+};
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _EFCOLUMNTABLEINSERTER_H
+#define _EFCOLUMNTABLEINSERTER_H
+
+#include <trident/binarytables/binarytableinserter.h>
+#include <trident/kb/consts.h>
+
+#include <vector>
+
+//Writes the tables read by EFColumnTable. The second column comes first
+//and its size is known only at the end, so the rows are kept in memory
+//until stopAppend().
+class EFColumnTableInserter: public BinaryTableInserter {
+private:
+    std::vector<uint64_t> firstTerms;
+    std::vector<uint64_t> startRows;
+    std::vector<uint64_t> secondTerms;
+    int64_t prevel1;
+    uint64_t largestElement2;
+
+    uint64_t writeEF(const std::vector<uint64_t> &values);
+
+public:
+    int getType() {
+        return EFCOLUMN_ITR;
+    }
+
+    void startAppend();
+
+    void append(int64_t t1, int64_t t2);
+
+    void stopAppend();
+};
+
+#endif
@@ -25,7 +25,9 @@
 
 #include <trident/binarytables/newtable.h>
 #include <trident/kb/consts.h>
+#include <trident/utils/fixedbytes.h>
 
+#include <algorithm>
 #include <iostream>
 #include <assert.h>
 
@@ -154,6 +156,33 @@ class NewClusterTable: public AbsNewTable {
             return current < end;
         }
 
+        size_t nextBlock(int64_t *v1, int64_t *v2, size_t n) {
+            if (isSecondColumnIgnored) {
+                return PairItr::nextBlock(v1, v2, n);
+            }
+            size_t i = 0;
+            while (i < n && current < end) {
+                if (count == 0) {
+                    currentValue1 = Reader1::read(current);
+                    current += Reader1::size();
+                    count = countgroup = ReaderCount::read(current);
+                    current += ReaderCount::size();
+                }
+                //The second column of a group is contiguous
+                const size_t m = std::min(n - i, (size_t) count);
+                FixedBytesDecoder::decode(current, end, Reader2::size(),
+                        v2 + i, m);
+                std::fill(v1 + i, v1 + i + m, currentValue1);
+                current += m * Reader2::size();
+                count -= m;
+                i += m;
+            }
+            if (i > 0) {
+                currentValue2 = v2[i - 1];
+            }
+            return i;
+        }
+
         bool hasNext() {
             return current < end;
         }
@@ -303,6 +332,9 @@ class NewClusterTable: public AbsNewTable {
                     } else {
                         const char *e = current + count * Reader2::size();
                         const char *orige = e;
+                        gallop(current, e, Reader2::size(), [c2](const char *p) {
+                                return (int64_t) Reader2::read(p) < c2;
+                                });
                         while (current < e) {
                             const size_t diff = e - current;
                             const size_t middlevalue = (diff / Reader2::size()) >> 1;
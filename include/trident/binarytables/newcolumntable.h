@@ -26,8 +26,10 @@
 //#include <trident/iterators/pairitr.h>
 #include <trident/binarytables/newtable.h>
 #include <trident/kb/consts.h>
+#include <trident/utils/fixedbytes.h>
 #include <kognac/utils.h>
 
+#include <algorithm>
 #include <assert.h>
 
 class SequenceWriter {
@@ -191,6 +193,43 @@ class NewColumnTable: public AbsNewTable {
             return hasNext();
         }
 
+        size_t nextBlock(int64_t *v1, int64_t *v2, size_t n) {
+            if (isSecondColumnIgnored) {
+                return PairItr::nextBlock(v1, v2, n);
+            }
+#if DEBUG
+            movetoAllowed = true;
+#endif
+            size_t i = 0;
+            while (i < n && hasNext()) {
+                if (scannedCounts == currentCount) {
+                    currentValue1 = Utils::decode_longFixedBytes(currentpos1, bytesPerFirstEntry);
+                    currentpos1 += bytesPerFirstEntry;
+                    currentCount = Utils::decode_longFixedBytes(currentpos1, bytesPerCount);
+                    currentpos1 += bytesPerCount + bytesPerStartingPoint;
+                    scannedCounts = 0;
+                    startblock2 = currentpos2;
+                }
+                //Decode the rest of the current group (or as much as fits
+                //in the output) in one go
+                size_t m = std::min((uint64_t) (n - i), currentCount - scannedCounts);
+                m = std::min(m, (size_t) ((end - currentpos2) / bytesPerSecondEntry));
+                if (m == 0) {
+                    break;
+                }
+                FixedBytesDecoder::decode(currentpos2, end, bytesPerSecondEntry,
+                        v2 + i, m);
+                std::fill(v1 + i, v1 + i + m, currentValue1);
+                currentpos2 += m * bytesPerSecondEntry;
+                scannedCounts += m;
+                i += m;
+            }
+            if (i > 0) {
+                currentValue2 = v2[i - 1];
+            }
+            return i;
+        }
+
         void first() {
             next();
         }
@@ -218,9 +257,13 @@ class NewColumnTable: public AbsNewTable {
 
             bool searchsecondterm = c1 == currentValue1;
             if (c1 > currentValue1) {
-                //Binary search
+                //Galloping search, followed by a binary search
                 const char *s = currentpos1;
                 const char *e = startpos2;
+                const uint8_t bytesEntry = bytesPerFirstEntry;
+                gallop(s, e, bytesFirstBlock, [bytesEntry, c1](const char *p) {
+                        return Utils::decode_longFixedBytes(p, bytesEntry) < c1;
+                        });
                 bool found = false;
                 uint64_t middleValue;
                 while (s < e) {
@@ -281,6 +324,10 @@ class NewColumnTable: public AbsNewTable {
 
                     const char *s = currentpos2;
                     const char *e = startblock2 + currentCount * bytesPerSecondEntry;
+                    const uint8_t bytesEntry = bytesPerSecondEntry;
+                    gallop(s, e, bytesEntry, [bytesEntry, c2](const char *p) {
+                            return Utils::decode_longFixedBytes(p, bytesEntry) < c2;
+                            });
                     bool found = false;
                     while (s < e) {
                         const uint64_t middlePos = (e - s) / bytesPerSecondEntry / 2;
@@ -26,6 +26,7 @@
 #include <trident/binarytables/newtable.h>
 #include <trident/kb/consts.h>
 
+#include <algorithm>
 #include <iostream>
 #include <assert.h>
 
@@ -147,6 +148,24 @@ class NewRowTable: public AbsNewTable {
             return current < end;
         }
 
+        size_t nextBlock(int64_t *v1, int64_t *v2, size_t n) {
+            if (isSecondColumnIgnored) {
+                return PairItr::nextBlock(v1, v2, n);
+            }
+            const uint8_t rowsize = Reader1::size() + Reader2::size();
+            const size_t m = std::min(n, (size_t) ((end - current) / rowsize));
+            for (size_t i = 0; i < m; ++i) {
+                v1[i] = Reader1::read(current);
+                v2[i] = Reader2::read(current + Reader1::size());
+                current += rowsize;
+            }
+            if (m > 0) {
+                currentValue1 = v1[m - 1];
+                currentValue2 = v2[m - 1];
+            }
+            return m;
+        }
+
         bool hasNext() {
             assert(current <= end);
             return current < end;
@@ -264,23 +283,16 @@ class NewRowTable: public AbsNewTable {
 
             if (c1 > currentValue1 ||
                     (!isSecondColumnIgnored && c1 == currentValue1 && c2 > currentValue2)) {
-                // Read the first entry
-                int64_t currentvalue = -1;
-                while (current != end) {
-                    currentvalue = Reader1::read(current);
-                    if (currentvalue >= c1)
-                        break;
-                    current += Reader1::size() + Reader2::size();
-                }
+                //Search the first row that is not smaller than (c1, c2)
+                const int64_t target2 = c2 > 0 ? c2 : 0;
+                current = lowerBound(current, end,
+                        Reader1::size() + Reader2::size(),
+                        [c1, target2](const char *p) {
+                        const int64_t v1 = Reader1::read(p);
+                        return v1 < c1 || (v1 == c1 &&
+                                (int64_t) Reader2::read(p + Reader1::size()) < target2);
+                        });
                 assert(current <= end);
-
-                if (c2 > 0 && current != end && currentvalue == c1) {
-                    int64_t currentC1 = Reader1::read(current);
-                    while (current != end && Reader1::read(current) == currentC1 &&
-                            Reader2::read(current + Reader1::size()) < c2) {
-                        current += Reader1::size() + Reader2::size();
-                    }
-                }
             } else {
                 current -= Reader1::size() + Reader2::size();
             }
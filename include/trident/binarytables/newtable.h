@@ -25,9 +25,53 @@
 
 #include <trident/iterators/pairitr.h>
 
+#include <algorithm>
 
 
 class AbsNewTable : public PairItr {
+    protected:
+        //Galloping (exponential) search over entries of "stride" bytes.
+        //isLess(p) returns true if the entry at p precedes the target.
+        //The range [s, e) is restricted to the part that contains the
+        //first entry that is not less than the target. The cost depends
+        //on how far this entry is from s, and not on the size of the
+        //range. This is what we need in merge joins, where the target is
+        //often only a few entries ahead.
+        template<typename Less>
+            static void gallop(const char *&s, const char *&e,
+                    const size_t stride, const Less &isLess) {
+                size_t step = 1;
+                while (true) {
+                    const size_t remaining = (e - s) / stride;
+                    if (step > remaining) {
+                        break;
+                    }
+                    const char *probe = s + (step - 1) * stride;
+                    if (!isLess(probe)) {
+                        e = probe + stride;
+                        break;
+                    }
+                    s = probe + stride;
+                    step <<= 1;
+                }
+            }
+
+        //Returns the first entry in [s, e) that is not less than the target
+        template<typename Less>
+            static const char *lowerBound(const char *s, const char *e,
+                    const size_t stride, const Less &isLess) {
+                gallop(s, e, stride, isLess);
+                while (s < e) {
+                    const char *middle = s + ((e - s) / stride / 2) * stride;
+                    if (isLess(middle)) {
+                        s = middle + stride;
+                    } else {
+                        e = middle;
+                    }
+                }
+                return s;
+            }
+
     public:
         virtual char getReaderSize1() const = 0;
 
@@ -45,6 +89,13 @@ class AbsNewTable : public PairItr {
                 const int64_t rowId) const  {
             throw 10;
         }
+
+        //All rows of a table share the same key
+        size_t nextBatch(int64_t *keys, int64_t *v1, int64_t *v2, size_t n) {
+            const size_t m = nextBlock(v1, v2, n);
+            std::fill(keys, keys + m, key);
+            return m;
+        }
 };
 
 #endif
@@ -34,6 +34,10 @@
 #include <trident/binarytables/binarytablereaders.h>
 #include <trident/binarytables/newrowtableinserter.h>
 #include <trident/binarytables/newclustertableinserter.h>
+#include <trident/binarytables/comprcolumntable.h>
+#include <trident/binarytables/comprcolumntableinserter.h>
+#include <trident/binarytables/efcolumntable.h>
+#include <trident/binarytables/efcolumntableinserter.h>
 #include <trident/binarytables/factorytables.h>
 
 #include <trident/kb/consts.h>
@@ -48,6 +52,16 @@
  * Current format: 3bits <storage format> -- 1bit <delta on the first term> -- 1 bit <compr on firs el> -- 1 bit <compr on second el> -- 1 bit <aggregated> -- 1 bit unused
  */
 
+/*
+ * Tables with block compression use the storage type COMPRCOLUMN_STORAGE
+ * (the type of their iterator, COMPRCOLUMN_ITR, does not fit in three bits)
+ * and store the codec in the two bits that other layouts use for the size
+ * of the first element.
+ */
+#define COMPRCOLUMN_STORAGE 6
+//Same for the tables with an Elias-Fano directory (EFCOLUMN_ITR)
+#define EFCOLUMN_STORAGE 7
+
 #define RATE_LIST 1.05
 
 LIBEXP extern const unsigned FIXEDSTRAT5;
@@ -80,6 +94,22 @@ struct Statistics {
         aggregated = 0;
         notAggregated = 0;
     }
+
+    void add(const Statistics &s) {
+        nListStrategies += s.nListStrategies;
+        nList2Strategies += s.nList2Strategies;
+        nGroupStrategies += s.nGroupStrategies;
+        nFirstCompr1 += s.nFirstCompr1;
+        nFirstCompr2 += s.nFirstCompr2;
+        nSecondCompr1 += s.nSecondCompr1;
+        nSecondCompr2 += s.nSecondCompr2;
+        diff += s.diff;
+        nodiff += s.nodiff;
+        exact += s.exact;
+        approximate += s.approximate;
+        aggregated += s.aggregated;
+        notAggregated += s.notAggregated;
+    }
 };
 
 class StorageStrat {
@@ -103,6 +133,10 @@ public:
     static unsigned getStrat6();
     static unsigned getStrat7();
 
+    static unsigned getComprStrat(const int codec);
+
+    static unsigned getEFStrat();
+
 protected:
     static void createAllCombinations(std::vector<Combinations> &output,
                                       int64_t *groupCounters1Compr2,
@@ -152,6 +186,8 @@ private:
     Factory<NewColumnTable> *f4;
     FactoryNewRowTable *f5;
     FactoryNewClusterTable *f6;
+    Factory<ComprColumnTable> *f7;
+    Factory<EFColumnTable> *f8;
 
     Factory<RowTableInserter> *f1i;
     Factory<ClusterTableInserter> *f2i;
@@ -159,6 +195,8 @@ private:
     Factory<NewColumnTableInserter> *f4i;
     Factory<NewRowTableInserter> *f5i;
     Factory<NewClusterTableInserter> *f6i;
+    Factory<ComprColumnTableInserter> *f7i;
+    Factory<EFColumnTableInserter> *f8i;
 
 public:
     bool static isAggregated(const char signature) {
@@ -203,10 +241,18 @@ public:
         return signature >> 5 & 7;
     }
 
+    int static getCodec(const unsigned signature) {
+        return (signature >> 3) & 3;
+    }
+
     StorageStrat() {
         f4 = NULL;
         f5 = NULL;
         f6 = NULL;
+        f7 = NULL;
+        f7i = NULL;
+        f8 = NULL;
+        f8i = NULL;
         statsCluster = statsRow = statsColumn = 0;
     }
 
@@ -223,7 +269,11 @@ public:
               Factory<ColumnTableInserter> *list2Factory_i,
               Factory<NewColumnTableInserter> *ncFactory_i,
               Factory<NewRowTableInserter> *nrFactory_i,
-              Factory<NewClusterTableInserter> *ncluFactory_i) {
+              Factory<NewClusterTableInserter> *ncluFactory_i,
+              Factory<ComprColumnTable> *ccFactory,
+              Factory<ComprColumnTableInserter> *ccFactory_i,
+              Factory<EFColumnTable> *efFactory,
+              Factory<EFColumnTableInserter> *efFactory_i) {
         this->f4 = ncFactory;
         this->f5 = newRowFactories;
         this->f6 = newClusterFactories;
@@ -233,6 +283,10 @@ public:
         this->f4i = ncFactory_i;
         this->f5i = nrFactory_i;
         this->f6i = ncluFactory_i;
+        this->f7 = ccFactory;
+        this->f7i = ccFactory_i;
+        this->f8 = efFactory;
+        this->f8i = efFactory_i;
     }
 
     PairItr *getBinaryTable(const char signature);
@@ -104,6 +104,9 @@ class TableStorage {
         //permutation ID
         int perm;
 
+        //Number of scans that are currently reading the tables
+        int nScans;
+
         //*** INSERT ***
         bool indicesWritten;
         BinaryTableInserter* insertHandler;
@@ -132,6 +135,10 @@ class TableStorage {
 
         void setStrategy(const char strat);
 
+        //Appends the next tables to a new file, so that the existing files
+        //and their marks are left untouched
+        void startNewFile();
+
         void append(int64_t v1, int64_t v2);
 
         void stopAppend();
@@ -146,6 +153,14 @@ class TableStorage {
             return sizeLastCreatedFile;
         }
 
+        int64_t getMaxFileSize() {
+            return cache->getFileMaxSize();
+        }
+
+        int getMaxNFiles() {
+            return cache->getMaxFiles();
+        }
+
         bool doesFileHaveCoordinates(short file);
 
         const char *getBeginTableCoordinates(short file);
@@ -154,6 +169,16 @@ class TableStorage {
 
         std::vector<const char*> loadAllFiles();
 
+        //Tell the storage that a scan over all its tables starts/ends, so
+        //that the files can be mapped for sequential access
+        void beginScan();
+
+        void endScan();
+
+        //Loads all the files (tables and marks) of the storage in memory.
+        //Returns the number of pages that were touched
+        size_t warmup();
+
         void stopInsert();
 
         ~TableStorage();
@@ -76,8 +76,16 @@ public:
         return id;
     }
 
+    int getTrackerId() {
+        return memoryTrackerId;
+    }
+
     bool isUsed();
 
+    void advise(int flags);
+
+    size_t prefault();
+
     void shiftFile(uint64_t pos, uint64_t diff);
 
     void append(char *bytes, const uint64_t size);
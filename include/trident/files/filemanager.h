@@ -24,6 +24,7 @@
 #define FILEMANAGER_H_
 
 #include <trident/utils/memorymgr.h>
+#include <trident/utils/memoryfile.h>
 #include <trident/kb/consts.h>
 #include <trident/kb/statistics.h>
 
@@ -52,6 +53,9 @@ class FileManager {
 
         MemoryManager<K> *bytesTracker;
         T *openedFiles[MAX_N_FILES];
+        //Block of each opened file in bytesTracker. It is kept here so
+        //that a file can be pinned without dereferencing it
+        int trackerIds[MAX_N_FILES];
         list<int> trackerOpenedFiles;
 
         //Cache the uncompressed size of file used during the writing
@@ -62,6 +66,11 @@ class FileManager {
 
         Stats* const stats;
 
+        //Mapping hints applied to every file that is loaded (0 = none)
+        int advice;
+        //Touch all the pages of the files when they are loaded
+        bool populate;
+
 #ifdef MT
         std::mutex mutex;
 #endif
@@ -70,6 +79,15 @@ class FileManager {
             return openedFiles[id] != NULL;
         }
 
+        //Claims the block of the file so that it cannot be pinned while it
+        //is deleted. Returns false if the file is in use.
+        bool claimFile(const int id) {
+            if (bytesTracker == NULL || trackerIds[id] < 0) {
+                return false;
+            }
+            return bytesTracker->claim(trackerIds[id], openedFiles[id]);
+        }
+
         void load_file(const int id) {
             if (!isFileLoaded(id)) {
 #ifdef MT
@@ -84,7 +102,7 @@ class FileManager {
                         bool rem = true;
                         assert(!trackerOpenedFiles.empty());
                         while (openedFiles[idxFileToRemove] == NULL ||
-                                openedFiles[idxFileToRemove]->isUsed()) {
+                                !claimFile(idxFileToRemove)) {
 
                             if (openedFiles[idxFileToRemove] != NULL) {
                                 //It means the file is still used
@@ -112,6 +130,7 @@ class FileManager {
                             //LOG(DEBUGL) << "Deleting map for file " << idxFileToRemove;
                             delete openedFiles[idxFileToRemove];
                             openedFiles[idxFileToRemove] = NULL;
+                            trackerIds[idxFileToRemove] = -1;
                             nOpenedFiles--;
                         }
                     }
@@ -119,6 +138,13 @@ class FileManager {
                     filePath << cacheDir << DIR_SEP << id;
                     T* f = new T(readOnly, id, filePath.str(), fileMaxSize,
                             bytesTracker, openedFiles, stats);
+                    if (advice != 0) {
+                        f->advise(advice);
+                    }
+                    if (populate) {
+                        f->prefault();
+                    }
+                    trackerIds[id] = f->getTrackerId();
                     openedFiles[id] = f;
                     trackerOpenedFiles.push_back(id);
                     nOpenedFiles++;
@@ -134,9 +160,10 @@ class FileManager {
                 Stats * const stats) :
             readOnly(readOnly), cacheDir(path), fileMaxSize(fileMaxSize),
             maxFiles(maxNumberFiles), lastFileId(lastFileId), bytesTracker(bytesTracker),
-            stats(stats) {
+            stats(stats), advice(0), populate(false) {
                 for (int i = 0; i < MAX_N_FILES; ++i) {
                     openedFiles[i] = NULL;
+                    trackerIds[i] = -1;
                 }
 
                 lastSession = 0;
@@ -156,29 +183,43 @@ class FileManager {
         }
 
         char* getBuffer(short id, uint64_t offset, uint64_t *length, int sessionId) {
-            load_file(id);
-            int memoryBlock;
-
-            char *result = openedFiles[id]->getBuffer(offset, length,
-                    memoryBlock, sessionId);
-
-            if (sessionId != EMPTY_SESSION && sessions[sessionId] != memoryBlock) {
-                //Tell the memory manager that we don't need this block anymore
-                if (sessions[sessionId] >= 0) {
-                    bytesTracker->releaseLock(sessions[sessionId]);
+            while (true) {
+                load_file(id);
+                T *f = openedFiles[id];
+                const int memoryBlock = trackerIds[id];
+                if (f == NULL) {
+                    //Evicted after it was loaded
+                    continue;
                 }
 
-                sessions[sessionId] = memoryBlock;
-
-                if (memoryBlock >= 0) {
-                    bytesTracker->addLock(memoryBlock);
+                if (sessionId != EMPTY_SESSION && memoryBlock >= 0) {
+                    if (sessions[sessionId] != memoryBlock) {
+                        //Pin the new block before touching the file and
+                        //before releasing the previous one, so that the
+                        //session always holds a lock. If the pin fails, the
+                        //file is being evicted and must be loaded again.
+                        if (!bytesTracker->addLock(memoryBlock, f)) {
+                            continue;
+                        }
+                        if (sessions[sessionId] >= 0) {
+                            bytesTracker->releaseLock(sessions[sessionId]);
+                        }
+                        sessions[sessionId] = memoryBlock;
+                    } else if (!bytesTracker->holds(memoryBlock, f)) {
+                        //The id of the file is stale
+                        continue;
+                    }
                 }
-            }
 
-            return result;
+                int block;
+                return f->getBuffer(offset, length, block, sessionId);
+            }
         }
 
         int newSession() {
+#ifdef MT
+            std::unique_lock<std::mutex> lock(mutex);
+#endif
             int cnt = 0;
             while (sessions[lastSession] != FREE_SESSION) {
                 lastSession = (lastSession + 1) % MAX_SESSIONS;
@@ -196,6 +237,9 @@ class FileManager {
         }
 
         void closeSession(int idx) {
+#ifdef MT
+            std::unique_lock<std::mutex> lock(mutex);
+#endif
             //Release the lock
             if (sessions[idx] >= 0) {
                 bytesTracker->releaseLock(sessions[idx]);
@@ -204,6 +248,38 @@ class FileManager {
             sessions[idx] = FREE_SESSION;
         }
 
+        //Changes the mapping hints of the files that are currently loaded
+        //and of the ones that will be loaded later. Only the access hints
+        //are changed: populating the files is set with setPopulate
+        void setAdvice(int flags) {
+            flags &= ~MAPPING_POPULATE;
+#ifdef MT
+            std::unique_lock<std::mutex> lock(mutex);
+#endif
+            advice = flags;
+            for (int i = 0; i < MAX_N_FILES; ++i) {
+                if (openedFiles[i] != NULL) {
+                    openedFiles[i]->advise(flags);
+                }
+            }
+        }
+
+        //The files loaded from now on are populated once, when they are
+        //mapped
+        void setPopulate(bool value) {
+#ifdef MT
+            std::unique_lock<std::mutex> lock(mutex);
+#endif
+            populate = value;
+        }
+
+        //Loads the file and touches all its pages. Returns the number of
+        //pages that were touched
+        size_t prefault(const int idx) {
+            load_file(idx);
+            return openedFiles[idx]->prefault();
+        }
+
         uint64_t sizeFile(const int idx) {
             if (isFileLoaded(idx)) {
                 return openedFiles[idx]->getFileLength();
@@ -243,6 +319,10 @@ class FileManager {
             return fileMaxSize;
         }
 
+        int getMaxFiles() {
+            return maxFiles;
+        }
+
         short createNewFile() {
             lastFileId++;
             if (lastFileId == MAX_N_FILES) {
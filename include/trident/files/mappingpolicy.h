@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _MAPPINGPOLICY_H
+#define _MAPPINGPOLICY_H
+
+#include <trident/utils/memoryfile.h>
+
+#include <string>
+
+class KBConfig;
+
+//Decides which hints are given to the kernel when the index files are
+//mapped in memory. The policy is process-wide because the files are
+//mapped lazily deep inside the storage layer. It is set by the KB when it
+//is opened (see the MAPPING_* params in KBConfig).
+class MappingPolicy {
+    private:
+        static int tableFlags;
+        static int scanFlags;
+        static int indexFlags;
+        static bool populateTables;
+
+    public:
+        static void init(KBConfig &config);
+
+        //Flags used to map the files that contain the binary tables
+        static int getTableFlags() {
+            return tableFlags;
+        }
+
+        //Flags applied to the tables of a permutation while it is being
+        //scanned. If it is MAPPING_NORMAL, scans do not change the advice
+        static int getScanFlags() {
+            return scanFlags;
+        }
+
+        //The table and scan flags only contain access hints, which can
+        //change at any time. Populating the tables happens once, when
+        //their files are mapped
+        static bool getPopulateTables() {
+            return populateTables;
+        }
+
+        //Flags used to map the tree and the first-level indices of the
+        //tables (the marks files)
+        static int getIndexFlags() {
+            return indexFlags;
+        }
+
+        //Parses "normal", "sequential" or "random". Returns -1 if the
+        //string is not recognized ("auto" is handled by init)
+        static int parseAdvice(std::string advice);
+};
+
+#endif
@@ -73,6 +73,8 @@ public:
 
 	LIBEXP void next();
 
+	LIBEXP size_t nextBlock(int64_t *v1, int64_t *v2, size_t n);
+
 	LIBEXP void mark();
 
 	LIBEXP void reset(const char i);
@@ -25,6 +25,7 @@
 
 
 #include <inttypes.h>
+#include <stddef.h>
 
 #define NO_CONSTRAINT -1
 
@@ -62,6 +63,42 @@ class PairItr {
             return hasNext();
         }
 
+        //Reads up to n pairs and copies them into v1 and v2. Returns the
+        //number of pairs that were read. Afterwards, the iterator points
+        //to the last pair that was returned, as if next() was called that
+        //many times. Iterators that can decode several values at once
+        //should override it.
+        virtual size_t nextBlock(int64_t *v1, int64_t *v2, size_t n) {
+            size_t i = 0;
+            while (i < n && hasNext()) {
+                next();
+                v1[i] = getValue1();
+                v2[i] = getValue2();
+                i++;
+            }
+            return i;
+        }
+
+        //Batch version of the iterator: reads up to n rows and copies the
+        //key and the two values of each row in the three arrays. Returns
+        //the number of rows that were read. This default implementation
+        //works for every iterator (also the ones where the key changes,
+        //like the scans). Iterators that can do better override it.
+        //Notice that counts are not returned, so it should not be
+        //used after ignoreSecondColumn().
+        virtual size_t nextBatch(int64_t *keys, int64_t *v1, int64_t *v2,
+                size_t n) {
+            size_t i = 0;
+            while (i < n && hasNext()) {
+                next();
+                keys[i] = getKey();
+                v1[i] = getValue1();
+                v2[i] = getValue2();
+                i++;
+            }
+            return i;
+        }
+
         virtual void ignoreSecondColumn() = 0;
 
         virtual int64_t getCount() = 0;
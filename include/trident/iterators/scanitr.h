@@ -29,6 +29,7 @@
 #include <trident/iterators/termitr.h>
 #include <trident/binarytables/storagestrat.h>
 #include <trident/binarytables/tableshandler.h>
+#include <trident/utils/prefetcher.h>
 
 class Querier;
 class TreeItr;
@@ -56,6 +57,23 @@ private:
     //TableStorage *storage;
     //StorageStrat *strat;
 
+    //Read-ahead of the following tables. "lookahead" walks the same terms
+    //of itr1 but it is ahead of up to getScanPrefetchTables() tables
+    Prefetcher *prefetcher;
+    TermItr *lookahead;
+    TableStorage *lookaheadStorage;
+    int64_t lag; //Tables opened by the scan before lookahead reached them
+    bool hasPending; //Table that did not fit in the budget of the prefetcher
+    std::pair<const char*, const char*> pending;
+
+    void startPrefetch();
+
+    void fillPrefetch();
+
+    void tableOpened();
+
+    void stopPrefetch();
+
 public:
     void init(int idx, Querier *q);
 
@@ -107,6 +125,8 @@ public:
 
     bool next(int64_t &v1, int64_t &v2, int64_t &v3);
 
+    size_t nextBatch(int64_t *keys, int64_t *v1, int64_t *v2, size_t n);
+
     void clear();
 
     uint64_t getCardinality();
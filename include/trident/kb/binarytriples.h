@@ -0,0 +1,87 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef BINARYTRIPLES_H_
+#define BINARYTRIPLES_H_
+
+#include <trident/utils/memoryfile.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <inttypes.h>
+
+//Binary format of pre-encoded triples. A file starts with a header of 32
+//bytes: the magic string BINTRIPLES_MAGIC, the version (uint32), the number
+//of bytes per ID (uint32, between 1 and 8), the number of triples (uint64)
+//and the largest ID (uint64). Then it contains the triples, stored as three
+//IDs (s, p, o). All numbers are little-endian.
+#define BINTRIPLES_MAGIC "TRIDENTB"
+#define BINTRIPLES_MAGIC_SIZE 8
+#define BINTRIPLES_VERSION 1
+#define BINTRIPLES_HEADER_SIZE 32
+
+struct BinaryTriplesHeader {
+    uint32_t version;
+    uint32_t idBytes;
+    uint64_t ntriples;
+    uint64_t maxID;
+};
+
+class BinaryTriples {
+    private:
+        struct File {
+            std::unique_ptr<MemoryMappedFile> mapping;
+            const char *triples;
+            int64_t firstTriple;
+            int64_t ntriples;
+            int idBytes;
+        };
+
+        std::vector<File> files;
+        int64_t ntriples;
+        int64_t maxID;
+
+    public:
+        //Returns true if the file starts with the magic string
+        static bool isBinary(std::string file);
+
+        static BinaryTriplesHeader readHeader(std::string file);
+
+        //Maps all the files in memory
+        BinaryTriples(std::vector<std::string> files);
+
+        int64_t getNTriples() const {
+            return ntriples;
+        }
+
+        int64_t getMaxID() const {
+            return maxID;
+        }
+
+        //Decodes the triples from start to start + n (in the order of the
+        //files) and stores them in out as s, p, o. It can be called by
+        //several threads at the same time.
+        void read(int64_t start, int64_t n, int64_t *out) const;
+};
+
+#endif /* BINARYTRIPLES_H_ */
@@ -72,6 +72,8 @@
 #define FILTERSAME_ITR 20
 #define REORDER_ITR 21
 #define REORDERTERM_ITR 22
+#define COMPRCOLUMN_ITR 23
+#define EFCOLUMN_ITR 24
 
 //Use for dynamic layout
 #define W_DIFFERENCE 0
@@ -80,10 +82,21 @@
 #define COMPR_2 1
 #define NO_COMPR 2
 
+//Codecs used by the tables with block compression (COMPRCOLUMN_ITR)
+#define BLOCKCODEC_PFOR 0
+#define BLOCKCODEC_LZ4 1
+//Number of rows in a compressed block
+#define COMPR_BLOCK_ROWS 128
+
 //Size buffer (i.e. number of elements) to sort during the compression
 #define SORTING_BLOCK_SIZE 25000000
 
 #define MAX_N_BLOCKS_IN_CACHE 1000000
+//Number of independent partitions of the cache of mapped files
+#define N_CACHE_SHARDS 16
+
+//Number of rows that are read at once with PairItr::nextBatch
+#define ITR_BATCH_SIZE 1024
 
 //Used in the dictionary lookup thread
 #define OUTPUT_BUFFER_SIZE 2048
@@ -98,6 +111,22 @@
 
 #define MAX_N_FILES 4096
 
+//Minimum number of triples in a key range of a permutation that is
+//built in parallel
+#define TRIPLES_PER_RANGE 16000000
+
+//Estimated memory taken by each sorted file that is opened during a merge
+//(the buffers of the LZ4 reader and the decompressed segment)
+#define MERGE_BYTES_PER_FILE (2 * 1024 * 1024)
+
+//Estimated memory taken by each thread that parses the input during the
+//dictionary encoding (its hash tables and string pools)
+#define DICT_BYTES_PER_THREAD (256 * 1024 * 1024)
+
+//Number of <ID,coordinates> pairs passed at once to the thread that fills
+//the inverse dictionary during the loading
+#define INVDICT_BATCH_SIZE 65536
+
 //Used in the cache of the tree to serialize the nodes
 #define SIZE_SUPPORT_BUFFER 512 * 1024
 
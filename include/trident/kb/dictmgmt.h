@@ -181,6 +181,16 @@ class DictMgmt {
 
         LIBEXP bool getText(nTerm key, char *value, int &size);
 
+        //Retrieves the text of several terms. The keys are visited in
+        //order, and so are the strings afterwards. Consecutive strings
+        //often share the same block, which is then uncompressed only once.
+        //The text of keys[i] is stored in texts, at the offset and with
+        //the size in positions[i]. Returns false if some key was not found
+        //(its text is empty)
+        LIBEXP bool getTexts(const std::vector<uint64_t> &keys,
+                std::string &texts,
+                std::vector<std::pair<size_t, size_t>> &positions);
+
         void getTextFromCoordinates(int64_t coordinates, char *output,
                 int &sizeOutput);
 
@@ -199,6 +209,12 @@ class DictMgmt {
 
         bool putPair(const char *key, int sizeKey, nTerm &value);
 
+        //Appends the term only to the dictionary. Coordinates is set to
+        //the position of the term in the string buffer, which must be
+        //added to the inverse dictionary with putInvDict
+        void appendDict(const char *key, int sizeKey, nTerm &value,
+                int64_t &coordinates);
+
         void appendPair(const char *key, int sizeKey, nTerm &value);
 
         bool useHashForCompression() {
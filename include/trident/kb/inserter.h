@@ -35,6 +35,7 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
 
 #define POSAGGRBYTE INT64_C(0x100000000000)
 
@@ -62,6 +63,15 @@ class Inserter {
         size_t thresholdForColumnStorage;
         const size_t thresholdSkipTable;
 
+        //Codec used to compress the large tables (-1 if disabled) and
+        //number of rows above which a table is compressed
+        int blockCompression;
+        size_t thresholdBlockCompression;
+
+        //Number of rows above which a table is stored with an Elias-Fano
+        //directory (0 if disabled)
+        size_t thresholdEFDirectory;
+
         int64_t currentT1[N_PARTITIONS];
         int64_t currentT2[N_PARTITIONS];
         int64_t nElements[N_PARTITIONS];
@@ -91,6 +101,8 @@ class Inserter {
         Factory<NewColumnTableInserter> ncFactory[N_PARTITIONS];
         Factory<NewRowTableInserter> nrFactory[N_PARTITIONS];
         Factory<NewClusterTableInserter> ncluFactory[N_PARTITIONS];
+        Factory<ComprColumnTableInserter> ccFactory[N_PARTITIONS];
+        Factory<EFColumnTableInserter> efFactory[N_PARTITIONS];
         BinaryTableInserter *currentPairHandler[N_PARTITIONS];
 
         //Store the number of virtual tables per partition
@@ -113,6 +125,11 @@ class Inserter {
 
 
     public:
+        //Memory used by the buffers of one permutation that is being
+        //inserted. They are freed by stopInserts()
+        static const int64_t BUFFER_BYTES = (int64_t) 2 * 8 *
+            (THRESHOLD_KEEP_MEMORY + 1);
+
         Inserter(Root *tree, TableStorage **files, int64_t nTerms,
                 bool useFixedStrategy, char fixedStrategy,
                 const size_t thresholdSkipTable,
@@ -121,6 +138,8 @@ class Inserter {
         useRowForLargeTables(false),
         thresholdForColumnStorage(StorageStrat::getBinaryBreakingPoint()),
         thresholdSkipTable(thresholdSkipTable),
+        blockCompression(-1), thresholdBlockCompression(0),
+        thresholdEFDirectory(0),
         ntables(ntables), nFirstElsNTables(nFirstElsNTables) {
             assert(thresholdSkipTable < THRESHOLD_KEEP_MEMORY);
             this->tree = tree;
@@ -128,15 +147,20 @@ class Inserter {
 
             for (int i = 0; i < N_PARTITIONS; ++i) {
                 currentT1[i] = -1;
-                values1[i] = new int64_t[THRESHOLD_KEEP_MEMORY + 1];
-                values2[i] = new int64_t[THRESHOLD_KEEP_MEMORY + 1];
+                //Allocated by the first insert in the permutation
+                values1[i] = NULL;
+                values2[i] = NULL;
                 storageStrategy[i].init(/*NULL, NULL, NULL,*/ NULL, NULL, NULL,
                         &listFactory[i],
                         &comprFactory[i],
                         &list2Factory[i],
                         &ncFactory[i],
                         &nrFactory[i],
-                        &ncluFactory[i]);
+                        &ncluFactory[i],
+                        NULL,
+                        &ccFactory[i],
+                        NULL,
+                        &efFactory[i]);
                 currentPairHandler[i] = NULL;
 
                 lastFirstTerm[i] = -1;
@@ -156,6 +180,26 @@ class Inserter {
             useRowForLargeTables = true;
         }
 
+        void disableBlockCompression() {
+            blockCompression = -1;
+        }
+
+        void setBlockCompression(const int codec, const size_t threshold) {
+            blockCompression = codec;
+            //Larger tables are not kept in memory, so I cannot count them
+            thresholdBlockCompression = std::min(threshold,
+                    (size_t) THRESHOLD_KEEP_MEMORY);
+        }
+
+        void disableEFDirectory() {
+            thresholdEFDirectory = 0;
+        }
+
+        void setEFDirectory(const size_t threshold) {
+            thresholdEFDirectory = std::max((size_t) 1, std::min(threshold,
+                    (size_t) THRESHOLD_KEEP_MEMORY));
+        }
+
         bool insert(const int permutation, const int64_t t1, const int64_t t2,
                 const int64_t t3, const int64_t count,
                 TripleWriter *posArray, TreeInserter *treeInserter,
@@ -163,6 +207,11 @@ class Inserter {
 
         void insert(nTerm key, TermCoordinates *value);
 
+        //Replaces the coordinates of the table of "key" in one permutation
+        //and keeps the ones of the other permutations
+        void updateCoordinates(nTerm key, const int permutation, short file,
+                int64_t mark, int64_t nElements, char strategy);
+
         std::string getPathPermutationStorage(const int perm);
 
         void flush(int permutation, TripleWriter *posArray,
@@ -172,6 +221,20 @@ class Inserter {
 
         void stopInserts(int permutation);
 
+        //Creates an inserter with the same configuration of this one that
+        //writes in "files". Used to build several key ranges of a
+        //permutation in parallel
+        Inserter *createPartition(TableStorage **files, int64_t *ntables,
+                int64_t *nFirstElsNTables);
+
+        //Creates an empty storage in "path" with the same limits of the
+        //storage of the permutation
+        TableStorage *createStorage(const int permutation, std::string path);
+
+        //Adds the counters of an inserter returned by createPartition to
+        //the ones of this inserter
+        void mergePartition(const int permutation, Inserter *partition);
+
         Statistics *getStats(int permutation) {
             return &stats[permutation];
         }
@@ -186,8 +249,10 @@ class Inserter {
 
         ~Inserter() {
             for (int i = 0; i < N_PARTITIONS; ++i) {
-                delete[] values1[i];
-                delete[] values2[i];
+                if (values1[i] != NULL) {
+                    delete[] values1[i];
+                    delete[] values2[i];
+                }
             }
         }
 };
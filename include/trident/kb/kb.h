@@ -34,6 +34,7 @@
 #include <kognac/factory.h>
 
 #include <string>
+#include <atomic>
 
 class Leaf;
 class Querier;
@@ -84,6 +85,11 @@ class KB {
         bool relsIDsSep; //Do relations have their own IDs?
 
         size_t thresholdSkipTable;
+        int blockCompression;
+        int64_t thresholdBlockCompression;
+        int64_t thresholdEFDirectory;
+        int scanPrefetchTables;
+        int64_t scanPrefetchBytes;
 
         double sampleRate;
 
@@ -97,6 +103,8 @@ class KB {
 
         //The data structures below handle updates
         std::vector<std::unique_ptr<DiffIndex>> diffIndices;
+        //Increased every time the content of the KB changes
+        std::atomic<uint64_t> updateVersion;
         std::unique_ptr<ROMappedFile> spo_f;
         std::unique_ptr<ROMappedFile> sop_f;
         std::unique_ptr<ROMappedFile> pos_f;
@@ -182,6 +190,23 @@ class KB {
             return ntables[idx];
         }
 
+        bool areIndicesAggregated() const {
+            return aggrIndices;
+        }
+
+        //Registers triples that were appended to the permutations without
+        //going through the storage of the KB
+        void addAppendedTriples(const int64_t n) {
+            totalNumberTriples += n;
+            updateVersion++;
+        }
+
+        //Changes whenever the KB is updated. Used to invalidate the data
+        //derived from the content of the KB (e.g., the cached plans)
+        uint64_t getUpdateVersion() const {
+            return updateVersion;
+        }
+
         double getSampleRate() {
             return sampleRate;
         }
@@ -200,6 +225,10 @@ class KB {
 
         std::vector<const char*> openAllFiles(int perm);
 
+        //Loads in memory the tree and all the files of the given
+        //permutations. Returns the number of pages that were touched
+        size_t warmup(const std::vector<int> &perms);
+
         void addDiffIndex(string inputdir, const char **globalbuffers, Querier *q);
 
         Partial *getPartial(int idx) {
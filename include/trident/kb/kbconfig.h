@@ -43,6 +43,9 @@ typedef enum {
 
     THRESHOLD_SKIP_TABLE, //Define the threshold when a table can be skipped
     RELSOWNIDS, //If set to true, then the relations have independent IDs
+    BLOCKCOMPRESSION, //Codec used to compress the large tables (-1 disables it)
+    THRESHOLD_BLOCKCOMPRESSION, //Number of rows above which a table is compressed
+    THRESHOLD_EFDIRECTORY, //Number of rows above which a table has an Elias-Fano directory (0 disables it)
 
     TREE_MAXELEMENTSNODE, //Max elements inside a node
     TREE_MAXSIZECACHETREE, //Max size of the cache in bytes
@@ -62,6 +65,7 @@ typedef enum {
 
     TREE_NODE_KEYS_FACTORY_SIZE, //Size factory of arrays of int64_ts to be used in the nodes
     TREE_NODE_KEYS_PREALL_FACTORY_SIZE, //Same as before, only the preallocated size
+    TREE_STATIC, //If the KB is read-only, use the static copy of the tree if it exists
 
 //The following parameters are equalivant to the previous but apply to the dictionary tree
     DICT_MAXELEMENTSNODE,
@@ -92,10 +96,19 @@ typedef enum {
     STORAGE_MAX_FILE_SIZE,
     STORAGE_MAX_N_FILES,
 
+//Parameters about how the index files are mapped in memory
+    MAPPING_ADVICE, //Access pattern of the tables: "normal", "sequential", "random" or "auto"
+    MAPPING_WILLNEED_INDEX, //Prefetch the tree and the first-level indices of the tables
+    MAPPING_POPULATE_FILES, //Pre-fault the files when they are mapped
+    MAPPING_HUGEPAGES_FILES, //Ask for transparent huge pages
+    SCAN_PREFETCH_TABLES, //Number of tables that a scan reads ahead (0 disables it)
+    SCAN_PREFETCH_BYTES, //Max number of bytes that a scan reads ahead
+
 //Parameters about the string buffer
     SB_COMPRESSDOMAINS,
     SB_PREALLBUFFERS,
-    SB_CACHESIZE
+    SB_CACHESIZE,
+    SB_COMPRESSTHREADS //Threads that compress the blocks when writing
 
 } KBParam;
 
@@ -34,6 +34,10 @@ private:
 public:
     static void optimizeForWriting(int64_t inputTriples, KBConfig &config);
 
+    //Reduce the caches set by optimizeForWriting so that they fit in
+    //maxMemory bytes
+    static void limitForWriting(int64_t maxMemory, KBConfig &config);
+
     static void optimizeForReading(int ndicts, KBConfig &config);
 
     static void optimizeForReasoning(int ndicts, KBConfig &config);
@@ -23,21 +23,34 @@
 #ifndef _PERM_SORTER_H
 #define _PERM_SORTER_H
 
+#include <trident/kb/binarytriples.h>
+
 #include <kognac/multidisklz4reader.h>
 #include <kognac/multidisklz4writer.h>
 
 #include <string>
 #include <vector>
+#include <memory>
 
 class PermSorter {
     private:
-        static void writeTermInBuffer(char *buffer, const int64_t n);
+        static bool radixSort;
+        static int64_t maxMemory;
+        static int64_t maxTermID;
+        static std::string binaryInputDir;
+        static std::shared_ptr<BinaryTriples> binaryInput;
 
-        static void write8TermInBuffer(char *buffer, const int64_t n);
+        //The terms are stored big-endian in W bytes, so that the records
+        //can be sorted byte by byte
+        template<int W>
+        static void writeTerm(char *buffer, const int64_t n);
 
-        static int64_t readTermFromBuffer(char *buffer);
+        template<int W>
+        static int64_t readTerm(const char *buffer);
 
-        static int64_t read8TermFromBuffer(char *buffer);
+        //Throws if n does not fit in W bytes
+        template<int W>
+        static void checkTerm(const int64_t n);
 
         static void sortChunks_seq(const int idReader,
                 MultiDiskLZ4Reader *reader,
@@ -48,6 +61,7 @@ class PermSorter {
                 std::vector<std::pair<string, char>> additionalPermutations,
                 bool outputSPO);
 
+        template<int W>
         static void dumpPermutation_seq(
                 char *start,
                 char *end,
@@ -55,6 +69,7 @@ class PermSorter {
                 int currentPart,
                 bool includeCount);
 
+        template<int W>
         static void dumpPermutation(char *input, int64_t end,
                 int parallelProcesses,
                 int maxReadingThreads,
@@ -63,9 +78,11 @@ class PermSorter {
 
         //static bool isMax(char *input, int64_t idx);
 
+        template<int W>
         static void sortPermutation(char *start,
                 char *end, int nthreads, bool includeCount);
 
+        template<int W>
         static void sortChunks2_load(const int idReader,
                 MultiDiskLZ4Reader *reader,
                 char *rawTriples,
@@ -74,6 +91,13 @@ class PermSorter {
                 int64_t *count,
                 bool includeCount);
 
+        template<int W>
+        static void sortChunks2_loadBinary(const BinaryTriples *input,
+                int64_t start,
+                int64_t n,
+                char *rawTriples);
+
+        template<int W>
         static void sortChunks2_fill(
                 MultiDiskLZ4Reader **readers,
                 size_t maxInserts,
@@ -84,6 +108,7 @@ class PermSorter {
                 bool includeCount,
                 char *rawTriples);
 
+        template<int W>
         static void sortChunks2_permute(
                 char *start,
                 char *end,
@@ -91,7 +116,58 @@ class PermSorter {
                 int currentPerm,
                 int nextPerm);
 
+        //Sorts the chunks with records of W bytes per term
+        template<int W>
+        static void sortChunks2_w(
+                std::vector<std::pair<string, char>> &inputs,
+                int maxReadingThreads,
+                int parallelProcesses,
+                int64_t estimatedSize,
+                bool includeCount);
+
     public:
+        //Sort the in-memory chunks with the parallel radix sort (default)
+        //or with the parallel comparison sort
+        static void setRadixSort(bool enabled) {
+            radixSort = enabled;
+        }
+
+        //Upper bound (in bytes) of the memory used to sort the chunks.
+        //0 means that it is set to a fraction of the system memory
+        static void setMaxMemory(int64_t bytes) {
+            maxMemory = bytes;
+        }
+
+        static int64_t getMaxMemory() {
+            return maxMemory;
+        }
+
+        //Largest ID in the triples, or -1 if it is not known. It sets the
+        //number of bytes per term in the in-memory records: 5 up to 2^40,
+        //6 up to 2^48 and 8 otherwise (or if it is not known)
+        static void setMaxTermID(int64_t id) {
+            maxTermID = id;
+        }
+
+        static int64_t getMaxTermID() {
+            return maxTermID;
+        }
+
+        static int getTermBytes();
+
+        //The unsorted triples of dir are read from the binary files in
+        //input instead of the files in dir. It is used by the next sort of
+        //dir only.
+        static void setBinaryInput(std::string dir,
+                std::shared_ptr<BinaryTriples> input) {
+            binaryInputDir = dir;
+            binaryInput = input;
+        }
+
+        static bool hasBinaryInput() {
+            return binaryInput != NULL;
+        }
+
         /*static void sortChunks(string inputdir,
                 int maxReadingThreads,
                 int parallelProcesses,
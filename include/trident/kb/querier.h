@@ -283,6 +283,10 @@ class Querier {
         std::string pathRawData;
         bool copyRawData;
 
+        //Read-ahead of the scans (see Prefetcher)
+        int scanPrefetchTables;
+        int64_t scanPrefetchBytes;
+
         // const int nindices;
 
         std::vector<std::unique_ptr<DiffIndex>> &diffIndices;
@@ -309,6 +313,8 @@ class Querier {
         Factory<NewColumnTable> ncFactory;
         FactoryNewRowTable nrFactory;
         FactoryNewClusterTable ncluFactory;
+        Factory<ComprColumnTable> ccFactory;
+        Factory<EFColumnTable> efFactory;
 
         StorageStrat strat;
 
@@ -406,6 +412,25 @@ class Querier {
             return &strat;
         }
 
+        TableStorage *getTableStorage(const int perm) {
+            return files[perm];
+        }
+
+        //Max number of tables and of bytes that a scan reads ahead. If
+        //ntables is 0, the read-ahead is disabled.
+        void setScanPrefetch(const int ntables, const int64_t nbytes) {
+            scanPrefetchTables = ntables;
+            scanPrefetchBytes = nbytes;
+        }
+
+        int getScanPrefetchTables() {
+            return scanPrefetchTables;
+        }
+
+        int64_t getScanPrefetchBytes() {
+            return scanPrefetchBytes;
+        }
+
         bool isPresent(int idx) {
             return present[idx];
         }
@@ -501,6 +526,11 @@ class Querier {
             return tot;
         }
 
+        //Used by the scans to switch the mapping hints of a permutation
+        void beginScan(const int perm);
+
+        void endScan(const int perm);
+
         uint64_t getNFirstTablesPerPartition(const int idx) {
             uint64_t output = nFirstTablesPerPartition[idx];
             if (!diffIndices.empty()) {
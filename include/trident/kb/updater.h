@@ -36,6 +36,7 @@ class Querier;
 class PairItr;
 class KB;
 class DictMgmt;
+class Inserter;
 class Updater {
     private:
 
@@ -75,6 +76,13 @@ class Updater {
             int leno;
         };
 
+        void compressTriples(DiffIndex::TypeUpdate type,
+                string updatedir,
+                KB *kb,
+                ByteArrayToNumberMap &tmpdict,
+                StringCollection &tmpdictsupport,
+                std::vector<Triple> &output);
+
         void compressUpdate(DiffIndex::TypeUpdate type,
                 string updatedir,
                 std::vector<uint64_t> &all_s,
@@ -124,9 +132,62 @@ class Updater {
 
         static void writeDict(DictMgmt *dictmgmt, string updatedir, ByteArrayToNumberMap &dict);
 
+        static Triple reorder(const int perm, const Triple &t);
+
+        //Merges the update with the tables of the keys that receive new
+        //triples. deadrows is increased by the rows of the tables that
+        //are replaced
+        static int64_t mergePermutation(const int perm,
+                std::vector<Triple> &triples,
+                Querier *q,
+                const int64_t firstNewID,
+                std::string output,
+                int64_t &newtables,
+                int64_t &newfirstels,
+                int64_t &deadrows);
+
+        //Merges the update with all the rows of the permutation, so that
+        //the permutation can be rewritten without the replaced tables
+        static int64_t mergeAllPermutation(const int perm,
+                std::vector<Triple> &triples,
+                Querier *q,
+                std::string output,
+                int64_t &newtables,
+                int64_t &newfirstels);
+
+        static void appendPermutation(const int perm,
+                std::string input,
+                std::string storagedir,
+                bool newStorage,
+                Inserter *ins,
+                const int64_t newtables,
+                const int64_t newfirstels);
+
+        //Returns the id of the last table file in the directory, or -1
+        static int getLastFileId(std::string dir);
+
+        static void copyPath(std::string from, std::string to);
+
+        static void readAppendStats(std::string kbdir, int64_t *deadrows);
+
+        static void writeAppendStats(std::string kbdir, const int64_t *deadrows);
+
+        //Copies the parts of the KB that the append changes in place
+        static void beginAppendJournal(std::string kbdir, const bool *present);
+
+        static void endAppendJournal(std::string kbdir);
+
     public:
         LIBEXP void creatediffupdate(DiffIndex::TypeUpdate type, std::string kbdir, std::string updatedir);
 
+        //Adds the triples directly to the permutations of the KB. Only the
+        //tables of the keys that receive new triples are rewritten
+        LIBEXP void appendupdate(std::string kbdir, std::string updatedir);
+
+        //Brings the KB back to its state before an append that did not
+        //complete. Does nothing if there is no such append
+        LIBEXP static void recoverAppend(std::string kbdir);
+
         LIBEXP static std::string getPathForUpdate(std::string kbdir);
 };
 #endif
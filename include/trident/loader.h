@@ -26,6 +26,7 @@
 #include <trident/kb/kb.h>
 #include <trident/tree/coordinates.h>
 #include <trident/kb/inserter.h>
+#include <trident/utils/parallel.h>
 
 #include <kognac/filemerger.h>
 #include <kognac/sorter.h>
@@ -37,6 +38,7 @@
 
 #include <mutex>
 #include <condition_variable>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -96,6 +98,17 @@ class TreeWriter: public TreeInserter {
             fos.write(supportBuffer, 23);
         }
 
+        //Copies the entries written by another writer in "path", shifting
+        //the IDs of the files by "fileOffset"
+        void addEntries(string path, short fileOffset) {
+            ifstream fis(path, ios_base::binary);
+            while (fis.read(supportBuffer, 23)) {
+                short file = Utils::decode_short(supportBuffer, 16);
+                Utils::encode_short(supportBuffer, 16, file + fileOffset);
+                fos.write(supportBuffer, 23);
+            }
+        }
+
         void finish() {
             fos.close();
         }
@@ -224,6 +237,17 @@ struct ParamInsert {
     bool deletePreviousExt;
 };
 
+//Key range of a permutation that is built by its own inserter
+struct InsertRange {
+    string input; //Triples of the range
+    string storageDir; //Directory of the tables
+    string treeFile; //Coordinates of the tables
+    TableStorage *files[N_PARTITIONS];
+    int64_t ntables[N_PARTITIONS];
+    int64_t nFirstEls[N_PARTITIONS];
+    int nfiles; //Files created by the range (numbered from 0)
+};
+
 class L_Triple {
     public:
         uint64_t first, second, third;
@@ -398,6 +422,9 @@ struct ParamsLoad {
     bool sample;
     double sampleRate;
     int thresholdSkipTable;
+    string blockCompression;
+    int64_t thresholdBlockCompression;
+    int64_t thresholdEFDirectory;
     string remoteLocation;
     int64_t limitSpace;
     string graphTransformation;
@@ -405,6 +432,12 @@ struct ParamsLoad {
     bool storeDicts;
     bool relsOwnIDs;
     bool flatTree;
+    bool staticTree;
+    bool radixSort;
+    int64_t maxMemory;
+    int mergeFanIn;
+    bool pipelineIndices;
+    string profile;
 
     ParamsLoad() {
         /**** DEFAULT VALUES ****/
@@ -430,6 +463,9 @@ struct ParamsLoad {
         sample = true;
         sampleRate = 0.01;
         thresholdSkipTable = 20;
+        blockCompression = "none";
+        thresholdBlockCompression = 100000;
+        thresholdEFDirectory = 0;
         remoteLocation = "";
         limitSpace = 0;
         graphTransformation = "";
@@ -437,6 +473,12 @@ struct ParamsLoad {
         storeDicts = true;
         relsOwnIDs = false;
         flatTree = false;
+        staticTree = false;
+        radixSort = true;
+        maxMemory = 0;
+        mergeFanIn = 4;
+        pipelineIndices = true;
+        profile = "";
     }
 
     std::string tostring() {
@@ -463,6 +505,9 @@ struct ParamsLoad {
         output += ";sample=" + to_string(sample);
         output += ";sampleRate=" + to_string(sampleRate);
         output += ";thresholdSkipTable=" + to_string(thresholdSkipTable);
+        output += ";blockCompression=" + blockCompression;
+        output += ";thresholdBlockCompression=" + to_string(thresholdBlockCompression);
+        output += ";thresholdEFDirectory=" + to_string(thresholdEFDirectory);
         output += ";remoteLocation=" + remoteLocation;
         output += ";limitSpace=" + to_string(limitSpace);
         output += ";graphTransformation=" + graphTransformation;
@@ -470,6 +515,12 @@ struct ParamsLoad {
         output += ";storeDicts=" + to_string(storeDicts);
         output += ";relsOwnIDs=" + to_string(relsOwnIDs);
         output += ";flatTree=" + to_string(flatTree);
+        output += ";staticTree=" + to_string(staticTree);
+        output += ";radixSort=" + to_string(radixSort);
+        output += ";maxMemory=" + to_string(maxMemory);
+        output += ";mergeFanIn=" + to_string(mergeFanIn);
+        output += ";pipelineIndices=" + to_string(pipelineIndices);
+        output += ";profile=" + profile;
         return output;
     }
 };
@@ -478,6 +529,25 @@ class Loader {
     private:
         bool printStats;
 
+        //Maximum number of sorted files that are merged in one pass
+        static int mergeFanIn;
+
+        //Produce the next permutation while the current one is inserted
+        static bool pipelineIndices;
+
+        //Memory budget (in MB) of the load. It is shared by the merges,
+        //also the ones that run in parallel, and by the sorting and the
+        //insertion of the pipelined permutations. NULL if not set
+        static std::unique_ptr<TokenBudget> memoryBudget;
+
+        //Writes the JSON report and the trace of the loading, if requested
+        static void writeLoadProfile(ParamsLoad &p);
+
+        //Part of the memory budget that goes to the insertion. If the
+        //permutations are pipelined, the rest is used to sort and merge
+        //the next one
+        static int64_t getInsertMemory(int64_t budget, bool pipeline);
+
     public:
         static void generateNewPermutation(string outputdir,
                 string inputdir,
@@ -514,6 +584,18 @@ class Loader {
                     string out,
                     char sorter);
 
+        static void setMergeFanIn(int fanIn) {
+            mergeFanIn = fanIn;
+        }
+
+        static void setPipelineIndices(bool enabled) {
+            pipelineIndices = enabled;
+        }
+
+        static void setMemoryBudget(int64_t mb) {
+            memoryBudget.reset(mb > 0 ? new TokenBudget(mb) : NULL);
+        }
+
         static void mergeDiskFragments(ParamsMergeDiskFragments params);
 
         static void insert(ParamInsert params);
@@ -546,6 +628,12 @@ class Loader {
 
         static BufferCoordinates *getBunchTermCoordinates(SharedStructs *structs);
 
+        static void insertRange(InsertRange *range, const int permutation,
+                Inserter *ins, std::mutex &insMutex, const bool canSkipTables);
+
+        static void stitchRanges(std::vector<InsertRange*> &ranges,
+                const int permutation, Inserter *ins, TreeWriter *treeWriter);
+
         static void releaseBunchTermCoordinates(BufferCoordinates *cord,
                 SharedStructs *structs);
 
@@ -670,7 +758,8 @@ class Loader {
                 int64_t limitSpace);
 
         static void createPermsAndDictsFromFiles_seq(DiskReader *reader,
-                DiskLZ4Writer *writer, int id, int64_t *output);
+                DiskLZ4Writer *writer, int id, int64_t *output,
+                int64_t *maxTerm);
 
         static int64_t createPermsAndDictsFromFiles(
                 string inputtriples,
@@ -694,6 +783,14 @@ class Loader {
                 int maxReadingThreads,
                 int parallelProcesses);
 
+        //If the RDF input is made of files that can be decompressed in
+        //parallel (BGZF or LZ4), it rewrites them in one gzip file per
+        //thread so that the parser uses all threads even with one input
+        //file. Returns the input to give to the parser.
+        static string splitCompressedInput(string input,
+                string tmpDir,
+                int nthreads);
+
         static void generateNewPermutation_seq(MultiDiskLZ4Reader *reader,
                 MultiDiskLZ4Writer *writer,
                 int idx,
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _RESULTSWRITER_H
+#define _RESULTSWRITER_H
+
+#include <trident/utils/httpserver.h>
+#include <trident/utils/json.h>
+
+#include <rts/operator/ResultsPrinter.hpp>
+
+#include <string>
+#include <vector>
+
+//Encodes the results of a SPARQL query in one of the standard formats and
+//streams them to the client with the chunked transfer encoding
+class SPARQLResultsWriter : public ResultsWriter {
+    public:
+        enum Format { JSONFORMAT, TSVFORMAT, CSVFORMAT };
+
+    private:
+        //A term in N-Triples syntax, split in its components
+        struct Term {
+            enum Kind { UNBOUND, URI, BNODE, LITERAL };
+            Kind kind;
+            const char *value;
+            size_t valueLen;
+            const char *lang;
+            size_t langLen;
+            const char *datatype;
+            size_t datatypeLen;
+        };
+
+        HttpChunkedWriter &out;
+        const Format format;
+        std::vector<std::string> vars;
+        std::string row;
+        bool started;
+        bool firstRow;
+
+        static void parseTerm(const std::string &term, Term &t);
+
+        static void appendJSON(std::string &out, const char *s, size_t len);
+
+        static void appendTSV(std::string &out, const std::string &term);
+
+        static void appendCSV(std::string &out, const char *s, size_t len);
+
+        void appendJSONRow(const std::vector<std::string> &values);
+
+    public:
+        SPARQLResultsWriter(HttpChunkedWriter &out, Format format);
+
+        //Returns the content type of the response
+        static std::string getContentType(Format format);
+
+        bool begin(const std::vector<std::string> &vars);
+
+        bool writeRow(const std::vector<std::string> &values);
+
+        //Closes the document. The statistics are added only to the JSON
+        //output
+        bool end(JSON *stats);
+
+        bool isStarted() const {
+            return started;
+        }
+};
+
+#endif
@@ -5,6 +5,8 @@
 
 #include <trident/utils/json.h>
 #include <trident/utils/httpserver.h>
+#include <trident/server/resultswriter.h>
+#include <trident/sparql/plancache.h>
 
 #include <layers/TridentLayer.hpp>
 
@@ -30,14 +32,31 @@ class TridentServer {
         int webport;
         std::shared_ptr<HttpServer> server;
         int nthreads;
+        //Max. n. of threads that execute a single query
+        int queryThreads;
+        //Plans of the queries, shared by all requests
+        PlanCache planCache;
+        //Max. n. of requests waiting for a thread
+        size_t maxQueuedRequests;
+        //Requests that wait longer (ms) are rejected
+        uint64_t requestTimeout;
 
         void startThread(int port);
 
-        void processRequest(std::string req, std::string &resp);
+        void processRequest(std::string req, std::string &resp,
+                HttpChunkedWriter &writer);
+
+        //The format of the results, from the request or its Accept header
+        static SPARQLResultsWriter::Format getFormat(const string &req,
+                const string &form);
 
     public:
         //OK
-        TridentServer(KB &kb, string htmlfiles, int nthreads = 1);
+        TridentServer(KB &kb, string htmlfiles, int nthreads = 1,
+                int queryThreads = 1,
+                size_t planCacheSize = PLANCACHE_DEFAULT_SIZE,
+                size_t maxQueuedRequests = HTTPSERVER_MAX_QUEUED_REQUESTS,
+                uint64_t requestTimeout = HTTPSERVER_REQUEST_TIMEOUT);
 
         //OK
         void start(int port);
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _PLANCACHE_H
+#define _PLANCACHE_H
+
+#include <cts/infra/QueryGraph.hpp>
+#include <cts/plangen/Plan.hpp>
+#include <cts/plangen/PlanGen.hpp>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#define PLANCACHE_DEFAULT_SIZE 1000
+
+//Caches the plans of the SPARQL queries. Queries that differ only in the
+//constants of their triple patterns share the same entry: the plan that was
+//computed for the first one is re-used for the others. The cache is emptied
+//when the KB changes (see KB::getUpdateVersion()).
+class PlanCache {
+    public:
+        struct Entry {
+            //The graph the plan refers to
+            std::shared_ptr<QueryGraph> graph;
+            //Owns the plans
+            std::shared_ptr<PlanGen> plangen;
+            Plan *plan;
+        };
+
+    private:
+        const size_t maxEntries;
+        std::mutex lock;
+        //The most recently used entries are at the front
+        std::list<std::pair<std::string, std::shared_ptr<const Entry>>> entries;
+        std::unordered_map<std::string,
+            std::list<std::pair<std::string, std::shared_ptr<const Entry>>>::iterator> index;
+        uint64_t kbVersion;
+        uint64_t hits, misses;
+
+        void checkVersion(const uint64_t version);
+
+        static bool isSimpleGraph(const QueryGraph &graph);
+
+        static Plan *copyPlan(const Plan *plan, const QueryGraph &from,
+                const QueryGraph &to, PlanContainer &container);
+
+    public:
+        PlanCache(size_t maxEntries = PLANCACHE_DEFAULT_SIZE) :
+            maxEntries(maxEntries), kbVersion(0), hits(0), misses(0) {
+            }
+
+        //Computes the key of the query. Returns false if the plans of the
+        //query cannot be cached (only queries made of triple patterns can)
+        static bool getKey(const QueryGraph &graph, std::string &key);
+
+        //Returns true if the plan only contains operators that can be
+        //moved to another graph
+        static bool canCache(const Plan *plan);
+
+        //Returns a copy of the plan of the entry that refers to the nodes
+        //of another graph with the same key. The copy is allocated in
+        //the container
+        static Plan *rebind(const Entry &entry, const QueryGraph &graph,
+                PlanContainer &container);
+
+        std::shared_ptr<const Entry> get(const std::string &key,
+                const uint64_t version);
+
+        void put(const std::string &key, const uint64_t version,
+                std::shared_ptr<const Entry> entry);
+
+        void clear();
+
+        size_t size();
+
+        uint64_t getHits();
+
+        uint64_t getMisses();
+};
+
+#endif
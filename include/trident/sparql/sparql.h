@@ -2,14 +2,58 @@
 #define _SPARQL_H
 
 #include <trident/utils/json.h>
+#include <trident/sparql/plancache.h>
 
 #include <layers/TridentLayer.hpp>
 #include <cts/infra/QueryGraph.hpp>
 #include <cts/parser/SPARQLParser.hpp>
 #include <rts/runtime/QueryDict.hpp>
 
+#include <chrono>
+
+class ResultsWriter;
+
 class SPARQLUtils {
     public:
+        //A query that was parsed and optimized. It can be executed several
+        //times (one at the time) without repeating these steps
+        class PreparedQuery {
+            private:
+                friend class SPARQLUtils;
+
+                std::unique_ptr<QueryDict> queryDict;
+                std::shared_ptr<QueryGraph> queryGraph;
+                std::vector<std::string> variables;
+                //Owns the plan if it was not taken from the cache
+                std::shared_ptr<PlanGen> plangen;
+                //Owns the plan if it was taken from the cache
+                PlanContainer cachedPlans;
+                Plan *plan;
+                bool parsed;
+                bool cachedPlan;
+
+            public:
+                PreparedQuery() : plan(NULL), parsed(false),
+                cachedPlan(false) {
+                }
+
+                bool isParsed() const {
+                    return parsed;
+                }
+
+                bool isPlanned() const {
+                    return plan != NULL;
+                }
+
+                bool isPlanCached() const {
+                    return cachedPlan;
+                }
+
+                const std::vector<std::string> &getVariables() const {
+                    return variables;
+                }
+        };
+
         static void parseQuery(bool &success,
                 SPARQLParser &parser,
                 std::unique_ptr<QueryGraph> &queryGraph,
@@ -24,7 +68,43 @@ class SPARQLUtils {
                 bool jsonoutput,
                 JSON *jsonvars,
                 JSON *jsonresults,
-                JSON *jsonstats);
+                JSON *jsonstats,
+                unsigned threads = 1,
+                PlanCache *cache = NULL,
+                ResultsWriter *writer = NULL);
+
+        //Parses and optimizes the query. If a cache is given, the plan of
+        //a previous query with the same shape is re-used
+        static std::shared_ptr<PreparedQuery> prepareQuery(string sparqlquery,
+                int64_t nterms,
+                TridentLayer &db,
+                PlanCache *cache = NULL);
+
+        static void execPreparedQuery(PreparedQuery &query,
+                TridentLayer &db,
+                bool printstdout,
+                bool jsonoutput,
+                JSON *jsonvars,
+                JSON *jsonresults,
+                JSON *jsonstats,
+                unsigned threads = 1,
+                ResultsWriter *writer = NULL) {
+            execPreparedQuery(query, db, printstdout, jsonoutput, jsonvars,
+                    jsonresults, jsonstats, threads, writer,
+                    std::chrono::system_clock::now());
+        }
+
+    private:
+        static void execPreparedQuery(PreparedQuery &query,
+                TridentLayer &db,
+                bool printstdout,
+                bool jsonoutput,
+                JSON *jsonvars,
+                JSON *jsonresults,
+                JSON *jsonstats,
+                unsigned threads,
+                ResultsWriter *writer,
+                std::chrono::system_clock::time_point start);
 };
 
 #endif
@@ -26,6 +26,7 @@
 #include <trident/iterators/tupleiterators.h>
 #include <trident/iterators/pairitr.h>
 #include <vector>
+#include <memory>
 
 class Tuple;
 class Querier;
@@ -46,11 +47,20 @@ private:
     bool nextOutcome;
     size_t processedValues;
 
+    //Rows are read from the physical iterator in batches
+    std::unique_ptr<int64_t[]> batch;
+    int64_t *batchValues[3];
+    size_t batchSize, batchPos;
+
     bool checkFields();
 
+    bool advance();
+
 public:
     TupleKBItr();
 
+    //Notice that the physical iterator is ahead of this one, since the
+    //rows are read in batches
     PairItr *getPhysicalIterator() {
         return physIterator;
     }
@@ -31,6 +31,7 @@
 #include <list>
 #include <string>
 #include <deque>
+#include <vector>
 
 class Node;
 class TreeContext;
@@ -51,6 +52,12 @@ private:
     char supportBuffer2[SIZE_SUPPORT_BUFFER];
 
     LeafFactory *factory;
+
+#ifdef MT
+    std::vector<Node*> reclaimed;
+
+    void retireNode(Node *node);
+#endif
 public:
 
     Cache(int maxNodesInCache, bool compressedNodes) :
@@ -64,7 +71,7 @@ public:
 
     void init(TreeContext *context, std::string path, int fileMaxSize,
               int maxNFiles, int64_t cacheMaxSize, int sizeLeavesFactory,
-              int sizePreallLeavesFactory, int nodeMinBytes);
+              int sizePreallLeavesFactory, int nodeMinBytes, int mappingHints);
 
     Node *getNodeFromCache(int64_t id);
 
@@ -86,19 +93,7 @@ public:
 
     void flushAllCache();
 
-    ~Cache() {
-        Node *node = NULL;
-        while (!registeredNodes.empty()) {
-            node = registeredNodes.front();
-            registeredNodes.pop_front();
-            if (node->shouldDeallocate())
-                delete node;
-        }
-        registeredNodes.clear();
-
-        delete factory;
-        delete manager;
-    }
+    ~Cache();
 };
 
 #endif /* CACHE_H_ */
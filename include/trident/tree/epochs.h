@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef EPOCHS_H_
+#define EPOCHS_H_
+
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <inttypes.h>
+
+#define EPOCH_MAX_READERS 256
+
+class Node;
+
+/* Epoch-based reclamation of the nodes of a read-only tree. Readers announce
+ * the epoch in which they started (enter/exit, or EpochGuard) and never take
+ * a lock. A node that is evicted from the cache is first unlinked from its
+ * parent and then retired: it is given back to the factory only once all
+ * readers that could have seen it are gone. Retiring and reclaiming must be
+ * done while holding the mutex of the tree. */
+class EpochManager {
+    private:
+        struct Slot {
+            std::atomic<uint64_t> epoch; //0 means free
+            char padding[64 - sizeof(std::atomic<uint64_t>)];
+        };
+
+        std::atomic<uint64_t> globalEpoch;
+        Slot slots[EPOCH_MAX_READERS];
+        std::deque<std::pair<uint64_t, Node*>> retired;
+
+        uint64_t minActiveEpoch();
+
+    public:
+        EpochManager();
+
+        //Returns the slot that must be passed to exit()
+        int enter();
+
+        void exit(int slot) {
+            slots[slot].epoch.store(0, std::memory_order_release);
+        }
+
+        void retire(Node *node);
+
+        //Moves in out the retired nodes that no reader can access anymore
+        void collect(std::vector<Node*> &out);
+
+        //Moves in out all retired nodes. Only when there are no readers.
+        void collectAll(std::vector<Node*> &out);
+};
+
+class EpochGuard {
+    private:
+        EpochManager &manager;
+        const int slot;
+
+    public:
+        EpochGuard(EpochManager &manager) : manager(manager),
+        slot(manager.enter()) {
+        }
+
+        ~EpochGuard() {
+            manager.exit(slot);
+        }
+};
+
+#endif
@@ -34,7 +34,7 @@ private:
 
     Node *updateChildren(Node *split, int p,
                          void (*insertAverage)(Node*, int p, Node*, Node*));
-    void ensureChildIsLoaded(int p);
+    Node *ensureChildIsLoaded(int p);
 
 public:
 
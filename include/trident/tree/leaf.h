@@ -55,6 +55,8 @@ private:
 
     Coordinates *parseInternalLine(const int pos);
 
+    void decodeInternalLine(const int pos, TermCoordinates *value);
+
     Node *insertAtPosition(int p, tTerm *key, int sizeKey, nTerm value);
 
     Node *insertAtPosition(int p, nTerm key, int64_t coordinates);
@@ -88,7 +88,8 @@ private:
 
 public:
     NodeManager(TreeContext *context, int nodeMinBytes, int fileMaxSize,
-                int maxNFiles, int64_t cacheMaxSize, std::string path);
+                int maxNFiles, int64_t cacheMaxSize, std::string path,
+                int mappingHints);
 
     char* get(CachedNode *node);
 
@@ -52,7 +52,8 @@ typedef enum params {
     LEAF_ARRAYS_FACTORY_SIZE,
     LEAF_ARRAYS_PREALL_FACTORY_SIZE,
     NODE_KEYS_FACTORY_SIZE,
-    NODE_KEYS_PREALL_FACTORY_SIZE
+    NODE_KEYS_PREALL_FACTORY_SIZE,
+    MAPPING_HINTS //Flags used to map the files of a read-only tree
 } TreeParams;
 
 class Root {
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _STATICROOT_H
+#define _STATICROOT_H
+
+#include <trident/tree/root.h>
+#include <trident/utils/memoryfile.h>
+
+#include <memory>
+#include <string>
+
+//Number of keys in a node (i.e., one cache line)
+#define STATICTREE_NODE_KEYS 8
+#define STATICTREE_FANOUT (STATICTREE_NODE_KEYS + 1)
+#define STATICTREE_MAX_LAYERS 24
+#define STATICTREE_HEADER_SIZE 256
+#define STATICTREE_VERSION 1
+//Size of the coordinates of one permutation in a record
+#define STATICTREE_PERM_SIZE 13
+
+/*
+ * Read-only version of the tree that maps every term to the coordinates of
+ * its tables. It is built once from a Root and then mapped from disk. The
+ * keys are stored in a static B+-tree: every node is a cache line with
+ * STATICTREE_NODE_KEYS sorted keys and the nodes of each layer are stored
+ * one after the other, so the children of the j-th node of a layer are the
+ * nodes j * STATICTREE_FANOUT ... j * STATICTREE_FANOUT + NODE_KEYS of the
+ * next layer. The i-th key of an internal node is the smallest key under
+ * its child i + 1, and the missing keys are set to INT64_MAX. A lookup
+ * counts the keys that are not larger than the term in one node per layer
+ * (with AVX2 if available) and never follows a pointer.
+ *
+ * Layout:
+ * <header (STATICTREE_HEADER_SIZE bytes): version, number of keys, number
+ * of layers, position of the offsets, position of the records, index of
+ * the first node of each layer (from the root)>
+ * <nodes (64 bytes each)> <offset of each record (8 bytes)> <records>
+ * The last layer contains all the keys in order. A record is a byte with
+ * the permutations that exist, followed by the number of elements (5
+ * bytes), the strategy (1 byte), the file (2 bytes) and the position (5
+ * bytes) of each of them.
+ */
+class StaticRoot: public Root {
+    private:
+        std::unique_ptr<MemoryMappedFile> file;
+        const char *raw;
+        int64_t nKeys;
+        int nLayers;
+        const int64_t *layers[STATICTREE_MAX_LAYERS];
+        const char *offsets;
+        const char *records;
+        const bool useAVX2;
+
+        //Returns the position of the key, or -1 if it does not exist
+        int64_t find(const nTerm key) const;
+
+    public:
+        StaticRoot(std::string path);
+
+        bool get(nTerm key, TermCoordinates *value);
+
+        TreeItr *itr();
+
+        //Writes in "path" the static version of the tree
+        static void build(Root *root, std::string path);
+
+        static void readRecord(const char *record, TermCoordinates *value);
+
+        ~StaticRoot();
+};
+
+#endif
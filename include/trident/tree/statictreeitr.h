@@ -0,0 +1,60 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _STATICTREEITR_H
+#define _STATICTREEITR_H
+
+#include <trident/tree/treeitr.h>
+#include <trident/tree/staticroot.h>
+
+#include <cstring>
+
+class StaticTreeItr: public TreeItr {
+    private:
+        const int64_t *keys;
+        const char *offsets;
+        const char *records;
+        const int64_t nKeys;
+        int64_t idx;
+
+    public:
+        StaticTreeItr(const int64_t *keys, const char *offsets,
+                const char *records, int64_t nKeys) : keys(keys),
+        offsets(offsets), records(records), nKeys(nKeys), idx(0) {}
+
+        bool hasNext() {
+            return idx < nKeys;
+        }
+
+        int64_t next(TermCoordinates *value) {
+            if (idx < nKeys) {
+                uint64_t offset;
+                memcpy(&offset, offsets + idx * 8, 8);
+                StaticRoot::readRecord(records + offset, value);
+                return keys[idx++];
+            } else {
+                return 0;
+            }
+        }
+};
+
+#endif
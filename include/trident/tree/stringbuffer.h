@@ -36,6 +36,7 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <deque>
 #include <condition_variable>
 
 struct eqint {
@@ -52,7 +53,11 @@ struct hashint {
 
 class StringBuffer {
 private:
-    static char FINISH_THREAD[1];
+    struct BlockToCompress {
+        int64_t id;
+        char *buffer;
+        int size;
+    };
 
     Stats *stats;
     std::string dir;
@@ -70,22 +75,18 @@ private:
 
     std::fstream sb;
 
-    //Used by the compression thread
+    //Used by the compression threads. The blocks are compressed in
+    //parallel, but they are written in the order they were filled
     std::mutex fileLock;
-    char *bufferToCompress;
-    int sizeBufferToCompress;
+    std::deque<BlockToCompress> blocksToCompress;
+    int64_t nQueuedBlocks;
+    int64_t nWrittenBlocks;
+    int maxPendingBlocks;
+    bool stopCompression;
 
     std::condition_variable compressWait;
     std::mutex _compressMutex;
-    std::thread compressionThread;
-
-    //Used to check for termination
-    std::condition_variable compressTerm;
-    std::mutex _compressTerm;
-    bool threadRunning;
-    bool isThreadFinished() {
-        return !threadRunning;
-    }
+    std::vector<std::thread> compressionThreads;
 
     std::mutex sizeLock;
 
@@ -129,7 +130,7 @@ private:
 
 public:
     StringBuffer(string dir, bool readOnly, int factorySize, int64_t cacheSize,
-                 Stats *stats);
+                 Stats *stats, int nCompressionThreads = 1);
 
     int64_t getSize();
 
@@ -25,6 +25,7 @@
 
 #include <trident/tree/intermediatenode.h>
 #include <trident/tree/leaf.h>
+#include <trident/tree/epochs.h>
 
 #include <kognac/factory.h>
 
@@ -49,6 +50,7 @@ private:
 
 #ifdef MT
     std::recursive_mutex mutex;
+    EpochManager epochs;
 #endif
 
 public:
@@ -113,6 +115,10 @@ public:
     std::recursive_mutex &getMutex() {
         return mutex;
     }
+
+    EpochManager &getEpochs() {
+        return epochs;
+    }
 #endif
 };
 
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _BLOCKCODEC_H
+#define _BLOCKCODEC_H
+
+#include <trident/kb/consts.h>
+
+#include <inttypes.h>
+#include <stddef.h>
+
+/*
+ * Codecs for the blocks of the compressed tables. A block contains up to
+ * COMPR_BLOCK_ROWS rows sorted by (v1, v2). Before compression the rows
+ * are transformed: the first column is stored as the difference with the
+ * previous row, the second one as the difference with the previous row
+ * only if the first column did not change. Then,
+ * - BLOCKCODEC_PFOR bit-packs each column with the number of bits that
+ *   minimizes the size of the block, storing the values that do not fit
+ *   as exceptions (patched frame-of-reference);
+ * - BLOCKCODEC_LZ4 writes the two columns with the smallest number of
+ *   bytes that fits all the values of the block, and compresses them with
+ *   LZ4.
+ * Every block is self-contained and can be decoded independently.
+ */
+class BlockCodec {
+    private:
+        static size_t packPFOR(const uint64_t *in, const size_t n, char *out);
+
+        static const char *unpackPFOR(const char *in, const size_t n,
+                int64_t *out);
+
+    public:
+        //Upper bound to the size of an encoded block of n rows
+        LIBEXP static size_t maxEncodedSize(const size_t n);
+
+        //Size of the buffer passed to decode()
+        LIBEXP static size_t scratchSize(const size_t n);
+
+        //Encode n rows in out. Returns the number of bytes written.
+        LIBEXP static size_t encode(const int codec, const int64_t *v1,
+                const int64_t *v2, const size_t n, char *out);
+
+        //Decode the n rows encoded in [in, in + len). "scratch" is a
+        //buffer of scratchSize(n) bytes.
+        LIBEXP static void decode(const int codec, const char *in,
+                const size_t len, const size_t n, int64_t *v1, int64_t *v2,
+                char *scratch);
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _ELIASFANO_H
+#define _ELIASFANO_H
+
+#include <trident/kb/consts.h>
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include <vector>
+
+//Every how many ones (zeros) of the upper bits the position is sampled
+#define EF_SAMPLING 256
+
+/*
+ * Elias-Fano encoding of a non-decreasing sequence of n integers. Each
+ * value is split in l low bits, stored verbatim, and in the high part,
+ * stored in unary in a bitvector where the i-th value sets the bit
+ * (high + i). The positions of every EF_SAMPLING-th one and zero of the
+ * bitvector are sampled, so that select() and nextGEQ() only scan a few
+ * words. The space is about n * (2 + log(universe / n)) bits.
+ *
+ * Layout (64-bit little-endian words): n, l, largest high part, number of
+ * words of the low bits, of the high bits, of the samples of the ones and
+ * of the samples of the zeros, followed by the four arrays in this order.
+ *
+ * A reader is bound to a buffer with init(). It remembers the last
+ * position returned by select(), so that reading the values in order
+ * costs O(1) each.
+ */
+class EliasFano {
+    private:
+        const char *data;
+        uint64_t n;
+        uint8_t l;
+        uint64_t maxHigh;
+        uint64_t nlower, nupper, nsamples1, nsamples0;
+        const char *lower;
+        const char *upper;
+        const char *samples1;
+        const char *samples0;
+
+        //Last position in the high bits found by select()
+        uint64_t lastIdx, lastPos;
+
+        static uint64_t readWord(const char *p, const uint64_t idx);
+
+        uint64_t getLow(const uint64_t i) const;
+
+        //Position of the first one at or after pos (the bitvector must
+        //contain one)
+        uint64_t nextOne(uint64_t pos) const;
+
+        //Position of the k-th one (zero) of the high bits
+        uint64_t select1(const uint64_t k) const;
+
+        uint64_t select0(const uint64_t k) const;
+
+    public:
+        EliasFano() : data(NULL), n(0) {
+        }
+
+        //Writes the encoding of the n values in "out"
+        LIBEXP static void encode(const uint64_t *values, const uint64_t n,
+                std::vector<uint64_t> &out);
+
+        LIBEXP void init(const char *data);
+
+        //Number of bytes occupied by the encoding
+        LIBEXP size_t sizeInBytes() const;
+
+        uint64_t size() const {
+            return n;
+        }
+
+        //Returns the i-th value
+        LIBEXP uint64_t select(const uint64_t i);
+
+        //Returns the index of the first value not smaller than x, or
+        //size() if there is none
+        LIBEXP uint64_t nextGEQ(const uint64_t x);
+};
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _FIXEDBYTES_H
+#define _FIXEDBYTES_H
+
+#include <trident/kb/consts.h>
+
+#include <inttypes.h>
+#include <stddef.h>
+
+/*
+ * Block decoders for the fixed-width columns used in the binary tables.
+ * Every value occupies nbytes (1..8) and is stored in big-endian order,
+ * i.e., the same format read by Utils::decode_longFixedBytes.
+ */
+class FixedBytesDecoder {
+    public:
+        //Decode n consecutive values starting at "in" and write them in
+        //"out". "limit" marks the end of the readable memory: the vectorized
+        //kernels load more bytes than they need, so they are used only
+        //as long as these loads stay before "limit". The remaining values
+        //are decoded with the scalar code.
+        LIBEXP static void decode(const char *in, const char *limit,
+                const uint8_t nbytes, int64_t *out, const size_t n);
+
+        //Same as above, but always uses the scalar code. It is the reference
+        //for the vectorized kernels
+        LIBEXP static void decode_scalar(const char *in, const uint8_t nbytes,
+                int64_t *out, const size_t n);
+
+        LIBEXP static bool hasAVX2();
+
+        LIBEXP static bool hasSSSE3();
+};
+
+#endif
@@ -5,74 +5,214 @@
 
 #include <string>
 #include <thread>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 #include <inttypes.h>
 
+#define HTTPSERVER_MAX_QUEUED_REQUESTS 1024
+#define HTTPSERVER_REQUEST_TIMEOUT 30000 //ms
+
 #if defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
 #include <sys/socket.h>
 #include <sys/select.h>
 #include <poll.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <strings.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
-class HttpServer {
+//Sends a response with the chunked transfer encoding, so that the body can
+//be written while it is produced. The data is buffered and sent in chunks
+//of (at least) chunkSize bytes. The writes wait until the client has read
+//the previous data, therefore a slow client slows down whoever writes it.
+class HttpChunkedWriter {
     private:
-        class Socket {
-            private:
-                int connFd;
-                bool eof;
-                bool toBeClosed;
+        int connFd;
+        bool keepAlive;
+        uint64_t timeout;
+        size_t chunkSize;
+        bool chunked;
+        std::string buffer;
+        bool started;
+        bool finished;
+        bool broken;
+
+        bool sendChunk();
+
+    public:
+        //HTTP/1.0 clients do not understand chunks. Without chunked, the
+        //data is sent as it is and the end of the body is marked by
+        //closing the connection
+        HttpChunkedWriter(int connFd, bool keepAlive = true,
+                uint64_t timeout = HTTPSERVER_REQUEST_TIMEOUT,
+                size_t chunkSize = 64 * 1024, bool chunked = true);
+
+        //Sends all the data on a non-blocking socket. It waits (at most
+        //timeout ms at the time) until the client reads it
+        static bool sendAll(int connFd, const char *data, size_t size,
+                uint64_t timeout);
 
-            public:
-                Socket(int connFd) : connFd(connFd), eof(false), toBeClosed(false) {
-                }
+        //Sends the status line and the headers
+        bool start(const std::string &contentType);
 
-                Socket() : connFd(-1), eof(true) {}
+        bool write(const char *data, size_t size);
 
-                int getFD() const {
-                    return connFd;
-                }
+        bool write(const std::string &data) {
+            return write(data.c_str(), data.size());
+        }
+
+        //Sends the buffered data, even if it is less than a chunk
+        bool flush();
+
+        //Sends the last chunk. Afterwards, nothing can be written
+        bool finish();
+
+        bool isStarted() const {
+            return started;
+        }
 
-                bool shouldBeClosed() const {
-                    return toBeClosed;
-                }
+        bool isChunked() const {
+            return chunked;
+        }
+
+        bool isFinished() const {
+            return finished;
+        }
+
+        //True if the client has closed the connection
+        bool isBroken() const {
+            return broken;
+        }
+};
+
+class HttpServer {
+    private:
+        //A connection monitored by the event loop. Only the thread of the
+        //event loop reads from it and closes it
+        struct Connection {
+            //Data received but not processed yet. It can contain several
+            //(pipelined) requests
+            std::string buffer;
+            //When the connection was used for the last time (ms)
+            uint64_t lastActivity;
+            //When the first byte of the incomplete request arrived (ms)
+            uint64_t requestStart;
+            //A worker is answering one of its requests. The requests of a
+            //connection are processed one at the time, so that the
+            //responses are sent in the same order
+            bool busy;
+            //The client will not send more data
+            bool eof;
+
+            Connection() : lastActivity(0), requestStart(0), busy(false),
+            eof(false) {}
+        };
 
-                void close() {
-                    toBeClosed = true;
-                }
+        //A complete request, waiting for a worker
+        struct Request {
+            int connFd;
+            std::string request;
+            uint64_t arrival;
+            bool keepAlive;
 
-                bool isEOF() const {
-                    return eof;
-                }
+            Request() : connFd(-1), arrival(0), keepAlive(false) {}
+        };
+
+        //A request that was answered, sent back to the event loop
+        struct Completion {
+            int connFd;
+            bool close;
         };
 
         uint32_t port;
-        bool launched;
+        std::atomic<bool> launched;
+        std::atomic<bool> stopped;
         uint64_t maxLifeConn;
+        size_t maxQueuedRequests;
+        uint64_t requestTimeout;
 
         int listenFd;
+        int pollFd; //epoll instance (only on Linux)
+        int wakeFds[2]; //Pipe used by the workers to wake up the event loop
         struct sockaddr_in svrAdd, clntAdd;
-        ConcurrentQueue<Socket> queueReady;
+        std::unordered_map<int, Connection> connections;
+#ifndef __linux__
+        //Connections that wait for data
+        std::unordered_set<int> armed;
+#endif
+        ConcurrentQueue<Request> queueRequests;
+        ConcurrentQueue<Completion> queueCompleted;
         std::vector<std::thread> threads;
-        std::function<void(const std::string&, std::string&)> handlerFunction;
-
-        ConcurrentQueue<Socket> queueWait;
-        std::thread threadWait;
+        std::function<void(const std::string&, std::string&,
+                HttpChunkedWriter&)> handlerFunction;
 
         bool listn();
 
-        void processSocket();
+        void processRequests();
+
+        void eventLoop();
+
+        //Functions to monitor the sockets. The connections are monitored
+        //in "one-shot" mode: they must be re-armed after every event
+        void watch(int fd, bool oneShot);
+
+        void rearm(int fd);
+
+        void unwatch(int fd);
+
+        void waitEvents(std::vector<int> &ready, int timeout);
+
+        void acceptConnections();
 
-        void waitForData();
+        void readConnection(int connFd);
+
+        //Hands the first complete request in the buffer to the workers.
+        //Returns false if the connection should wait for more data
+        bool dispatch(int connFd, Connection &conn);
+
+        void closeConnection(int connFd);
+
+        void checkTimeouts();
+
+        void wakeUp();
+
+        //Returns the size of the first request in the buffer, or 0 if it
+        //is not complete yet. Throws if the request is malformed
+        static size_t getRequestLength(const std::string &buffer);
+
+        static bool isHttp10(const std::string &request);
+
+        static bool isKeepAlive(const std::string &request);
+
+        static const char *getReasonPhrase(int code);
+
+        static std::string errorResponse(int code);
 
         uint64_t getMessageBodyLength(std::string& request);
 
     public:
+        //The handler can either fill the response or stream it with the
+        //writer. In the second case, the response string is ignored.
+        //At most maxQueuedRequests requests wait for a worker, the others
+        //are rejected. Requests that are not received or started within
+        //requestTimeout ms are rejected as well
         HttpServer(uint32_t port,
-                std::function<void(const std::string&, std::string&)> handler,
+                std::function<void(const std::string&, std::string&,
+                    HttpChunkedWriter&)> handler,
                 uint32_t nthreads = 1,
-                uint64_t maxLifeConn = 7000); //after one second, connections are closed
+                uint64_t maxLifeConn = 7000, //idle connections are closed after 7 seconds
+                size_t maxQueuedRequests = HTTPSERVER_MAX_QUEUED_REQUESTS,
+                uint64_t requestTimeout = HTTPSERVER_REQUEST_TIMEOUT);
+
+        //Case-insensitive search of a header of the request. Returns the
+        //position of its value, or npos
+        static size_t findHeader(const std::string &request, const char *name);
 
         void start();
 
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _LOADPROFILER_H
+#define _LOADPROFILER_H
+
+#include <inttypes.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+/*
+ * Records the phases of the loading (compression, sorting, merging,
+ * insertion, dictionary, tree...). For each phase it stores the wall time
+ * and the resource usage of the process while the phase was running: CPU
+ * time, bytes read and written, RSS and peak RSS. The counters are
+ * process-wide, so phases that run at the same time on different threads
+ * see each other's usage.
+ *
+ * The phases are written in a JSON report and in a timeline in the Chrome
+ * trace format (chrome://tracing, Perfetto). The profiler does nothing
+ * unless it is enabled.
+ */
+class LoadProfiler {
+    public:
+        struct Usage {
+            double cpu; //seconds
+            int64_t bytesRead;
+            int64_t bytesWritten;
+            int64_t rss; //KB
+            int64_t peakRSS; //KB
+        };
+
+        struct Phase {
+            std::string name;
+            std::string category;
+            int thread;
+            int depth;
+            double start; //seconds since the profiler was enabled
+            double end;
+            Usage startUsage;
+            Usage endUsage;
+        };
+
+    private:
+        static bool enabled;
+        static std::mutex mutex;
+        static std::chrono::steady_clock::time_point startTime;
+        static std::vector<Phase> phases;
+        static std::map<std::thread::id, int> threadIds;
+        static std::map<int, int> openPhases;
+
+        static Usage getUsage();
+
+        static double now();
+
+    public:
+        static void enable();
+
+        static bool isEnabled() {
+            return enabled;
+        }
+
+        //Returns the id of the phase, or -1 if the profiler is disabled
+        static int64_t begin(std::string name, std::string category);
+
+        static void end(int64_t id);
+
+        static void writeReport(std::string file, std::string params);
+
+        static void writeTrace(std::string file);
+};
+
+//Profiles the scope in which it is declared
+class LoadPhase {
+    private:
+        int64_t id;
+
+    public:
+        LoadPhase(std::string name, std::string category) {
+            id = LoadProfiler::begin(name, category);
+        }
+
+        ~LoadPhase() {
+            LoadProfiler::end(id);
+        }
+};
+
+#endif
@@ -19,6 +19,16 @@
 #include <sys/stat.h>
 #endif
 
+//Hints about how a mapped file is going to be accessed. The first three
+//are mutually exclusive, the others can be combined with them.
+#define MAPPING_NORMAL 0
+#define MAPPING_SEQUENTIAL 1
+#define MAPPING_RANDOM 2
+#define MAPPING_ACCESS_MASK 3
+#define MAPPING_WILLNEED 4
+#define MAPPING_POPULATE 8
+#define MAPPING_HUGEPAGES 16
+
 class MemoryMappedFile {
     private: 
 #if defined(_WIN32)
@@ -33,7 +43,7 @@ class MemoryMappedFile {
 
     public:
         MemoryMappedFile(std::string file, bool ro, off_t start,
-                size_t len) {
+                size_t len, int flags) {
 #if defined(_WIN32)
 			fd = CreateFile(file.c_str(), ro ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
 			LARGE_INTEGER size;
@@ -59,15 +69,39 @@ class MemoryMappedFile {
                 LOG(ERRORL) << "Failed opening the file " << file;
                 throw 10;
             } 
+            int mapflags = MAP_SHARED;
+#ifdef MAP_POPULATE
+            if (flags & MAPPING_POPULATE) {
+                mapflags |= MAP_POPULATE;
+                flags &= ~MAPPING_POPULATE;
+            }
+#endif
             data = static_cast<char*>(::mmap(NULL, len,
                         ro ? PROT_READ : (PROT_READ | PROT_WRITE),
-                        MAP_SHARED, fd, start));
+                        mapflags, fd, start));
             if (data == MAP_FAILED) {
                 LOG(ERRORL) << "Failed mapping the file " << file;
                 throw 10;
             }
 #endif
 			this->length = len;
+            if (flags != MAPPING_NORMAL) {
+                advise(flags);
+            }
+            //Without MAP_POPULATE the pages are touched once, here
+            if (flags & MAPPING_POPULATE) {
+                prefault();
+            }
+        }
+
+        MemoryMappedFile(std::string file, bool ro, off_t start,
+                size_t len) : MemoryMappedFile(file, ro, start, len,
+                    MAPPING_NORMAL) {
+        }
+
+        MemoryMappedFile(std::string file, bool ro, int flags) :
+            MemoryMappedFile(file, ro, 0, (int64_t)Utils::fileSize(file),
+                    flags) {
         }
 
         MemoryMappedFile(std::string file, bool ro) : MemoryMappedFile(file, ro, 0,
@@ -134,6 +168,55 @@ class MemoryMappedFile {
 #endif
         }
 
+        //Tells the kernel how the mapping will be accessed (see the
+        //MAPPING_* flags). The hints are best-effort: the ones that are not
+        //supported by the OS are silently ignored. MAPPING_POPULATE is not
+        //a hint: the pages are loaded only when the file is mapped.
+        void advise(int flags) {
+#if defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+            if (length == 0) {
+                return;
+            }
+            switch (flags & MAPPING_ACCESS_MASK) {
+                case MAPPING_SEQUENTIAL:
+                    madvise(data, length, MADV_SEQUENTIAL);
+                    break;
+                case MAPPING_RANDOM:
+                    madvise(data, length, MADV_RANDOM);
+                    break;
+                default:
+                    madvise(data, length, MADV_NORMAL);
+            }
+#ifdef MADV_HUGEPAGE
+            if (flags & MAPPING_HUGEPAGES) {
+                madvise(data, length, MADV_HUGEPAGE);
+            }
+#endif
+            if (flags & MAPPING_WILLNEED) {
+                madvise(data, length, MADV_WILLNEED);
+            }
+#endif
+        }
+
+        //Touches one byte per page so that the whole file is loaded in
+        //memory. Returns the number of pages that were touched.
+        size_t prefault() {
+#if defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+            if (length > 0) {
+                madvise(data, length, MADV_WILLNEED);
+            }
+#endif
+            const size_t pagesize = 4096;
+            volatile char sink = 0;
+            size_t npages = 0;
+            for (size_t i = 0; i < length; i += pagesize) {
+                sink ^= data[i];
+                npages++;
+            }
+            (void) sink;
+            return npages;
+        }
+
         void flush(off_t begin, size_t len) {
 #if defined(_WIN32)
 			if (!FlushViewOfFile(data + begin, len)) {
@@ -25,7 +25,12 @@
 
 #include <trident/kb/consts.h>
 
-#include <iostream>
+#include <kognac/logs.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstring>
 #include <assert.h>
 
 using namespace std;
@@ -36,35 +41,143 @@ struct MemoryBlock {
     K** parentBlock;
     size_t bytes;
     int idx;
-    int lock;
+    //Pin count. It is changed without taking the lock of the shard. -1
+    //means that the slot is free or claimed by the eviction
+    std::atomic<int> lock;
+    //Used by the CLOCK eviction: set on every access, cleared by the hand
+    std::atomic<bool> referenced;
 };
 
+/*
+ * Keeps track of the memory used by the mapped files (or segments) and
+ * evicts them with the CLOCK algorithm when the cache exceeds its size.
+ * The blocks are spread over N_CACHE_SHARDS shards, each with its own
+ * mutex, so that concurrent queriers that share the same manager do not
+ * contend on a single lock. Adding and removing blocks takes the mutex of
+ * one shard, while pinning (addLock/releaseLock/isUsed) only uses atomic
+ * operations: the eviction claims a block by swapping its pin count from
+ * 0 to -1, so a block is either pinned or claimed, never both. The ids
+ * returned by add() encode the shard and the slot.
+ */
 template<class K>
 class MemoryManager {
 private:
+    static const int CHUNK_SIZE = 4096;
+    static const int SLOTS_PER_SHARD = MAX_N_BLOCKS_IN_CACHE / N_CACHE_SHARDS;
+    static const int CHUNKS_PER_SHARD = (SLOTS_PER_SHARD + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    struct Shard {
+        std::mutex mutex;
+        //Slots are allocated in chunks that are never moved, so that they
+        //can be accessed without the mutex
+        MemoryBlock<K> *chunks[CHUNKS_PER_SHARD];
+        std::vector<int> freeSlots;
+        int nslots;
+        int hand;
+    };
+
     const size_t cacheMaxSize;
-    size_t bytes;
+    std::atomic<size_t> bytes;
+    std::atomic<int> blocksLeft;
+    std::atomic<uint32_t> nextShard;
+    std::atomic<uint32_t> nextEvictShard;
+
+    Shard shards[N_CACHE_SHARDS];
 
-    MemoryBlock<K> **blocks;
-    int start;
-    int end;
-    int blocksLeft;
+    MemoryBlock<K> &getBlock(const int id) {
+        const int slot = id % SLOTS_PER_SHARD;
+        return shards[id / SLOTS_PER_SHARD].chunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE];
+    }
+
+    //Must be called while holding the mutex of the shard. Returns the
+    //element that must be deallocated (after releasing the mutex).
+    K *detach(Shard &shard, const int slot) {
+        MemoryBlock<K> &b = shard.chunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE];
+        K *elToRemove = b.block;
+        bytes -= b.bytes;
+        if (b.parentBlock != NULL) {
+            b.parentBlock[b.idx] = NULL;
+        }
+        b.block = NULL;
+        b.parentBlock = NULL;
+        b.bytes = 0;
+        b.lock = -1;
+        shard.freeSlots.push_back(slot);
+        blocksLeft++;
+        return elToRemove;
+    }
 
-    void removeOneBlock() {
-        if (blocksLeft < MAX_N_BLOCKS_IN_CACHE) {
-            if (start == MAX_N_BLOCKS_IN_CACHE) {
-                start = 0;
+    //Move the hand of the clock until it finds a block that is neither
+    //pinned nor recently used, and claim it. Returns -1 if there is none.
+    int findVictim(Shard &shard) {
+        for (int i = 0; i < 2 * shard.nslots; ++i) {
+            if (shard.hand >= shard.nslots) {
+                shard.hand = 0;
+            }
+            const int slot = shard.hand++;
+            MemoryBlock<K> &b = shard.chunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE];
+            if (b.block == NULL || b.lock.load() != 0) {
+                continue;
             }
+            if (b.referenced.exchange(false)) {
+                continue;
+            }
+            //A querier might have pinned it in the meantime
+            int expected = 0;
+            if (!b.lock.compare_exchange_strong(expected, -1)) {
+                continue;
+            }
+            return slot;
+        }
+        return -1;
+    }
 
-            //Check the block is not NULL
-            while (blocks[start] == NULL || blocks[start]->lock > 0) {
-                start++;
-                if (start == MAX_N_BLOCKS_IN_CACHE) {
-                    start = 0;
+    bool removeOneBlock() {
+        const uint32_t first = nextEvictShard++;
+        for (int i = 0; i < N_CACHE_SHARDS; ++i) {
+            Shard &shard = shards[(first + i) % N_CACHE_SHARDS];
+            K *elToRemove = NULL;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                const int slot = findVictim(shard);
+                if (slot != -1) {
+                    elToRemove = detach(shard, slot);
+                } else {
+                    continue;
                 }
             }
-            removeBlock(start++);
+            //Delete block. This will trigger the deconstructor of K which
+            //should remove the block and update all the datastructures
+            delete elToRemove;
+            return true;
+        }
+        return false;
+    }
+
+    //Returns the slot or -1 if the shard is full
+    int newSlot(Shard &shard) {
+        if (!shard.freeSlots.empty()) {
+            const int slot = shard.freeSlots.back();
+            shard.freeSlots.pop_back();
+            return slot;
+        }
+        if (shard.nslots == SLOTS_PER_SHARD) {
+            return -1;
+        }
+        const int slot = shard.nslots;
+        if (slot % CHUNK_SIZE == 0) {
+            MemoryBlock<K> *chunk = new MemoryBlock<K>[CHUNK_SIZE];
+            for (int i = 0; i < CHUNK_SIZE; ++i) {
+                chunk[i].block = NULL;
+                chunk[i].parentBlock = NULL;
+                chunk[i].bytes = 0;
+                chunk[i].lock = -1;
+                chunk[i].referenced = false;
+            }
+            shard.chunks[slot / CHUNK_SIZE] = chunk;
         }
+        shard.nslots++;
+        return slot;
     }
 
 public:
@@ -72,81 +185,173 @@ public:
         cacheMaxSize(cacheMaxSize) {
             assert(cacheMaxSize > 0);
         bytes = 0;
-        blocks = new MemoryBlock<K>*[MAX_N_BLOCKS_IN_CACHE];
-        memset(blocks, 0, sizeof(MemoryBlock<K>*) * MAX_N_BLOCKS_IN_CACHE);
-        start = end = 0;
-        blocksLeft = MAX_N_BLOCKS_IN_CACHE;
+        blocksLeft = SLOTS_PER_SHARD * N_CACHE_SHARDS;
+        nextShard = 0;
+        nextEvictShard = 0;
+        for (int i = 0; i < N_CACHE_SHARDS; ++i) {
+            memset(shards[i].chunks, 0, sizeof(MemoryBlock<K>*) * CHUNKS_PER_SHARD);
+            shards[i].nslots = 0;
+            shards[i].hand = 0;
+        }
     }
 
     void update(int idx, size_t bytes) {
-        this->bytes -= blocks[idx]->bytes;
+        Shard &shard = shards[idx / SLOTS_PER_SHARD];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        MemoryBlock<K> &b = getBlock(idx);
+        this->bytes -= b.bytes;
         this->bytes += bytes;
-        blocks[idx]->bytes = bytes;
+        b.bytes = bytes;
     }
 
     void removeBlock(int idx) {
-        //Delete block. This will trigger the deconstructor of K which should remove the block and update all the datastructures
-        bytes -= blocks[idx]->bytes;
-        K *elToRemove = blocks[idx]->block;
-        blocks[idx]->parentBlock[blocks[idx]->idx] = NULL;
-        delete blocks[idx];
-        blocks[idx] = NULL;
-        blocksLeft++;
+        Shard &shard = shards[idx / SLOTS_PER_SHARD];
+        K *elToRemove = NULL;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (getBlock(idx).block == NULL) {
+                return;
+            }
+            elToRemove = detach(shard, idx % SLOTS_PER_SHARD);
+        }
         delete elToRemove;
     }
 
-    void removeBlockWithoutDeallocation(int idx) {
-        if (blocks[idx] != NULL) {
-            bytes -= blocks[idx]->bytes;
-            delete blocks[idx];
-            blocks[idx] = NULL;
-            blocksLeft++;
+    //Called by the destructor of the element. The element is passed
+    //because the slot might have been evicted and reused in the meantime.
+    void removeBlockWithoutDeallocation(int idx, const K *element) {
+        if (idx < 0) {
+            return;
+        }
+        Shard &shard = shards[idx / SLOTS_PER_SHARD];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (getBlock(idx).block == element) {
+            detach(shard, idx % SLOTS_PER_SHARD);
+        }
+    }
+
+    //Pins the block if it still holds the element. Returns false if the
+    //block was claimed by the eviction or reused for another element, in
+    //which case the caller must look the element up again.
+    bool addLock(int idx, const K *element) {
+        MemoryBlock<K> &b = getBlock(idx);
+        int current = b.lock.load();
+        do {
+            if (current < 0) {
+                return false;
+            }
+        } while (!b.lock.compare_exchange_weak(current, current + 1));
+        //Once pinned, the block cannot be evicted, so reading it is safe
+        if (b.block != element) {
+            b.lock--;
+            return false;
+        }
+        b.referenced.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    //Claims an unpinned block that holds the element, so that the caller
+    //can deallocate the element. Returns false if the block is pinned.
+    bool claim(int idx, const K *element) {
+        MemoryBlock<K> &b = getBlock(idx);
+        int expected = 0;
+        if (!b.lock.compare_exchange_strong(expected, -1)) {
+            return false;
+        }
+        if (b.block != element) {
+            b.lock = 0;
+            return false;
         }
+        return true;
     }
 
-    void addLock(int idx) {
-        blocks[idx]->lock++;
+    //Returns true if the block holds the element. Only meaningful while
+    //the caller pins the block.
+    bool holds(int idx, const K *element) {
+        return getBlock(idx).block == element;
     }
 
     bool isUsed(int idx) {
-        return blocks[idx]->lock > 0;
+        return getBlock(idx).lock.load() > 0;
     }
 
     void releaseLock(int idx) {
-        blocks[idx]->lock--;
+        getBlock(idx).lock--;
     }
 
+    //Returns the id of the block, or -1 if all the slots hold pinned
+    //blocks. In this case the element is not tracked, and the manager
+    //never evicts it.
     int add(size_t bytes, K *element, int idxInParentArray, K **parentArray) {
-        if (this->bytes + bytes > cacheMaxSize) {
-            while (this->bytes >= cacheMaxSize || blocksLeft == 0) {
-                removeOneBlock();
+        //Reserve a slot. Once reserved, a free slot is guaranteed to exist
+        //in one of the shards
+        int left = blocksLeft.load();
+        while (true) {
+            if (left > 0) {
+                if (blocksLeft.compare_exchange_weak(left, left - 1)) {
+                    break;
+                }
+            } else {
+                if (!removeOneBlock()) {
+                    LOG(WARNL) << "All blocks in the cache are pinned. The block is not tracked";
+                    return -1;
+                }
+                left = blocksLeft.load();
             }
         }
-        this->bytes += bytes;
 
-        if (end == MAX_N_BLOCKS_IN_CACHE) {
-        end = 0;
-    }
-    while (blocks[end] != NULL) {
-            end = (end + 1) % MAX_N_BLOCKS_IN_CACHE;
+        //Make room. If all the blocks are pinned, the cache is allowed to
+        //grow over its size.
+        while (this->bytes + bytes > cacheMaxSize && this->bytes > 0) {
+            if (!removeOneBlock()) {
+                LOG(WARNL) << "All blocks in the cache are used. Cannot free space";
+                break;
+            }
         }
+        this->bytes += bytes;
 
-        MemoryBlock<K> *memoryBlock = new MemoryBlock<K>();
-        memoryBlock->bytes = bytes;
-        memoryBlock->block = element;
-        memoryBlock->idx = idxInParentArray;
-        memoryBlock->parentBlock = parentArray;
-        memoryBlock->lock = 0;
-        blocks[end] = memoryBlock;
-        blocksLeft--;
-        return end++;
+        //Another thread may take the free slot of a shard that was already
+        //visited. Its reserved slot is then somewhere else
+        uint32_t next = nextShard++;
+        while (true) {
+            const int shardId = next++ % N_CACHE_SHARDS;
+            Shard &shard = shards[shardId];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            const int slot = newSlot(shard);
+            if (slot == -1) {
+                continue;
+            }
+            MemoryBlock<K> &memoryBlock = shard.chunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE];
+            memoryBlock.bytes = bytes;
+            memoryBlock.block = element;
+            memoryBlock.idx = idxInParentArray;
+            memoryBlock.parentBlock = parentArray;
+            memoryBlock.referenced = true;
+            //Publish the block only when all its fields are set
+            memoryBlock.lock = 0;
+            return shardId * SLOTS_PER_SHARD + slot;
+        }
     }
 
     ~MemoryManager() {
-        while (blocksLeft < MAX_N_BLOCKS_IN_CACHE) {
-            removeOneBlock();
+        for (int i = 0; i < N_CACHE_SHARDS; ++i) {
+            Shard &shard = shards[i];
+            for (int slot = 0; slot < shard.nslots; ++slot) {
+                K *elToRemove = NULL;
+                {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    if (shard.chunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE].block != NULL) {
+                        elToRemove = detach(shard, slot);
+                    }
+                }
+                delete elToRemove;
+            }
+            for (int j = 0; j < CHUNKS_PER_SHARD; ++j) {
+                if (shard.chunks[j] != NULL) {
+                    delete[] shard.chunks[j];
+                }
+            }
         }
-        delete[] blocks;
     }
 };
 
@@ -182,6 +182,18 @@ class ConcurrentQueue {
             cv.notify_one();
         }
 
+        //Adds the element only if the queue contains less than maxSize
+        //elements. Returns false if the element was not added
+        bool push_bounded(El el, size_t maxSize) {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (q.size() >= maxSize) {
+                return false;
+            }
+            q.push(el);
+            cv.notify_one();
+            return true;
+        }
+
         void pop(El &el) {
             std::unique_lock<std::mutex> lock(mtx);
             el = q.front();
@@ -202,4 +214,39 @@ class ConcurrentQueue {
             q.pop();
         }
 };
+
+//Counting semaphore over a budget of units (e.g. MB of memory). A task
+//acquires the units it needs before it starts and blocks until they are
+//released by the others. Requests larger than the budget are trimmed to
+//it, so they can still run (alone).
+class TokenBudget {
+    private:
+        const int64_t total;
+        int64_t available;
+        std::mutex mtx;
+        std::condition_variable cv;
+
+    public:
+        TokenBudget(int64_t total) : total(total), available(total) {}
+
+        int64_t acquire(int64_t n) {
+            n = std::max((int64_t) 0, std::min(n, total));
+            std::unique_lock<std::mutex> lock(mtx);
+            while (available < n) {
+                cv.wait(lock);
+            }
+            available -= n;
+            return n;
+        }
+
+        void release(int64_t n) {
+            std::unique_lock<std::mutex> lock(mtx);
+            available += n;
+            cv.notify_all();
+        }
+
+        int64_t getTotal() const {
+            return total;
+        }
+};
 #endif
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef _PREFETCHER_H
+#define _PREFETCHER_H
+
+#include <trident/kb/consts.h>
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+/*
+ * Reads ahead the tables that a scan is going to visit. The scan pushes the
+ * memory ranges of the following tables, in the order in which it will
+ * read them, and a background thread asks the kernel to load them
+ * (madvise(WILLNEED)) and then touches their pages, so that the page faults
+ * happen on this thread rather than on the scan. The ranges that were
+ * pushed but not yet consumed by the scan cannot exceed maxBytes, so that
+ * the prefetched pages are not evicted before they are read.
+ */
+class Prefetcher {
+    private:
+        struct Range {
+            const char *begin;
+            const char *end;
+        };
+
+        const uint64_t maxBytes;
+
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::deque<Range> toLoad; //Ranges still to be prefetched
+        std::deque<uint64_t> ahead; //Sizes of the ranges not yet consumed
+        uint64_t bytesAhead;
+        bool stop;
+
+        //Last page that was touched, to avoid touching it once per table
+        const char *lastPage;
+        size_t pagesize;
+
+        std::thread thread;
+
+        void run();
+
+        void load(const char *begin, const char *end);
+
+    public:
+        LIBEXP Prefetcher(const uint64_t maxBytes);
+
+        //Queues the next range. Returns false if the range does not fit in
+        //the budget (it is accepted anyway if nothing else is pending)
+        LIBEXP bool push(const char *begin, const char *end);
+
+        //Tells that the scan has started to read the oldest pushed range
+        LIBEXP void consume();
+
+        //Number of ranges that were pushed and not yet consumed
+        LIBEXP size_t getNAhead();
+
+        LIBEXP ~Prefetcher();
+};
+
+#endif
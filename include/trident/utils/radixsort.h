@@ -0,0 +1,245 @@
+#ifndef _RADIXSORT_H
+#define _RADIXSORT_H
+
+#include <kognac/logs.h>
+
+#include <vector>
+#include <array>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <inttypes.h>
+
+/*
+ * Parallel radix sort of records of SIZE bytes, in the lexicographic order
+ * of their (unsigned) bytes. This is the order of the permutations, where
+ * the terms are written in big-endian.
+ *
+ * Only the bytes that are not constant over all records are used as digits.
+ * The largest ranges are first partitioned in place on their most
+ * significant digit (American flag sort), until they are small enough.
+ * Then, the threads sort the ranges independently with a LSD radix sort,
+ * each one with its own scatter buffer. The extra memory is therefore only
+ * a fraction of the input (about 1/16).
+ */
+template<size_t SIZE>
+class RadixSorter {
+    private:
+        struct Record {
+            unsigned char b[SIZE];
+        };
+
+        struct Range {
+            Record *start;
+            size_t n;
+            size_t digit; //Index of the first digit to consider
+        };
+
+        typedef std::array<size_t, 256> Histogram;
+
+        static bool less(const Record &a, const Record &b) {
+            return memcmp(a.b, b.b, SIZE) < 0;
+        }
+
+        static void insertionSort(Record *start, size_t n) {
+            for (size_t i = 1; i < n; ++i) {
+                Record tmp = start[i];
+                size_t j = i;
+                while (j > 0 && less(tmp, start[j - 1])) {
+                    start[j] = start[j - 1];
+                    j--;
+                }
+                start[j] = tmp;
+            }
+        }
+
+        static void count(const Record *start, size_t n, size_t digit,
+                Histogram &h) {
+            h.fill(0);
+            for (size_t i = 0; i < n; ++i) {
+                h[start[i].b[digit]]++;
+            }
+        }
+
+        //Partitions the records in place on the byte at position digit.
+        //bucketStarts gets 257 entries.
+        static void partition(Record *start, size_t digit, const Histogram &h,
+                size_t *bucketStarts) {
+            size_t next[256], ends[256];
+            size_t s = 0;
+            for (int b = 0; b < 256; ++b) {
+                bucketStarts[b] = next[b] = s;
+                s += h[b];
+                ends[b] = s;
+            }
+            bucketStarts[256] = s;
+            for (int b = 0; b < 256; ++b) {
+                while (next[b] < ends[b]) {
+                    const unsigned char v = start[next[b]].b[digit];
+                    if (v == b) {
+                        next[b]++;
+                    } else {
+                        std::swap(start[next[b]], start[next[v]++]);
+                    }
+                }
+            }
+        }
+
+        //LSD radix sort of a range on the digits from fromDigit on. h must
+        //have one histogram per digit
+        static void lsd(Record *start, size_t n,
+                const std::vector<size_t> &digits, size_t fromDigit,
+                std::vector<Record> &buffer, std::vector<Histogram> &h) {
+            if (n <= 64) {
+                insertionSort(start, n);
+                return;
+            }
+            const size_t nd = digits.size() - fromDigit;
+            for (size_t k = 0; k < nd; ++k) {
+                h[k].fill(0);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t k = 0; k < nd; ++k) {
+                    h[k][start[i].b[digits[fromDigit + k]]]++;
+                }
+            }
+
+            Record *src = start;
+            Record *dst = buffer.data();
+            for (size_t k = nd; k-- > 0;) {
+                const size_t digit = digits[fromDigit + k];
+                if (h[k][src[0].b[digit]] == n) {
+                    continue; //All records have the same byte
+                }
+                size_t offsets[256];
+                size_t s = 0;
+                for (int b = 0; b < 256; ++b) {
+                    offsets[b] = s;
+                    s += h[k][b];
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    dst[offsets[src[i].b[digit]]++] = src[i];
+                }
+                std::swap(src, dst);
+            }
+            if (src != start) {
+                memcpy(start, src, n * sizeof(Record));
+            }
+        }
+
+    public:
+        static void sort(char *data, size_t n, int nthreads) {
+            static_assert(sizeof(Record) == SIZE, "Records must be packed");
+            if (n < 2) {
+                return;
+            }
+            nthreads = std::max(1, nthreads);
+            Record *records = (Record*) data;
+
+            //Histograms of all bytes, to find the ones that are not constant
+            std::vector<std::vector<Histogram>> partialHist(nthreads,
+                    std::vector<Histogram>(SIZE));
+            std::vector<std::thread> threads;
+            const size_t chunk = (n + nthreads - 1) / nthreads;
+            for (int t = 0; t < nthreads; ++t) {
+                threads.push_back(std::thread([&, t]() {
+                    std::vector<Histogram> &h = partialHist[t];
+                    for (size_t d = 0; d < SIZE; ++d) {
+                        h[d].fill(0);
+                    }
+                    const size_t end = std::min(n, (t + 1) * chunk);
+                    for (size_t i = t * chunk; i < end; ++i) {
+                        for (size_t d = 0; d < SIZE; ++d) {
+                            h[d][records[i].b[d]]++;
+                        }
+                    }
+                }));
+            }
+            for (auto &t : threads) {
+                t.join();
+            }
+            threads.clear();
+            std::vector<Histogram> hist(SIZE);
+            std::vector<size_t> digits;
+            for (size_t d = 0; d < SIZE; ++d) {
+                hist[d].fill(0);
+                for (int t = 0; t < nthreads; ++t) {
+                    for (int b = 0; b < 256; ++b) {
+                        hist[d][b] += partialHist[t][d][b];
+                    }
+                }
+                if (hist[d][records[0].b[d]] != n) {
+                    digits.push_back(d);
+                }
+            }
+            if (digits.empty()) {
+                return;
+            }
+
+            //Split in place the large ranges on their most significant digit
+            const size_t maxRange = std::max((size_t) 65536,
+                    n / (16 * nthreads));
+            std::vector<Range> pending;
+            std::vector<Range> ranges;
+            pending.push_back(Range{records, n, 0});
+            size_t bucketStarts[257];
+            Histogram h;
+            while (!pending.empty()) {
+                Range r = pending.back();
+                pending.pop_back();
+                if (r.digit == digits.size()) {
+                    continue; //All records in the range are equal
+                }
+                if (r.n <= maxRange) {
+                    ranges.push_back(r);
+                    continue;
+                }
+                const size_t digit = digits[r.digit];
+                if (r.start == records && r.n == n) {
+                    h = hist[digit];
+                } else {
+                    count(r.start, r.n, digit, h);
+                }
+                partition(r.start, digit, h, bucketStarts);
+                for (int b = 0; b < 256; ++b) {
+                    const size_t size = bucketStarts[b + 1] - bucketStarts[b];
+                    if (size > 1) {
+                        pending.push_back(Range{r.start + bucketStarts[b], size,
+                                r.digit + 1});
+                    }
+                }
+            }
+
+            //Sort the ranges in parallel, the largest first. The buffers and
+            //the histograms are allocated here, because the threads must not
+            //throw: if an allocation fails the records are still a
+            //permutation of the input and the caller can sort them
+            //otherwise.
+            std::sort(ranges.begin(), ranges.end(),
+                    [](const Range &a, const Range &b) { return a.n > b.n; });
+            const int nworkers = std::min((size_t) nthreads, ranges.size());
+            std::vector<std::vector<Record>> buffers(nworkers);
+            std::vector<std::vector<Histogram>> lsdHist(nworkers);
+            for (int t = 0; t < nworkers; ++t) {
+                buffers[t].resize(ranges[0].n);
+                lsdHist[t].resize(digits.size());
+            }
+            std::atomic<size_t> nextRange(0);
+            for (int t = 0; t < nworkers; ++t) {
+                threads.push_back(std::thread([&, t]() {
+                    size_t idx;
+                    while ((idx = nextRange++) < ranges.size()) {
+                        const Range &r = ranges[idx];
+                        lsd(r.start, r.n, digits, r.digit, buffers[t],
+                                lsdHist[t]);
+                    }
+                }));
+            }
+            for (auto &t : threads) {
+                t.join();
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#ifndef TEXTREADER_H_
+#define TEXTREADER_H_
+
+#include <trident/utils/memoryfile.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <inttypes.h>
+
+//Size of the text that is given to a thread at once
+#define TEXTREADER_CHUNK_SIZE (8 * 1024 * 1024)
+
+//Reads a large text file (i.e., a file with one record per line) with
+//several threads. Plain files and compressed files made of independent
+//blocks are split in chunks that are decompressed and parsed in parallel.
+//These are BGZF files (the blocked gzip produced by bgzip, which is a
+//multi-member gzip file where every member stores its size) and LZ4 frames
+//with independent blocks (the default of the lz4 tool). The other gzip
+//files and the LZ4 frames with linked blocks are decompressed by one
+//thread, but the lines are still parsed in parallel.
+class ParallelTextReader {
+    public:
+        enum Format { PLAIN, GZIP, BGZF, LZ4 };
+
+        //Receives a piece of text that contains only complete lines (the
+        //last line of the file might not end with a newline). It is called
+        //by several threads at the same time; thread is between 0 and the
+        //number of threads - 1.
+        typedef std::function<void(const char *start, const char *end,
+                int thread)> Consumer;
+
+    private:
+        struct Block {
+            const char *data;
+            uint64_t size;
+            uint64_t rawSize; //Upper bound of the decompressed size
+            bool compressed;
+        };
+
+        //Lines cut by the borders of a chunk. They are parsed at the end
+        struct Fragments {
+            std::string head;
+            std::string tail;
+        };
+
+        const std::string file;
+        std::unique_ptr<MemoryMappedFile> mapping;
+        const char *start;
+        const char *end;
+        Format format;
+
+        //Position of the next block. The chunks are taken under the lock
+        std::mutex lock;
+        const char *pos;
+        bool insideFrame;
+        uint64_t lz4BlockSize;
+        bool lz4BlockChecksum;
+        bool lz4ContentChecksum;
+        bool lz4Linked;
+        std::deque<Fragments> fragments;
+
+        bool readLZ4FrameHeader();
+
+        bool nextBlock(Block &block);
+
+        bool nextChunk(std::vector<Block> &blocks, Fragments *&fragments);
+
+        void decodeBlock(const Block &block, void *zstream, char *out,
+                uint64_t &outsize);
+
+        void readChunks(int thread, Consumer *consumer);
+
+        void readParallel(int nthreads, Consumer &consumer);
+
+        void readSequential(int nthreads, Consumer &consumer);
+
+    public:
+        ParallelTextReader(std::string file);
+
+        static Format getFormat(std::string file);
+
+        //Returns true if the file can be decompressed by several threads
+        static bool isSplittable(std::string file);
+
+        Format getFormat() const {
+            return format;
+        }
+
+        //Reads the entire file and passes it to consumer, which is called
+        //by nthreads threads
+        void read(int nthreads, Consumer consumer);
+};
+
+#endif /* TEXTREADER_H_ */
@@ -36,6 +36,8 @@ class TridentUtils {
 
         static int64_t getVmRSS();
 
+        static int64_t getVmHWM();
+
         static double getCPUUsage();
 
         static int64_t diskread();
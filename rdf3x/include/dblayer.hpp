@@ -51,6 +51,15 @@ class DBLayer {
 
                 virtual bool first(uint64_t, bool, uint64_t, bool, uint64_t, bool) = 0;
 
+                // Restrict the following first() to the rows where the first
+                // unconstrained value is >= start. constrained tells whether
+                // first() will constrain the first value. Returns false if
+                // the scan cannot jump to start (it would have to skip the
+                // rows one by one).
+                virtual bool setRangeStart(uint64_t start, bool constrained) {
+                    return false;
+                }
+
                 virtual ~Scan() {}
         };
 
@@ -122,6 +131,29 @@ class DBLayer {
                 ::Type::ID& type,
                 unsigned& subType) = 0;
 
+        /// Lookup the strings of several ids. The string of ids[i] is stored
+        /// in texts, at the offset and with the length in positions[i].
+        /// Strings that are not found are empty. Layers that can retrieve
+        /// the strings in a single pass should override it.
+        virtual void lookupByIds(const std::vector<uint64_t>& ids,
+                std::string& texts,
+                std::vector<std::pair<size_t, size_t>>& positions,
+                std::vector<::Type::ID>& types) {
+            texts.clear();
+            positions.resize(ids.size());
+            types.resize(ids.size());
+            for (size_t i = 0; i < ids.size(); ++i) {
+                const char *start, *stop;
+                unsigned subType;
+                positions[i] = std::make_pair(texts.size(), (size_t) 0);
+                types[i] = ::Type::Literal;
+                if (lookupById(ids[i], start, stop, types[i], subType)) {
+                    texts.append(start, stop - start);
+                    positions[i].second = stop - start;
+                }
+            }
+        }
+
         virtual uint64_t getNextId() = 0;
 
         virtual double getScanCost(DBLayer::DataOrder order,
@@ -90,6 +90,8 @@ private:
     ProbePeek probePeekTask;
     /// Task priorities
     double hashPriority, probePriority;
+    /// The scheduler that runs the plan, if any
+    Scheduler* scheduler;
 
     /// Insert into the hash table
     void insert(Entry* e);
@@ -39,6 +39,8 @@ private:
     };
     friend class IndexScanHint;
 
+    /// The database
+    DBLayer& db;
     /// The registers for the different parts of the triple
     Register* value1, *value2, *value3;
     /// The different boundings
@@ -90,6 +92,14 @@ public:
     /// Register parts of the tree that can be executed asynchronous
     void getAsyncInputCandidates(Scheduler& scheduler);
 
+    /// Can readParallel be used?
+    bool canReadParallel();
+    /// Read all tuples, splitting the scan in key ranges that are read by the threads of the scheduler.
+    /// Every part gets the tuples (value1,value2,value3) read by one thread. Merge hints are not used
+    void readParallel(Scheduler& scheduler, std::vector<std::vector<uint64_t> >& parts);
+    /// Store a tuple produced by readParallel in the registers
+    void loadTuple(const uint64_t* tuple);
+
     /// Create a suitable operator
     static IndexScan* create(DBLayer& db, DBLayer::DataOrder order, Register* subjectRegister, bool subjectBound, Register* predicateRegister, bool predicateBound, Register* objectRegister, bool objectBound, double expectedOutputCardinality);
 };
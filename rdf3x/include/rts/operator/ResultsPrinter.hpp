@@ -17,6 +17,7 @@
 
 #include <vector>
 #include <map>
+#include <functional>
 #include <unordered_set>
 #include <string>
 #include <sstream>
@@ -48,6 +49,18 @@ std::string tostring(/*const std::map<uint64_t, CacheEntry>& stringCache,*/ bool
 };
 }
 
+/// Receives the results one row at the time, without materializing them
+class ResultsWriter {
+    public:
+        /// Called once, before the first row
+        virtual bool begin(const std::vector<std::string>& vars) = 0;
+        /// Write a row. The values are in N-Triples syntax, unbound values
+        /// are empty. Returns false if no more rows should be produced
+        virtual bool writeRow(const std::vector<std::string>& values) = 0;
+        /// Destructor
+        virtual ~ResultsWriter() {}
+};
+
 /// Consumes its input and prints it. Produces a single empty tuple.
 class ResultsPrinter : public Operator {
     public:
@@ -81,6 +94,8 @@ class ResultsPrinter : public Operator {
         //Used for JSON output
         JSON *jsonoutput;
         std::vector<std::string> jsonvars;
+        //Used for streaming the results
+        ResultsWriter *writer;
         //Used for set output
         std::unordered_set<uint64_t> *outputset;
         unsigned prjId;
@@ -91,6 +106,11 @@ class ResultsPrinter : public Operator {
                 ResultsPrinter::DuplicateHandling duplicateHandling,
                 JSON *output);
 
+        /// Resolve the rows a block at the time and pass them to emit, until
+        /// it returns false
+        void streamResults(uint64_t count, uint64_t offset,
+                const std::function<bool(const std::vector<std::string>&)>& emit);
+
     public:
         /// Constructor
         ResultsPrinter(Runtime& runtime, Operator* input, const std::vector<Register*>& output, DuplicateHandling duplicateHandling, uint64_t limit = UINT64_MAX, uint64_t offset = 0, bool silent = false);
@@ -116,6 +136,12 @@ class ResultsPrinter : public Operator {
             this->jsonvars = jsonvars;
         }
 
+        void setStreamOutput(ResultsWriter *writer,
+                const std::vector<std::string> &vars) {
+            this->writer = writer;
+            this->jsonvars = vars;
+        }
+
         void setSetOutput(std::unordered_set<uint64_t> *results, unsigned prjId) {
             outputset = results;
             this->prjId = prjId;
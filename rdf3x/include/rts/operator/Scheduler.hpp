@@ -3,6 +3,8 @@
 //---------------------------------------------------------------------------
 #include "infra/osdep/Event.hpp"
 #include "infra/osdep/Mutex.hpp"
+#include <exception>
+#include <functional>
 #include <vector>
 #include <set>
 //---------------------------------------------------------------------------
@@ -42,31 +44,34 @@ class Scheduler
    Mutex workerLock;
    /// Notification
    Event workerSignal;
-   /// The queue of tasks
-   std::vector<RegisteredPoint*> workQueue;
    /// The number of threads to use
    unsigned threads;
-   /// The number of active threads
-   volatile unsigned activeWorkers,workerThreads;
-   /// Should the workers die?
-   volatile bool workersDie;
+   /// The number of execution points handed to the worker pool and not finished yet
+   unsigned activeWorkers;
+   /// The first exception thrown by an execution point
+   std::exception_ptr failure;
 
-   /// Perform the work of a worker thread
-   void performWork();
-   /// Entry point for worker threads
-   static void asyncWorker(void*);
+   /// Run an execution point on a worker thread
+   void runPoint(RegisteredPoint* p);
 
    public:
-   /// Constructor
+   /// Constructor. The number of threads is taken from MAXTHREADS
    Scheduler();
+   /// Constructor. Use at most the given number of threads
+   explicit Scheduler(unsigned threads);
    /// Destructor
    ~Scheduler();
 
+   /// The number of threads that can work on the plan (0 means single threaded)
+   unsigned getThreads() const { return threads; }
    /// The current position within the execution points
    unsigned getRegisteredPoints() const { return registeredPoints.size(); }
    /// Register an async execution point
    void registerAsyncPoint(AsyncPoint& point,unsigned schedulingClass,double priority,unsigned dependencies);
 
+   /// Run body(0)..body(n-1), spreading the calls over the worker threads. The caller takes part in the work
+   void parallelFor(unsigned n,const std::function<void(unsigned)>& body);
+
    /// Execute a plan single threaded
    void executeSingleThreaded(Operator* root);
    /// Execute a plan using, using potentially multiple threads
@@ -60,6 +60,8 @@ class TemporaryDictionary
    bool lookup(const std::string& text,Type::ID type,unsigned subType, uint64_t& id);
    /// Lookup a string for a given id
    bool lookupById(uint64_t id,const char*& start,const char*& stop,Type::ID& type,unsigned& subType);
+   /// Is the id stored in this dictionary (and not in the underlying one)?
+   bool isTemporary(uint64_t id) const { return id>=idBase; }
 };
 //---------------------------------------------------------------------------
 #endif
@@ -16,6 +16,7 @@
 #include <rts/operator/Operator.hpp>
 #include <rts/operator/PlanPrinter.hpp>
 #include <rts/operator/ResultsPrinter.hpp>
+#include <rts/operator/Scheduler.hpp>
 //END RDF3x dependencies
 
 #include <string>
@@ -24,7 +25,7 @@ using namespace std;
 
 DDLEXPORT void execNativeQuery(ProgramArgs &vm, Querier *q, KB &kb, bool silent);
 DDLEXPORT void callRDF3X(TridentLayer &db, const string &queryFileName, bool explain,
-        bool disableBifocalSampling, bool resultslookup);
+        bool disableBifocalSampling, bool resultslookup, int threads);
 
 std::unique_ptr<Query> createQueryFromRF3XQueryGraph(SPARQLParser &parser,
         QueryGraph &graph) {
@@ -102,7 +103,7 @@ void parseQuery(bool &success,
 }
 
 void callRDF3X(TridentLayer &db, const string &queryFileName, bool explain,
-        bool disableBifocalSampling, bool resultslookup) {
+        bool disableBifocalSampling, bool resultslookup, int threads) {
     QueryDict queryDict(db.getNextId());
     bool parsingOk;
 
@@ -164,9 +165,8 @@ void callRDF3X(TridentLayer &db, const string &queryFileName, bool explain,
         delete operatorTree;
     } else {
         std::chrono::system_clock::time_point startQ = std::chrono::system_clock::now();
-        if (operatorTree->first()) {
-            while (operatorTree->next());
-        }
+        Scheduler scheduler(threads);
+        scheduler.execute(operatorTree);
         std::chrono::duration<double> durationQ = std::chrono::system_clock::now() - startQ;
         std::chrono::duration<double> duration = std::chrono::system_clock::now() - start;
         LOG(INFOL) << "Runtime queryopti: " << durationO.count() * 1000 << "ms.";
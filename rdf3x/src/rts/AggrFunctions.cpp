@@ -218,6 +218,5 @@ void AggrFunctions::addMergeHint(Register* reg1,Register* reg2) {
 
 /// Register parts of the tree that can be executed asynchronous
 void AggrFunctions::getAsyncInputCandidates(Scheduler& scheduler) {
-    LOG(ERRORL) << "Not implemented yet: AggrFunctions::getAsyncInputCandidates";
-    throw 10;
+    child->getAsyncInputCandidates(scheduler);
 }
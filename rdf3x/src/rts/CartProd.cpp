@@ -203,5 +203,7 @@ void CartProd::addMergeHint(Register* /*reg1*/, Register* /*reg2*/)
 void CartProd::getAsyncInputCandidates(Scheduler& scheduler)
     // Register parts of the tree that can be executed asynchronous
 {
+    left->getAsyncInputCandidates(scheduler);
+    right->getAsyncInputCandidates(scheduler);
 }
 //---------------------------------------------------------------------------
@@ -1,9 +1,11 @@
 #include "rts/operator/HashJoin.hpp"
+#include "rts/operator/IndexScan.hpp"
 #include "rts/operator/PlanPrinter.hpp"
 #include "rts/runtime/Runtime.hpp"
 
 #include <kognac/logs.h>
 
+#include <chrono>
 #include <iostream>
 //---------------------------------------------------------------------------
 // RDF-3X
@@ -23,6 +25,8 @@ static inline uint64_t hash1(uint64_t key, uint64_t hashTableSize) {
 static inline uint64_t hash2(uint64_t key, uint64_t hashTableSize) {
     return hashTableSize + ((key ^ (key >> 3)) & (hashTableSize - 1));
 }
+/// Smaller inputs are not worth reading with several threads
+static const double minParallelBuildCardinality = 100000;
 //---------------------------------------------------------------------------
 //
 void HashJoin::BuildHashTable::run()
@@ -47,7 +51,7 @@ void HashJoin::BuildHashTable::run()
     uint64_t tailLength = join.leftTail.size();
     join.hashTable.clear();
     join.hashTable.resize(2 * hashTableSize);
-    for (uint64_t leftCount = join.left->first(); leftCount; leftCount = join.left->next()) {
+    auto add = [&](uint64_t leftCount) {
         // Check the domain first
         bool joinCandidate = true;
         for (uint64_t index = 0, limit = domainRegs.size(); index < limit; ++index) {
@@ -58,7 +62,7 @@ void HashJoin::BuildHashTable::run()
             observedDomains[index].add(domainRegs[index]->value);
         }
         if (!joinCandidate)
-            continue;
+            return;
         // Compute the slots
         uint64_t leftKey = leftValue->value;
         uint64_t slot1 = hash1(leftKey, hashTableSize), slot2 = hash2(leftKey, hashTableSize);
@@ -87,7 +91,7 @@ void HashJoin::BuildHashTable::run()
                     }
                 }
             if (match)
-                continue;
+                return;
 
             // Append to the current bucket
             e = join.entryPool.alloc();
@@ -97,7 +101,7 @@ void HashJoin::BuildHashTable::run()
             e->count = leftCount;
             for (uint64_t index2 = 0; index2 < tailLength; index2++)
                 e->values[index2] = join.leftTail[index2]->value;
-            continue;
+            return;
         }
 
         // Create a new tuple
@@ -112,6 +116,24 @@ void HashJoin::BuildHashTable::run()
         // And insert it
         join.insert(e);
         hashTableSize = join.hashTable.size() / 2;
+    };
+
+    // Large scans are read in key ranges by all threads, and then inserted
+    IndexScan* scan = dynamic_cast<IndexScan*>(join.left);
+    if (join.scheduler && (join.scheduler->getThreads() > 1) && scan &&
+            (scan->getExpectedOutputCardinality() >= minParallelBuildCardinality) &&
+            scan->canReadParallel()) {
+        vector<vector<uint64_t>> parts;
+        scan->readParallel(*join.scheduler, parts);
+        for (vector<vector<uint64_t>>::const_iterator iter = parts.begin(), limit = parts.end(); iter != limit; ++iter) {
+            for (size_t index = 0; index < iter->size(); index += 3) {
+                scan->loadTuple(&(*iter)[index]);
+                add(1);
+            }
+        }
+    } else {
+        for (uint64_t leftCount = join.left->first(); leftCount; leftCount = join.left->next())
+            add(leftCount);
     }
 
     // Update the domains
@@ -139,7 +161,7 @@ HashJoin::HashJoin(Operator* left, Register* leftValue, const vector<Register*>&
     : Operator(expectedOutputCardinality), left(left), right(right), leftValue(leftValue), rightValue(rightValue),
     leftTail(leftTail), rightTail(rightTail), entryPool(leftTail.size() * sizeof(uint64_t)),
     bitset(bitset), buildHashTableTask(*this), probePeekTask(*this), hashPriority(hashPriority), probePriority(probePriority),
-    leftOptional(leftOptional), rightOptional(rightOptional)
+    scheduler(0), leftOptional(leftOptional), rightOptional(rightOptional)
       // Constructor
 {
 }
@@ -310,12 +332,13 @@ void HashJoin::addMergeHint(Register* /*reg1*/, Register* /*reg2*/)
 void HashJoin::getAsyncInputCandidates(Scheduler& scheduler)
     // Register parts of the tree that can be executed asynchronous
 {
+    this->scheduler = &scheduler;
     uint64_t p1 = scheduler.getRegisteredPoints();
     left->getAsyncInputCandidates(scheduler);
     scheduler.registerAsyncPoint(buildHashTableTask, 0, hashPriority, p1);
 
-    uint64_t p2 = scheduler.getRegisteredPoints();
+    // The probe side is not peeked asynchronously: first() reads it again
+    // anyway, and it must wait for the hash keys set by the build
     right->getAsyncInputCandidates(scheduler);
-    scheduler.registerAsyncPoint(probePeekTask, 1, probePriority, p2);
 }
 //---------------------------------------------------------------------------
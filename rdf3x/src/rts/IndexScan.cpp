@@ -1,6 +1,11 @@
 #include "rts/operator/IndexScan.hpp"
 #include "rts/operator/PlanPrinter.hpp"
 #include "rts/runtime/Runtime.hpp"
+#include "rts/operator/Scheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 //---------------------------------------------------------------------------
 // RDF-3X
 // (c) 2008 Thomas Neumann. Web site: http://www.mpi-inf.mpg.de/~neumann/rdf3x
@@ -222,7 +227,7 @@ void IndexScan::IndexScanHint::next(uint64_t& value1, uint64_t& value2, uint64_t
 }
 //---------------------------------------------------------------------------
 IndexScan::IndexScan(DBLayer& db, DBLayer::DataOrder order, Register* value1, bool bound1, Register* value2, bool bound2, Register* value3, bool bound3, double expectedOutputCardinality)
-    : Operator(expectedOutputCardinality), value1(value1), value2(value2), value3(value3), bound1(bound1), bound2(bound2), bound3(bound3)/*,facts(db.getFacts(order))*/, order(order),
+    : Operator(expectedOutputCardinality), db(db), value1(value1), value2(value2), value3(value3), bound1(bound1), bound2(bound2), bound3(bound3)/*,facts(db.getFacts(order))*/, order(order),
       hint(*this), scan(db.getScan(order, DBLayer::AGGR_NO, &hint))
       //,scan(disableSkipping?0:&hint),hint(*this)
       // Constructor
@@ -312,6 +317,112 @@ void IndexScan::getAsyncInputCandidates(Scheduler& /*scheduler*/)
 {
 }
 //---------------------------------------------------------------------------
+bool IndexScan::canReadParallel()
+// Can readParallel be used?
+{
+    // Lookups of one or two values are too small to be split
+    if (bound1 && bound2)
+        return false;
+    return db.getScan(order, DBLayer::AGGR_NO, NULL)->setRangeStart(0, bound1);
+}
+//---------------------------------------------------------------------------
+void IndexScan::readParallel(Scheduler& scheduler, std::vector<std::vector<uint64_t> >& parts)
+// Read all tuples using the threads of the scheduler
+{
+    // The scan is split on the first value that is not bound
+    const uint64_t stop1 = value1->value, filter2 = value2->value, filter3 = value3->value;
+    const uint64_t nextId = db.getNextId();
+
+    // The key ranges that still have to be read. A worker that is reading a
+    // range gives away the upper half of it when another worker is idle, so
+    // that also skewed ranges are spread over all threads
+    std::mutex lock;
+    std::condition_variable signal;
+    std::vector<std::pair<uint64_t, uint64_t> > ranges;
+    ranges.push_back(std::make_pair(0, ~static_cast<uint64_t>(0)));
+    unsigned busy = 0;
+    bool failed = false;
+    std::atomic<unsigned> idle(0);
+
+    const unsigned threads = std::max(scheduler.getThreads(), 1u);
+    parts.clear();
+    parts.resize(threads);
+    scheduler.parallelFor(threads, [&](unsigned worker) {
+        std::unique_ptr<DBLayer::Scan> s = db.getScan(order, DBLayer::AGGR_NO, NULL);
+        std::vector<uint64_t>& out = parts[worker];
+        std::unique_lock<std::mutex> guard(lock);
+        while (!failed) {
+            if (ranges.empty()) {
+                if (!busy)
+                    break;
+                idle++;
+                signal.wait(guard);
+                idle--;
+                continue;
+            }
+            uint64_t lo = ranges.back().first, hi = ranges.back().second;
+            ranges.pop_back();
+            busy++;
+            guard.unlock();
+
+            try {
+                s->setRangeStart(lo, bound1);
+                bool ok = bound1 ? s->first(stop1, true, 0, false, 0, false) : s->first();
+                for (uint64_t rows = 0; ok; ok = s->next()) {
+                    if (bound1 && (s->getValue1() != stop1))
+                        break;
+                    uint64_t v = bound1 ? s->getValue2() : s->getValue1();
+                    if (v >= hi)
+                        break;
+                    if (((++rows) % 4096 == 0) && idle) {
+                        // Give the upper half of the range to an idle worker
+                        std::lock_guard<std::mutex> g(lock);
+                        uint64_t end = std::min(hi, nextId);
+                        if (ranges.empty() && (end > v + 1)) {
+                            uint64_t mid = v + (end - v) / 2;
+                            ranges.push_back(std::make_pair(mid, hi));
+                            hi = mid;
+                            signal.notify_one();
+                        }
+                    }
+                    if ((!bound1) && bound2 && (s->getValue2() != filter2))
+                        continue;
+                    if (bound3 && (s->getValue3() != filter3))
+                        continue;
+                    out.push_back(s->getValue1());
+                    out.push_back(s->getValue2());
+                    out.push_back(s->getValue3());
+                }
+            } catch (...) {
+                // Wake up the workers that wait for this range, so that they
+                // stop and parallelFor can report the error
+                guard.lock();
+                busy--;
+                failed = true;
+                signal.notify_all();
+                throw;
+            }
+
+            guard.lock();
+            busy--;
+            if (ranges.empty() && !busy)
+                signal.notify_all();
+        }
+    });
+
+    observedOutputCardinality = 0;
+    for (std::vector<std::vector<uint64_t> >::const_iterator iter = parts.begin(), limit = parts.end(); iter != limit; ++iter)
+        observedOutputCardinality += iter->size() / 3;
+}
+//---------------------------------------------------------------------------
+void IndexScan::loadTuple(const uint64_t* tuple)
+// Store a tuple produced by readParallel in the registers
+{
+    value1->value = tuple[0];
+    value2->value = tuple[1];
+    value3->value = tuple[2];
+}
+//---------------------------------------------------------------------------
 IndexScan* IndexScan::create(DBLayer& db, DBLayer::DataOrder order, Register* subject, bool subjectBound, Register* predicate, bool predicateBound, Register* object, bool objectBound, double expectedOutputCardinality)
 // Constructor
 {
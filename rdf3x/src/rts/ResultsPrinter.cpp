@@ -12,6 +12,8 @@
 #include <set>
 #include <cstring>
 #include <sstream>
+#include <unordered_map>
+#include <algorithm>
 //---------------------------------------------------------------------------
 // RDF-3X
 // (c) 2008 Thomas Neumann. Web site: http://www.mpi-inf.mpg.de/~neumann/rdf3x
@@ -25,7 +27,7 @@
 using namespace std;
 //---------------------------------------------------------------------------
 ResultsPrinter::ResultsPrinter(Runtime& runtime, Operator* input, const vector<Register*>& output, DuplicateHandling duplicateHandling, uint64_t limit, uint64_t offset, bool silent)
-    : Operator(1), output(output), input(input), runtime(runtime), dictionary(runtime.getDatabase()), duplicateHandling(duplicateHandling), outputMode(DefaultOutput), limit(limit), offset(offset), silent(silent), nrows(0), jsonoutput(NULL), outputset(NULL)
+    : Operator(1), output(output), input(input), runtime(runtime), dictionary(runtime.getDatabase()), duplicateHandling(duplicateHandling), outputMode(DefaultOutput), limit(limit), offset(offset), silent(silent), nrows(0), jsonoutput(NULL), writer(NULL), outputset(NULL)
       // Constructor
 {
 }
@@ -157,6 +159,102 @@ namespace {
             }
         }
     }
+    //---------------------------------------------------------------------------
+    /// Resolves the ids of a block of rows with a single pass over the
+    /// dictionary. The terms of the last blocks are kept in a bounded cache
+    class TermDecoder {
+        /// A resolved term
+        struct Term {
+            std::string text;
+            Type::ID type;
+        };
+        /// The dictionaries
+        DBLayer& dictionary;
+        TemporaryDictionary* tempDict;
+        QueryDict* dictQuery;
+        /// The cache. When the current generation is full, it replaces the
+        /// previous one. Terms of the previous generation that are used
+        /// again are copied in the current one
+        const size_t maxCached;
+        std::unordered_map<uint64_t, Term> current, previous;
+        /// Support structures for the lookups
+        std::vector<uint64_t> toLookup;
+        std::string texts;
+        std::vector<std::pair<size_t, size_t>> positions;
+        std::vector<Type::ID> types;
+
+        public:
+        /// Constructor
+        TermDecoder(DBLayer& dictionary, TemporaryDictionary* tempDict,
+                QueryDict* dictQuery, size_t maxCached = 1 << 16)
+            : dictionary(dictionary), tempDict(tempDict), dictQuery(dictQuery),
+            maxCached(maxCached) {}
+        /// Resolve the ids (they are sorted in the process). Afterwards,
+        /// get() can be called for each of them until the next call
+        void resolve(vector<uint64_t>& ids);
+        /// Get the string of an id that was resolved
+        void get(uint64_t id, CacheEntry& c) const;
+    };
+    //---------------------------------------------------------------------------
+    void TermDecoder::resolve(vector<uint64_t>& ids)
+        // Resolve the ids
+    {
+        if (current.size() >= maxCached / 2) {
+            previous.swap(current);
+            current.clear();
+        }
+        sort(ids.begin(), ids.end());
+        toLookup.clear();
+        for (vector<uint64_t>::const_iterator iter = ids.begin(),
+                limit = ids.end(); iter != limit; ++iter) {
+            uint64_t id = *iter;
+            if ((iter != ids.begin() && *(iter - 1) == id) || !~id ||
+                    DictMgmt::isnumeric(id) || current.count(id))
+                continue;
+            unordered_map<uint64_t, Term>::const_iterator p = previous.find(id);
+            if (p != previous.end()) {
+                current.insert(*p);
+            } else if (dictQuery && dictQuery->hasID(id)) {
+                std::pair<char*, char*> pair = dictQuery->getStringBoundaries(id);
+                Term& t = current[id];
+                t.text.assign(pair.first, pair.second);
+                t.type = Type::Literal;
+            } else if (tempDict && tempDict->isTemporary(id)) {
+                const char *start, *stop;
+                unsigned subType;
+                Term& t = current[id];
+                t.type = Type::Literal;
+                if (tempDict->lookupById(id, start, stop, t.type, subType))
+                    t.text.assign(start, stop);
+            } else {
+                toLookup.push_back(id);
+            }
+        }
+        if (toLookup.empty())
+            return;
+        // The remaining ids are resolved together
+        dictionary.lookupByIds(toLookup, texts, positions, types);
+        for (size_t i = 0; i < toLookup.size(); ++i) {
+            Term& t = current[toLookup[i]];
+            t.text.assign(texts, positions[i].first, positions[i].second);
+            t.type = types[i];
+        }
+    }
+    //---------------------------------------------------------------------------
+    void TermDecoder::get(uint64_t id, CacheEntry& c) const
+        // Get the string of an id that was resolved
+    {
+        unordered_map<uint64_t, Term>::const_iterator t = current.find(id);
+        if (t == current.end()) {
+            c.start = c.stop = 0;
+            c.type = Type::Literal;
+        } else {
+            c.start = t->second.text.data();
+            c.stop = c.start + t->second.text.size();
+            c.type = t->second.type;
+        }
+        c.subType = 0;
+    }
 };
 //---------------------------------------------------------------------------
 void formatJSONRow(const std::vector<std::string> &columns,
@@ -235,12 +333,96 @@ void ResultsPrinter::formatJSON(const std::vector<string> &columns,
     }
 }
 //---------------------------------------------------------------------------
+void ResultsPrinter::streamResults(uint64_t count, uint64_t o,
+        const std::function<bool(const std::vector<std::string>&)>& emit)
+    // Pass the rows to emit as soon as a block of them is produced
+{
+    TemporaryDictionary* tempDict = runtime.hasTemporaryDictionary() ?
+        (&runtime.getTemporaryDictionary()) : 0;
+    QueryDict *dictQuery = runtime.getQueryDict();
+    if (dictQuery && dictQuery->isEmpty()) dictQuery = NULL;
+    TermDecoder decoder(dictionary, tempDict, dictQuery);
+
+    // The rows are collected in blocks, and the ids of a block are resolved
+    // together
+    const uint64_t blockSize = 1024;
+    const size_t columns = output.size();
+    uint64_t minCount = (duplicateHandling == ShowDuplicates) ? 2 : 1;
+    vector<uint64_t> block, ids;
+    vector<string> values(columns);
+    ostringstream ss;
+    uint64_t pending = 0;
+    bool done = false;
+    while (!done) {
+        // Collect a block
+        block.clear();
+        ids.clear();
+        do {
+            if (count < minCount) continue;
+            if (o > 0)  {
+                if (o >= count) {
+                    o -= count;
+                    continue;
+                }
+                count -= o;
+                o = 0;
+            }
+            uint64_t copies = (duplicateHandling == ExpandDuplicates) ? count : 1;
+            block.push_back(copies);
+            for (vector<Register*>::const_iterator iter = output.begin(),
+                    limit = output.end(); iter != limit; ++iter) {
+                block.push_back((*iter)->value);
+                ids.push_back((*iter)->value);
+            }
+            pending += copies;
+            if (block.size() >= blockSize * (columns + 1) ||
+                    nrows + pending >= limit) {
+                count = input->next();
+                break;
+            }
+        } while ((count = input->next()) != 0);
+        done = (count == 0) || nrows + pending >= limit;
+
+        // Decode and emit it. The consumer can block, and this stops the
+        // operator tree as well
+        decoder.resolve(ids);
+        for (vector<uint64_t>::const_iterator iter = block.begin(),
+                limit = block.end(); iter != limit; iter += columns + 1) {
+            for (size_t i = 0; i < columns; ++i) {
+                uint64_t id = iter[i + 1];
+                if (!~id) {
+                    values[i].clear();
+                } else if (DictMgmt::isnumeric(id)) {
+                    values[i] = DictMgmt::tostr(id);
+                } else {
+                    CacheEntry c;
+                    decoder.get(id, c);
+                    ss.str("");
+                    c.print(ss, false);
+                    values[i] = ss.str();
+                }
+            }
+            for (uint64_t copies = *iter; copies > 0; copies--) {
+                pending--;
+                if (!emit(values))
+                    return;
+                if ((++nrows) >= this->limit)
+                    return;
+            }
+        }
+    }
+}
+//---------------------------------------------------------------------------
 uint64_t ResultsPrinter::first()
     // Produce the first tuple
 {
     observedOutputCardinality = 1;
     uint64_t o = offset;
 
+    if (writer && !writer->begin(jsonvars)) {
+        return 1;
+    }
+
     // Empty input?
     uint64_t count;
     if ((count = input->first()) == 0) {
@@ -266,6 +448,14 @@ uint64_t ResultsPrinter::first()
         return 1;
     }
 
+    if (writer) {
+        if (limit > 0)
+            streamResults(count, o, [this](const vector<string>& values) {
+                    return writer->writeRow(values);
+                    });
+        return 1;
+    }
+
     if (silent && !jsonoutput) {
         //Count the rows and output a single line
         do {
@@ -287,60 +477,25 @@ uint64_t ResultsPrinter::first()
         return 1;
     }
 
-    //If there are no modifiers I simply print out the strings as they come
-    //without any caching...
+    //If there are no modifiers I simply print out the rows as they come,
+    //one block at the time...
     TemporaryDictionary* tempDict = runtime.hasTemporaryDictionary() ?
         (&runtime.getTemporaryDictionary()) : 0;
     QueryDict *dictQuery = runtime.getQueryDict();
     if (dictQuery && dictQuery->isEmpty()) dictQuery = NULL;
     if (!silent && !jsonoutput && duplicateHandling == ExpandDuplicates) {
-        do {
-	    if (o > 0)  {
-		if (o >= count) {
-		    o -= count;
-		    continue;
-		}
-		count -= o;
-		o = 0;
-	    }
-	    stringstream ss;
-            for (vector<Register*>::const_iterator iter = output.begin(),
-                    limit = output.end(); iter != limit; ++iter) {
-                uint64_t id = (*iter)->value;
-                if (DictMgmt::isnumeric(id)) {
-                    ss << DictMgmt::tostr(id);
-                } else {
-                    CacheEntry c;
-                    if (dictQuery && dictQuery->hasID(id)) {
-                        //I need to set c.start and c.stop
-                        std::pair<char*, char*> pair = dictQuery->getStringBoundaries(id);
-                        c.start = pair.first;
-                        c.stop = pair.second;
-                        c.type = Type::Literal;
-                    } else {
-                        if (tempDict)
-                            tempDict->lookupById(id, c.start, c.stop, c.type, c.subType);
-                        else
-                            dictionary.lookupById(id, c.start, c.stop, c.type, c.subType);
-                    }
-                    //print cache entry
-                    c.print(ss, false);
+        string line;
+        streamResults(count, o, [&line](const vector<string>& values) {
+                line.clear();
+                for (vector<string>::const_iterator iter = values.begin(),
+                        limit = values.end(); iter != limit; ++iter) {
+                    line += iter->empty() ? "NULL" : *iter;
+                    line += ' ';
                 }
-		ss << ' ';
-            }
-            ss << '\n';
-	    std::string s = ss.str();
-	    while (count > 0) {
-		cout << s;
-		nrows++;
-		if (nrows >= limit)
-		    break;
-		count--;
-	    }
-	    if (nrows >= limit) {
-		break;
-	    }
-        } while ((count = input->next()) != 0);
+                line += '\n';
+                cout << line;
+                return true;
+                });
         return 1;
     }
 
@@ -374,40 +529,43 @@ uint64_t ResultsPrinter::first()
     std::unique_ptr<char[]> buf_current(new char[buf_max]);
     size_t buf_size = 0;
 
-    // Lookup the strings
-    set<unsigned> subTypes;
+    // Lookup the strings. The ids of the database are resolved together,
+    // in a single pass over the dictionary
+    vector<uint64_t> dbIds;
+    vector<CacheEntry*> dbEntries;
     for (map<uint64_t, CacheEntry>::iterator iter = stringCache.begin(),
             limit = stringCache.end(); iter != limit; ++iter) {
         CacheEntry& c = (*iter).second;
-
+        c.subType = 0;
         if (dictQuery && dictQuery->hasID(iter->first)) {
             //I need to set c.start and c.stop
             std::pair<char*, char*> pair = dictQuery->getStringBoundaries(iter->first);
             c.start = pair.first;
             c.stop = pair.second;
             c.type = Type::Literal;
+        } else if (tempDict && tempDict->isTemporary(iter->first)) {
+            tempDict->lookupById((*iter).first, c.start, c.stop, c.type, c.subType);
         } else {
-            if (tempDict)
-                tempDict->lookupById((*iter).first, c.start, c.stop, c.type, c.subType);
-            else
-                dictionary.lookupById((*iter).first, c.start, c.stop, c.type, c.subType);
-
-            //Copy the text in a permanent data structure
-            const size_t len = c.stop - c.start;
-            if (len > buf_max - buf_size) {
-                buf_all.push_back(std::move(buf_current));
-                buf_current = std::unique_ptr<char[]>(new char[buf_max]);
-                buf_size = 0;
-            }
-            memcpy(buf_current.get() + buf_size, c.start, len);
-            c.start = buf_current.get() + buf_size;
-            c.stop = c.start + len;
-            buf_size += len;
-            //Copying done
+            dbIds.push_back(iter->first);
+            dbEntries.push_back(&c);
         }
+    }
+    string texts;
+    vector<pair<size_t, size_t>> positions;
+    vector<Type::ID> types;
+    dictionary.lookupByIds(dbIds, texts, positions, types);
+    for (size_t i = 0; i < dbIds.size(); ++i) {
+        CacheEntry& c = *dbEntries[i];
+        c.start = texts.data() + positions[i].first;
+        c.stop = c.start + positions[i].second;
+        c.type = types[i];
+    }
 
-        if (Type::hasSubType(c.type))
-            subTypes.insert(c.subType);
+    set<unsigned> subTypes;
+    for (map<uint64_t, CacheEntry>::const_iterator iter = stringCache.begin(),
+            limit = stringCache.end(); iter != limit; ++iter) {
+        if (Type::hasSubType(iter->second.type))
+            subTypes.insert(iter->second.subType);
     }
 
     for (set<unsigned>::const_iterator iter = subTypes.begin(),
@@ -2,9 +2,122 @@
 #include "rts/operator/Operator.hpp"
 #include "infra/osdep/Thread.hpp"
 #include <cstdlib>
+#include <deque>
+#include <memory>
 //---------------------------------------------------------------------------
 using namespace std;
 //---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// The worker threads. They are shared by all schedulers, so that concurrent
+/// queries do not start (and stop) their own threads
+class WorkerPool
+{
+   private:
+   /// A synchronization lock
+   Mutex lock;
+   /// Notification
+   Event signal;
+   /// The queue of tasks
+   deque<function<void()> > tasks;
+   /// The number of worker threads
+   unsigned workers;
+
+   /// Constructor
+   WorkerPool() : workers(0) {}
+
+   /// Entry point for worker threads
+   static void asyncWorker(void* info);
+
+   public:
+   /// The pool. It is never destroyed since the workers live until the process exits
+   static WorkerPool& get() { static WorkerPool* pool=new WorkerPool(); return *pool; }
+
+   /// Queue a task. Make sure that at least minWorkers threads are running
+   void submit(const function<void()>& task,unsigned minWorkers);
+};
+//---------------------------------------------------------------------------
+void WorkerPool::asyncWorker(void* info)
+   // Thread entry point
+{
+   WorkerPool& pool=*static_cast<WorkerPool*>(info);
+   pool.lock.lock();
+   while (true) {
+      // Nothing to do?
+      if (pool.tasks.empty()) {
+         pool.signal.wait(pool.lock);
+         continue;
+      }
+      // Grab the next job
+      function<void()> task=pool.tasks.front();
+      pool.tasks.pop_front();
+
+      // Run the job
+      pool.lock.unlock();
+      task();
+      pool.lock.lock();
+   }
+}
+//---------------------------------------------------------------------------
+void WorkerPool::submit(const function<void()>& task,unsigned minWorkers)
+   // Queue a task
+{
+   auto_lock guard(lock);
+   while (workers<minWorkers) {
+      if (!Thread::start(asyncWorker,this))
+         break;
+      workers++;
+   }
+   tasks.push_back(task);
+   signal.notify(lock);
+}
+//---------------------------------------------------------------------------
+/// The state of a parallelFor call
+struct ParallelLoop {
+   /// The loop body
+   function<void(unsigned)> body;
+   /// A synchronization lock
+   Mutex lock;
+   /// Notification
+   Event signal;
+   /// The next iteration to hand out and the number of iterations
+   unsigned next,n;
+   /// The number of iterations that are running
+   unsigned running;
+   /// The first exception thrown by the body
+   exception_ptr failure;
+
+   /// Constructor
+   ParallelLoop(const function<void(unsigned)>& body,unsigned n) : body(body),next(0),n(n),running(0) {}
+
+   /// Run iterations until there are none left
+   void work();
+};
+//---------------------------------------------------------------------------
+void ParallelLoop::work()
+   // Run iterations until there are none left
+{
+   lock.lock();
+   while (next<n) {
+      unsigned i=next++;
+      running++;
+      lock.unlock();
+      try {
+         body(i);
+      } catch (...) {
+         auto_lock guard(lock);
+         if (!failure)
+            failure=current_exception();
+      }
+      lock.lock();
+      running--;
+      signal.notifyAll(lock);
+   }
+   lock.unlock();
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
 Scheduler::AsyncPoint::~AsyncPoint()
    // Destructor
 {
@@ -17,7 +130,7 @@ Scheduler::RegisteredPoint::RegisteredPoint(AsyncPoint& point,unsigned schedulin
 }
 //---------------------------------------------------------------------------
 Scheduler::Scheduler()
-   : activeWorkers(0),workerThreads(0),workersDie(false)
+   : activeWorkers(0)
    // Constructor
 {
    // How many threads should we use?
@@ -26,28 +139,24 @@ Scheduler::Scheduler()
       threads=atoi(getenv("MAXTHREADS"));
    if ((threads<2)||(threads>1000))
       threads=0;
-
-   // Start worker threads
-   if (threads) {
-      workerLock.lock();
-      for (unsigned index=0;index<threads;index++)
-         Thread::start(asyncWorker,this);
-      workerLock.unlock();
-   }
+}
+//---------------------------------------------------------------------------
+Scheduler::Scheduler(unsigned threads)
+   : threads(threads),activeWorkers(0)
+   // Constructor
+{
+   if ((threads<2)||(threads>1000))
+      this->threads=0;
 }
 //---------------------------------------------------------------------------
 Scheduler::~Scheduler()
    // Destructor
 {
-   // Wait for all workers to stop
-   if (threads) {
-      workerLock.lock();
-      workersDie=true;
-      workerSignal.notifyAll(workerLock);
-      while (workerThreads)
-         workerSignal.wait(workerLock);
-      workerLock.unlock();
-   }
+   // Wait for the execution points that are still running
+   workerLock.lock();
+   while (activeWorkers)
+      workerSignal.wait(workerLock);
+   workerLock.unlock();
 
    // Cleanup registered execution points
    for (vector<RegisteredPoint*>::const_iterator iter=registeredPoints.begin(),limit=registeredPoints.end();iter!=limit;++iter)
@@ -64,6 +173,32 @@ void Scheduler::registerAsyncPoint(AsyncPoint& point,unsigned schedulingClass,do
    registeredPoints.push_back(p);
 }
 //---------------------------------------------------------------------------
+void Scheduler::parallelFor(unsigned n,const function<void(unsigned)>& body)
+   // Run body(0)..body(n-1) using the worker threads
+{
+   if ((threads<2)||(n<2)) {
+      for (unsigned index=0;index<n;index++)
+         body(index);
+      return;
+   }
+
+   // Helpers that start when all iterations are taken return immediately, so
+   // we only wait for the iterations that are running. This way a loop never
+   // waits for a helper that is stuck in the queue behind other tasks
+   shared_ptr<ParallelLoop> loop(new ParallelLoop(body,n));
+   unsigned helpers=min(n,threads)-1;
+   for (unsigned index=0;index<helpers;index++)
+      WorkerPool::get().submit([loop]() { loop->work(); },threads);
+   loop->work();
+
+   loop->lock.lock();
+   while (loop->running)
+      loop->signal.wait(loop->lock);
+   loop->lock.unlock();
+   if (loop->failure)
+      rethrow_exception(loop->failure);
+}
+//---------------------------------------------------------------------------
 void Scheduler::executeSingleThreaded(Operator* root)
    // Execute a plan single threaded
 {
@@ -72,51 +207,28 @@ void Scheduler::executeSingleThreaded(Operator* root)
    }
 }
 //---------------------------------------------------------------------------
-void Scheduler::performWork()
-   // Perform the work of a worker thread
+void Scheduler::runPoint(RegisteredPoint* p)
+   // Run an execution point on a worker thread
 {
-   // Register as worker
-   workerLock.lock();
-   workerThreads++;
-
-   // Perform the work
-   while (!workersDie) {
-      // Nothing to do?
-      if (workQueue.empty()) {
-         workerSignal.wait(workerLock);
-         continue;
-      }
-      // Grab the next job
-      RegisteredPoint* job=workQueue.front();
-      workQueue.erase(workQueue.begin());
-      workerSignal.notifyAll(workerLock);
-
-      // Run the job
-      activeWorkers++;
-      workerLock.unlock();
-      job->point.run();
-      workerLock.lock();
-      activeWorkers--;
-
-      // Eliminate it as done
-      for (vector<RegisteredPoint*>::iterator iter=registeredPoints.begin(),limit=registeredPoints.end();iter!=limit;++iter)
-         (*iter)->dependencies.erase(job);
-      delete job;
-      workerSignal.notifyAll(workerLock);
+   exception_ptr error;
+   try {
+      p->point.run();
+   } catch (...) {
+      error=current_exception();
    }
 
-   // Deregister
-   workerThreads--;
+   // Eliminate it as done
+   workerLock.lock();
+   for (vector<RegisteredPoint*>::iterator iter=registeredPoints.begin(),limit=registeredPoints.end();iter!=limit;++iter)
+      (*iter)->dependencies.erase(p);
+   delete p;
+   if (error&&!failure)
+      failure=error;
+   activeWorkers--;
    workerSignal.notifyAll(workerLock);
    workerLock.unlock();
 }
 //---------------------------------------------------------------------------
-void Scheduler::asyncWorker(void* info)
-   // Thread entry point
-{
-   static_cast<Scheduler*>(info)->performWork();
-}
-//---------------------------------------------------------------------------
 void Scheduler::execute(Operator* root)
    // Execute a plan using, using potentially multiple threads
 {
@@ -130,12 +242,14 @@ void Scheduler::execute(Operator* root)
    for (vector<RegisteredPoint*>::const_iterator iter=registeredPoints.begin(),limit=registeredPoints.end();iter!=limit;++iter)
       delete *iter;
    registeredPoints.clear();
+   failure=exception_ptr();
    root->getAsyncInputCandidates(*this);
 
    // Execute all asynchronous execution points
-   while (!registeredPoints.empty()) {
-      // Is the worker queue full?
-      if ((workQueue.size()+activeWorkers)>=threads) {
+   workerLock.lock();
+   while ((!registeredPoints.empty())&&(!failure)) {
+      // Are enough points running already?
+      if (activeWorkers>=threads) {
          workerSignal.wait(workerLock);
          continue;
       }
@@ -155,24 +269,26 @@ void Scheduler::execute(Operator* root)
       // No candidate found?
       if (!best) {
          // Still work?
-         if (activeWorkers||workQueue.size()) {
+         if (activeWorkers) {
             workerSignal.wait(workerLock);
             continue;
          }
          // No, cyclic dependency!
-         throw;
+         workerLock.unlock();
+         throw 10;
       }
-      // Add the task
-      workQueue.push_back(best);
+      // Hand the task to the workers
       swap(*bestPos,registeredPoints.back());
       registeredPoints.pop_back();
-      workerSignal.notifyAll(workerLock);
+      activeWorkers++;
+      WorkerPool::get().submit([this,best]() { runPoint(best); },threads);
    }
-   while (!workQueue.empty())
-      workerSignal.wait(workerLock);
    while (activeWorkers)
       workerSignal.wait(workerLock);
+   exception_ptr error=failure;
    workerLock.unlock();
+   if (error)
+      rethrow_exception(error);
 
    // Now run the main parts if any
    if (root->first()) {
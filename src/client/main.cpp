@@ -50,6 +50,7 @@
 #include <cstdlib>
 #include <sstream>
 #include <fstream>
+#include <chrono>
 
 using namespace std;
 
@@ -60,7 +61,7 @@ extern bool checkMachineConstraints();
 //Implemented in main_sparql.cpp
 extern void execNativeQuery(ProgramArgs &vm, Querier *q, KB &kb, bool silent);
 extern void callRDF3X(TridentLayer &db, const string &queryFileName, bool explain,
-        bool disableBifocalSampling, bool resultslookup);
+        bool disableBifocalSampling, bool resultslookup, int threads);
 
 //Implemented in main_ml.cpp
 extern void launchML(KB &kb, string op, string algo, string paramsLearn,
@@ -72,6 +73,29 @@ extern void subgraphCreate(KB &kb, ProgramArgs &vm);
 //Implemented in kb.cpp
 extern bool _sort_by_number(const string &s1, const string &s2);
 
+void setAccessParams(ProgramArgs &vm, KBConfig &config) {
+    config.setParam(MAPPING_ADVICE, vm["mapAdvice"].as<string>());
+    config.setParamBool(MAPPING_WILLNEED_INDEX, vm["mapWillneed"].as<bool>());
+    config.setParamBool(MAPPING_POPULATE_FILES, vm["mapPopulate"].as<bool>());
+    config.setParamBool(MAPPING_HUGEPAGES_FILES, vm["mapHugePages"].as<bool>());
+    config.setParamInt(SCAN_PREFETCH_TABLES, vm["scanPrefetch"].as<int>());
+    config.setParamLong(SCAN_PREFETCH_BYTES, vm["scanPrefetchBytes"].as<int64_t>());
+    config.setParamBool(TREE_STATIC, vm["staticTree"].as<bool>());
+}
+
+void warmup(KB &kb, string perms) {
+    std::vector<int> permutations;
+    istringstream f(perms);
+    string s;
+    while (getline(f, s, ';')) {
+        permutations.push_back(stoi(s));
+    }
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    size_t npages = kb.warmup(permutations);
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Touched " << npages << " pages in " << sec.count() * 1000 << " ms";
+}
+
 void lookup(DictMgmt *dict, ProgramArgs &vm) {
     if (vm.count("text")) {
         nTerm value;
@@ -176,6 +200,9 @@ void testkb(string kbDir, ProgramArgs &vm) {
         p.sample = vm["sample"].as<bool>();
         p.sampleRate = vm["sampleRate"].as<double>();
         p.thresholdSkipTable = vm["thresholdSkipTable"].as<int>();
+        p.blockCompression = vm["blockCompr"].as<string>();
+        p.thresholdBlockCompression = vm["thresholdBlockCompr"].as<int64_t>();
+        p.thresholdEFDirectory = vm["efDir"].as<int64_t>();
         //p.logPtr = NULL;
         p.timeoutStats = -1;
         p.remoteLocation = "";
@@ -183,11 +210,18 @@ void testkb(string kbDir, ProgramArgs &vm) {
         p.graphTransformation = vm["gf"].as<string>();
         p.storeDicts = vm["storedicts"].as<bool>();
         p.flatTree = vm["flatTree"].as<bool>();
+        p.staticTree = vm["buildStaticTree"].as<bool>();
+        p.radixSort = vm["radixSort"].as<bool>();
+        p.maxMemory = vm["maxMemory"].as<int64_t>();
+        p.mergeFanIn = vm["mergeFanIn"].as<int>();
+        p.pipelineIndices = vm["pipelineIndices"].as<bool>();
+        p.profile = vm["profile"].as<string>();
 
         loader.load(p);
     }
 
     KBConfig config;
+    setAccessParams(vm, config);
     std::vector<string> locUpdates;
     KB kb(kbDir.c_str(), true, false, true, config, locUpdates);
 
@@ -243,10 +277,12 @@ void printInfo(KB &kb) {
 }
 
 #ifdef SERVER
-void startServer(KB &kb, int port, int nthreads) {
+void startServer(KB &kb, int port, int nthreads, int queryThreads,
+        int planCacheSize, int maxQueuedRequests, int requestTimeout) {
     std::unique_ptr<TridentServer> webint;
     webint = std::unique_ptr<TridentServer>(
-            new TridentServer(kb, "./../webinterface", nthreads));
+            new TridentServer(kb, "./../webinterface", nthreads, queryThreads,
+                planCacheSize, maxQueuedRequests, requestTimeout));
     webint->start(port);
     LOG(INFOL) << "Server is launched at 0.0.0.0:" << to_string(port);
     webint->join();
@@ -335,11 +371,13 @@ int main(int argc, const char** argv) {
     if (cmd == "query") {
 #ifdef SPARQL
         KBConfig config;
+        setAccessParams(vm, config);
         std::vector<string> locUpdates;
         KB kb(kbDir.c_str(), true, false, true, config, locUpdates, vm["enablePartials"].as<bool>());
         TridentLayer layer(kb);
         callRDF3X(layer, vm["query"].as<string>(), vm["explain"].as<bool>(),
-                vm["disbifsampl"].as<bool>(), vm["decodeoutput"].as<bool>());
+                vm["disbifsampl"].as<bool>(), vm["decodeoutput"].as<bool>(),
+                vm["queryThreads"].as<int>());
 
         int repeatQuery = vm["repeatQuery"].as<int>();
         ofstream file("/dev/null");
@@ -347,7 +385,8 @@ int main(int argc, const char** argv) {
         cout.rdbuf(file.rdbuf());
         while (repeatQuery > 0 && !vm["explain"].as<bool>()) {
             callRDF3X(layer, vm["query"].as<string>(), false,
-                    vm["disbifsampl"].as<bool>(), vm["decodeoutput"].as<bool>());
+                    vm["disbifsampl"].as<bool>(), vm["decodeoutput"].as<bool>(),
+                    vm["queryThreads"].as<int>());
             repeatQuery--;
         }
         cout.rdbuf(strm_buffer);
@@ -359,6 +398,7 @@ int main(int argc, const char** argv) {
     } else if (cmd == "query_native") {
 #ifdef SPARQL
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config, vm["enablePartials"].as<bool>());
         Querier *q = kb.query();
         execNativeQuery(vm, q, kb, ! vm["decodeoutput"].as<bool>());
@@ -380,6 +420,7 @@ int main(int argc, const char** argv) {
 #endif
     } else if (cmd == "lookup") {
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         lookup(kb.getDictMgmt(), vm);
     } else if (cmd == "testkb") {
@@ -442,6 +483,9 @@ int main(int argc, const char** argv) {
         p.sample = vm["sample"].as<bool>();
         p.sampleRate = vm["sampleRate"].as<double>();
         p.thresholdSkipTable = vm["thresholdSkipTable"].as<int>();
+        p.blockCompression = vm["blockCompr"].as<string>();
+        p.thresholdBlockCompression = vm["thresholdBlockCompr"].as<int64_t>();
+        p.thresholdEFDirectory = vm["efDir"].as<int64_t>();
         //p.logPtr = logptr;
         p.timeoutStats = vm["timeoutStats"].as<int>();
         p.remoteLocation = vm["remoteLoc"].as<string>();
@@ -450,11 +494,23 @@ int main(int argc, const char** argv) {
         p.storeDicts = vm["storedicts"].as<bool>();
         p.relsOwnIDs = vm["relsOwnIDs"].as<bool>();
         p.flatTree = vm["flatTree"].as<bool>();
+        p.staticTree = vm["buildStaticTree"].as<bool>();
+        p.radixSort = vm["radixSort"].as<bool>();
+        p.maxMemory = vm["maxMemory"].as<int64_t>();
+        p.mergeFanIn = vm["mergeFanIn"].as<int>();
+        p.pipelineIndices = vm["pipelineIndices"].as<bool>();
+        p.profile = vm["profile"].as<string>();
 
         loader.load(p);
 
+    } else if (cmd == "warmup") {
+        KBConfig config;
+        setAccessParams(vm, config);
+        KB kb(kbDir.c_str(), true, false, false, config);
+        warmup(kb, vm["warmupPerms"].as<string>());
     } else if (cmd == "info") {
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         printInfo(kb);
     } else if (cmd == "add") {
@@ -465,13 +521,19 @@ int main(int argc, const char** argv) {
         string updatedir = vm["update"].as<string>();
         Updater up;
         up.creatediffupdate(DiffIndex::TypeUpdate::DELETE_df, kbDir, updatedir);
+    } else if (cmd == "append") {
+        string updatedir = vm["update"].as<string>();
+        Updater up;
+        up.appendupdate(kbDir, updatedir);
     } else if (cmd == "merge") {
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         kb.mergeUpdates();
     } else if (cmd == "analytics") {
 #ifdef ANALYTICS
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         launchAnalytics(kb, vm["op"].as<string>(), vm["oparg1"].as<string>(),
                 vm["oparg2"].as<string>());
@@ -491,13 +553,17 @@ int main(int argc, const char** argv) {
 #endif
     } else if (cmd == "dump") {
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         dump(&kb, vm["output"].as<string>());
     } else if (cmd == "server") {
 #ifdef SERVER
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
-        startServer(kb, vm["port"].as<int>(), vm["webthreads"].as<int>());
+        startServer(kb, vm["port"].as<int>(), vm["webthreads"].as<int>(),
+                vm["queryThreads"].as<int>(), vm["planCacheSize"].as<int>(),
+                vm["webQueueSize"].as<int>(), vm["webTimeout"].as<int>());
 #else
         LOG(ERRORL) << "Trident was not compiled with the webserver. Add -DSERVER=1 to cmake";
         return EXIT_FAILURE;
@@ -505,6 +571,7 @@ int main(int argc, const char** argv) {
     } else if (cmd == "learn") {
 #ifdef ML
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         launchML(kb, cmd, vm["algo"].as<string>(), vm["args_learn"].as<string>(), "");
 #else
@@ -514,6 +581,7 @@ int main(int argc, const char** argv) {
     } else if (cmd == "predict") {
 #ifdef ML
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         launchML(kb, cmd, vm["algo"].as<string>(), "", vm["args_predict"].as<string>());
 #else
@@ -523,6 +591,7 @@ int main(int argc, const char** argv) {
     } else if (cmd == "subeval") {
 #ifdef ML
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         subgraphEval(kb, vm);
 #else
@@ -532,6 +601,7 @@ int main(int argc, const char** argv) {
     } else if (cmd == "subanswers") {
 #ifdef ML
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         subgraphAnswers(kb, vm);
 #else
@@ -541,6 +611,7 @@ int main(int argc, const char** argv) {
     } else if (cmd == "subcreate") {
 #ifdef ML
         KBConfig config;
+        setAccessParams(vm, config);
         KB kb(kbDir.c_str(), true, false, true, config);
         subgraphCreate(kb, vm);
 #else
@@ -1,6 +1,8 @@
 #include <trident/kb/kbconfig.h>
 #include <trident/loader.h>
 #include <trident/binarytables/storagestrat.h>
+#include <trident/sparql/plancache.h>
+#include <trident/utils/httpserver.h>
 
 #include <kognac/progargs.h>
 
@@ -36,9 +38,11 @@ void printHelp(const char *programName, string section,
         cout << "load\t\t\t load the KB." << endl;
         cout << "add\t\t\t add triples to an existing KB." << endl;
         cout << "rm\t\t\t rm triples to an existing KB." << endl;
+        cout << "append\t\t\t append triples to the indices of an existing KB." << endl;
         cout << "lookup\t\t\t lookup for values in the dictionary." << endl;
         cout << "info\t\t\t print some information about the KB." << endl;
         cout << "dump\t\t\t dump the graph on files." << endl;
+        cout << "warmup\t\t\t load the indices of the KB in the page cache." << endl;
 
 #ifdef ANALYTICS
         cout << "analytics\t\t perform analytical operations on the graph." << endl;
@@ -82,6 +86,7 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv,
             && cmd != "info"
             && cmd != "add"
             && cmd != "rm"
+            && cmd != "append"
             && cmd != "merge"
 #ifdef ANALYTICS
             && cmd != "analytics"
@@ -89,6 +94,7 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv,
             && cmd != "mine"
             && cmd != "server"
             && cmd != "dump"
+            && cmd != "warmup"
             && cmd != "learn"
             && cmd != "predict"
             && cmd != "subcreate"
@@ -123,13 +129,21 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv,
         }
 
         //Check if the directory is not empty
-        if (cmd == "query" || cmd == "lookup" || cmd == "query_native") {
+        if (cmd == "query" || cmd == "lookup" || cmd == "query_native"
+                || cmd == "warmup") {
             if (Utils::isEmpty(kbDir)) {
                 printErrorMsg(
                         (string("The directory ") + kbDir + string(" is empty.")).c_str());
                 return false;
             }
         }
+
+        string mapAdvice = vm["mapAdvice"].as<string>();
+        if (mapAdvice != "normal" && mapAdvice != "sequential"
+                && mapAdvice != "random" && mapAdvice != "auto") {
+            printErrorMsg("The parameter mapAdvice can only be 'normal', 'sequential', 'random' or 'auto'");
+            return false;
+        }
         /*** Check specific parameters ***/
         if (cmd == "query") {
             string queryFile = vm["query"].as<string>();
@@ -206,7 +220,7 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv,
                 }
 
             }
-        } else if (cmd == "add" || cmd == "rm") {
+        } else if (cmd == "add" || cmd == "rm" || cmd == "append") {
             if (!vm.count("update")) {
                 printErrorMsg(
                         "The path for the update is not set");
@@ -270,6 +284,8 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
             "Disable bifocal sampling (accurate but expensive). Default is false", false);
     query_options.add<bool>("", "enablePartials", false,
             "Allow creation of partial indices (for instance when only one index is present). Default is false", false);
+    query_options.add<int>("", "queryThreads", 1,
+            "N. of threads that execute a SPARQL query. It is also the maximum for the queries sent to <server>. Default is 1", false);
 
     /***** LOAD *****/
     ParamsLoad p;
@@ -286,7 +302,7 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
 
     ProgramArgs::GroupArgs& load_options = *vm.newGroup("Options for <load>");
     load_options.add<string>("","inputformat", "rdf", "Input format. Can be either 'rdf' or 'snap'. Default is 'rdf'.", false);
-    load_options.add<string>("","comprinput", "", "Path to a file that contains a list of compressed triples.", false);
+    load_options.add<string>("","comprinput", "", "Path to a file that contains a list of compressed triples. The triples can be either in text or in the binary format described in trident/kb/binarytriples.h.", false);
     load_options.add<string>("","comprdict", "", "Path to a file that contains the dictionary for the compressed triples.", false);
     load_options.add<string>("","comprdict_rel", "", "Path to a file that contains the dictionary for the relations used in compressed triples (used only if relsOwnIDs is set to true).", false);
 
@@ -299,6 +315,9 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     load_options.add<int>("","ndicts", p.dictionaries, "Sets the number dictionary partitions. Default is '1'", false);
     load_options.add<bool>("","skipTables", p.canSkipTables, "Skip storage of some tables. Default is 'false'", false);
     load_options.add<int>("","thresholdSkipTable", p.thresholdSkipTable, "If dynamic strategy is enabled, this param. defines the size above which a table is not stored. Default is '10'", false);
+    load_options.add<string>("","blockCompr", p.blockCompression, "Compress the large tables in blocks. Can be 'none', 'pfor' (delta + patched bit-packing) or 'lz4'. Default is 'none'", false);
+    load_options.add<int64_t>("","thresholdBlockCompr", p.thresholdBlockCompression, "If block compression is enabled, this param. defines the number of rows above which a table is compressed. Default is '100000'", false);
+    load_options.add<int64_t>("","efDir", p.thresholdEFDirectory, "Store the tables with at least this number of rows as a column with an Elias-Fano directory of the first terms. Block compression, if enabled, has the precedence. Default is '0' (disabled)", false);
     load_options.add<int>("","timeoutStats", p.timeoutStats, "If set greater than 0, it starts a new thread to log some resource statistics every n seconds. Works only under Linux. Default is '-1' (disabled)", false);
     load_options.add<bool>("","onlyCompress", p.onlyCompress, "Only compresses the data. Works only with RDF inputs. Default is DISABLED", false);
     load_options.add<bool>("","sample", p.sample, "Store a little sample of the data, to improve query optimization. Default is ENABLED", false);
@@ -320,6 +339,12 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     load_options.add<string>("","gf", p.graphTransformation, "Possible graph transformations. 'unlabeled' removes the edge labels (but keeps it directed), 'undirected' makes the graph undirected and without edge labels", false);
     load_options.add<bool>("","relsOwnIDs", p.relsOwnIDs, "Should I give independent IDs to the terms that appear as predicates? (Useful for ML learning models). Default is DISABLED", false);
     load_options.add<bool>("","flatTree", p.flatTree, "Create a flat representation of the nodes' tree. This parameter is forced to tree if the graph is unlabeled. Default is DISABLED", false);
+    load_options.add<bool>("","buildStaticTree", p.staticTree, "Create the static copy of the nodes' tree that is used with --staticTree. It is kept up to date by <append>. Default is DISABLED", false);
+    load_options.add<bool>("","radixSort", p.radixSort, "Sort the permutations with a parallel radix sort. If disabled, it uses a parallel comparison sort. Default is ENABLED", false);
+    load_options.add<int64_t>("","maxMemory", p.maxMemory, "Upper bound (in MB) of the memory used to sort, merge and insert the permutations. The dictionary encoding uses fewer threads if they do not fit in it, and the load stops if the budget is too small to insert with the number of threads. If it is 0, the loader uses a fraction of the system memory. Default is 0", false);
+    load_options.add<int>("","mergeFanIn", p.mergeFanIn, "Maximum number of sorted files that are merged in one pass. It is reduced if it does not fit in maxMemory. Default is 4", false);
+    load_options.add<bool>("","pipelineIndices", p.pipelineIndices, "Sort and merge the next permutation while the current one is inserted. The memory budget is split between the two. Default is ENABLED", false);
+    load_options.add<string>("","profile", p.profile, "Profile the phases of the loading. The value is the prefix of the two output files: a JSON report (<prefix>.json) and a timeline in the Chrome trace format (<prefix>.trace.json). Default is disabled", false);
 
     /***** LOOKUP *****/
     ProgramArgs::GroupArgs& lookup_options = *vm.newGroup("Options for <lookup>");
@@ -333,13 +358,16 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     test_options.add<int>("", "testsystem", 0, "Test system. 0=Trident 1=RDF3X", false);
 
     /***** UPDATES *****/
-    ProgramArgs::GroupArgs& update_options = *vm.newGroup("Options for <add> or <rm>");
+    ProgramArgs::GroupArgs& update_options = *vm.newGroup("Options for <add>, <rm> or <append>");
     update_options.add<string>("", "update", "", "Path to the file/dir that contains the triples to update", false);
 
     /***** SERVER *****/
     ProgramArgs::GroupArgs& server_options = *vm.newGroup("Options for <server>");
     server_options.add<int>("", "port", 8080, "Port to listen to", false);
     server_options.add<int>("", "webthreads", 1, "N. of threads for the webserver", false);
+    server_options.add<int>("", "webQueueSize", HTTPSERVER_MAX_QUEUED_REQUESTS, "Max. n. of requests that wait for a thread of the webserver. Further requests are rejected with 503", false);
+    server_options.add<int>("", "webTimeout", HTTPSERVER_REQUEST_TIMEOUT, "Requests that are not received or do not reach a thread within this time (ms) are rejected", false);
+    server_options.add<int>("", "planCacheSize", PLANCACHE_DEFAULT_SIZE, "Max. n. of query plans that are cached. Queries that differ only in the constants of their triple patterns share the same plan. 0 disables the cache", false);
 
     /***** LEARN/PREDICT *****/
 #ifdef ML
@@ -399,6 +427,10 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
             "The directory that contains the binarized embeddings of subgraphs, entities and relations.", false);
 #endif
 
+    /***** WARMUP *****/
+    ProgramArgs::GroupArgs& warmup_options = *vm.newGroup("Options for <warmup>");
+    warmup_options.add<string>("", "warmupPerms", "0;1;2;3;4;5", "Permutations to load in memory, separated by ;", false);
+
     /***** GENERAL OPTIONS *****/
     ProgramArgs::GroupArgs& cmdline_options = *vm.newGroup("General options");
     cmdline_options.add<string>("i","input", "",
@@ -407,6 +439,20 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
             "Set the log level (accepted values: trace, debug, info, warning, error, fatal). Default is info", false);
     cmdline_options.add<string>("", "logfile","",
             "Set if you want to store the logs in a file", false);
+    cmdline_options.add<string>("", "mapAdvice", "normal",
+            "How the tables are accessed once they are mapped in memory. Can be 'normal', 'sequential', 'random' or 'auto' (random, but sequential during the scans). Default is 'normal'", false);
+    cmdline_options.add<bool>("", "mapWillneed", false,
+            "Prefetch the tree and the first-level indices of the tables. Default is DISABLED", false);
+    cmdline_options.add<bool>("", "mapPopulate", false,
+            "Pre-fault the index files when they are mapped. Default is DISABLED", false);
+    cmdline_options.add<bool>("", "mapHugePages", false,
+            "Ask the OS to use transparent huge pages for the index files. Default is DISABLED", false);
+    cmdline_options.add<int>("", "scanPrefetch", 0,
+            "Number of tables that the scans load ahead. Every scan that prefetches uses its own background thread. 0 disables it. Default is DISABLED", false);
+    cmdline_options.add<int64_t>("", "scanPrefetchBytes", INT64_C(64) * 1024 * 1024,
+            "Max number of bytes that the scans load ahead. Default is 64MB", false);
+    cmdline_options.add<bool>("", "staticTree", false,
+            "Look up the terms in a static, cache-friendly copy of the tree. The copy must be created when loading the KB (see --buildStaticTree). Default is DISABLED", false);
 
     sections.insert(make_pair("general",&cmdline_options));
     sections.insert(make_pair("query",&query_options));
@@ -415,10 +461,12 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     sections.insert(make_pair("test",&test_options));
     sections.insert(make_pair("add",&update_options));
     sections.insert(make_pair("rm",&update_options));
+    sections.insert(make_pair("append",&update_options));
 #ifdef ANALYTICS
     sections.insert(make_pair("analytics",&ana_options));
 #endif
     sections.insert(make_pair("dump",&dump_options));
+    sections.insert(make_pair("warmup",&warmup_options));
     sections.insert(make_pair("mine",&mine_options));
     sections.insert(make_pair("server",&server_options));
 #ifdef ML
@@ -133,10 +133,43 @@ bool TridentLayer::lookupById(uint64_t id,
     return resp;
 }
 
+void TridentLayer::lookupByIds(const std::vector<uint64_t>& ids,
+        std::string& texts,
+        std::vector<std::pair<size_t, size_t>>& positions,
+        std::vector<::Type::ID>& types) {
+    dict->getTexts(ids, texts, positions);
+    types.resize(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        auto &p = positions[i];
+        if (p.second >= 2 && texts[p.first] == '<') {
+            p.first++;
+            p.second -= 2;
+            types[i] = ::Type::ID::URI;
+        } else {
+            types[i] = ::Type::ID::Literal;
+        }
+    }
+}
+
 uint64_t TridentLayer::getNextId() {
     return kb.getNextID();
 }
 
+Querier *TridentLayer::acquireQuerier() {
+    std::lock_guard<std::mutex> lock(queriersLock);
+    if (freeQueriers.empty()) {
+        return kb.query();
+    }
+    Querier *querier = freeQueriers.back().release();
+    freeQueriers.pop_back();
+    return querier;
+}
+
+void TridentLayer::releaseQuerier(Querier *querier) {
+    std::lock_guard<std::mutex> lock(queriersLock);
+    freeQueriers.push_back(std::unique_ptr<Querier>(querier));
+}
+
 double TridentLayer::getScanCost(DBLayer::DataOrder order,
         uint64_t value1,
         uint64_t value1C,
@@ -861,7 +894,7 @@ std::unique_ptr<DBLayer::Scan> TridentLayer::getScan(
             perm = IDX_OSP;
             break;
     }
-    std::unique_ptr<DBLayer::Scan> s(new TridentScan(perm, a, q.get(), hint));
+    std::unique_ptr<DBLayer::Scan> s(new TridentScan(perm, a, *this, hint));
     return s;
 }
 
@@ -1065,24 +1098,161 @@ next_test:
 //-----------------------------------------------------------------------------
 
 uint64_t TridentScan::getValue1() {
+    if (batched)
+        return batchKeys[batchPos];
     return itr->getKey();
 }
 
 uint64_t TridentScan::getValue2() {
     assert(a != DBLayer::Aggr_t::AGGR_SKIP_2LAST);
+    if (batched)
+        return batchValues1[batchPos];
     return itr->getValue1();
 }
 
 uint64_t TridentScan::getValue3() {
     assert(a == DBLayer::Aggr_t::AGGR_NO);
+    if (batched)
+        return batchValues2[batchPos];
     return itr->getValue2();
 }
 
 uint64_t TridentScan::getCount() {
+    if (batched)
+        return 1;
     return itr->getCount();
 }
 
+TridentScan::TridentScan(const int perm, const DBLayer::Aggr_t a,
+        TridentLayer &layer, DBLayer::Hint *hint) : a(a), perm(perm),
+    itr(NULL),
+    layer(layer),
+    q(layer.acquireQuerier()),
+    hint(hint),
+    countHint(0),
+    batched(false),
+    batchKeys(NULL),
+    batchValues1(NULL),
+    batchValues2(NULL),
+    batchSize(0),
+    batchPos(0),
+    rangeStart(0),
+    canSeekKey(-1) {
+    }
+
+bool TridentScan::setRangeStart(uint64_t start, bool constrained) {
+    if (a != DBLayer::AGGR_NO)
+        return false;
+    if (!constrained) {
+        //Only the scan iterator can jump to a key. The others (e.g., when
+        //there are updates) would have to skip all the previous rows
+        if (canSeekKey == -1) {
+            PairItr *probe = q->getPermuted(perm, -1, -1, -1, false);
+            canSeekKey = probe->getTypeItr() == SCAN_ITR;
+            q->releaseItr(probe);
+        }
+        if (!canSeekKey)
+            return false;
+    }
+    rangeStart = start;
+    return true;
+}
+
+bool TridentScan::readFirst(const int nconstrained) {
+    if (a == DBLayer::AGGR_NO) {
+        if (!batch) {
+            batch = std::unique_ptr<int64_t[]>(new int64_t[ITR_BATCH_SIZE * 3]);
+            batchKeys = batch.get();
+            batchValues1 = batchKeys + ITR_BATCH_SIZE;
+            batchValues2 = batchValues1 + ITR_BATCH_SIZE;
+        }
+        batched = true;
+        if (rangeStart > 0 && nconstrained < 2)
+            return readFirstInRange(nconstrained);
+        return fillBatch();
+    } else {
+        batched = false;
+        bool resp = itr->hasNext();
+        if (resp)
+            itr->next();
+        return resp;
+    }
+}
+
+bool TridentScan::readFirstInRange(const int nconstrained) {
+    //The range is on the key if nothing is constrained, otherwise on the
+    //first value
+    batchPos = batchSize = 0;
+    if (!itr->hasNext())
+        return false;
+    itr->next();
+    const bool onKey = nconstrained == 0;
+    if ((uint64_t) (onKey ? itr->getKey() : itr->getValue1()) < rangeStart) {
+        if (!onKey) {
+            itr->moveto(rangeStart, 0);
+            return fillBatch();
+        } else if (itr->getTypeItr() == SCAN_ITR) {
+            itr->gotoKey(rangeStart);
+            return fillBatch();
+        }
+        LOG(ERRORL) << "The iterator cannot jump to the start of the range";
+        throw 10;
+    }
+    //The current row is in the range. Return it before the others
+    batchKeys[0] = itr->getKey();
+    batchValues1[0] = itr->getValue1();
+    batchValues2[0] = itr->getValue2();
+    batchSize = 1 + itr->nextBatch(batchKeys + 1, batchValues1 + 1,
+            batchValues2 + 1, ITR_BATCH_SIZE - 1);
+    return true;
+}
+
+bool TridentScan::fillBatch() {
+    batchSize = itr->nextBatch(batchKeys, batchValues1, batchValues2,
+            ITR_BATCH_SIZE);
+    batchPos = 0;
+    return batchSize > 0;
+}
+
+void TridentScan::applyHintOnBatch() {
+    uint64_t s = 0, p = 0, o = 0;
+    hint->next(s, p, o);
+    if (p <= (uint64_t) batchValues1[batchPos]) {
+        return;
+    }
+    //First skip the rows that are already in the batch. Next() moves to
+    //batchPos + 1, so I stop at the row before the target.
+    const int64_t key = batchKeys[batchPos];
+    while (batchPos + 1 < batchSize && batchKeys[batchPos + 1] == key &&
+            ((uint64_t) batchValues1[batchPos + 1] < p ||
+             ((uint64_t) batchValues1[batchPos + 1] == p &&
+              (uint64_t) batchValues2[batchPos + 1] < o))) {
+        batchPos++;
+    }
+    if (batchPos + 1 == batchSize) {
+        //The batch is consumed, and the iterator is at its last row. Let
+        //the physical iterator jump before the next batch is read.
+        itr->moveto(p, o);
+    }
+}
+
 bool TridentScan::next() {
+    if (batched) {
+        assert(itr != NULL);
+        if (hint && countHint == 0) {
+            applyHintOnBatch();
+        }
+        if (countHint++ > COUNTHINT_MAX)
+            countHint = 0;
+
+        if (++batchPos < batchSize || fillBatch()) {
+            return true;
+        } else {
+            q->releaseItr(itr);
+            itr = NULL;
+            return false;
+        }
+    }
 
     if (hint && countHint == 0) {
         uint64_t s = 0, p = 0, o = 0;
@@ -1130,10 +1300,7 @@ bool TridentScan::first() {
         itr = q->getPermuted(perm, -1, -1, -1, false);
         if (a == DBLayer::AGGR_SKIP_LAST)
             itr->ignoreSecondColumn();
-        bool resp = itr->hasNext();
-        if (resp)
-            itr->next();
-        return resp;
+        return readFirst(0);
     }
 }
 
@@ -1146,8 +1313,7 @@ bool TridentScan::first(uint64_t el, bool constrained) {
     else
         itr = q->getPermuted(perm, -1, -1, -1, false);
 
-    if (itr->hasNext()) {
-        itr->next();
+    if (readFirst(constrained ? 1 : 0)) {
         return true;
     } else {
         q->releaseItr(itr);
@@ -1173,8 +1339,7 @@ bool TridentScan::first(uint64_t el1, bool constrained1, uint64_t el2, bool cons
     if (a == DBLayer::Aggr_t::AGGR_SKIP_LAST) {
         itr->ignoreSecondColumn();
     }
-    if (itr->hasNext()) {
-        itr->next();
+    if (readFirst(constrained1 ? (constrained2 ? 2 : 1) : 0)) {
         return true;
     } else {
         q->releaseItr(itr);
@@ -1203,10 +1368,8 @@ bool TridentScan::first(uint64_t el1, bool constrained1, uint64_t el2,
         itr = q->getPermuted(perm, -1, -1, -1, false);
     }
 
-    bool resp = itr->hasNext();
-    if (resp) {
-        itr->next();
-    } else {
+    bool resp = readFirst(constrained1 ? (constrained2 ? 2 : 1) : 0);
+    if (!resp) {
         q->releaseItr(itr);
         itr = NULL;
     }
@@ -1218,4 +1381,5 @@ TridentScan::~TridentScan() {
         q->releaseItr(itr);
         itr = NULL;
     }
+    layer.releaseQuerier(q);
 }
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/binarytables/comprcolumntable.h>
+
+#include <kognac/utils.h>
+
+#include <algorithm>
+
+void ComprColumnTable::loadBlock(const int64_t block) {
+    if (block == loadedBlock) {
+        return;
+    }
+    const uint8_t bytesRow = bytesPerFirstEntry + bytesPerSecondEntry;
+    const char *begin = start + Utils::decode_longFixedBytes(
+            getDirEntry(block) + bytesRow, bytesPerOffset);
+    const char *end = directory;
+    if (block + 1 < nBlocks) {
+        end = start + Utils::decode_longFixedBytes(
+                getDirEntry(block + 1) + bytesRow, bytesPerOffset);
+    }
+    const int64_t n = std::min((int64_t) COMPR_BLOCK_ROWS,
+            nTerms - block * COMPR_BLOCK_ROWS);
+    BlockCodec::decode(codec, begin, end - begin, n, values1, values2,
+            scratch);
+    loadedBlock = block;
+}
+
+int64_t ComprColumnTable::searchRow(const int64_t from, const int64_t to,
+        const int64_t c1, const int64_t c2) {
+    if (from >= to) {
+        return to;
+    }
+    //Search in the directory the first block after the current one that
+    //starts with a row that is not smaller than (c1, c2)
+    const int64_t firstBlock = from / COMPR_BLOCK_ROWS;
+    const int64_t lastBlock = (to - 1) / COMPR_BLOCK_ROWS;
+    const uint8_t b1 = bytesPerFirstEntry;
+    const uint8_t b2 = bytesPerSecondEntry;
+    const char *entry = AbsNewTable::lowerBound(getDirEntry(firstBlock + 1),
+            getDirEntry(lastBlock + 1), bytesDirEntry,
+            [b1, b2, c1, c2](const char *p) {
+            const int64_t v1 = Utils::decode_longFixedBytes(p, b1);
+            return v1 < c1 || (v1 == c1 &&
+                    Utils::decode_longFixedBytes(p + b1, b2) < c2);
+            });
+    const int64_t nextBlock = (entry - directory) / bytesDirEntry;
+
+    //The row is either in the previous block or the first of nextBlock
+    const int64_t block = nextBlock - 1;
+    const int64_t base = block * COMPR_BLOCK_ROWS;
+    loadBlock(block);
+    int64_t s = std::max(from, base) - base;
+    const int64_t e = std::min(to, base + COMPR_BLOCK_ROWS) - base;
+    int64_t l = e;
+    while (s < l) {
+        const int64_t middle = (s + l) / 2;
+        if (values1[middle] < c1 ||
+                (values1[middle] == c1 && values2[middle] < c2)) {
+            s = middle + 1;
+        } else {
+            l = middle;
+        }
+    }
+    if (s < e) {
+        return base + s;
+    }
+    return std::min(nextBlock * COMPR_BLOCK_ROWS, to);
+}
+
+size_t ComprColumnTable::nextBlock(int64_t *v1, int64_t *v2, size_t n) {
+    if (isSecondColumnIgnored) {
+        return PairItr::nextBlock(v1, v2, n);
+    }
+    size_t m = 0;
+    while (m < n && row < endRow) {
+        loadBlock(row / COMPR_BLOCK_ROWS);
+        const int64_t offset = row % COMPR_BLOCK_ROWS;
+        const int64_t k = std::min((int64_t) (n - m), std::min(
+                    (int64_t) COMPR_BLOCK_ROWS - offset, endRow - row));
+        std::copy(values1 + offset, values1 + offset + k, v1 + m);
+        std::copy(values2 + offset, values2 + offset + k, v2 + m);
+        m += k;
+        row += k;
+    }
+    if (m > 0) {
+        currentRow = row - 1;
+        currentValue1 = v1[m - 1];
+        currentValue2 = v2[m - 1];
+    }
+    return m;
+}
+
+uint64_t ComprColumnTable::getCardinality() {
+    if (isSecondColumnIgnored) {
+        if (startRow == 0 && endRow == nTerms) {
+            return nUniqueFirstTerms;
+        }
+        //The table was restricted to a single first term
+        return endRow > startRow ? 1 : 0;
+    } else {
+        return endRow - startRow;
+    }
+}
+
+void ComprColumnTable::setup(const char* start, const char *end) {
+    initializeConstraints();
+    const char *trailer = end - COMPRTABLE_TRAILER_SIZE;
+    nTerms = Utils::decode_longFixedBytes(trailer, 5);
+    nUniqueFirstTerms = Utils::decode_longFixedBytes(trailer + 5, 5);
+    directory = start + Utils::decode_longFixedBytes(trailer + 10, 5);
+    bytesPerFirstEntry = trailer[15];
+    bytesPerSecondEntry = trailer[16];
+    bytesPerOffset = trailer[17];
+    codec = trailer[18];
+    bytesDirEntry = bytesPerFirstEntry + bytesPerSecondEntry + bytesPerOffset;
+    nBlocks = (nTerms + COMPR_BLOCK_ROWS - 1) / COMPR_BLOCK_ROWS;
+
+    this->start = start;
+    loadedBlock = -1;
+    startRow = row = 0;
+    endRow = nTerms;
+    currentRow = -1;
+    currentValue1 = currentValue2 = -1;
+    count = 1;
+    isSecondColumnIgnored = false;
+}
+
+void ComprColumnTable::setup(int64_t c1, const char* start, const char *end) {
+    setup(start, end);
+    startRow = row = searchRow(0, nTerms, c1, 0);
+    endRow = searchRow(startRow, nTerms, c1 + 1, 0);
+}
+
+void ComprColumnTable::setup(int64_t c1, int64_t c2, const char* start,
+        const char *end) {
+    setup(start, end);
+    startRow = row = searchRow(0, nTerms, c1, c2);
+    if (row < nTerms && getValue1At(row) == c1 &&
+            values2[row % COMPR_BLOCK_ROWS] == c2) {
+        endRow = row + 1;
+    } else {
+        endRow = row;
+    }
+}
+
+void ComprColumnTable::moveto(const int64_t c1, const int64_t c2) {
+    assert(currentValue1 != -1);
+    if (!hasNext() && (c1 > currentValue1 ||
+                (!isSecondColumnIgnored && c1 == currentValue1 && c2 > currentValue2))) {
+        return;
+    }
+
+    if (c1 > currentValue1 ||
+            (!isSecondColumnIgnored && c1 == currentValue1 && c2 > currentValue2)) {
+        const int64_t target2 = isSecondColumnIgnored ? 0 : std::max(c2, (int64_t) 0);
+        row = searchRow(row, endRow, c1, target2);
+    } else {
+        //The current row is the one to return
+        row = currentRow;
+    }
+}
+
+void ComprColumnTable::ignoreSecondColumn() {
+    isSecondColumnIgnored = true;
+    if (currentValue1 != -1) {
+        //Skip the remaining rows with the same first term
+        while (row < endRow && getValue1At(row) == currentValue1) {
+            row++;
+            count++;
+        }
+    }
+}
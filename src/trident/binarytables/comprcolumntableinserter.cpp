@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/binarytables/comprcolumntableinserter.h>
+#include <trident/utils/blockcodec.h>
+
+#include <kognac/utils.h>
+
+#include <algorithm>
+
+void ComprColumnTableInserter::startAppend() {
+    nvalues = 0;
+    buffer.resize(BlockCodec::maxEncodedSize(COMPR_BLOCK_ROWS));
+    dirValues1.clear();
+    dirValues2.clear();
+    dirOffsets.clear();
+    nTerms = nUniqueFirstTerms = 0;
+    prevel1 = -1;
+    largestElement1 = largestElement2 = 0;
+    written = 0;
+}
+
+void ComprColumnTableInserter::append(int64_t t1, int64_t t2) {
+    if (t1 != prevel1) {
+        nUniqueFirstTerms++;
+        prevel1 = t1;
+    }
+    if (t1 > largestElement1) {
+        largestElement1 = t1;
+    }
+    if (t2 > largestElement2) {
+        largestElement2 = t2;
+    }
+    nTerms++;
+    values1[nvalues] = t1;
+    values2[nvalues] = t2;
+    if (++nvalues == COMPR_BLOCK_ROWS) {
+        flushBlock();
+    }
+}
+
+void ComprColumnTableInserter::flushBlock() {
+    dirValues1.push_back(values1[0]);
+    dirValues2.push_back(values2[0]);
+    dirOffsets.push_back(written);
+    const size_t size = BlockCodec::encode(codec, values1, values2, nvalues,
+            buffer.data());
+    written += writeBytes(buffer.data(), size);
+    nvalues = 0;
+}
+
+void ComprColumnTableInserter::stopAppend() {
+    if (nvalues > 0) {
+        flushBlock();
+    }
+
+    //Write the directory
+    const uint8_t bytesPerFirstEntry = std::max(1,
+            (int) Utils::numBytesFixedLength(largestElement1));
+    const uint8_t bytesPerSecondEntry = std::max(1,
+            (int) Utils::numBytesFixedLength(largestElement2));
+    const uint8_t bytesPerOffset = std::max(1,
+            (int) Utils::numBytesFixedLength(written));
+    const uint64_t posDirectory = written;
+    for (size_t i = 0; i < dirOffsets.size(); ++i) {
+        writeLong(bytesPerFirstEntry, dirValues1[i]);
+        writeLong(bytesPerSecondEntry, dirValues2[i]);
+        writeLong(bytesPerOffset, dirOffsets[i]);
+    }
+
+    //Write the trailer
+    writeLong(5, nTerms);
+    writeLong(5, nUniqueFirstTerms);
+    writeLong(5, posDirectory);
+    writeByte(bytesPerFirstEntry);
+    writeByte(bytesPerSecondEntry);
+    writeByte(bytesPerOffset);
+    writeByte(codec);
+}
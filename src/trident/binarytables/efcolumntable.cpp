@@ -0,0 +1,177 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/binarytables/efcolumntable.h>
+#include <trident/utils/fixedbytes.h>
+
+#include <algorithm>
+
+void EFColumnTable::loadGroup(const int64_t g) {
+    group = g;
+    groupValue = values.select(g);
+    groupBegin = starts.select(g);
+    groupEnd = g + 1 < nUniqueFirstTerms ? starts.select(g + 1) : nTerms;
+}
+
+int64_t EFColumnTable::searchRow(const int64_t from, const int64_t to,
+        const int64_t c1, const int64_t c2) {
+    if (from >= to) {
+        return to;
+    }
+    int64_t r;
+    seekGroup(from);
+    if (groupValue >= c1) {
+        //The first term is already in the current group
+        r = groupBegin;
+    } else {
+        const int64_t g = values.nextGEQ(c1);
+        if (g == nUniqueFirstTerms) {
+            return to;
+        }
+        loadGroup(g);
+        r = groupBegin;
+        if (r >= to) {
+            return to;
+        }
+    }
+    if (groupValue == c1) {
+        //Search the second term among the rows of the group
+        const uint8_t b2 = bytesPerSecondEntry;
+        const char *s = start + std::max(r, from) * b2;
+        const char *e = start + std::min(groupEnd, to) * b2;
+        const char *entry = AbsNewTable::lowerBound(s, e, b2,
+                [b2, c2](const char *p) {
+                return (int64_t) Utils::decode_longFixedBytes(p, b2) < c2;
+                });
+        r = (entry - start) / b2;
+    }
+    return std::min(std::max(r, from), to);
+}
+
+size_t EFColumnTable::nextBlock(int64_t *v1, int64_t *v2, size_t n) {
+    if (isSecondColumnIgnored) {
+        return PairItr::nextBlock(v1, v2, n);
+    }
+    size_t m = 0;
+    while (m < n && row < endRow) {
+        seekGroup(row);
+        const int64_t k = std::min((int64_t) (n - m),
+                std::min(groupEnd, endRow) - row);
+        std::fill(v1 + m, v1 + m + k, groupValue);
+        FixedBytesDecoder::decode(start + row * bytesPerSecondEntry,
+                start + nTerms * bytesPerSecondEntry, bytesPerSecondEntry,
+                v2 + m, k);
+        m += k;
+        row += k;
+    }
+    if (m > 0) {
+        currentRow = row - 1;
+        currentValue1 = v1[m - 1];
+        currentValue2 = v2[m - 1];
+    }
+    return m;
+}
+
+uint64_t EFColumnTable::getCardinality() {
+    if (isSecondColumnIgnored) {
+        if (startRow == 0 && endRow == nTerms) {
+            return nUniqueFirstTerms;
+        }
+        //The table was restricted to a single first term
+        return endRow > startRow ? 1 : 0;
+    } else {
+        return endRow - startRow;
+    }
+}
+
+void EFColumnTable::setup(const char* start, const char *end) {
+    initializeConstraints();
+    const char *trailer = end - EFTABLE_TRAILER_SIZE;
+    nTerms = Utils::decode_longFixedBytes(trailer, 5);
+    nUniqueFirstTerms = Utils::decode_longFixedBytes(trailer + 5, 5);
+    values.init(start + Utils::decode_longFixedBytes(trailer + 10, 5));
+    starts.init(start + Utils::decode_longFixedBytes(trailer + 15, 5));
+    bytesPerSecondEntry = trailer[20];
+
+    this->start = start;
+    group = -1;
+    groupBegin = groupEnd = 0;
+    startRow = row = 0;
+    endRow = nTerms;
+    currentRow = -1;
+    currentValue1 = currentValue2 = -1;
+    count = 1;
+    isSecondColumnIgnored = false;
+}
+
+void EFColumnTable::setup(int64_t c1, const char* start, const char *end) {
+    setup(start, end);
+    const int64_t g = values.nextGEQ(c1);
+    if (g < nUniqueFirstTerms) {
+        loadGroup(g);
+        startRow = row = groupBegin;
+        endRow = groupValue == c1 ? groupEnd : groupBegin;
+    } else {
+        startRow = row = endRow = nTerms;
+    }
+}
+
+void EFColumnTable::setup(int64_t c1, int64_t c2, const char* start,
+        const char *end) {
+    setup(start, end);
+    startRow = row = searchRow(0, nTerms, c1, c2);
+    endRow = row;
+    if (row < nTerms) {
+        seekGroup(row);
+        if (groupValue == c1 && getValue2At(row) == c2) {
+            endRow = row + 1;
+        }
+    }
+}
+
+void EFColumnTable::moveto(const int64_t c1, const int64_t c2) {
+    assert(currentValue1 != -1);
+    if (!hasNext() && (c1 > currentValue1 ||
+                (!isSecondColumnIgnored && c1 == currentValue1 && c2 > currentValue2))) {
+        return;
+    }
+
+    if (c1 > currentValue1 ||
+            (!isSecondColumnIgnored && c1 == currentValue1 && c2 > currentValue2)) {
+        const int64_t target2 = isSecondColumnIgnored ? 0 : std::max(c2, (int64_t) 0);
+        row = searchRow(row, endRow, c1, target2);
+    } else {
+        //The current row is the one to return
+        row = currentRow;
+    }
+}
+
+void EFColumnTable::ignoreSecondColumn() {
+    isSecondColumnIgnored = true;
+    if (currentValue1 != -1) {
+        //Skip the remaining rows with the same first term
+        seekGroup(currentRow);
+        const int64_t last = std::min(groupEnd, endRow);
+        count += last - row;
+        row = last;
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/binarytables/efcolumntableinserter.h>
+#include <trident/utils/eliasfano.h>
+
+#include <kognac/utils.h>
+
+#include <algorithm>
+
+void EFColumnTableInserter::startAppend() {
+    firstTerms.clear();
+    startRows.clear();
+    secondTerms.clear();
+    prevel1 = -1;
+    largestElement2 = 0;
+}
+
+void EFColumnTableInserter::append(int64_t t1, int64_t t2) {
+    if (t1 != prevel1) {
+        firstTerms.push_back(t1);
+        startRows.push_back(secondTerms.size());
+        prevel1 = t1;
+    }
+    if (t2 > largestElement2) {
+        largestElement2 = t2;
+    }
+    secondTerms.push_back(t2);
+}
+
+uint64_t EFColumnTableInserter::writeEF(const std::vector<uint64_t> &values) {
+    std::vector<uint64_t> encoded;
+    EliasFano::encode(values.data(), values.size(), encoded);
+    return writeBytes((char*) encoded.data(), encoded.size() * 8);
+}
+
+void EFColumnTableInserter::stopAppend() {
+    const uint8_t bytesPerSecondEntry = std::max(1,
+            (int) Utils::numBytesFixedLength(largestElement2));
+    for (size_t i = 0; i < secondTerms.size(); ++i) {
+        writeLong(bytesPerSecondEntry, secondTerms[i]);
+    }
+    const uint64_t posValues = secondTerms.size() * bytesPerSecondEntry;
+    const uint64_t posStarts = posValues + writeEF(firstTerms);
+    writeEF(startRows);
+
+    //Write the trailer
+    writeLong(5, secondTerms.size());
+    writeLong(5, firstTerms.size());
+    writeLong(5, posValues);
+    writeLong(5, posStarts);
+    writeByte(bytesPerSecondEntry);
+
+    //Free the memory, since the inserters are recycled
+    std::vector<uint64_t>().swap(firstTerms);
+    std::vector<uint64_t>().swap(startRows);
+    std::vector<uint64_t>().swap(secondTerms);
+}
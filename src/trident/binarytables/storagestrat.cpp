@@ -46,6 +46,18 @@ unsigned StorageStrat::getStrat7() {
     return output;
 }
 
+unsigned StorageStrat::getComprStrat(const int codec) {
+    unsigned output = 0;
+    output = StorageStrat::setStorageType(output, COMPRCOLUMN_STORAGE);
+    output = StorageStrat::setBytesField1(output, codec);
+    return output;
+}
+
+unsigned StorageStrat::getEFStrat() {
+    unsigned output = 0;
+    output = StorageStrat::setStorageType(output, EFCOLUMN_STORAGE);
+    return output;
+}
 
 const unsigned FIXEDSTRAT5 = StorageStrat::getStrat5();
 const unsigned FIXEDSTRAT6 = StorageStrat::getStrat6();
@@ -72,6 +84,10 @@ PairItr *StorageStrat::getBinaryTable(const char signature) {
         if (signature & 1)
             ncount = 4;
         return f6->get(nbytes1, nbytes2, ncount);
+    } else if (storageType == COMPRCOLUMN_STORAGE) {
+        return f7->get();
+    } else if (storageType == EFCOLUMN_STORAGE) {
+        return f8->get();
     } else {
         throw 10;
     }
@@ -122,6 +138,12 @@ BinaryTableInserter *StorageStrat::getBinaryTableInserter(const char signature)
         }
         ph->setSizes(nbytes1, nbytes2, ncount);
         return ph;
+    } else if (storageType == COMPRCOLUMN_STORAGE) {
+        ComprColumnTableInserter *ph = f7i->get();
+        ph->setCodec(getCodec(signature));
+        return ph;
+    } else if (storageType == EFCOLUMN_STORAGE) {
+        return f8i->get();
     } else {
         throw 10;
     }
@@ -21,6 +21,7 @@
 
 
 #include <trident/binarytables/tableshandler.h>
+#include <trident/files/mappingpolicy.h>
 
 #include <kognac/utils.h>
 
@@ -38,7 +39,8 @@ void FileMarks::parse(string path) {
         throw 10;
     }
 
-    this->mappedFile = std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(path));
+    this->mappedFile = std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(path,
+                true, MappingPolicy::getIndexFlags()));
     //this->filemapping = new bip::file_mapping(path.c_str(), bip::read_only);
     //this->mappedrgn = new bip::mapped_region(*(this->filemapping),
     //        bip::read_only);
@@ -87,6 +89,11 @@ TableStorage::TableStorage(bool readOnly, string pathDir, int64_t maxFileSize,
                     readOnly, maxFileSize, maxNFiles, lastCreatedFile,
                     bytesTracker, &stats);
         }
+        if (readOnly) {
+            cache->setAdvice(MappingPolicy::getTableFlags());
+            cache->setPopulate(MappingPolicy::getPopulateTables());
+        }
+        nScans = 0;
         indicesWritten = false;
         insertHandler = NULL;
         nTriplesInserted = 0;
@@ -194,6 +201,14 @@ int64_t TableStorage::startAppend(const int64_t key,
     return createdMarks[lastCreatedFile] - 1;
 }
 
+void TableStorage::startNewFile() {
+    cache->createNewFile();
+    lastCreatedFile = cache->getIdLastFile();
+    sizeLastCreatedFile = 0;
+    marksToStore.resize(lastCreatedFile);
+    createdMarks.resize(lastCreatedFile);
+}
+
 void TableStorage::setStrategy(const char strat) {
     marksToStore[lastCreatedFile].back().strat = strat;
 }
@@ -279,6 +294,45 @@ std::vector<const char*> TableStorage::loadAllFiles() {
     return files;
 }
 
+void TableStorage::beginScan() {
+    const int flags = MappingPolicy::getScanFlags();
+    if (!readOnly || flags == MAPPING_NORMAL) {
+        return;
+    }
+#ifdef MT
+    std::unique_lock<std::mutex> lock(mutex);
+#endif
+    if (nScans++ == 0) {
+        cache->setAdvice(flags);
+    }
+}
+
+void TableStorage::endScan() {
+    if (!readOnly || MappingPolicy::getScanFlags() == MAPPING_NORMAL) {
+        return;
+    }
+#ifdef MT
+    std::unique_lock<std::mutex> lock(mutex);
+#endif
+    if (--nScans == 0) {
+        cache->setAdvice(MappingPolicy::getTableFlags());
+    }
+}
+
+size_t TableStorage::warmup() {
+    size_t npages = 0;
+    for (int i = 0; i <= cache->getIdLastFile(); ++i) {
+        sprintf(pathDir + sizePathDir, "%d.idx", i);
+        string pathIdx = string(pathDir);
+        if (Utils::exists(pathIdx)) {
+            MemoryMappedFile mf(pathIdx);
+            npages += mf.prefault();
+        }
+        npages += cache->prefault(i);
+    }
+    return npages;
+}
+
 TableStorage::~TableStorage() {
     if (!readOnly && !indicesWritten) {
         storeFileIndices();
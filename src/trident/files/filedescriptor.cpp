@@ -202,7 +202,8 @@ void FileDescriptor::overwriteVLong2At(uint64_t pos, int64_t number) {
 }
 
 bool FileDescriptor::isUsed() {
-    if (tracker) {
+    //An untracked file cannot be evicted
+    if (tracker && memoryTrackerId >= 0) {
         if (tracker->isUsed(memoryTrackerId))
             return true;
         else
@@ -212,9 +213,17 @@ bool FileDescriptor::isUsed() {
     }
 }
 
+void FileDescriptor::advise(int flags) {
+    mappedFile->advise(flags);
+}
+
+size_t FileDescriptor::prefault() {
+    return mappedFile->prefault();
+}
+
 FileDescriptor::~FileDescriptor() {
     if (tracker) {
-        tracker->removeBlockWithoutDeallocation(memoryTrackerId);
+        tracker->removeBlockWithoutDeallocation(memoryTrackerId, this);
     }
 
     buffer = NULL;
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/files/mappingpolicy.h>
+#include <trident/kb/kbconfig.h>
+
+#include <kognac/logs.h>
+
+int MappingPolicy::tableFlags = MAPPING_NORMAL;
+int MappingPolicy::scanFlags = MAPPING_NORMAL;
+int MappingPolicy::indexFlags = MAPPING_NORMAL;
+bool MappingPolicy::populateTables = false;
+
+int MappingPolicy::parseAdvice(std::string advice) {
+    if (advice == "normal") {
+        return MAPPING_NORMAL;
+    } else if (advice == "sequential") {
+        return MAPPING_SEQUENTIAL;
+    } else if (advice == "random") {
+        return MAPPING_RANDOM;
+    }
+    return -1;
+}
+
+void MappingPolicy::init(KBConfig &config) {
+    const std::string advice = config.getParam(MAPPING_ADVICE);
+    int common = 0;
+    populateTables = config.getParamBool(MAPPING_POPULATE_FILES);
+    if (config.getParamBool(MAPPING_HUGEPAGES_FILES)) {
+        common |= MAPPING_HUGEPAGES;
+    }
+
+    if (advice == "auto") {
+        //Random access for the lookups, sequential once a scan starts
+        tableFlags = MAPPING_RANDOM | common;
+        scanFlags = MAPPING_SEQUENTIAL | common;
+    } else {
+        const int access = parseAdvice(advice);
+        if (access == -1) {
+            LOG(ERRORL) << "Mapping advice " << advice << " not recognized";
+            throw 10;
+        }
+        tableFlags = access | common;
+        scanFlags = MAPPING_NORMAL;
+    }
+
+    indexFlags = common;
+    if (populateTables) {
+        indexFlags |= MAPPING_POPULATE;
+    }
+    if (config.getParamBool(MAPPING_WILLNEED_INDEX)) {
+        indexFlags |= MAPPING_WILLNEED;
+    }
+}
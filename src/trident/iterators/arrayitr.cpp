@@ -94,6 +94,34 @@ void ArrayItr::next() {
     countElems = 0;
 }
 
+size_t ArrayItr::nextBlock(int64_t *o1, int64_t *o2, size_t nrows) {
+    if (ignSecondColumn) {
+        return PairItr::nextBlock(o1, o2, nrows);
+    }
+    if (hasNextChecked && !n) {
+        return 0;
+    }
+    size_t i = 0;
+    while (i < nrows && pos < nElements) {
+        const std::pair<uint64_t, uint64_t> &el = (*array)[pos];
+        if (constraint1 != -1 && ((int64_t) el.first != constraint1 ||
+                    (constraint2 != -1 && (int64_t) el.second != constraint2))) {
+            break;
+        }
+        o1[i] = (int64_t) el.first;
+        o2[i] = (int64_t) el.second;
+        pos++;
+        i++;
+    }
+    if (i > 0) {
+        v1 = o1[i - 1];
+        v2 = o2[i - 1];
+        hasNextChecked = false;
+        countElems = 0;
+    }
+    return i;
+}
+
 void ArrayItr::clear() {
     array = NULL;
 }
@@ -26,6 +26,7 @@
 
 #include <trident/binarytables/storagestrat.h>
 
+#include <algorithm>
 #include <iostream>
 
 using namespace std;
@@ -54,6 +55,79 @@ void ScanItr::init(int idx, Querier *q) {
         itr2 = NULL;
     ignseccolumn = false;
     hnc = hn = false;
+    q->beginScan(idx);
+
+    prefetcher = NULL;
+    lookahead = NULL;
+    startPrefetch();
+}
+
+void ScanItr::startPrefetch() {
+    //Only the scans that read the tables of a single permutation are
+    //prefetched. The ones that reconstruct a permutation from its reverse
+    //(itr2) are not.
+    if (q->getScanPrefetchTables() <= 0 || itr2 != NULL || itr1 == NULL) {
+        return;
+    }
+    lookaheadStorage = q->getTableStorage(idx);
+    if (lookaheadStorage == NULL) {
+        return;
+    }
+    lookahead = q->getKBTermList(idx, true);
+    if (lookahead == NULL) {
+        return;
+    }
+    prefetcher = new Prefetcher(q->getScanPrefetchBytes());
+    lag = 0;
+    hasPending = false;
+    fillPrefetch();
+}
+
+void ScanItr::fillPrefetch() {
+    if (hasPending) {
+        if (!prefetcher->push(pending.first, pending.second)) {
+            return;
+        }
+        hasPending = false;
+    }
+    const size_t ntables = q->getScanPrefetchTables();
+    while (prefetcher->getNAhead() < ntables && lookahead->hasNext()) {
+        lookahead->next();
+        if (lag > 0) {
+            //The scan has already opened this table
+            lag--;
+            continue;
+        }
+        std::pair<const char*, const char*> table = lookaheadStorage->getTable(
+                lookahead->getCurrentFile(), lookahead->getCurrentMark());
+        if (!prefetcher->push(table.first, table.second)) {
+            pending = table;
+            hasPending = true;
+            break;
+        }
+    }
+}
+
+void ScanItr::tableOpened() {
+    if (prefetcher->getNAhead() > 0) {
+        prefetcher->consume();
+    } else if (hasPending) {
+        hasPending = false;
+    } else {
+        lag++;
+    }
+    fillPrefetch();
+}
+
+void ScanItr::stopPrefetch() {
+    if (prefetcher) {
+        delete prefetcher;
+        prefetcher = NULL;
+    }
+    if (lookahead) {
+        q->releaseItr(lookahead);
+        lookahead = NULL;
+    }
 }
 
 uint64_t ScanItr::getCardinality() {
@@ -160,6 +234,9 @@ void ScanItr::next() {
                 int64_t mark = itr1->getCurrentMark();
                 currentTable = q->getIterator(idx, key, file, mark, strategy,
                         -1, -1, false, false);
+                if (prefetcher) {
+                    tableOpened();
+                }
                 if (ignseccolumn)
                     currentTable->ignoreSecondColumn();
                 setKey(key);
@@ -206,6 +283,9 @@ bool ScanItr::next(int64_t &v1, int64_t &v2, int64_t &v3) {
                 int64_t mark = itr1->getCurrentMark();
                 currentTable = q->getIterator(idx, key, file, mark, strategy,
                         -1, -1, false, false);
+                if (prefetcher) {
+                    tableOpened();
+                }
                 if (ignseccolumn)
                     currentTable->ignoreSecondColumn();
                 setKey(key);
@@ -242,6 +322,34 @@ bool ScanItr::next(int64_t &v1, int64_t &v2, int64_t &v3) {
     return hasNext;
 }
 
+size_t ScanItr::nextBatch(int64_t *keys, int64_t *v1, int64_t *v2, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        PairItr *table = currentTable != NULL ? currentTable : reversedItr;
+        if (table != NULL && table->hasNext()) {
+            //Copy as much as possible from the current table
+            const size_t m = table->nextBlock(v1 + i, v2 + i, n - i);
+            if (m == 0) {
+                break;
+            }
+            std::fill(keys + i, keys + i + m, getKey());
+            i += m;
+            hnc = false;
+        } else {
+            //Open the following table (if any) and read its first pair
+            if (!hasNext()) {
+                break;
+            }
+            next();
+            keys[i] = getKey();
+            v1[i] = getValue1();
+            v2[i] = getValue2();
+            i++;
+        }
+    }
+    return i;
+}
+
 void ScanItr::clear() {
     if (m_currentTable) {
         q->releaseItr(m_currentTable);
@@ -274,6 +382,8 @@ void ScanItr::clear() {
     if (reversedItr && reversedItr != m_reversedItr) {
         q->releaseItr(reversedItr);
     }
+    stopPrefetch();
+    q->endScan(idx);
 }
 
 void ScanItr::mark() {
@@ -302,6 +412,9 @@ void ScanItr::mark() {
 }
 
 void ScanItr::reset(const char i) {
+    //The scan goes back, so the tables that were read ahead are not
+    //the following ones anymore
+    stopPrefetch();
     hnc = m_hnc;
     hn = m_hn;
 
@@ -343,6 +456,7 @@ void ScanItr::reset(const char i) {
 
 void ScanItr::gotoKey(int64_t k) {
     if (k > getKey()) {
+        stopPrefetch();
         if (currentTable) {
             //release it
             if (currentTable != m_currentTable) {
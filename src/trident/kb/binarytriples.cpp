@@ -0,0 +1,134 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/kb/binarytriples.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <cstring>
+
+static uint64_t __readLE(const char *buffer, const int nbytes) {
+    uint64_t n = 0;
+    for (int i = nbytes - 1; i >= 0; --i) {
+        n = (n << 8) | (uint8_t) buffer[i];
+    }
+    return n;
+}
+
+bool BinaryTriples::isBinary(std::string file) {
+    char magic[BINTRIPLES_MAGIC_SIZE];
+    std::ifstream in(file, std::ios_base::binary);
+    if (!in.read(magic, BINTRIPLES_MAGIC_SIZE)) {
+        return false;
+    }
+    return memcmp(magic, BINTRIPLES_MAGIC, BINTRIPLES_MAGIC_SIZE) == 0;
+}
+
+BinaryTriplesHeader BinaryTriples::readHeader(std::string file) {
+    char buffer[BINTRIPLES_HEADER_SIZE];
+    std::ifstream in(file, std::ios_base::binary);
+    if (!in.read(buffer, BINTRIPLES_HEADER_SIZE) ||
+            memcmp(buffer, BINTRIPLES_MAGIC, BINTRIPLES_MAGIC_SIZE) != 0) {
+        LOG(ERRORL) << "The file " << file << " is not a binary triple file";
+        throw 10;
+    }
+    BinaryTriplesHeader header;
+    header.version = __readLE(buffer + 8, 4);
+    header.idBytes = __readLE(buffer + 12, 4);
+    header.ntriples = __readLE(buffer + 16, 8);
+    header.maxID = __readLE(buffer + 24, 8);
+    if (header.version != BINTRIPLES_VERSION) {
+        LOG(ERRORL) << "Version " << header.version << " of the binary "
+            "triple file " << file << " is not supported";
+        throw 10;
+    }
+    if (header.idBytes < 1 || header.idBytes > 8) {
+        LOG(ERRORL) << "The IDs of " << file << " are stored in " <<
+            header.idBytes << " bytes. Only 1 to 8 bytes are supported";
+        throw 10;
+    }
+    const uint64_t expectedSize = BINTRIPLES_HEADER_SIZE +
+        header.ntriples * 3 * header.idBytes;
+    if (Utils::fileSize(file) != expectedSize) {
+        LOG(ERRORL) << "The file " << file << " should contain " <<
+            header.ntriples << " triples (" << expectedSize << " bytes)";
+        throw 10;
+    }
+    return header;
+}
+
+BinaryTriples::BinaryTriples(std::vector<std::string> filenames) :
+    ntriples(0), maxID(-1) {
+    for (auto &f : filenames) {
+        BinaryTriplesHeader header = readHeader(f);
+        File file;
+        file.firstTriple = ntriples;
+        file.ntriples = header.ntriples;
+        file.idBytes = header.idBytes;
+        file.triples = NULL;
+        if (header.ntriples > 0) {
+            file.mapping = std::unique_ptr<MemoryMappedFile>(
+                    new MemoryMappedFile(f, true, MAPPING_SEQUENTIAL));
+            file.triples = file.mapping->getData() + BINTRIPLES_HEADER_SIZE;
+        }
+        files.push_back(std::move(file));
+        ntriples += header.ntriples;
+        maxID = std::max(maxID, (int64_t) header.maxID);
+        LOG(DEBUGL) << "Binary triple file " << f << ": " << header.ntriples
+            << " triples, IDs of " << header.idBytes << " bytes";
+    }
+}
+
+void BinaryTriples::read(int64_t start, int64_t n, int64_t *out) const {
+    size_t idxFile = 0;
+    while (idxFile < files.size() && files[idxFile].firstTriple +
+            files[idxFile].ntriples <= start) {
+        idxFile++;
+    }
+    while (n > 0 && idxFile < files.size()) {
+        const File &file = files[idxFile];
+        const int64_t offset = start - file.firstTriple;
+        const int64_t toRead = std::min(n, file.ntriples - offset);
+        const int idBytes = file.idBytes;
+        const char *in = file.triples + offset * 3 * idBytes;
+        const int64_t nvalues = toRead * 3;
+        if (idBytes == 8) {
+            for (int64_t i = 0; i < nvalues; ++i) {
+                out[i] = (int64_t) __readLE(in + i * 8, 8);
+            }
+        } else if (idBytes == 4) {
+            for (int64_t i = 0; i < nvalues; ++i) {
+                out[i] = (int64_t) __readLE(in + i * 4, 4);
+            }
+        } else {
+            for (int64_t i = 0; i < nvalues; ++i) {
+                out[i] = (int64_t) __readLE(in + i * idBytes, idBytes);
+            }
+        }
+        out += nvalues;
+        start += toRead;
+        n -= toRead;
+        idxFile++;
+    }
+}
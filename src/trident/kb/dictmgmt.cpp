@@ -32,6 +32,8 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <memory>
 
 using namespace std;
 
@@ -217,6 +219,65 @@ bool DictMgmt::getText(nTerm key, char *value, int &size) {
     return false;
 }
 
+bool DictMgmt::getTexts(const std::vector<uint64_t> &keys,
+        std::string &texts,
+        std::vector<std::pair<size_t, size_t>> &positions) {
+    texts.clear();
+    positions.assign(keys.size(), std::make_pair((size_t) 0, (size_t) 0));
+
+    std::vector<std::pair<uint64_t, size_t>> sortedKeys(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        sortedKeys[i] = std::make_pair(keys[i], i);
+    }
+    std::sort(sortedKeys.begin(), sortedKeys.end());
+
+    //First get the coordinates of all strings, descending the tree with
+    //increasing keys
+    struct Location {
+        int dict;
+        int64_t coordinates;
+        size_t idx;
+        bool operator <(const Location &l) const {
+            return dict < l.dict || (dict == l.dict && coordinates < l.coordinates);
+        }
+    };
+    std::vector<Location> locations;
+    locations.reserve(keys.size());
+    bool allFound = true;
+    int idx = 0;
+    for (const auto &key : sortedKeys) {
+        while (idx < beginrange.size() - 1 && key.first >= beginrange[idx + 1]) {
+            idx++;
+        }
+        Location l;
+        if (dictionaries[idx].invdict->get(key.first, l.coordinates)) {
+            l.dict = idx;
+            l.idx = key.second;
+            locations.push_back(l);
+        } else {
+            auto it = gud_idtext.find(key.first);
+            if (it != gud_idtext.end()) {
+                positions[key.second] = std::make_pair(texts.size(),
+                        it->second.size());
+                texts += it->second;
+            } else {
+                allFound = false;
+            }
+        }
+    }
+
+    //Then read the strings in the order they are stored
+    std::sort(locations.begin(), locations.end());
+    std::unique_ptr<char[]> buffer(new char[MAX_TERM_SIZE]);
+    for (const auto &l : locations) {
+        int size = 0;
+        dictionaries[l.dict].sb->get(l.coordinates, buffer.get(), size);
+        positions[l.idx] = std::make_pair(texts.size(), (size_t) size);
+        texts.append(buffer.get(), size);
+    }
+    return allFound;
+}
+
 void DictMgmt::getTextFromCoordinates(int64_t coordinates, char *output,
         int &sizeOutput) {
     dictionaries[0].sb->get(coordinates, output, sizeOutput);
@@ -262,6 +323,15 @@ void DictMgmt::appendPair(const char *key, int sizeKey, nTerm &value) {
         largestID = value;
 }
 
+void DictMgmt::appendDict(const char *key, int sizeKey, nTerm &value,
+        int64_t &coordinates) {
+    coordinates = dictionaries[0].sb->getSize();
+    dictionaries[0].dict->append((tTerm*) key, sizeKey, value);
+    insertedNewTerms[0]++;
+    if (value > largestID)
+        largestID = value;
+}
+
 bool DictMgmt::putPair(const char *key, int sizeKey, nTerm &value) {
     int64_t coordinates = dictionaries[0].sb->getSize();
     if (dictionaries[0].dict->insertIfNotExists((tTerm*) key, sizeKey, value)) {
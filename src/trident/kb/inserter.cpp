@@ -40,6 +40,10 @@ bool Inserter::insert(const int permutation,
         const bool canSkipTables) {
 
     bool ret = false;
+    if (values1[permutation] == NULL) {
+        values1[permutation] = new int64_t[THRESHOLD_KEEP_MEMORY + 1];
+        values2[permutation] = new int64_t[THRESHOLD_KEEP_MEMORY + 1];
+    }
     if (t1 != currentT1[permutation]) {
         if (t1 < currentT1[permutation]) {
             LOG(DEBUGL) << "t1=" << t1 << " currentT1[perm]=" << currentT1[permutation];
@@ -130,6 +134,17 @@ void Inserter::insert(nTerm key, TermCoordinates *value) {
     tree->put(key, value);
 }
 
+void Inserter::updateCoordinates(nTerm key, const int permutation,
+        short file, int64_t mark, int64_t nElements, char strategy) {
+    TermCoordinates value;
+    value.clear();
+    if (!tree->get(key, &value)) {
+        value.clear();
+    }
+    value.set(permutation, file, mark, nElements, strategy);
+    tree->put(key, &value);
+}
+
 void Inserter::writeCurrentEntryIntoTree(int permutation,
         TripleWriter *posArray, TreeInserter *treeInserter,
         const bool aggregated,
@@ -174,6 +189,12 @@ void Inserter::writeCurrentEntryIntoTree(int permutation,
             case NEWCLUSTER_ITR:
                 ncluFactory[permutation].release((NewClusterTableInserter *) (currentPairHandler[permutation]));
                 break;
+            case COMPRCOLUMN_ITR:
+                ccFactory[permutation].release((ComprColumnTableInserter *) (currentPairHandler[permutation]));
+                break;
+            case EFCOLUMN_ITR:
+                efFactory[permutation].release((EFColumnTableInserter *) (currentPairHandler[permutation]));
+                break;
         }
 
         int64_t nels;
@@ -217,6 +238,10 @@ void Inserter::storeInmemoryValuesIntoFiles(int permutation, int64_t* v1, int64_
         onlyReferences[permutation] = aggregated && StorageStrat::determineAggregatedStrategy(v1, v2, n, nTerms, stats[permutation]);
         if (onlyReferences[permutation]) {
             strat = STRATEGY_FOR_POS;
+        } else if (blockCompression != -1 && n >= thresholdBlockCompression) {
+            strat = StorageStrat::getComprStrat(blockCompression);
+        } else if (thresholdEFDirectory > 0 && n >= thresholdEFDirectory) {
+            strat = StorageStrat::getEFStrat();
         } else {
             strat = StorageStrat::determineStrategy(v1, v2, n, nTerms,
                     thresholdForColumnStorage,
@@ -279,4 +304,35 @@ void Inserter::flush(int permutation, TripleWriter * posArray,
 
 void Inserter::stopInserts(int permutation) {
     files[permutation]->stopInsert();
+    if (values1[permutation] != NULL) {
+        delete[] values1[permutation];
+        delete[] values2[permutation];
+        values1[permutation] = values2[permutation] = NULL;
+    }
+}
+
+Inserter *Inserter::createPartition(TableStorage **files, int64_t *ntables,
+        int64_t *nFirstElsNTables) {
+    Inserter *ins = new Inserter(tree, files, nTerms, useFixedStrategy,
+            fixedStrategy, thresholdSkipTable, ntables, nFirstElsNTables);
+    ins->useRowForLargeTables = useRowForLargeTables;
+    ins->thresholdForColumnStorage = thresholdForColumnStorage;
+    ins->blockCompression = blockCompression;
+    ins->thresholdBlockCompression = thresholdBlockCompression;
+    ins->thresholdEFDirectory = thresholdEFDirectory;
+    return ins;
+}
+
+TableStorage *Inserter::createStorage(const int permutation,
+        std::string path) {
+    Stats stats;
+    return new TableStorage(false, path, files[permutation]->getMaxFileSize(),
+            files[permutation]->getMaxNFiles(), NULL, stats, permutation);
+}
+
+void Inserter::mergePartition(const int permutation, Inserter *partition) {
+    stats[permutation].add(partition->stats[permutation]);
+    skippedTables[permutation] += partition->skippedTables[permutation];
+    ntables[permutation] += partition->ntables[permutation];
+    nFirstElsNTables[permutation] += partition->nFirstElsNTables[permutation];
 }
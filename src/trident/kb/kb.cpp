@@ -26,9 +26,12 @@
 #include <trident/kb/inserter.h>
 #include <trident/kb/consts.h>
 #include <trident/kb/kbconfig.h>
+#include <trident/kb/updater.h>
+#include <trident/files/mappingpolicy.h>
 #include <trident/kb/partial.h>
 #include <trident/tree/root.h>
 #include <trident/tree/flatroot.h>
+#include <trident/tree/staticroot.h>
 #include <trident/tree/stringbuffer.h>
 #include <trident/binarytables/tableshandler.h>
 
@@ -55,12 +58,17 @@ KB::KB(const char *path,
         std::vector<string> locationUpdates,
         bool enablePartials) :
     path(path), readOnly(readOnly), ntables(), nFirstTables(), isClosed(false),
-    dictEnabled(dictEnabled), config(config) {
+    dictEnabled(dictEnabled), config(config), updateVersion(0) {
 
         if (readOnly && !Utils::exists(string(path) + DIR_SEP + "tree")) {
             LOG(ERRORL) << "The input path does not seem to be a valid KB";
             throw 10;
         }
+        //An append that did not complete leaves the KB inconsistent
+        if (readOnly && Utils::exists(string(path) + DIR_SEP + "_append" +
+                    DIR_SEP + "journal" + DIR_SEP + "BEGIN")) {
+            Updater::recoverAppend(path);
+        }
 
         std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
 
@@ -149,10 +157,22 @@ KB::KB(const char *path,
             }
             aggrIndices = config.getParamBool(AGGRINDICES);
             incompleteIndices = config.getParamBool(INCOMPLINDICES);
-            useFixedStrategy = config.getParamBool(USEFIXEDSTRAT);
-            storageFixedStrategy = (char) config.getParamInt(FIXEDSTRAT);
-            thresholdSkipTable = config.getParamInt(THRESHOLD_SKIP_TABLE);
         }
+        //The strategy of the tables is not stored, so tables that are
+        //appended to an existing KB also follow the configuration
+        useFixedStrategy = config.getParamBool(USEFIXEDSTRAT);
+        storageFixedStrategy = (char) config.getParamInt(FIXEDSTRAT);
+        thresholdSkipTable = config.getParamInt(THRESHOLD_SKIP_TABLE);
+        //The codec is stored in the signature of each table, so the
+        //compression can also be enabled when updating an existing KB
+        blockCompression = config.getParamInt(BLOCKCOMPRESSION);
+        thresholdBlockCompression = config.getParamLong(THRESHOLD_BLOCKCOMPRESSION);
+        thresholdEFDirectory = config.getParamLong(THRESHOLD_EFDIRECTORY);
+
+        //Hints for the kernel on how the index files will be accessed
+        MappingPolicy::init(config);
+        scanPrefetchTables = readOnly ? config.getParamInt(SCAN_PREFETCH_TABLES) : 0;
+        scanPrefetchBytes = config.getParamLong(SCAN_PREFETCH_BYTES);
 
         //Optimize the memory management
         if (reasoning) {
@@ -193,7 +213,21 @@ KB::KB(const char *path,
                     config.getParamInt(TREE_NODE_KEYS_FACTORY_SIZE));
             map.setInt(NODE_KEYS_PREALL_FACTORY_SIZE,
                     config.getParamInt(TREE_NODE_KEYS_PREALL_FACTORY_SIZE));
+            map.setInt(MAPPING_HINTS, MappingPolicy::getIndexFlags());
             tree = new Root(fileTree, NULL, readOnly, map);
+
+            if (readOnly && config.getParamBool(TREE_STATIC)) {
+                //The static tree is created by the loader. It is never
+                //written here because the KB might be on read-only media
+                string staticTree = fileTree + string("static");
+                if (Utils::exists(staticTree)) {
+                    delete tree;
+                    tree = new StaticRoot(staticTree);
+                } else {
+                    LOG(WARNL) << "The static tree " << staticTree <<
+                        " does not exist (see --buildStaticTree). I use the normal tree";
+                }
+            }
         }
 
         std::chrono::duration<double> sec = std::chrono::system_clock::now()
@@ -261,6 +295,14 @@ KB::KB(const char *path,
         string sampleDir = path + DIR_SEP + string("_sample");
         if (Utils::exists(sampleDir)) {
             KBConfig sampleConfig;
+            //The mapping policy is global, so it must not be reset
+            sampleConfig.setParam(MAPPING_ADVICE, config.getParam(MAPPING_ADVICE));
+            sampleConfig.setParamBool(MAPPING_WILLNEED_INDEX,
+                    config.getParamBool(MAPPING_WILLNEED_INDEX));
+            sampleConfig.setParamBool(MAPPING_POPULATE_FILES,
+                    config.getParamBool(MAPPING_POPULATE_FILES));
+            sampleConfig.setParamBool(MAPPING_HUGEPAGES_FILES,
+                    config.getParamBool(MAPPING_HUGEPAGES_FILES));
             sampleKB = new KB(sampleDir.c_str(), true, false, false, sampleConfig);
             sampleRate = (double) sampleKB->getSize() / this->totalNumberTriples;
         } else {
@@ -415,7 +457,8 @@ void KB::loadDict(KBConfig *config) {
     maindict->sb = std::shared_ptr<StringBuffer>(new StringBuffer(ss1.str(), readOnly,
                 config->getParamInt(SB_PREALLBUFFERS),
                 config->getParamLong(SB_CACHESIZE),
-                maindict->stats.get()));
+                maindict->stats.get(),
+                config->getParamInt(SB_COMPRESSTHREADS)));
     maindict->dict = std::shared_ptr<Root>(new Root(ss1.str(), maindict->sb.get(), readOnly, map));
 
     //Initialize the inverse dictionaries
@@ -443,9 +486,11 @@ void KB::loadDict(KBConfig *config) {
 }
 
 Querier *KB::query() {
-    return new Querier(tree, dictManager, files, totalNumberTriples,
+    Querier *q = new Querier(tree, dictManager, files, totalNumberTriples,
             totalNumberTerms, nindices, ntables, nFirstTables,
             sampleKB, diffIndices, present, partial);
+    q->setScanPrefetch(scanPrefetchTables, scanPrefetchBytes);
+    return q;
 }
 
 Inserter *KB::insert() {
@@ -453,7 +498,7 @@ Inserter *KB::insert() {
         LOG(ERRORL) << "Insert() is not available if the knowledge base is opened in read_only mode.";
     }
 
-    return new Inserter(tree,
+    Inserter *ins = new Inserter(tree,
             files,
             totalNumberTerms + (dictEnabled ? dictManager->getNTermsInserted() : 0),
             useFixedStrategy,
@@ -461,6 +506,13 @@ Inserter *KB::insert() {
             thresholdSkipTable,
             ntables,
             nFirstTables);
+    if (blockCompression != -1) {
+        ins->setBlockCompression(blockCompression, thresholdBlockCompression);
+    }
+    if (thresholdEFDirectory > 0) {
+        ins->setEFDirectory(thresholdEFDirectory);
+    }
+    return ins;
 }
 
 void KB::closeMainDict() {
@@ -494,7 +546,7 @@ void KB::close() {
     if (!readOnly) {
         if (dictEnabled) {
             totalNumberTerms += dictManager->getNTermsInserted();
-            nextID = dictManager->getLargestIDInserted() + 1;
+            nextID = max(nextID, dictManager->getLargestIDInserted() + 1);
         }
         if (this->graphType != GraphType::DEFAULT) {
             totalNumberTriples += files[IDX_SOP]->getNTriplesInserted();
@@ -531,6 +583,7 @@ void KB::close() {
     }
 
     diffIndices.clear();
+    updateVersion++;
     isClosed = true;
 }
 
@@ -643,12 +696,36 @@ void KB::addDiffIndex(string inputdir, const char **globalbuffers, Querier *q) {
     if (q) {
         q->initDiffIndex(diffIndices.back().get());
     }
+    updateVersion++;
 }
 
 std::vector<const char*> KB::openAllFiles(int perm) {
     return files[perm]->loadAllFiles();
 }
 
+size_t KB::warmup(const std::vector<int> &perms) {
+    size_t npages = 0;
+    string treeDir = path + DIR_SEP + string("tree");
+    if (Utils::exists(treeDir)) {
+        for (auto f : Utils::getFiles(treeDir)) {
+            if (Utils::fileSize(f) > 0) {
+                MemoryMappedFile mf(f);
+                npages += mf.prefault();
+            }
+        }
+    }
+    for (auto perm : perms) {
+        if (perm < 0 || perm >= N_PARTITIONS) {
+            LOG(ERRORL) << "Permutation " << perm << " does not exist";
+            throw 10;
+        }
+        if (files[perm] != NULL) {
+            npages += files[perm]->warmup();
+        }
+    }
+    return npages;
+}
+
 void KB::createSingleUpdate(DiffIndex::TypeUpdate type, PairItr *itr, std::string dir, std::string diffDir, Querier *q) {
 
     std::vector<uint64_t> all_s;
@@ -826,6 +903,7 @@ void KB::mergeUpdates() {
         throw 10;
     }
     // Utils::remove_all(old);
+    updateVersion++;
     std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
     LOG(INFOL) << "Total merge time = " << sec.count() * 1000 << " ms.";
 }
@@ -39,6 +39,9 @@ KBConfig::KBConfig() {
     internalMap.setInt(FIXEDSTRAT, 0);
     internalMap.setInt(THRESHOLD_SKIP_TABLE, 10);
     internalMap.setBool(RELSOWNIDS, false);
+    internalMap.setInt(BLOCKCOMPRESSION, -1);
+    internalMap.setLong(THRESHOLD_BLOCKCOMPRESSION, 100000);
+    internalMap.setLong(THRESHOLD_EFDIRECTORY, 0);
 
     //Parameters about the main tree
     internalMap.setInt(TREE_MAXELEMENTSNODE, 2048);
@@ -59,6 +62,7 @@ KBConfig::KBConfig() {
     //Nodes in the tree
     internalMap.setInt(TREE_NODE_KEYS_FACTORY_SIZE, 10);
     internalMap.setInt(TREE_NODE_KEYS_PREALL_FACTORY_SIZE, 10000);
+    internalMap.setBool(TREE_STATIC, false);
 
     //Dictionary
     internalMap.setInt(DICT_MAXELEMENTSNODE, 2048);
@@ -91,10 +95,20 @@ KBConfig::KBConfig() {
     internalMap.setLong(STORAGE_MAX_FILE_SIZE, INT64_C(20) * 1024 * 1024 * 1024);
     internalMap.setInt(STORAGE_MAX_N_FILES, MAX_N_FILES);
 
+    //Mapping of the index files
+    internalMap.set(MAPPING_ADVICE, "normal");
+    internalMap.setBool(MAPPING_WILLNEED_INDEX, false);
+    internalMap.setBool(MAPPING_POPULATE_FILES, false);
+    internalMap.setBool(MAPPING_HUGEPAGES_FILES, false);
+    //Opt-in: every scan that prefetches runs its own thread
+    internalMap.setInt(SCAN_PREFETCH_TABLES, 0);
+    internalMap.setLong(SCAN_PREFETCH_BYTES, INT64_C(64) * 1024 * 1024); //64MB
+
     //String buffer
     internalMap.setBool(SB_COMPRESSDOMAINS, false);
     internalMap.setInt(SB_PREALLBUFFERS, 1000);
     internalMap.setLong(SB_CACHESIZE, INT64_C(128) * 1024 * 1024); //128MB
+    internalMap.setInt(SB_COMPRESSTHREADS, 1);
 }
 
 void KBConfig::setParam(KBParam key, string value) {
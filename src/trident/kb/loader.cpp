@@ -27,8 +27,11 @@
 #include <trident/kb/permsorter.h>
 #include <trident/tree/nodemanager.h>
 #include <trident/tree/flatroot.h>
+#include <trident/tree/staticroot.h>
 #include <trident/utils/tridentutils.h>
 #include <trident/utils/parallel.h>
+#include <trident/utils/loadprofiler.h>
+#include <trident/utils/textreader.h>
 
 #include <kognac/lz4io.h>
 #include <kognac/utils.h>
@@ -40,6 +43,7 @@
 #include <kognac/kognac.h>
 
 #include <zstr/zstr.hpp>
+#include <zlib.h>
 
 #include <mutex>
 #include <condition_variable>
@@ -143,43 +147,34 @@ bool _sorter_pso(const Triple &a, const Triple &b) {
     return false;
 }
 
-void __parseLineSnapFile(string &line, string &origline,
-        std::map<int64_t, int64_t> &dictionary, std::vector<Triple> &triples, int64_t &counter) {
-    origline = line;
-    char delim = '\t';
-    if (line[0] != '#') {
-        int64_t s,o;
-        auto pos = line.find(delim);
-        if (pos == string::npos) {
-            if (delim == '\t') {
-                delim = ' ';
-                pos = line.find(delim);
-                if (pos == string::npos) {
-                    LOG(ERRORL) << "Failed parsing the SNAP file (no delim)";
-                    throw 10;
-                }
-            }
-        }
-        string ss = line.substr(0, pos);
-        s = stol(ss);
-        line = line.substr(pos + 1);
-        o = stol(line);
-
-        if (dictionary.count(s)) {
-            s = dictionary.find(s)->second;
-        } else {
-            dictionary.insert(std::make_pair(s, counter));
-            s = counter++;
-        }
+//Parses the next number in a line. The numbers are separated by spaces
+//or tabs
+static bool __parseNumber(const char *&c, const char *end, int64_t &n) {
+    while (c < end && (*c == ' ' || *c == '\t' || *c == '\r')) {
+        c++;
+    }
+    const bool negative = c < end && *c == '-';
+    if (negative) {
+        c++;
+    }
+    if (c == end || *c < '0' || *c > '9') {
+        return false;
+    }
+    n = 0;
+    while (c < end && *c >= '0' && *c <= '9') {
+        n = n * 10 + (*c++ - '0');
+    }
+    if (negative) {
+        n = -n;
+    }
+    return true;
+}
 
-        if (dictionary.count(o)) {
-            o = dictionary.find(o)->second;
-        } else {
-            dictionary.insert(std::make_pair(o, counter));
-            o = counter++;
-        }
-        triples.push_back(Triple(s, 0, o));
+static bool __isBlankLine(const char *c, const char *end) {
+    while (c < end && (*c == ' ' || *c == '\t' || *c == '\r')) {
+        c++;
     }
+    return c == end;
 }
 
 int64_t Loader::parseSnapFile(string inputtriples,
@@ -192,24 +187,59 @@ int64_t Loader::parseSnapFile(string inputtriples,
         int parallelProcesses) {
     LOG(DEBUGL) << "Loading input graph from " << inputtriples;
 
-    //Create the permutations
-    int64_t counter = 0;
-    std::map<int64_t, int64_t> dictionary;
-    std::vector<Triple> triples;
-    string line, origline;
-    if (Utils::ends_with(inputtriples, ".gz")) {
-        zstr::ifstream inputreader(inputtriples);
-        while(std::getline(inputreader, line)) {
-            __parseLineSnapFile(line, origline, dictionary, triples, counter);
+    //The file is decompressed and parsed by all the threads
+    std::vector<std::vector<std::pair<int64_t, int64_t>>> edges(
+            std::max(parallelProcesses, 1));
+    ParallelTextReader reader(inputtriples);
+    reader.read(edges.size(), [&](const char *start, const char *end,
+                int thread) {
+        auto &out = edges[thread];
+        const char *line = start;
+        while (line < end) {
+            const char *eol = (const char*) memchr(line, '\n', end - line);
+            if (eol == NULL) {
+                eol = end;
+            }
+            const char *c = line;
+            int64_t s, o;
+            if (*line != '#' && !__isBlankLine(line, eol)) {
+                if (!__parseNumber(c, eol, s) || !__parseNumber(c, eol, o)) {
+                    LOG(ERRORL) << "Failed parsing the SNAP file (line " <<
+                        string(line, eol) << ")";
+                    throw 10;
+                }
+                out.push_back(std::make_pair(s, o));
+            }
+            line = eol + 1;
         }
-    } else {
-        ifstream inputreader(inputtriples);
-        while(std::getline(inputreader, line)) {
-            __parseLineSnapFile(line, origline, dictionary, triples, counter);
+    });
+
+    //Number the vertices in the order of their original IDs
+    std::vector<int64_t> vertices;
+    for (const auto &part : edges) {
+        for (const auto &edge : part) {
+            vertices.push_back(edge.first);
+            vertices.push_back(edge.second);
+        }
+    }
+    ParallelTasks::sort_int(vertices.begin(), vertices.end(),
+            std::max(parallelProcesses, 1));
+    vertices.erase(std::unique(vertices.begin(), vertices.end()),
+            vertices.end());
+    std::vector<Triple> triples;
+    for (auto &part : edges) {
+        for (const auto &edge : part) {
+            const int64_t s = std::lower_bound(vertices.begin(),
+                    vertices.end(), edge.first) - vertices.begin();
+            const int64_t o = std::lower_bound(vertices.begin(),
+                    vertices.end(), edge.second) - vertices.begin();
+            triples.push_back(Triple(s, 0, o));
         }
+        std::vector<std::pair<int64_t, int64_t>>().swap(part);
     }
+    const int64_t counter = vertices.size();
 
-    LOG(DEBUGL) << "Loaded a vocabulary of " << dictionary.size();
+    LOG(DEBUGL) << "Loaded a vocabulary of " << counter;
     int detailPerms[6];
     Compressor::parsePermutationSignature(signaturePerm, detailPerms);
     for(int i = 0; i < nperms; ++i) {
@@ -251,26 +281,77 @@ int64_t Loader::parseSnapFile(string inputtriples,
         }
     }
 
-    //Store the dictionary. I must ensure that the data is ordered by key.
-    std::map<int64_t, int64_t> inverseDict;
-    for(const auto &it : dictionary) {
-        inverseDict.insert(std::make_pair(it.second, it.first));
-    }
+    //Store the dictionary. The IDs follow the order of the vertices
     LZ4Writer outputDict(fileNameDictionaries);
     char *support = new char[MAX_TERM_SIZE];
-    for(const auto &it : inverseDict) {
-        outputDict.writeLong(it.first);
-        string text = to_string(it.second);
+    for(int64_t i = 0; i < counter; ++i) {
+        outputDict.writeLong(i);
+        string text = to_string(vertices[i]);
         Utils::encode_short(support, text.length());
         memcpy(support + 2, text.c_str(), text.length());
         outputDict.writeString(support, text.length() + 2);
     }
     delete[] support;
+    PermSorter::setMaxTermID(counter - 1);
     return triples.size();
 }
 
+string Loader::splitCompressedInput(string input, string tmpDir,
+        int nthreads) {
+    std::vector<string> files;
+    if (Utils::isDirectory(input)) {
+        files = Utils::getFiles(input);
+    } else {
+        files.push_back(input);
+    }
+    if (files.empty()) {
+        return input;
+    }
+    for (auto &file : files) {
+        auto format = ParallelTextReader::getFormat(file);
+        if ((format != ParallelTextReader::BGZF &&
+                    format != ParallelTextReader::LZ4) ||
+                !ParallelTextReader::isSplittable(file)) {
+            return input;
+        }
+    }
+
+    nthreads = std::max(nthreads, 1);
+    string outputDir = tmpDir + DIR_SEP + "input-split";
+    LOG(INFOL) << "Splitting the input in " << nthreads << " files in " <<
+        outputDir;
+    Utils::create_directories(outputDir);
+    std::vector<gzFile> outputs;
+    for (int i = 0; i < nthreads; ++i) {
+        string file = outputDir + DIR_SEP + "part-" + to_string(i) + ".nt.gz";
+        outputs.push_back(gzopen(file.c_str(), "wb1"));
+        if (outputs.back() == NULL) {
+            LOG(ERRORL) << "Failed opening " << file;
+            throw 10;
+        }
+    }
+    for (auto &file : files) {
+        ParallelTextReader reader(file);
+        reader.read(nthreads, [&](const char *start, const char *end,
+                    int thread) {
+            gzwrite(outputs[thread], start, end - start);
+            if (end[-1] != '\n') {
+                //Last line of the file
+                gzputc(outputs[thread], '\n');
+            }
+        });
+    }
+    for (auto &output : outputs) {
+        if (gzclose(output) != Z_OK) {
+            LOG(ERRORL) << "Failed writing the split input";
+            throw 10;
+        }
+    }
+    return outputDir;
+}
+
 void Loader::createPermsAndDictsFromFiles_seq(DiskReader *reader,
-        DiskLZ4Writer *writer, int id, int64_t *output) {
+        DiskLZ4Writer *writer, int id, int64_t *output, int64_t *maxTerm) {
     typedef std::istream_iterator<char> isitr;
 
     //size_t sizebuffer = 0;
@@ -279,6 +360,7 @@ void Loader::createPermsAndDictsFromFiles_seq(DiskReader *reader,
     std::vector<char> uncompressedByteArray;
 
     int64_t processedtriples = 0;
+    int64_t maxID = -1;
     while (buffer.b != NULL) {
         //Read the file
         const char *pivotbuffer = buffer.b;
@@ -321,6 +403,10 @@ void Loader::createPermsAndDictsFromFiles_seq(DiskReader *reader,
             }
             if (*start == '\n') {
                 if (pos > 1) {
+                    maxID = max(maxID, max(triple[0], triple[1]));
+                    if (pos > 2) {
+                        maxID = max(maxID, triple[2]);
+                    }
                     if (pos == 2) {
                         //Add an empty predicate
                         writer->writeLong(id, triple[0]);
@@ -347,6 +433,10 @@ void Loader::createPermsAndDictsFromFiles_seq(DiskReader *reader,
         }
         tkn = start + 1;
         if (pos > 1) {
+            maxID = max(maxID, max(triple[0], triple[1]));
+            if (pos > 2) {
+                maxID = max(maxID, triple[2]);
+            }
             if (pos == 2) {
                 //Add an empty predicate
                 writer->writeLong(id, triple[0]);
@@ -367,6 +457,7 @@ void Loader::createPermsAndDictsFromFiles_seq(DiskReader *reader,
     }
     writer->setTerminated(id);
     *output = processedtriples;
+    *maxTerm = maxID;
 }
 
 void _convertDictFile(std::vector<string> ins, string out) {
@@ -445,28 +536,79 @@ int64_t Loader::createPermsAndDictsFromFiles(string inputtriples,
 
     //Create the permutations
     int64_t ntriples = 0;
+    int64_t maxTerm = -1;
+
+    //If the triples are stored in the binary format, then they are not
+    //converted. The sorter reads them directly from the files.
+    std::vector<string> tripleFiles;
+    if (Utils::exists(inputtriples)) {
+        tripleFiles.push_back(inputtriples);
+    } else {
+        tripleFiles = Utils::getFilesWithPrefix(Utils::parentDir(inputtriples), Utils::filename(inputtriples));
+        std::sort(tripleFiles.begin(), tripleFiles.end());
+        for(int i = 0; i < tripleFiles.size(); ++i) {
+            tripleFiles[i] = Utils::parentDir(inputtriples) + DIR_SEP + tripleFiles[i];
+        }
+    }
+    if (!tripleFiles.empty() && BinaryTriples::isBinary(tripleFiles[0])) {
+        std::shared_ptr<BinaryTriples> input(new BinaryTriples(tripleFiles));
+        LOG(INFOL) << "The triples are in binary format (" <<
+            tripleFiles.size() << " file(s), " << input->getNTriples() <<
+            " triples)";
+        PermSorter::setBinaryInput(permDirs[0], input);
+        PermSorter::setMaxTermID(input->getMaxID());
+        return input->getNTriples();
+    }
+
     if (Utils::exists(inputtriples)) {
-        zstr::ifstream compressedFile2(inputtriples);
-        string line;
         LOG(DEBUGL) << "Start converting triple file";
-        LZ4Writer writer(permDirs[0] + DIR_SEP + "input-0");
-        while(std::getline(compressedFile2, line)) {
-            int64_t s,p,o;
-            int pos = line.find(' ');
-            string ss = line.substr(0, pos);
-            s = stol(ss);
-            line = line.substr(pos + 1);
-            pos = line.find(' ');
-            string sp = line.substr(0, pos);
-            line = line.substr(pos + 1);
-            p = stol(sp);
-            o = stol(line);
-            for(int i = 0; i < nperms; ++i) {
-                writer.writeLong(s);
-                writer.writeLong(p);
-                writer.writeLong(o);
+        //The file is decompressed and parsed by all the threads. Each of
+        //them writes its own input file
+        nthreads = std::max(nthreads, 1);
+        std::vector<std::unique_ptr<LZ4Writer>> writers;
+        for (int i = 0; i < nthreads; ++i) {
+            writers.push_back(std::unique_ptr<LZ4Writer>(new LZ4Writer(
+                            permDirs[0] + DIR_SEP + "input-" + to_string(i))));
+        }
+        std::vector<int64_t> counts(nthreads);
+        std::vector<int64_t> maxTerms(nthreads, -1);
+        ParallelTextReader reader(inputtriples);
+        reader.read(nthreads, [&](const char *start, const char *end,
+                    int thread) {
+            LZ4Writer *writer = writers[thread].get();
+            int64_t count = 0;
+            int64_t maxT = maxTerms[thread];
+            const char *line = start;
+            while (line < end) {
+                const char *eol = (const char*) memchr(line, '\n', end - line);
+                if (eol == NULL) {
+                    eol = end;
+                }
+                const char *c = line;
+                int64_t s, p, o;
+                if (__parseNumber(c, eol, s) && __parseNumber(c, eol, p) &&
+                        __parseNumber(c, eol, o)) {
+                    maxT = max(maxT, max(s, max(p, o)));
+                    for(int i = 0; i < nperms; ++i) {
+                        writer->writeLong(s);
+                        writer->writeLong(p);
+                        writer->writeLong(o);
+                    }
+                    count++;
+                } else if (!__isBlankLine(line, eol)) {
+                    LOG(ERRORL) << "Failed parsing the triple " <<
+                        string(line, eol);
+                    throw 10;
+                }
+                line = eol + 1;
             }
-            ntriples++;
+            counts[thread] += count;
+            maxTerms[thread] = maxT;
+        });
+        writers.clear();
+        for (int i = 0; i < nthreads; ++i) {
+            ntriples += counts[i];
+            maxTerm = max(maxTerm, maxTerms[i]);
         }
     } else {
         // Load all the files in parallel
@@ -491,14 +633,17 @@ int64_t Loader::createPermsAndDictsFromFiles(string inputtriples,
         }
 
         int64_t *outputs = new int64_t[nthreads];
+        int64_t *maxTerms = new int64_t[nthreads];
         for(int i = 0; i < nthreads; ++i) {
             outputs[i] = 0;
+            maxTerms[i] = -1;
             threads[i] = std::thread(
                     std::bind(&Loader::createPermsAndDictsFromFiles_seq,
                         readers[i % nreadThreads],
                         writers[i % nreadThreads],
                         i / nreadThreads,
-                        outputs + i));
+                        outputs + i,
+                        maxTerms + i));
         }
 
         //Delete the datastructures
@@ -506,7 +651,9 @@ int64_t Loader::createPermsAndDictsFromFiles(string inputtriples,
             if (threads[i].joinable())
                 threads[i].join();
             ntriples += outputs[i];
+            maxTerm = max(maxTerm, maxTerms[i]);
         }
+        delete[] maxTerms;
         for (int i = 0; i < nreadThreads; ++i) {
             if (threadReaders[i].joinable())
                 threadReaders[i].join();
@@ -518,6 +665,9 @@ int64_t Loader::createPermsAndDictsFromFiles(string inputtriples,
         delete[] threadReaders;
         delete[] files;
     }
+    //The IDs are given in the input, so the largest one sets the size of
+    //the records used to sort the permutations
+    PermSorter::setMaxTermID(maxTerm);
     return ntriples;
 }
 
@@ -953,8 +1103,17 @@ for(auto inputFile : unsortedFiles)
     }
 }*/
 
+int Loader::mergeFanIn = 4;
+std::unique_ptr<TokenBudget> Loader::memoryBudget;
+bool Loader::pipelineIndices = true;
+
+int64_t Loader::getInsertMemory(int64_t budget, bool pipeline) {
+    return pipeline ? budget / 3 : budget;
+}
+
 void Loader::mergeDiskFragments(ParamsMergeDiskFragments params) {
     string inputDir = params.inputDir;
+    LoadPhase phase("merge " + Utils::filename(inputDir), "merge");
     //Do the merge-sort from the files on disk
     LOG(DEBUGL) << "Starting merging of disk segments ...";
     int globalCounter = 0;
@@ -963,10 +1122,10 @@ void Loader::mergeDiskFragments(ParamsMergeDiskFragments params) {
         if (sortedFiles.size() <= 2) {
             break;
         }
-        //Pick up to four files and merge them together
+        //Pick up to mergeFanIn files and merge them together
         int i = 0;
         while (i < sortedFiles.size()) {
-            int nfilesToMerge = 4;
+            int nfilesToMerge = mergeFanIn;
             if (i + nfilesToMerge > sortedFiles.size()) {
                 nfilesToMerge = sortedFiles.size() - i;
             }
@@ -976,6 +1135,11 @@ void Loader::mergeDiskFragments(ParamsMergeDiskFragments params) {
                 filesToMerge.push_back(sortedFiles[j]);
             }
             std::string outputFile = inputDir + "/merged-" + to_string(globalCounter++) + ".0";
+            //The merges of different permutations can run in parallel, so
+            //they take the memory for their files from the budget of the load
+            const int64_t tokens = memoryBudget ? memoryBudget->acquire(
+                    (int64_t) nfilesToMerge * MERGE_BYTES_PER_FILE /
+                    (1024 * 1024)) : 0;
             LZ4Writer writer(outputFile);
             LOG(DEBUGL) << "Merging " << nfilesToMerge << " into " << outputFile;
             if (nfilesToMerge == 1) {
@@ -996,16 +1160,22 @@ void Loader::mergeDiskFragments(ParamsMergeDiskFragments params) {
                     Triple t = merger.get();
                     t.writeTo(&writer);
                 }
-            } else {
-                if (nfilesToMerge > 4) {
-                    LOG(ERRORL) << "This should not have happened " << nfilesToMerge;
-                    throw 10;
-                }
+            } else if (nfilesToMerge == 4) {
                 FastFileMerger<4, Triple> merger(filesToMerge, true, true);
                 while (!merger.isEmpty()) {
                     Triple t = merger.get();
                     t.writeTo(&writer);
                 }
+            } else {
+                //Larger fan-in: use the heap-based merger
+                FileMerger<Triple> merger(filesToMerge, true, true);
+                while (!merger.isEmpty()) {
+                    Triple t = merger.get();
+                    t.writeTo(&writer);
+                }
+            }
+            if (memoryBudget) {
+                memoryBudget->release(tokens);
             }
             i += nfilesToMerge;
             LOG(DEBUGL) << "Stop merging of " << nfilesToMerge << " files";
@@ -1029,6 +1199,7 @@ void Loader::insert(ParamInsert params) {
     bool printstats = params.printstats;
     bool removeInput = params.removeInput;
     bool deletePreviousExt = params.deletePreviousExt;
+    LoadPhase phase("insert p" + to_string(permutation), "insert");
 
     SimpleTripleWriter *posWriter = NULL;
     if (POSoutputDir != NULL) {
@@ -1054,7 +1225,93 @@ void Loader::insert(ParamInsert params) {
     }
     bool first = true;
 
-    if (parallelProcesses > 1) {
+    if (parallelProcesses > 1 && posWriter == NULL && !aggregated) {
+        //Split the sorted stream in key ranges. Each range is built by its
+        //own inserter in separate files and they are stitched at the end
+        LOG(DEBUGL) << "Parallel insert in key ranges";
+        std::string storageDir = ins->getPathPermutationStorage(permutation);
+        storageDir = storageDir.substr(0, storageDir.size() - 1);
+        std::vector<InsertRange*> ranges;
+        ConcurrentQueue<InsertRange*> queue;
+        std::mutex insMutex;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < parallelProcesses; ++i) {
+            threads.push_back(std::thread([&queue, &insMutex, permutation, ins,
+                        canSkipTables]() {
+                InsertRange *range;
+                queue.pop_wait(range);
+                while (range != NULL) {
+                    Loader::insertRange(range, permutation, ins, insMutex,
+                            canSkipTables);
+                    queue.pop_wait(range);
+                }
+            }));
+        }
+
+        LZ4Writer *rangeWriter = NULL;
+        int64_t rangeSize = 0;
+        int countrandom = 0;
+        while (!merger.isEmpty()) {
+            Triple t = merger.get();
+            countInput++;
+            if (count % 1000000000 == 0) {
+                LOG(DEBUGL) << "..." << count << "...";
+            }
+
+            if (t.o != po || t.p != pp || t.s != ps) {
+                //Ranges are closed only when the first term changes, so
+                //that a table is never split
+                if (rangeWriter == NULL || (rangeSize >= TRIPLES_PER_RANGE &&
+                            t.s != ps)) {
+                    if (rangeWriter != NULL) {
+                        delete rangeWriter;
+                        queue.push(ranges.back());
+                    }
+                    const string id = to_string(ranges.size());
+                    InsertRange *range = new InsertRange();
+                    range->input = inputDir + DIR_SEP + "range-" + id;
+                    range->storageDir = storageDir + "-range" + id;
+                    range->treeFile = inputDir + DIR_SEP + "rangetree-" + id;
+                    ranges.push_back(range);
+                    rangeWriter = new LZ4Writer(range->input);
+                    rangeSize = 0;
+                }
+                t.writeTo(rangeWriter);
+                rangeSize++;
+                count++;
+                ps = t.s;
+                pp = t.p;
+                po = t.o;
+
+                if (storeRaw) {
+                    plainWriter->writeVLong(t.s);
+                    plainWriter->writeVLong(t.p);
+                    plainWriter->writeVLong(t.o);
+                }
+
+                if (sampleWriter != NULL) {
+                    if (first || countrandom < randThreshold) {
+                        sampleWriter->write(t.s, t.p, t.o);
+                        first = false;
+                    }
+                    countrandom = (countrandom + 1) % 100;
+                }
+            }
+        }
+        if (rangeWriter != NULL) {
+            delete rangeWriter;
+            queue.push(ranges.back());
+        }
+        for (int i = 0; i < parallelProcesses; ++i) {
+            queue.push(NULL);
+        }
+        for (int i = 0; i < parallelProcesses; ++i) {
+            threads[i].join();
+        }
+        LOG(DEBUGL) << "Built " << ranges.size() << " ranges";
+        stitchRanges(ranges, permutation, ins, treeWriter);
+
+    } else if (parallelProcesses > 1) {
         LOG(DEBUGL) << "Parallel insert";
         std::mutex m_buffers;
         std::condition_variable cond_buffers;
@@ -1223,6 +1480,85 @@ void Loader::insert(ParamInsert params) {
     LOG(DEBUGL) << "...completed. Added " << count << " triples out of " << countInput;
 }
 
+void Loader::insertRange(InsertRange *range, const int permutation,
+        Inserter *ins, std::mutex &insMutex, const bool canSkipTables) {
+    for (int i = 0; i < N_PARTITIONS; ++i) {
+        range->files[i] = NULL;
+        range->ntables[i] = 0;
+        range->nFirstEls[i] = 0;
+    }
+    range->files[permutation] = ins->createStorage(permutation,
+            range->storageDir);
+    Inserter *rangeIns = ins->createPartition(range->files, range->ntables,
+            range->nFirstEls);
+
+    TreeWriter treeWriter(range->treeFile);
+    {
+        LZ4Reader reader(range->input);
+        Triple t;
+        while (!reader.isEof()) {
+            t.readFrom(&reader);
+            rangeIns->insert(permutation, t.s, t.p, t.o, t.count, NULL,
+                    &treeWriter, false, canSkipTables);
+        }
+    }
+    rangeIns->flush(permutation, NULL, &treeWriter, false, canSkipTables);
+    rangeIns->stopInserts(permutation);
+    delete range->files[permutation];
+    range->files[permutation] = NULL;
+    treeWriter.finish();
+    Utils::remove(range->input);
+
+    //The inserter keeps large buffers for every permutation, so it is
+    //released now rather than when all the ranges are done
+    {
+        std::lock_guard<std::mutex> lock(insMutex);
+        ins->mergePartition(permutation, rangeIns);
+    }
+    delete rangeIns;
+
+    //A range that has only skipped tables creates no file, and the last
+    //file is removed if it is empty. The files that are left are
+    //numbered from 0 without holes
+    range->nfiles = 0;
+    while (Utils::exists(range->storageDir + DIR_SEP +
+                to_string(range->nfiles))) {
+        range->nfiles++;
+    }
+}
+
+void Loader::stitchRanges(std::vector<InsertRange*> &ranges,
+        const int permutation, Inserter *ins, TreeWriter *treeWriter) {
+    const std::string storageDir = ins->getPathPermutationStorage(permutation);
+    //If the storage of the permutation has already opened its first file,
+    //then I leave it alone
+    int offset = Utils::exists(storageDir + "0") ? 1 : 0;
+    for (auto range : ranges) {
+        if (offset + range->nfiles > MAX_N_FILES) {
+            LOG(ERRORL) << "Max number of files is reached";
+            throw 10;
+        }
+        //Move the tables after the ones of the previous ranges
+        for (int i = 0; i < range->nfiles; ++i) {
+            const std::string src = range->storageDir + DIR_SEP + to_string(i);
+            const std::string dst = storageDir + to_string(offset + i);
+            if (Utils::exists(src)) {
+                Utils::rename(src, dst);
+            }
+            if (Utils::exists(src + ".idx")) {
+                Utils::rename(src + ".idx", dst + ".idx");
+            }
+        }
+        Utils::remove_all(range->storageDir);
+
+        treeWriter->addEntries(range->treeFile, (short) offset);
+        Utils::remove(range->treeFile);
+        offset += range->nfiles;
+        delete range;
+    }
+    ranges.clear();
+}
+
 void Loader::insertDictionary(const int part, DictMgmt *dict, string
         dictFileInput, bool insertDictionary, bool insertInverseDictionary,
         bool storeNumbersCoordinates, nTerm *maxValueCounter) {
@@ -1247,6 +1583,37 @@ void Loader::insertDictionary(const int part, DictMgmt *dict, string
         }
     }
 
+    //The terms in the files are sorted and get increasing IDs, so they are
+    //appended to the dictionary. The inverse dictionary is filled in
+    //parallel by another thread, which receives batches of <ID,coordinates>
+    typedef std::vector<std::pair<nTerm, int64_t>> InvDictBatch;
+    const bool pipelineInvDict = insertDictionary && insertInverseDictionary
+        && !storeNumbersCoordinates;
+    InvDictBatch invDictBatches[4];
+    ConcurrentQueue<InvDictBatch*> freeBatches;
+    ConcurrentQueue<InvDictBatch*> fullBatches;
+    InvDictBatch *invDictBatch = NULL;
+    std::thread invDictThread;
+    if (pipelineInvDict) {
+        for (int i = 0; i < 4; ++i) {
+            invDictBatches[i].reserve(INVDICT_BATCH_SIZE);
+            freeBatches.push(invDictBatches + i);
+        }
+        invDictThread = std::thread([dict, &freeBatches, &fullBatches]() {
+            InvDictBatch *batch;
+            fullBatches.pop_wait(batch);
+            while (batch != NULL) {
+                for (auto &p : *batch) {
+                    dict->putInvDict(p.first, p.second);
+                }
+                batch->clear();
+                freeBatches.push(batch);
+                fullBatches.pop_wait(batch);
+            }
+        });
+        freeBatches.pop_wait(invDictBatch);
+    }
+
     for (auto dictfile = alldictfiles.begin(); dictfile != alldictfiles.end(); ++dictfile) {
         LZ4Reader in(*dictfile);
         LOG(DEBUGL) << "Parsing " << *dictfile;
@@ -1260,7 +1627,13 @@ void Loader::insertDictionary(const int part, DictMgmt *dict, string
             bool resp = true;
             if (insertDictionary && insertInverseDictionary) {
                 if (!storeNumbersCoordinates) {
-                    dict->appendPair(value, size, key);
+                    int64_t coordinates;
+                    dict->appendDict(value, size, key, coordinates);
+                    invDictBatch->push_back(std::make_pair(key, coordinates));
+                    if (invDictBatch->size() == INVDICT_BATCH_SIZE) {
+                        fullBatches.push(invDictBatch);
+                        freeBatches.pop_wait(invDictBatch);
+                    }
                 } else {
                     //In this case I only insert the "dict" entries
                     int64_t coordinates;
@@ -1282,6 +1655,14 @@ void Loader::insertDictionary(const int part, DictMgmt *dict, string
         }
     }
 
+    if (pipelineInvDict) {
+        if (!invDictBatch->empty()) {
+            fullBatches.push(invDictBatch);
+        }
+        fullBatches.push(NULL);
+        invDictThread.join();
+    }
+
     *maxValueCounter = key - 1;
     /*** I can now add the common terms. They are not in lex. ordering so I cannot append ***/
     if (Utils::exists(dictFileInput)) {
@@ -1428,6 +1809,15 @@ void Loader::addSchemaTerms(const int dictPartitions, nTerm highestNumber, DictM
     }
 }
 
+void Loader::writeLoadProfile(ParamsLoad &p) {
+    if (p.profile != "") {
+        LoadProfiler::writeReport(p.profile + ".json", p.tostring());
+        LoadProfiler::writeTrace(p.profile + ".trace.json");
+        LOG(INFOL) << "The profile of the loading is in " << p.profile <<
+            ".json and " << p.profile << ".trace.json";
+    }
+}
+
 void Loader::load(ParamsLoad p) {
     LOG(DEBUGL) << "Params: " << p.tostring();
     std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
@@ -1445,6 +1835,31 @@ void Loader::load(ParamsLoad p) {
         throw 10;
     }
     Utils::create_directories(p.kbDir);
+    if (p.profile != "") {
+        LoadProfiler::enable();
+    }
+    const int64_t loadPhase = LoadProfiler::begin("load", "load");
+    PermSorter::setRadixSort(p.radixSort);
+    PermSorter::setMaxTermID(-1);
+
+    //Memory budget of the loader (in MB). The chunks are sorted in rounds
+    //that fit in it, the merge fan-in is reduced so that all the opened
+    //files fit as well and the merges that run in parallel share it.
+    const int64_t maxMemory = p.maxMemory * 1024 * 1024;
+    PermSorter::setMaxMemory(maxMemory);
+    setMemoryBudget(p.maxMemory);
+    int fanIn = max(2, p.mergeFanIn);
+    if (maxMemory > 0) {
+        const int64_t maxFanIn = max((int64_t) 2,
+                maxMemory / MERGE_BYTES_PER_FILE);
+        if (fanIn > maxFanIn) {
+            LOG(WARNL) << "The merge fan-in is reduced to " << maxFanIn <<
+                " to stay within " << p.maxMemory << " MB";
+            fanIn = maxFanIn;
+        }
+    }
+    setMergeFanIn(fanIn);
+    setPipelineIndices(p.pipelineIndices);
 
     if (p.timeoutStats != -1) {
         //Activate it only for Linux systems
@@ -1478,8 +1893,37 @@ void Loader::load(ParamsLoad p) {
         p.dictionaries = p.parallelThreads;
     }
 
+    //The buffers of the dictionary encoding are sized by kognac for every
+    //thread, so the encoding runs with fewer threads if they would not fit
+    //in the budget
+    int parseThreads = p.parallelThreads;
+    if (maxMemory > 0 && parseThreads * (int64_t) DICT_BYTES_PER_THREAD > maxMemory) {
+        parseThreads = (int) max((int64_t) 1, maxMemory / DICT_BYTES_PER_THREAD);
+        LOG(WARNL) << "The dictionary encoding uses " << parseThreads <<
+            " threads to stay within " << p.maxMemory << " MB";
+        if (p.dictionaries > parseThreads) {
+            p.dictionaries = parseThreads;
+        }
+    }
+
     LOG(DEBUGL) << "Set number of dictionaries to " << p.dictionaries << " parallel threads=" << p.parallelThreads << " readingThreads=" << p.maxReadingThreads;
 
+    //Every thread that inserts a key range has its own inserter, and the
+    //buffers of the inserters come on top of the caches. At least as much
+    //memory must be left for the caches. When the permutations are
+    //pipelined, the insertion has only its share of the budget.
+    const int64_t insertMemory = getInsertMemory(maxMemory,
+            p.pipelineIndices && p.nindices > 1);
+    const int64_t insertBuffers = (int64_t) (p.parallelThreads + 1) *
+        Inserter::BUFFER_BYTES;
+    if (maxMemory > 0 && insertMemory < 2 * insertBuffers) {
+        LOG(ERRORL) << "The memory budget of " << p.maxMemory << " MB is too "
+            "small to insert with " << p.parallelThreads << " threads. The "
+            "insertion needs at least " << 2 * insertBuffers / (1024 * 1024) <<
+            " MB and it gets " << insertMemory / (1024 * 1024) << " MB";
+        throw 10;
+    }
+
     //Create data structures to compress the input
     int nperms = 1;
     int signaturePerm = 0;
@@ -1554,6 +1998,7 @@ void Loader::load(ParamsLoad p) {
         if (p.graphTransformation == "") {
             p.graphTransformation = "undirected";
         }
+        LoadPhase phase("parse snap", "compression");
         totalCount = parseSnapFile(p.triplesInputDir,
                 p.dictDir,
                 &permDirs[IDX_SOP], //Store the output in the SOP directory
@@ -1567,20 +2012,36 @@ void Loader::load(ParamsLoad p) {
             if (p.dictMethod != DICT_HEURISTICS) {
                 throw 10;
             }
-            Compressor comp(p.triplesInputDir, p.tmpDir);
+            const string rdfInput = splitCompressedInput(p.triplesInputDir,
+                    p.tmpDir, p.parallelThreads);
+            Compressor comp(rdfInput, p.tmpDir);
             //Parse the input
+            int64_t phase = LoadProfiler::begin("parse", "compression");
             comp.parse(p.dictionaries, p.sampleMethod, p.sampleArg, (int)(p.sampleRate * 100),
-                    p.parallelThreads, p.maxReadingThreads, false, NULL, false,
-                    p.graphTransformation != "");
+                    parseThreads, min(p.maxReadingThreads, parseThreads),
+                    false, NULL, false, p.graphTransformation != "");
+            if (p.maxMemory > 0 && Utils::get_max_mem() > p.maxMemory) {
+                //The estimate per thread was too low. The rest of the load
+                //is bounded, so it goes on
+                LOG(WARNL) << "The dictionary encoding used " <<
+                    Utils::get_max_mem() << " MB, more than the budget of " <<
+                    p.maxMemory << " MB";
+            }
+            LoadProfiler::end(phase);
             //Compress it
             LOG(DEBUGL) << "For now I create only one permutation";
             int tmpsig = 0;
             Compressor::addPermutation(IDX_SPO, tmpsig);
+            phase = LoadProfiler::begin("compress", "compression");
             comp.compress(p.graphTransformation != "" ? &permDirs[IDX_SOP] : &permDirs[IDX_SPO],
                     1, tmpsig, fileNameDictionaries,
                     p.dictionaries, p.parallelThreads, p.maxReadingThreads,
                     p.graphTransformation != "");
             totalCount = comp.getTotalCount();
+            LoadProfiler::end(phase);
+            if (rdfInput != p.triplesInputDir) {
+                Utils::remove_all(rdfInput);
+            }
             LOG(INFOL) << "Compression is finished. Starting the loading ...";
             if (p.onlyCompress) {
                 //Convert the triple files and the dictionary files in gzipped files
@@ -1600,6 +2061,8 @@ void Loader::load(ParamsLoad p) {
                 if (p.tmpDir != p.kbDir) {
                     Utils::remove_all(p.tmpDir);
                 }
+                LoadProfiler::end(loadPhase);
+                writeLoadProfile(p);
                 return;
             }
         } else {
@@ -1607,6 +2070,7 @@ void Loader::load(ParamsLoad p) {
                 LOG(INFOL) << "I force the parameter relsOwnIDs to true since the path to a dictionary for the relations is not null";
                 p.relsOwnIDs = true;
             }
+            LoadPhase phase("convert", "compression");
             totalCount = createPermsAndDictsFromFiles(p.triplesInputDir,
                     p.relsOwnIDs,
                     p.dictDir,
@@ -1617,6 +2081,10 @@ void Loader::load(ParamsLoad p) {
                     fileNameDictionaries[0],
                     p.maxReadingThreads,
                     p.parallelThreads);
+            if (PermSorter::hasBinaryInput() && p.graphTransformation != "") {
+                LOG(ERRORL) << "Graph transformations are not supported with binary input triples";
+                throw 10;
+            }
             if (p.dictDir == "" && p.dictDir_rel == "" && p.storeDicts) {
                 LOG(INFOL) << "I force storeDicts to false since no directory for the dictionary was given";
                 p.storeDicts = false;
@@ -1632,8 +2100,22 @@ void Loader::load(ParamsLoad p) {
     config.setParamInt(FIXEDSTRAT, p.fixedStrat);
     config.setParamInt(THRESHOLD_SKIP_TABLE, p.thresholdSkipTable);
     config.setParamBool(RELSOWNIDS, p.relsOwnIDs);
+    if (p.blockCompression == "pfor") {
+        config.setParamInt(BLOCKCOMPRESSION, BLOCKCODEC_PFOR);
+    } else if (p.blockCompression == "lz4") {
+        config.setParamInt(BLOCKCOMPRESSION, BLOCKCODEC_LZ4);
+    } else if (p.blockCompression != "none") {
+        LOG(ERRORL) << "Block compression '" << p.blockCompression << "' is not supported";
+        throw 10;
+    }
+    config.setParamLong(THRESHOLD_BLOCKCOMPRESSION, p.thresholdBlockCompression);
+    config.setParamLong(THRESHOLD_EFDIRECTORY, p.thresholdEFDirectory);
     LOG(DEBUGL) << "Optimizing memory management for " << totalCount << " triples";
     MemoryOptimizer::optimizeForWriting(totalCount, config);
+    if (maxMemory > 0) {
+        MemoryOptimizer::limitForWriting(insertMemory - insertBuffers, config);
+    }
+    config.setParamInt(SB_COMPRESSTHREADS, p.parallelThreads);
     if (p.dictMethod == DICT_HASH) {
         config.setParamBool(DICTHASH, true);
     }
@@ -1647,6 +2129,10 @@ void Loader::load(ParamsLoad p) {
             fileNameDictionaries,
             p.storeDicts,
             p.relsOwnIDs);
+    {
+        LoadPhase phase("close", "kb");
+        kb.reset();
+    }
 
     /*** CLEANUP ***/
     delete[] permDirs;
@@ -1661,6 +2147,8 @@ void Loader::load(ParamsLoad p) {
     if (monitor.joinable()) {
         monitor.join();
     }
+    LoadProfiler::end(loadPhase);
+    writeLoadProfile(p);
     std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
     LOG(INFOL) << "Loading is finished: Time (sec) " << sec.count();
 }
@@ -1699,6 +2187,7 @@ void Loader::loadKB_storeDicts(KB &kb,
         int dictionaries,
         string dictMethod,
         string *fileNameDictionaries) {
+    LoadPhase phase("dictionary", "dictionary");
     std::thread *threads;
     LOG(DEBUGL) << "Insert the dictionary in the trees";
     threads = new std::thread[dictionaries - 1];
@@ -1717,6 +2206,8 @@ void Loader::loadKB_storeDicts(KB &kb,
 #ifdef REASONING
     addSchemaTerms(dictionaries, maxValues[0], kb.getDictMgmt());
 #endif
+    PermSorter::setMaxTermID(max(PermSorter::getMaxTermID(),
+                (int64_t) maxValues[0]));
     delete[] maxValues;
     delete[] threads;
     /*** Close the dictionaries ***/
@@ -1774,6 +2265,9 @@ void Loader::loadKB_handleGraphTransformations(KB &kb,
         }
         ins->disableColumnStorage();
         ins->setUsageRowForLargeTables();
+        //The analytics read the tables directly
+        ins->disableBlockCompression();
+        ins->disableEFDirectory();
     } else {
         //If the relations should have their own IDs, I rewrite the compressed
         //graph storing an additional map with the IDs of the relations
@@ -1879,6 +2373,7 @@ void Loader::loadKB_createTree(KB &kb,
         Inserter *ins,
         int nindices) {
 
+    LoadPhase phase("tree", "tree");
     std::thread *threads;
     threads = new std::thread[2];
     LOG(DEBUGL) << "Compress the dictionary nodes...";
@@ -1952,6 +2447,7 @@ void Loader::loadKB(KB &kb,
     int maxReadingThreads = p.maxReadingThreads;
     string graphTransformation = p.graphTransformation;
     bool flatTree = p.flatTree;
+    bool staticTree = p.staticTree;
     //End init params
 
     if (storeDicts) {
@@ -2011,6 +2507,14 @@ void Loader::loadKB(KB &kb,
         }
     }
 
+    //The flat tree stores the IDs in 5 bytes
+    if ((flatTree || graphTransformation != "") &&
+            PermSorter::getMaxTermID() >= (INT64_C(1) << 40)) {
+        LOG(ERRORL) << "The flat tree does not support IDs larger than 2^40."
+            " The largest ID is " << PermSorter::getMaxTermID();
+        throw 10;
+    }
+
     int nidx = nindices;
     loadKB_handleGraphTransformations(kb, graphTransformation, permDirs,
             nidx, ins, relsOwnIDs, kbDir, storeDicts);
@@ -2037,6 +2541,7 @@ void Loader::loadKB(KB &kb,
 
     if (flatTree || graphTransformation != "") {
         LOG(DEBUGL) << "Load flat representation ...";
+        LoadPhase phase("flat tree", "tree");
         kb.close();
         string flatfile = kbDir + DIR_SEP + "tree" + DIR_SEP + "flat";
         //Create a tree itr to go through the tree
@@ -2052,7 +2557,16 @@ void Loader::loadKB(KB &kb,
                 graphTransformation == "undirected");
     }
 
+    if (staticTree) {
+        LOG(DEBUGL) << "Create the static tree ...";
+        LoadPhase phase("static tree", "tree");
+        kb.close();
+        std::unique_ptr<Root> root(kb.getRootTree());
+        StaticRoot::build(root.get(), kbDir + DIR_SEP + "tree" + DIR_SEP + "static");
+    }
+
     if (sample) {
+        LoadPhase phase("samples", "samples");
         delete sampleWriter;
         loadKB_createSamples(kbDir, sampleDir, parallelProcesses,
                 maxReadingThreads, nperms, sampleRate,
@@ -2483,10 +2997,7 @@ void Loader::createIndices(
         int64_t estimatedSize,
         int nindices) {
 
-    int posS = 0;
-    int posP = 1;
-    int posO = 2;
-    int lastIdx = IDX_SPO;
+    LoadPhase phase("indices", "indices");
     LOG(DEBUGL) << "start createIndices";
     std::vector<std::pair<string, char>> permutations;
     permutations.push_back(std::make_pair(permDirs[0], IDX_SPO));
@@ -2510,278 +3021,207 @@ void Loader::createIndices(
             estimatedSize,
             false);
 
-    for(auto &p : permutations) {
-        mergeDiskFragments(ParamsMergeDiskFragments(p.first));
-    }
-
-    ParamInsert params;
-    params.parallelProcesses = parallelProcesses;
-    params.permutation = IDX_SPO;
-    params.inputDir = permDirs[IDX_SPO];
-    params.POSoutputDir = (aggrIndices && nindices == 6) ? &aggr2Dir : NULL;
-    params.treeWriter = treeWriters[IDX_SPO];
-    params.ins = ins;
-    params.aggregated = false;
-    params.canSkipTables = false;
-    params.storeRaw = storePlainList;
-    params.sampleWriter = sampleWriter;
-    params.sampleRate = sampleRate;
-    params.printstats = printStats;
-    params.removeInput = false;
-    params.deletePreviousExt = false;
-
-    insert(params);
-
-    string lastInput = params.inputDir;
-
-    if (permDirs[IDX_OPS] != "") {
-        if (createIndicesInBlocks) {
-            generateNewPermutation(permDirs[IDX_OPS], lastInput, posO, posP, posS, parallelProcesses,
-                    maxReadingThreads);
-            PermSorter::sortChunks2(permDirs[IDX_OPS], IDX_OPS, maxReadingThreads,
+    //Permutations in the order they are inserted. With
+    //createIndicesInBlocks, each of them is generated from the previous one
+    //by moving the fields at positions pos1, pos2 and pos3 (s=0, p=1, o=2)
+    struct PermToCreate {
+        int idx;
+        int pos1, pos2, pos3;
+    };
+    std::vector<PermToCreate> perms;
+    int pos[3] = {0, 1, 2};
+    auto addPerm = [&](int idx, int f1, int f2, int f3) {
+        PermToCreate perm;
+        perm.idx = idx;
+        perm.pos1 = pos[f1];
+        perm.pos2 = pos[f2];
+        perm.pos3 = pos[f3];
+        perms.push_back(perm);
+        pos[f1] = 0;
+        pos[f2] = 1;
+        pos[f3] = 2;
+    };
+    addPerm(IDX_SPO, 0, 1, 2);
+    if (permDirs[IDX_OPS] != "")
+        addPerm(IDX_OPS, 2, 1, 0);
+    if (permDirs[IDX_SOP] != "")
+        addPerm(IDX_SOP, 0, 2, 1);
+    if (permDirs[IDX_OSP] != "")
+        addPerm(IDX_OSP, 2, 0, 1);
+    if (!aggrIndices) {
+        if (permDirs[IDX_POS] != "")
+            addPerm(IDX_POS, 1, 2, 0);
+        if (permDirs[IDX_PSO] != "")
+            addPerm(IDX_PSO, 1, 0, 2);
+    }
+
+    //The next permutation is produced (generated, sorted and merged) by
+    //another thread while the current one is inserted. The memory budget
+    //of the load (in MB) is split in tokens: the insertion takes a third
+    //of them, the sorting the rest and every merge the buffers of its
+    //files (see mergeDiskFragments). If the budget is too small to sort in
+    //parallel with the insertion, then the permutations are processed one
+    //after the other as before. Without --maxMemory the caches of the
+    //insertion are not limited, so the tokens only bound the sorting and
+    //the merging.
+    const int64_t prevMaxMemory = PermSorter::getMaxMemory();
+    const bool ownBudget = !memoryBudget;
+    if (ownBudget) {
+        setMemoryBudget(max((int64_t) 1, (int64_t) (Utils::getSystemMemory()
+                        * 0.6) / (1024 * 1024)));
+    }
+    TokenBudget &tokens = *memoryBudget;
+    const int64_t budget = tokens.getTotal();
+    //The caches used by the insertion were sized with the same share
+    const int64_t insertTokens = max((int64_t) 1, getInsertMemory(budget, true));
+    const int64_t sortTokens = budget - insertTokens;
+    const bool pipeline = pipelineIndices && perms.size() > 1 &&
+        (!createIndicesInBlocks || sortTokens >= 64);
+
+    std::mutex pipelineMutex;
+    std::condition_variable pipelineCV;
+    size_t nReady = 0; //Permutations that can be inserted
+    size_t nStarted = 0; //Permutations whose insertion has started
+
+    auto producePerm = [&](size_t i) {
+        const int idx = perms[i].idx;
+        if (createIndicesInBlocks && i > 0) {
+            const int64_t t = pipeline ? tokens.acquire(sortTokens) : 0;
+            generateNewPermutation(permDirs[idx], permDirs[perms[i - 1].idx],
+                    perms[i].pos1, perms[i].pos2, perms[i].pos3,
+                    parallelProcesses, maxReadingThreads);
+            PermSorter::sortChunks2(permDirs[idx], idx, maxReadingThreads,
                     parallelProcesses,
                     estimatedSize,
                     false);
-            mergeDiskFragments(ParamsMergeDiskFragments(permDirs[IDX_OPS]));
+            tokens.release(t);
         }
-        ins->stopInserts(lastIdx);
-        moveData(remotePath, outputDirs[lastIdx], limitSpace);
-        LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
+        mergeDiskFragments(ParamsMergeDiskFragments(permDirs[idx]));
+    };
 
-        params.permutation = IDX_OPS;
-        params.inputDir = permDirs[IDX_OPS];
-        params.POSoutputDir = aggrIndices ? &aggr1Dir : NULL;
-        params.treeWriter = treeWriters[IDX_OPS];
-        params.ins = ins;
-        params.aggregated = false;
-        params.canSkipTables = false;
-        params.storeRaw = false;
-        params.sampleWriter = NULL;
-        params.sampleRate = 0.0;
-        params.printstats = printStats;
-        params.removeInput = false;
-
-        insert(params);
-
-        Utils::remove_all(lastInput);
-        lastInput = permDirs[IDX_OPS];
-        posS = 2;
-        posP = 1;
-        posO = 0;
-        lastIdx = IDX_OPS;
-    }
-    if (permDirs[IDX_SOP] != "") {
+    std::thread producer;
+    if (pipeline) {
+        LOG(DEBUGL) << "Pipeline the permutations with a budget of " <<
+            budget << " MB";
         if (createIndicesInBlocks) {
-            generateNewPermutation(permDirs[IDX_SOP],
-                    lastInput, posS, posO, posP, parallelProcesses,
-                    maxReadingThreads);
-            PermSorter::sortChunks2(permDirs[IDX_SOP],
-                    IDX_SOP, maxReadingThreads,
-                    parallelProcesses,
-                    estimatedSize,
-                    false);
-            mergeDiskFragments(
-                    ParamsMergeDiskFragments(permDirs[IDX_SOP]));
+            PermSorter::setMaxMemory(sortTokens * 1024 * 1024);
         }
-        ins->stopInserts(lastIdx);
-        moveData(remotePath, outputDirs[lastIdx], limitSpace);
-        LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
-
-        params.permutation = IDX_SOP;
-        params.inputDir = permDirs[IDX_SOP];
-        params.POSoutputDir = (string*) NULL;
-        params.treeWriter = treeWriters[IDX_SOP];
-        params.ins = ins;
-        params.aggregated = false;
-        params.canSkipTables = canSkipTables;
-        params.storeRaw = false;
-        params.sampleWriter = NULL;
-        params.sampleRate = 0.0;
-        params.printstats = printStats;
-        params.removeInput = false;
-
-        insert(params);
-        Utils::remove_all(lastInput);
-        lastInput = permDirs[IDX_SOP];
-        posS = 0;
-        posO = 1;
-        posP = 2;
-        lastIdx = IDX_SOP;
+        producer = std::thread([&]() {
+            for (size_t i = 0; i < perms.size(); ++i) {
+                //Stay at most one permutation ahead of the insertions, so
+                //that at most three of them are on disk at the same time
+                {
+                    std::unique_lock<std::mutex> lock(pipelineMutex);
+                    while (nStarted < i) {
+                        pipelineCV.wait(lock);
+                    }
+                }
+                producePerm(i);
+                std::unique_lock<std::mutex> lock(pipelineMutex);
+                nReady = i + 1;
+                pipelineCV.notify_all();
+            }
+        });
     }
-    if (permDirs[IDX_OSP] != "") {
-        if (createIndicesInBlocks) {
-            generateNewPermutation(permDirs[IDX_OSP],
-                    lastInput, posO, posS, posP, parallelProcesses,
-                    maxReadingThreads);
-            PermSorter::sortChunks2(permDirs[IDX_OSP],
-                    IDX_OSP, maxReadingThreads,
-                    parallelProcesses,
-                    estimatedSize,
-                    false);
-            mergeDiskFragments(
-                    ParamsMergeDiskFragments(permDirs[IDX_OSP]));
-        }
-        ins->stopInserts(lastIdx);
-        moveData(remotePath, outputDirs[lastIdx], limitSpace);
-        LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
 
-        params.permutation = IDX_OSP;
-        params.inputDir = permDirs[IDX_OSP];
-        params.POSoutputDir = (string*) NULL;
-        params.treeWriter = treeWriters[IDX_OSP];
+    auto getInsertParams = [&](int idx) {
+        ParamInsert params;
+        params.parallelProcesses = parallelProcesses;
+        params.permutation = idx;
+        params.inputDir = permDirs[idx];
+        params.POSoutputDir = NULL;
+        if (idx == IDX_SPO && aggrIndices && nindices == 6) {
+            params.POSoutputDir = &aggr2Dir;
+        } else if (idx == IDX_OPS && aggrIndices) {
+            params.POSoutputDir = &aggr1Dir;
+        }
+        params.treeWriter = treeWriters[idx];
         params.ins = ins;
         params.aggregated = false;
-        params.canSkipTables = canSkipTables;
-        params.storeRaw = false;
-        params.sampleWriter = NULL;
-        params.sampleRate = 0.0;
+        params.canSkipTables = (idx == IDX_SOP || idx == IDX_OSP ||
+                idx == IDX_PSO) ? canSkipTables : false;
+        params.storeRaw = idx == IDX_SPO ? storePlainList : false;
+        params.sampleWriter = idx == IDX_SPO ? sampleWriter : NULL;
+        params.sampleRate = idx == IDX_SPO ? sampleRate : 0.0;
         params.printstats = printStats;
         params.removeInput = false;
+        params.deletePreviousExt = false;
+        return params;
+    };
 
-        insert(params);
-        Utils::remove_all(lastInput);
-        lastInput = permDirs[IDX_OSP];
-        posS = 1;
-        posO = 0;
-        posP = 2;
-        lastIdx = IDX_OSP;
-    }
-
-    if (permDirs[IDX_POS] != "" || aggrIndices) {
-        if (!aggrIndices) {
-            if (createIndicesInBlocks) {
-                generateNewPermutation(permDirs[IDX_POS],
-                        lastInput, posP, posO, posS, parallelProcesses,
-                        maxReadingThreads);
-                PermSorter::sortChunks2(permDirs[IDX_POS],
-                        IDX_POS, maxReadingThreads,
-                        parallelProcesses,
-                        estimatedSize,
-                        false);
-                mergeDiskFragments(
-                        ParamsMergeDiskFragments(permDirs[IDX_POS]));
+    string lastInput = "";
+    int lastIdx = IDX_SPO;
+    for (size_t i = 0; i < perms.size(); ++i) {
+        const int idx = perms[i].idx;
+        if (pipeline) {
+            std::unique_lock<std::mutex> lock(pipelineMutex);
+            while (nReady <= i) {
+                pipelineCV.wait(lock);
             }
-            ins->stopInserts(lastIdx);
-            moveData(remotePath, outputDirs[lastIdx], limitSpace);
-            LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
-
-            ParamInsert params;
-            params.parallelProcesses = parallelProcesses;
-            params.permutation = IDX_POS;
-            params.inputDir = permDirs[IDX_POS];
-            params.POSoutputDir = (string*) NULL;
-            params.treeWriter = treeWriters[IDX_POS];
-            params.ins = ins;
-            params.aggregated = aggrIndices;
-            params.canSkipTables = false;
-            params.storeRaw = false;
-            params.sampleWriter = NULL;
-            params.sampleRate = 0.0;
-            params.printstats = printStats;
-            params.removeInput = false;
-            params.deletePreviousExt = false;
-
-            insert(params);
-            LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
-            Utils::remove_all(lastInput);
-            lastInput = permDirs[IDX_POS];
         } else {
+            producePerm(i);
+        }
+        if (i > 0) {
             ins->stopInserts(lastIdx);
-            moveData(remotePath, outputDirs[lastIdx], limitSpace);
+            if (idx != IDX_PSO) {
+                moveData(remotePath, outputDirs[lastIdx], limitSpace);
+            }
             LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
-            ParamInsert params;
-            params.parallelProcesses = parallelProcesses;
-            params.permutation = IDX_POS;
-            params.inputDir = aggr1Dir;
-            params.POSoutputDir = (string*) NULL;
-            params.treeWriter = treeWriters[IDX_POS];
-            params.ins = ins;
-            params.aggregated = true;
-            params.canSkipTables = false;
-            params.storeRaw = false;
-            params.sampleWriter = NULL;
-            params.sampleRate = 0.0;
-            params.printstats = printStats;
-            params.removeInput = false;
-            params.deletePreviousExt = false;
-
-            PermSorter::sortChunks2(aggr1Dir,
-                    IDX_POS, maxReadingThreads,
-                    parallelProcesses,
-                    estimatedSize,
-                    true);
-            mergeDiskFragments(
-                    ParamsMergeDiskFragments(aggr1Dir));
+        }
+        {
+            std::unique_lock<std::mutex> lock(pipelineMutex);
+            nStarted = i + 1;
+            pipelineCV.notify_all();
+        }
 
-            insert(params);
-            LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
+        const int64_t t = pipeline ? tokens.acquire(insertTokens) : 0;
+        insert(getInsertParams(idx));
+        tokens.release(t);
+
+        //The producer has already read the previous permutation
+        if (i > 0) {
             Utils::remove_all(lastInput);
-            lastInput = aggr1Dir;
         }
-        posS = 2;
-        posO = 1;
-        posP = 0;
-        lastIdx = IDX_POS;
+        lastInput = permDirs[idx];
+        lastIdx = idx;
+    }
+    if (pipeline) {
+        producer.join();
+        PermSorter::setMaxMemory(prevMaxMemory);
+    }
+    if (ownBudget) {
+        setMemoryBudget(0);
     }
 
-    if (permDirs[IDX_PSO] != "" || (aggrIndices && nindices == 6)) {
-        if (!aggrIndices) {
-            if (createIndicesInBlocks) {
-                generateNewPermutation(permDirs[IDX_PSO],
-                        lastInput, posP, posS, posO, parallelProcesses,
-                        maxReadingThreads);
-                PermSorter::sortChunks2(permDirs[IDX_PSO],
-                        IDX_PSO, maxReadingThreads,
-                        parallelProcesses,
-                        estimatedSize,
-                        false);
-                mergeDiskFragments(
-                        ParamsMergeDiskFragments(permDirs[IDX_PSO]));
-            }
-
-            ins->stopInserts(lastIdx);
-
-            ParamInsert params;
-            params.parallelProcesses = parallelProcesses;
-            params.permutation = IDX_PSO;
-            params.inputDir = permDirs[IDX_PSO];
-            params.POSoutputDir = (string*) NULL;
-            params.treeWriter = treeWriters[IDX_PSO];
-            params.ins = ins;
-            params.aggregated = false;
-            params.canSkipTables = canSkipTables;
-            params.storeRaw = false;
-            params.sampleWriter = NULL;
-            params.sampleRate = 0.0;
-            params.printstats = printStats;
-            params.removeInput = false;
-            params.deletePreviousExt = false;
-
-            insert(params);
-            LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
+    //The aggregated indices are sorted from the triples that were written
+    //during the insertion of SPO and OPS
+    if (aggrIndices) {
+        ins->stopInserts(lastIdx);
+        moveData(remotePath, outputDirs[lastIdx], limitSpace);
+        LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
+        ParamInsert params = getInsertParams(IDX_POS);
+        params.inputDir = aggr1Dir;
+        params.aggregated = true;
 
-            Utils::remove_all(lastInput);
-            lastInput = permDirs[IDX_PSO];
+        PermSorter::sortChunks2(aggr1Dir,
+                IDX_POS, maxReadingThreads,
+                parallelProcesses,
+                estimatedSize,
+                true);
+        mergeDiskFragments(
+                ParamsMergeDiskFragments(aggr1Dir));
 
-        } else {
-            ParamInsert params;
+        insert(params);
+        LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
+        Utils::remove_all(lastInput);
+        lastInput = aggr1Dir;
+        lastIdx = IDX_POS;
 
+        if (permDirs[IDX_PSO] != "" || nindices == 6) {
             ins->stopInserts(lastIdx);
-
-            params.parallelProcesses = parallelProcesses;
-            params.permutation = IDX_PSO;
+            ParamInsert params = getInsertParams(IDX_PSO);
             params.inputDir = aggr2Dir;
-            params.POSoutputDir = (string*) NULL;
-            params.treeWriter = treeWriters[IDX_PSO];
-            params.ins = ins;
             params.aggregated = true;
-            params.canSkipTables = canSkipTables;
-            params.storeRaw = false;
-            params.sampleWriter = NULL;
-            params.sampleRate = 0.0;
-            params.printstats = printStats;
-            params.removeInput = false;
-            params.deletePreviousExt = false;
 
             PermSorter::sortChunks2(aggr2Dir,
                     IDX_PSO, maxReadingThreads,
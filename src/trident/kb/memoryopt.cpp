@@ -115,6 +115,26 @@ void MemoryOptimizer::optimizeForWriting(int64_t inputTriples, KBConfig &config)
     config.setParamLong(STORAGE_MAX_N_FILES, 4);
 }
 
+void MemoryOptimizer::limitForWriting(int64_t maxMemory, KBConfig &config) {
+    //Half of the budget goes to the tree with the coordinates, the rest is
+    //divided among the dictionary, the inverse dictionary and the strings.
+    //The caches are only reduced, never enlarged.
+    const int64_t treeCache = maxMemory / 2;
+    const int64_t dictCache = maxMemory / 6;
+    config.setParamLong(TREE_MAXSIZECACHETREE, std::min(treeCache,
+                config.getParamLong(TREE_MAXSIZECACHETREE)));
+    config.setParamLong(DICT_MAXSIZECACHETREE, std::min(dictCache,
+                config.getParamLong(DICT_MAXSIZECACHETREE)));
+    config.setParamLong(INVDICT_MAXSIZECACHETREE, std::min(dictCache,
+                config.getParamLong(INVDICT_MAXSIZECACHETREE)));
+    const int64_t sbCache = std::max((int64_t) SB_BLOCK_SIZE,
+            std::min(dictCache, config.getParamLong(SB_CACHESIZE)));
+    config.setParamLong(SB_CACHESIZE, sbCache);
+    config.setParamInt(SB_PREALLBUFFERS, std::min(
+                config.getParamInt(SB_PREALLBUFFERS),
+                (int) (sbCache / SB_BLOCK_SIZE)));
+}
+
 void MemoryOptimizer::optimizeForReasoning(int ndicts, KBConfig &config) {
     uint64_t totalMemory = (uint64_t) std::min((double)128000000, (double)(Utils::getSystemMemory() * 0.10));
 
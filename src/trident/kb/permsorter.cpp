@@ -22,6 +22,8 @@
 
 #include <trident/kb/permsorter.h>
 #include <trident/utils/parallel.h>
+#include <trident/utils/radixsort.h>
+#include <trident/utils/loadprofiler.h>
 #include <kognac/utils.h>
 #include <kognac/compressor.h>
 
@@ -29,78 +31,92 @@
 #include <functional>
 #include <array>
 
-typedef std::array<unsigned char, 15> __PermSorter_triple;
-typedef std::array<unsigned char, 23> __PermSorter_tripleCount;
-
-bool __PermSorter_triple_sorter(const __PermSorter_triple &a,
-        const __PermSorter_triple &b) {
+template<size_t SIZE>
+bool __PermSorter_sorter(const std::array<unsigned char, SIZE> &a,
+        const std::array<unsigned char, SIZE> &b) {
     return a < b;
 }
 
-bool __PermSorter_tripleCount_sorter(const __PermSorter_tripleCount &a,
-        const __PermSorter_tripleCount &b) {
-    return a < b;
+bool PermSorter::radixSort = true;
+int64_t PermSorter::maxMemory = 0;
+int64_t PermSorter::maxTermID = -1;
+std::string PermSorter::binaryInputDir = "";
+std::shared_ptr<BinaryTriples> PermSorter::binaryInput;
+
+int PermSorter::getTermBytes() {
+    if (maxTermID < 0) {
+        //Unknown: use the widest records
+        return 8;
+    } else if (maxTermID < (INT64_C(1) << 40)) {
+        return 5;
+    } else if (maxTermID < (INT64_C(1) << 48)) {
+        return 6;
+    } else {
+        return 8;
+    }
 }
 
+template<int W>
 void PermSorter::sortPermutation(char *start, char *end, int nthreads,
         bool includeCount) {
     std::chrono::system_clock::time_point starttime = std::chrono::system_clock::now();
+    if (radixSort) {
+        const size_t sizeTriple = includeCount ? 3 * W + 8 : 3 * W;
+        const size_t n = (end - start) / sizeTriple;
+        try {
+            if (includeCount) {
+                RadixSorter<3 * W + 8>::sort(start, n, nthreads);
+            } else {
+                RadixSorter<3 * W>::sort(start, n, nthreads);
+            }
+            std::chrono::duration<double> duration = std::chrono::system_clock::now() - starttime;
+            LOG(DEBUGL) << "Time sorting (radix): " << duration.count() << "s.";
+            return;
+        } catch (std::bad_alloc &e) {
+            LOG(WARNL) << "Not enough memory for the radix sort. Use the comparison sort";
+        }
+    }
     if (includeCount) {
-        __PermSorter_tripleCount *sstart = (__PermSorter_tripleCount*) start;
-        __PermSorter_tripleCount *send = (__PermSorter_tripleCount*) end;
-        ParallelTasks::sort_int(sstart, send, &__PermSorter_tripleCount_sorter, nthreads);
+        typedef std::array<unsigned char, 3 * W + 8> TripleCount;
+        TripleCount *sstart = (TripleCount*) start;
+        TripleCount *send = (TripleCount*) end;
+        ParallelTasks::sort_int(sstart, send, &__PermSorter_sorter<3 * W + 8>, nthreads);
     } else {
-        __PermSorter_triple *sstart = (__PermSorter_triple*) start;
-        __PermSorter_triple *send = (__PermSorter_triple*) end;
-        ParallelTasks::sort_int(sstart, send, &__PermSorter_triple_sorter, nthreads);
+        typedef std::array<unsigned char, 3 * W> Triple;
+        Triple *sstart = (Triple*) start;
+        Triple *send = (Triple*) end;
+        ParallelTasks::sort_int(sstart, send, &__PermSorter_sorter<3 * W>, nthreads);
     }
     std::chrono::duration<double> duration = std::chrono::system_clock::now() - starttime;
     LOG(DEBUGL) << "Time sorting: " << duration.count() << "s.";
 }
 
-void PermSorter::writeTermInBuffer(char *buffer, const int64_t n) {
-    buffer[0] = (n >> 32) & 0xFF;
-    buffer[1] = (n >> 24) & 0xFF;
-    buffer[2] = (n >> 16) & 0xFF;
-    buffer[3] = (n >> 8) & 0xFF;
-    buffer[4] = n & 0xFF;
-}
-
-void PermSorter::write8TermInBuffer(char *buffer, const int64_t n) {
-    buffer[0] = (n >> 56) & 0xFF;
-    buffer[1] = (n >> 48) & 0xFF;
-    buffer[2] = (n >> 40) & 0xFF;
-    buffer[3] = (n >> 32) & 0xFF;
-    buffer[4] = (n >> 24) & 0xFF;
-    buffer[5] = (n >> 16) & 0xFF;
-    buffer[6] = (n >> 8) & 0xFF;
-    buffer[7] = n & 0xFF;
+template<int W>
+void PermSorter::writeTerm(char *buffer, const int64_t n) {
+    for (int i = 0; i < W; ++i) {
+        buffer[i] = (n >> (8 * (W - 1 - i))) & 0xFF;
+    }
 }
 
-int64_t PermSorter::readTermFromBuffer(char *buffer) {
-    int64_t n = 0;
-    n += (int64_t) (buffer[0] & 0xFF) << 32;
-    n += (int64_t) (buffer[1] & 0xFF) << 24;
-    n += (buffer[2] & 0xFF) << 16;
-    n += (buffer[3] & 0xFF) << 8;
-    n += buffer[4] & 0xFF;
+template<int W>
+int64_t PermSorter::readTerm(const char *buffer) {
+    uint64_t n = 0;
+    for (int i = 0; i < W; ++i) {
+        n = (n << 8) | (buffer[i] & 0xFF);
+    }
     return n;
 }
 
-int64_t PermSorter::read8TermFromBuffer(char *buffer) {
-    int64_t n = 0;
-    n += (int64_t) (buffer[0] & 0xFF) << 56;
-    n += (int64_t) (buffer[1] & 0xFF) << 48;
-    n += (int64_t) (buffer[2] & 0xFF) << 40;
-    n += (int64_t) (buffer[3] & 0xFF) << 32;
-    n += (int64_t) (buffer[4] & 0xFF) << 24;
-    n += (buffer[5] & 0xFF) << 16;
-    n += (buffer[6] & 0xFF) << 8;
-    n += buffer[7] & 0xFF;
-    return n;
+template<int W>
+void PermSorter::checkTerm(const int64_t n) {
+    if (W < 8 && (uint64_t) n >> (W < 8 ? 8 * W : 0)) {
+        LOG(ERRORL) << "The ID " << n << " does not fit in " << W <<
+            " bytes. The largest ID was set to " << maxTermID;
+        throw 10;
+    }
 }
 
-
+template<int W>
 void PermSorter::dumpPermutation_seq(
         char *start,
         char *end,
@@ -111,24 +127,24 @@ void PermSorter::dumpPermutation_seq(
         size_t count = 0;
         while (start < end) {
             Triple t;
-            t.s = PermSorter::readTermFromBuffer(start);
-            t.p = PermSorter::readTermFromBuffer(start + 5);
-            t.o = PermSorter::read8TermFromBuffer(start + 10);
-            t.count = PermSorter::readTermFromBuffer(start + 18);
+            t.s = PermSorter::readTerm<W>(start);
+            t.p = PermSorter::readTerm<W>(start + W);
+            t.o = PermSorter::readTerm<8>(start + 2 * W);
+            t.count = PermSorter::readTerm<W>(start + 2 * W + 8);
 
             count++;
 
             t.writeTo(currentPart, writer);
-            start+= 23;
+            start += 3 * W + 8;
         }
     } else {
         while (start < end) {
             Triple t;
-            t.s = PermSorter::readTermFromBuffer(start);
-            t.p = PermSorter::readTermFromBuffer(start + 5);
-            t.o = PermSorter::readTermFromBuffer(start + 10);
+            t.s = PermSorter::readTerm<W>(start);
+            t.p = PermSorter::readTerm<W>(start + W);
+            t.o = PermSorter::readTerm<W>(start + 2 * W);
             t.writeTo(currentPart, writer);
-            start+=15;
+            start += 3 * W;
         }
     }
     writer->setTerminated(currentPart);
@@ -143,6 +159,7 @@ void PermSorter::dumpPermutation_seq(
   return true;
   }*/
 
+template<int W>
 void PermSorter::dumpPermutation(char *input, int64_t end,
         int parallelProcesses,
         int maxReadingThreads,
@@ -170,7 +187,7 @@ void PermSorter::dumpPermutation(char *input, int64_t end,
       break;
       }
       }*/
-    const size_t sizeTriple = includeCount ? 23 : 15;
+    const size_t sizeTriple = includeCount ? 3 * W + 8 : 3 * W;
 
     std::thread *threads = new std::thread[parallelProcesses];
     int64_t chunkSize = max((int64_t)1, (realSize / parallelProcesses));
@@ -187,7 +204,7 @@ void PermSorter::dumpPermutation(char *input, int64_t end,
         MultiDiskLZ4Writer *currentWriter = writers[i / partsPerWriter];
         int currentPart = i % partsPerWriter;
         if (nextEnd > currentEnd) {
-            threads[i] = std::thread(PermSorter::dumpPermutation_seq,
+            threads[i] = std::thread(PermSorter::dumpPermutation_seq<W>,
                     input + currentEnd * sizeTriple,
                     input + nextEnd * sizeTriple,
                     currentWriter,
@@ -227,9 +244,9 @@ void PermSorter::sortChunks_seq(const int idReader,
             int64_t first = reader->readLong(idReader);
             int64_t second = reader->readLong(idReader);
             int64_t third = reader->readLong(idReader);
-            PermSorter::writeTermInBuffer(current, first);
-            PermSorter::writeTermInBuffer(current + 5, second);
-            PermSorter::writeTermInBuffer(current + 10, third);
+            PermSorter::writeTerm<5>(current, first);
+            PermSorter::writeTerm<5>(current + 5, second);
+            PermSorter::writeTerm<5>(current + 10, third);
             current += 15;
             i++;
             if (i % 1000000000 == 0) {
@@ -241,9 +258,9 @@ void PermSorter::sortChunks_seq(const int idReader,
             int64_t first = reader->readLong(idReader);
             int64_t second = reader->readLong(idReader);
             int64_t third = reader->readLong(idReader);
-            PermSorter::writeTermInBuffer(current, first);
-            PermSorter::writeTermInBuffer(current + 5, third);
-            PermSorter::writeTermInBuffer(current + 10, second);
+            PermSorter::writeTerm<5>(current, first);
+            PermSorter::writeTerm<5>(current + 5, third);
+            PermSorter::writeTerm<5>(current + 10, second);
             current += 15;
             i++;
             if (i % 1000000000 == 0) {
@@ -469,6 +486,7 @@ struct _Offset {
     char third;
 };
 
+template<int W>
 void PermSorter::sortChunks2_load(const int idReader,
         MultiDiskLZ4Reader *reader,
         char *rawTriples,
@@ -485,16 +503,19 @@ void PermSorter::sortChunks2_load(const int idReader,
         int64_t first = reader->readLong(idReader);
         int64_t second = reader->readLong(idReader);
         int64_t third = reader->readLong(idReader);
-        PermSorter::writeTermInBuffer(current, first);
-        PermSorter::writeTermInBuffer(current + 5, second);
+        PermSorter::checkTerm<W>(first | second);
+        PermSorter::writeTerm<W>(current, first);
+        PermSorter::writeTerm<W>(current + W, second);
         if (includeCount) {
-            PermSorter::write8TermInBuffer(current + 10, third);
+            PermSorter::writeTerm<8>(current + 2 * W, third);
             int64_t count = reader->readLong(idReader);
-            PermSorter::writeTermInBuffer(current + 18, count);
-            current += 23;
+            PermSorter::checkTerm<W>(count);
+            PermSorter::writeTerm<W>(current + 2 * W + 8, count);
+            current += 3 * W + 8;
         } else {
-            PermSorter::writeTermInBuffer(current + 10, third);
-            current += 15;
+            PermSorter::checkTerm<W>(third);
+            PermSorter::writeTerm<W>(current + 2 * W, third);
+            current += 3 * W;
         }
         i++;
         if (i % 1000000000 == 0) {
@@ -504,6 +525,30 @@ void PermSorter::sortChunks2_load(const int idReader,
     *count = i;
 }
 
+template<int W>
+void PermSorter::sortChunks2_loadBinary(const BinaryTriples *input,
+        int64_t start,
+        int64_t n,
+        char *rawTriples) {
+    const int64_t batchSize = 4096;
+    std::vector<int64_t> batch(batchSize * 3);
+    while (n > 0) {
+        const int64_t m = min(n, batchSize);
+        input->read(start, m, batch.data());
+        for (int64_t i = 0; i < m; ++i) {
+            const int64_t *t = batch.data() + i * 3;
+            PermSorter::checkTerm<W>(t[0] | t[1] | t[2]);
+            PermSorter::writeTerm<W>(rawTriples, t[0]);
+            PermSorter::writeTerm<W>(rawTriples + W, t[1]);
+            PermSorter::writeTerm<W>(rawTriples + 2 * W, t[2]);
+            rawTriples += 3 * W;
+        }
+        start += m;
+        n -= m;
+    }
+}
+
+template<int W>
 void PermSorter::sortChunks2_fill(
         MultiDiskLZ4Reader **readers,
         size_t maxInserts,
@@ -514,7 +559,7 @@ void PermSorter::sortChunks2_fill(
         bool includeCount,
         char *rawTriples) {
     int curPart = 0;
-    const size_t sizeTriple = includeCount ? 23 : 15;
+    const size_t sizeTriple = includeCount ? 3 * W + 8 : 3 * W;
     std::vector<std::pair<int, int>> openedStreams;
     for(int i = 0; i < parallelProcesses; ++i) {
         int idxReader = i % maxReadingThreads;
@@ -543,15 +588,18 @@ void PermSorter::sortChunks2_fill(
                 const int64_t third = readers[pair.first]->readLong(pair.second);
 
                 const int64_t starto = counts[curPart] * sizeTriple;
-                PermSorter::writeTermInBuffer(start + starto, first);
-                PermSorter::writeTermInBuffer(start + starto + 5, second);
+                PermSorter::checkTerm<W>(first | second);
+                PermSorter::writeTerm<W>(start + starto, first);
+                PermSorter::writeTerm<W>(start + starto + W, second);
 
                 if (includeCount) {
-                    PermSorter::write8TermInBuffer(start + starto + 10, third);
+                    PermSorter::writeTerm<8>(start + starto + 2 * W, third);
                     const int64_t count = readers[pair.first]->readLong(pair.second);
-                    PermSorter::writeTermInBuffer(start + starto + 18, count);
+                    PermSorter::checkTerm<W>(count);
+                    PermSorter::writeTerm<W>(start + starto + 2 * W + 8, count);
                 } else {
-                    PermSorter::writeTermInBuffer(start + starto + 10, third);
+                    PermSorter::checkTerm<W>(third);
+                    PermSorter::writeTerm<W>(start + starto + 2 * W, third);
                 }
 
                 if (readers[pair.first]->isEOF(pair.second)) {
@@ -582,17 +630,22 @@ void PermSorter::sortChunks2_fill(
             + counts[i] * sizeTriple;
         char *beg_n = rawTriples + (i * maxInserts + limit) * sizeTriple;
         if (end_p < beg_n) {
-            memset(end_p, 1, beg_n-end_p);
+            memset(end_p, 0xFF, beg_n-end_p);
         }
     }
 }
 
+template<int W>
 void PermSorter::sortChunks2_permute(
         char *start,
         char *end,
         const size_t sizeTriple,
         int currentPerm,
         int nextPerm) {
+    char tmp[W];
+    char *first = start;
+    char *second = start + W;
+    char *third = start + 2 * W;
     if ((currentPerm == IDX_SPO && nextPerm == IDX_SOP)
             || (currentPerm == IDX_SOP && nextPerm == IDX_SPO)
             || (currentPerm == IDX_OSP && nextPerm == IDX_OPS)
@@ -601,24 +654,11 @@ void PermSorter::sortChunks2_permute(
             || (currentPerm == IDX_PSO && nextPerm == IDX_POS)
             ) {
         // switching second and third term
-        while (start < end) {
-            char tmp[5];
-            tmp[0] = start[5]; //copy second in tmp
-            tmp[1] = start[6];
-            tmp[2] = start[7];
-            tmp[3] = start[8];
-            tmp[4] = start[9];
-            start[5] = start[10]; //copy third in second
-            start[6] = start[11];
-            start[7] = start[12];
-            start[8] = start[13];
-            start[9] = start[14];
-            start[10] = tmp[0]; //copy tmp in third
-            start[11] = tmp[1];
-            start[12] = tmp[2];
-            start[13] = tmp[3];
-            start[14] = tmp[4];
-            start += sizeTriple;
+        for (; first < end; first += sizeTriple, second += sizeTriple,
+                third += sizeTriple) {
+            memcpy(tmp, second, W);
+            memcpy(second, third, W);
+            memcpy(third, tmp, W);
         }
     } else if ((currentPerm == IDX_SOP && nextPerm == IDX_OSP)
             || (currentPerm == IDX_OSP && nextPerm == IDX_SOP)
@@ -628,24 +668,11 @@ void PermSorter::sortChunks2_permute(
             || (currentPerm == IDX_PSO && nextPerm == IDX_SPO)
             ) {
         // switching first and second term
-        while (start < end) {
-            char tmp[5];
-            tmp[0] = start[0]; //copy first in tmp
-            tmp[1] = start[1];
-            tmp[2] = start[2];
-            tmp[3] = start[3];
-            tmp[4] = start[4];
-            start[0] = start[5]; //copy second in first
-            start[1] = start[6];
-            start[2] = start[7];
-            start[3] = start[8];
-            start[4] = start[9];
-            start[5] = tmp[0]; //copy tmp in second
-            start[6] = tmp[1];
-            start[7] = tmp[2];
-            start[8] = tmp[3];
-            start[9] = tmp[4];
-            start += sizeTriple;
+        for (; first < end; first += sizeTriple, second += sizeTriple,
+                third += sizeTriple) {
+            memcpy(tmp, first, W);
+            memcpy(first, second, W);
+            memcpy(second, tmp, W);
         }
     } else if ((currentPerm == IDX_SPO && nextPerm == IDX_OPS)
             || (currentPerm == IDX_OPS && nextPerm == IDX_SPO)
@@ -655,24 +682,11 @@ void PermSorter::sortChunks2_permute(
             || (currentPerm == IDX_SOP && nextPerm == IDX_POS)
             ) {
         // switching first and third term
-        while (start < end) {
-            char tmp[5];
-            tmp[0] = start[0]; //copy first in tmp
-            tmp[1] = start[1];
-            tmp[2] = start[2];
-            tmp[3] = start[3];
-            tmp[4] = start[4];
-            start[0] = start[10]; //copy third in first
-            start[1] = start[11];
-            start[2] = start[12];
-            start[3] = start[13];
-            start[4] = start[14];
-            start[10] = tmp[0]; //copy tmp in third
-            start[11] = tmp[1];
-            start[12] = tmp[2];
-            start[13] = tmp[3];
-            start[14] = tmp[4];
-            start += sizeTriple;
+        for (; first < end; first += sizeTriple, second += sizeTriple,
+                third += sizeTriple) {
+            memcpy(tmp, first, W);
+            memcpy(first, third, W);
+            memcpy(third, tmp, W);
         }
     } else if ((currentPerm == IDX_SPO && nextPerm == IDX_POS)
             || (currentPerm == IDX_OPS && nextPerm == IDX_PSO)
@@ -682,73 +696,78 @@ void PermSorter::sortChunks2_permute(
             || (currentPerm == IDX_SOP && nextPerm == IDX_OPS)
             ) {
         // rotating left
-        while (start < end) {
-            char tmp[5];
-            tmp[0] = start[0]; //copy first in tmp
-            tmp[1] = start[1];
-            tmp[2] = start[2];
-            tmp[3] = start[3];
-            tmp[4] = start[4];
-            start[0] = start[5]; //copy second in first
-            start[1] = start[6];
-            start[2] = start[7];
-            start[3] = start[8];
-            start[4] = start[9];
-            start[5] = start[10]; //copy third in second
-            start[6] = start[11];
-            start[7] = start[12];
-            start[8] = start[13];
-            start[9] = start[14];
-            start[10] = tmp[0]; //copy tmp in third
-            start[11] = tmp[1];
-            start[12] = tmp[2];
-            start[13] = tmp[3];
-            start[14] = tmp[4];
-            start += sizeTriple;
+        for (; first < end; first += sizeTriple, second += sizeTriple,
+                third += sizeTriple) {
+            memcpy(tmp, first, W);
+            memcpy(first, second, W);
+            memcpy(second, third, W);
+            memcpy(third, tmp, W);
         }
     } else {
         // rotating right
-        while (start < end) {
-            char tmp[5];
-            tmp[0] = start[0]; //copy first in tmp
-            tmp[1] = start[1];
-            tmp[2] = start[2];
-            tmp[3] = start[3];
-            tmp[4] = start[4];
-            start[0] = start[10]; //copy third in first
-            start[1] = start[11];
-            start[2] = start[12];
-            start[3] = start[13];
-            start[4] = start[14];
-            start[10] = start[5]; //copy second in third
-            start[11] = start[6];
-            start[12] = start[7];
-            start[13] = start[8];
-            start[14] = start[9];
-            start[5] = tmp[0]; //copy tmp in second
-            start[6] = tmp[1];
-            start[7] = tmp[2];
-            start[8] = tmp[3];
-            start[9] = tmp[4];
-            start += sizeTriple;
+        for (; first < end; first += sizeTriple, second += sizeTriple,
+                third += sizeTriple) {
+            memcpy(tmp, first, W);
+            memcpy(first, third, W);
+            memcpy(third, second, W);
+            memcpy(second, tmp, W);
         }
     }
 }
 
-void PermSorter::sortChunks2(
+template<int W>
+void PermSorter::sortChunks2_w(
         std::vector<std::pair<string, char>> &permutations,
         int ionthreads,
         int nthreads,
         int64_t estimatedSize,
         bool includeCount) {
     std::string inputdir = permutations[0].first;
-    std::vector<string> unsortedFiles = Utils::getFiles(inputdir, false);
-    const size_t threadsToUse = max(1, min((int)unsortedFiles.size(), (int) nthreads));
-
-    const size_t sizeTriple = includeCount ? 23 : 15;
-
-    LOG(DEBUGL) << "Start sortChunks2";
-    const int64_t mem = Utils::getSystemMemory() * 0.6;
+    std::string phaseName = "sort";
+    for (auto &p : permutations) {
+        phaseName += " p" + to_string((int) p.second);
+    }
+    LoadPhase phase(phaseName, "sort");
+
+    //The triples can come from binary files instead of the files in the
+    //directory. They are read only once.
+    std::shared_ptr<BinaryTriples> binaryTriples;
+    if (binaryInput && inputdir == binaryInputDir) {
+        binaryTriples = binaryInput;
+        binaryInput.reset();
+        binaryInputDir = "";
+    }
+    if (binaryTriples && includeCount) {
+        LOG(ERRORL) << "The binary triples cannot be aggregated";
+        throw 10;
+    }
+    std::vector<string> unsortedFiles;
+    if (!binaryTriples) {
+        unsortedFiles = Utils::getFiles(inputdir, false);
+    }
+    const size_t threadsToUse = binaryTriples ? max(1, nthreads) :
+        max(1, min((int)unsortedFiles.size(), (int) nthreads));
+
+    const size_t sizeTriple = includeCount ? 3 * W + 8 : 3 * W;
+
+    LOG(DEBUGL) << "Start sortChunks2 (" << W << " bytes per term)";
+    int64_t mem = Utils::getSystemMemory() * 0.6;
+    if (maxMemory > 0) {
+        if (radixSort) {
+            //The radix sort needs one scatter buffer per thread, that is
+            //about 1/16 of the array, and at least one small range each
+            mem = (maxMemory - (int64_t) nthreads * 65536 * sizeTriple)
+                / 17 * 16;
+        } else {
+            //The comparison sort may need as much memory as the array
+            mem = maxMemory / 2;
+        }
+        if (mem < (int64_t) (sizeTriple * threadsToUse)) {
+            LOG(ERRORL) << "The memory budget of " << maxMemory <<
+                " bytes is too small to sort the chunks";
+            throw 10;
+        }
+    }
     const size_t max_nelements = mem / sizeTriple;
 
     size_t nelements = max((size_t)threadsToUse,
@@ -772,34 +791,37 @@ void PermSorter::sortChunks2(
     auto itr = inputsReaders.begin();
     const size_t ioThreadsToUse = threadsToUse < nthreads ? 1 : ionthreads;
     int filesPerReader = threadsToUse / ioThreadsToUse;
-    MultiDiskLZ4Reader **readers = new MultiDiskLZ4Reader*[ioThreadsToUse];
-    for(int i = 0; i < ioThreadsToUse; ++i) {
-        readers[i] = new MultiDiskLZ4Reader(filesPerReader, 3, 4);
-        readers[i]->start();
-        for(int j = 0; j < filesPerReader; ++j) {
-            if (itr->empty()) {
-                LOG(DEBUGL) << "Part " << j << " is empty";
-            } else {
-                LOG(DEBUGL) << "Part " << i << " " << j << " " << itr->at(0);
-            }
-            if (itr != inputsReaders.end()) {
-                readers[i]->addInput(j, *itr);
-                itr++;
-            } else {
-                std::vector<string> emptyset;
-                readers[i]->addInput(j, emptyset);
+    MultiDiskLZ4Reader **readers = NULL;
+    if (!binaryTriples) {
+        readers = new MultiDiskLZ4Reader*[ioThreadsToUse];
+        for(int i = 0; i < ioThreadsToUse; ++i) {
+            readers[i] = new MultiDiskLZ4Reader(filesPerReader, 3, 4);
+            readers[i]->start();
+            for(int j = 0; j < filesPerReader; ++j) {
+                if (itr->empty()) {
+                    LOG(DEBUGL) << "Part " << j << " is empty";
+                } else {
+                    LOG(DEBUGL) << "Part " << i << " " << j << " " << itr->at(0);
+                }
+                if (itr != inputsReaders.end()) {
+                    readers[i]->addInput(j, *itr);
+                    itr++;
+                } else {
+                    std::vector<string> emptyset;
+                    readers[i]->addInput(j, emptyset);
+                }
             }
         }
-    }
 
-    if (includeCount) {
-        for(int i = 0; i < ioThreadsToUse; ++i) {
-            for(int idReader = 0; idReader < filesPerReader; ++idReader) {
-                if (!readers[i]->isEOF(idReader)) {
-                    char b = readers[i]->readByte(idReader);
-                    if (b != 1) {
-                        //Strange...
-                        throw 10;
+        if (includeCount) {
+            for(int i = 0; i < ioThreadsToUse; ++i) {
+                for(int idReader = 0; idReader < filesPerReader; ++idReader) {
+                    if (!readers[i]->isEOF(idReader)) {
+                        char b = readers[i]->readByte(idReader);
+                        if (b != 1) {
+                            //Strange...
+                            throw 10;
+                        }
                     }
                 }
             }
@@ -807,6 +829,7 @@ void PermSorter::sortChunks2(
     }
 
     int round = 0;
+    int64_t nextBinaryTriple = 0;
     LOG(DEBUGL) << "Got " << unsortedFiles.size() << " files from directory " << inputdir;
     std::vector<std::thread> threads(threadsToUse);
     while (true) {
@@ -815,11 +838,15 @@ void PermSorter::sortChunks2(
 
         //Check if I have finished sorting all the input data
         bool moreData = false;
-        for(int i = 0; i < threadsToUse; ++i) {
-            int idReader = i / ioThreadsToUse;
-            if (!readers[i % ioThreadsToUse]->isEOF(idReader)) {
-                moreData = true;
-                break;
+        if (binaryTriples) {
+            moreData = nextBinaryTriple < binaryTriples->getNTriples();
+        } else {
+            for(int i = 0; i < threadsToUse; ++i) {
+                int idReader = i / ioThreadsToUse;
+                if (!readers[i % ioThreadsToUse]->isEOF(idReader)) {
+                    moreData = true;
+                    break;
+                }
             }
         }
         if (!moreData)
@@ -828,39 +855,63 @@ void PermSorter::sortChunks2(
         //Load the array
         LOG(DEBUGL) << "Start loading the inmemory array ...";
         std::vector<int64_t> counts(threadsToUse);
-        for (int i = 0; i < threadsToUse; ++i) {
-            MultiDiskLZ4Reader *reader = readers[i % ioThreadsToUse];
-            int idReader = i / ioThreadsToUse;
-            size_t start = (i * sizeTriple * maxInserts);
-            size_t end;
-            if (i == threadsToUse - 1) {
-                end = start + lastMaxInserts * sizeTriple;
-            } else {
-                end = start + maxInserts * sizeTriple;
+        char *endArray = rawTriples.get() + nbytes;
+        if (binaryTriples) {
+            //The triples are copied directly from the mapped files, so
+            //there are no holes to fill
+            const int64_t n = min((int64_t) nelements,
+                    binaryTriples->getNTriples() - nextBinaryTriple);
+            const int64_t chunk = (n + threadsToUse - 1) / threadsToUse;
+            for (int i = 0; i < threadsToUse; ++i) {
+                const int64_t start = min(n, i * chunk);
+                counts[i] = min(n, start + chunk) - start;
+                threads[i] = std::thread(
+                        std::bind(&sortChunks2_loadBinary<W>,
+                            binaryTriples.get(),
+                            nextBinaryTriple + start,
+                            counts[i],
+                            rawTriples.get() + start * sizeTriple));
             }
-            threads[i] = std::thread(
-                    std::bind(&sortChunks2_load, idReader, reader,
-                        rawTriples.get(),
-                        start,
-                        end,
-                        &(counts[i]), includeCount));
-        }
-        for (int i = 0; i < threads.size(); ++i) {
-            threads[i].join();
+            for (int i = 0; i < threads.size(); ++i) {
+                threads[i].join();
+            }
+            nextBinaryTriple += n;
+            endArray = rawTriples.get() + n * sizeTriple;
+        } else {
+            for (int i = 0; i < threadsToUse; ++i) {
+                MultiDiskLZ4Reader *reader = readers[i % ioThreadsToUse];
+                int idReader = i / ioThreadsToUse;
+                size_t start = (i * sizeTriple * maxInserts);
+                size_t end;
+                if (i == threadsToUse - 1) {
+                    end = start + lastMaxInserts * sizeTriple;
+                } else {
+                    end = start + maxInserts * sizeTriple;
+                }
+                threads[i] = std::thread(
+                        std::bind(&sortChunks2_load<W>, idReader, reader,
+                            rawTriples.get(),
+                            start,
+                            end,
+                            &(counts[i]), includeCount));
+            }
+            for (int i = 0; i < threads.size(); ++i) {
+                threads[i].join();
+            }
+            LOG(DEBUGL) << "Stop loading the inmemory array";
+
+            //Fill the holes in the array
+            LOG(DEBUGL) << "Start filling the holes";
+            sortChunks2_fill<W>(readers, maxInserts, lastMaxInserts, counts, ioThreadsToUse,
+                    threadsToUse, includeCount,
+                    rawTriples.get());
+            LOG(DEBUGL) << "Stop filling the holes";
         }
-        LOG(DEBUGL) << "Stop loading the inmemory array";
-
-        //Fill the holes in the array
-        LOG(DEBUGL) << "Start filling the holes";
-        sortChunks2_fill(readers, maxInserts, lastMaxInserts, counts, ioThreadsToUse,
-                threadsToUse, includeCount,
-                rawTriples.get());
-        LOG(DEBUGL) << "Stop filling the holes";
 
         //Sort it
         LOG(DEBUGL) << "Start sorting the inmemory array";
-        PermSorter::sortPermutation(rawTriples.get(),
-                rawTriples.get() + nbytes, threadsToUse, includeCount);
+        PermSorter::sortPermutation<W>(rawTriples.get(),
+                endArray, threadsToUse, includeCount);
         LOG(DEBUGL) << "Stop sorting the inmemory array";
 
         //Dump it
@@ -869,7 +920,7 @@ void PermSorter::sortChunks2(
         LOG(DEBUGL) << "Start dumping the inmemory array of " << nloadedtriples;
         string outputFile = inputdir + DIR_SEP + string("sortedchunk-") + to_string(round);
 
-        PermSorter::dumpPermutation(rawTriples.get(),
+        PermSorter::dumpPermutation<W>(rawTriples.get(),
                 nloadedtriples,
                 threadsToUse,
                 ioThreadsToUse,
@@ -883,7 +934,7 @@ void PermSorter::sortChunks2(
 
             //Rewrite the permutation
             LOG(DEBUGL) << "Start permuting ...";
-            PermSorter::sortChunks2_permute(
+            PermSorter::sortChunks2_permute<W>(
                     rawTriples.get(),
                     rawTriples.get() + nloadedtriples * sizeTriple,
                     sizeTriple,
@@ -893,7 +944,7 @@ void PermSorter::sortChunks2(
 
             //Sort it
             LOG(DEBUGL) << "Start sorting the inmemory array. perm=" << permID;
-            PermSorter::sortPermutation(rawTriples.get(),
+            PermSorter::sortPermutation<W>(rawTriples.get(),
                     rawTriples.get() + nloadedtriples * sizeTriple, threadsToUse,
                     includeCount);
             LOG(DEBUGL) << "Stop sorting the inmemory array";
@@ -902,7 +953,7 @@ void PermSorter::sortChunks2(
             std::string currentDir = permutations[i].first;
             LOG(DEBUGL) << "Start dumping the inmemory array of " << nloadedtriples;
             outputFile = currentDir + DIR_SEP + string("sortedchunk-") + to_string(round);
-            PermSorter::dumpPermutation(rawTriples.get(),
+            PermSorter::dumpPermutation<W>(rawTriples.get(),
                     nloadedtriples,
                     threadsToUse,
                     ioThreadsToUse,
@@ -915,16 +966,41 @@ void PermSorter::sortChunks2(
         round++;
     }
 
-    for(int i = 0; i < ioThreadsToUse; ++i) {
-        delete readers[i];
+    if (readers) {
+        for(int i = 0; i < ioThreadsToUse; ++i) {
+            delete readers[i];
+        }
+        delete[] readers;
     }
-    delete[] readers;
     for(auto inputFile : unsortedFiles) {
         Utils::remove(inputFile);
     }
     LOG(DEBUGL) << "Stop sortChunks2";
 }
 
+void PermSorter::sortChunks2(
+        std::vector<std::pair<string, char>> &permutations,
+        int ionthreads,
+        int nthreads,
+        int64_t estimatedSize,
+        bool includeCount) {
+    //Narrower records take less memory and need fewer radix passes
+    switch (getTermBytes()) {
+        case 5:
+            sortChunks2_w<5>(permutations, ionthreads, nthreads,
+                    estimatedSize, includeCount);
+            break;
+        case 6:
+            sortChunks2_w<6>(permutations, ionthreads, nthreads,
+                    estimatedSize, includeCount);
+            break;
+        default:
+            sortChunks2_w<8>(permutations, ionthreads, nthreads,
+                    estimatedSize, includeCount);
+            break;
+    }
+}
+
 /*void PermSorter::sortChunks(string inputdir,
   int maxReadingThreads,
   int parallelProcesses,
@@ -83,8 +83,11 @@ Querier::Querier(Root* tree, DictMgmt *dict, TableStorage** files,
         this->files = files;
         lastKeyFound = false;
         lastKeyQueried = -1;
+        scanPrefetchTables = 0;
+        scanPrefetchBytes = 0;
         strat.init(/*&listFactory, &comprFactory, &list2Factory,*/ &ncFactory, &nrFactory, &ncluFactory,
-                NULL, NULL, NULL, NULL, NULL, NULL);
+                NULL, NULL, NULL, NULL, NULL, NULL, &ccFactory, NULL,
+                &efFactory, NULL);
         aggrIndices = notAggrIndices = cacheIndices = 0;
         spo = sop = pos = pso = ops = osp = 0;
 
@@ -653,7 +656,9 @@ void Querier::initNewIterator(TableStorage *storage,
     std::pair<const char*, const char*> coord = storage->getTable(file, mark);
 
     assert(t->getTypeItr() == NEWROW_ITR || t->getTypeItr() == NEWCLUSTER_ITR
-            || t->getTypeItr() == NEWCOLUMN_ITR);
+            || t->getTypeItr() == NEWCOLUMN_ITR
+            || t->getTypeItr() == COMPRCOLUMN_ITR
+            || t->getTypeItr() == EFCOLUMN_ITR);
     if (v1 != -1) {
         if (setConstraints) {
             if (v2 == -1) {
@@ -895,6 +900,18 @@ bool Querier::existKey(int perm, int64_t key) {
     return resp;
 }
 
+void Querier::beginScan(const int perm) {
+    if (files[perm] != NULL) {
+        files[perm]->beginScan();
+    }
+}
+
+void Querier::endScan(const int perm) {
+    if (files[perm] != NULL) {
+        files[perm]->endScan();
+    }
+}
+
 TermItr *Querier::getKBTermList(const int perm, const bool enforcePerm) {
     TableStorage *storage = files[perm];
     if (perm > 2 && ! enforcePerm) {
@@ -1309,6 +1326,12 @@ void Querier::releaseItr(PairItr * itr) {
         case NEWCLUSTER_ITR:
             ncluFactory.release((AbsNewTable *) itr);
             break;
+        case COMPRCOLUMN_ITR:
+            ccFactory.release((ComprColumnTable *) itr);
+            break;
+        case EFCOLUMN_ITR:
+            efFactory.release((EFColumnTable *) itr);
+            break;
         case ARRAY_ITR:
             itr->clear();
             factory2.release((ArrayItr*) itr);
@@ -27,10 +27,16 @@
 #include <trident/kb/dictmgmt.h>
 #include <trident/tree/stringbuffer.h>
 #include <trident/tree/root.h>
+#include <trident/tree/flatroot.h>
+#include <trident/tree/staticroot.h>
+#include <trident/kb/inserter.h>
+#include <trident/binarytables/tableshandler.h>
 
 #include <kognac/filereader.h>
+#include <kognac/lz4io.h>
 
 #include <string>
+#include <fstream>
 
 void Updater::parseUpdate(std::string update,
                           StringCollection &support,
@@ -145,21 +151,16 @@ void Updater::writeDict(DictMgmt *dictmgmt,
     ofs.close();
 }
 
-void Updater::compressUpdate(DiffIndex::TypeUpdate type,
-                             string updatedir,
-                             std::vector<uint64_t> &all_s,
-                             std::vector<uint64_t> &all_p,
-                             std::vector<uint64_t> &all_o,
-                             KB *kb,
-                             Querier *q,
-                             ByteArrayToNumberMap &tmpdict,
-                             StringCollection &tmpdictsupport) {
+void Updater::compressTriples(DiffIndex::TypeUpdate type,
+                              string updatedir,
+                              KB *kb,
+                              ByteArrayToNumberMap &tmpdict,
+                              StringCollection &tmpdictsupport,
+                              std::vector<Triple> &parsedtriples) {
     std::unique_ptr<char[]> supportbuffer(new char[MAX_TERM_SIZE + 2]);
     Utils::encode_short(supportbuffer.get(), 0);
     int64_t supportlen = 0;
 
-    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-    std::vector<Triple> parsedtriples;
     {
         //Read the update and parse the strings
         std::vector<TextualTriple> triples;
@@ -307,6 +308,21 @@ void Updater::compressUpdate(DiffIndex::TypeUpdate type,
     auto newend = std::unique(parsedtriples.begin(), parsedtriples.end(),
                               Triple::equal);
     parsedtriples.resize(std::distance(parsedtriples.begin(), newend));
+}
+
+void Updater::compressUpdate(DiffIndex::TypeUpdate type,
+                             string updatedir,
+                             std::vector<uint64_t> &all_s,
+                             std::vector<uint64_t> &all_p,
+                             std::vector<uint64_t> &all_o,
+                             KB *kb,
+                             Querier *q,
+                             ByteArrayToNumberMap &tmpdict,
+                             StringCollection &tmpdictsupport) {
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    std::vector<Triple> parsedtriples;
+    compressTriples(type, updatedir, kb, tmpdict, tmpdictsupport,
+                    parsedtriples);
 
     //Add triples that are either not existing (ADD) or existing (REMOVE) ...
     match(type, all_s, all_p, all_o, q, parsedtriples);
@@ -368,6 +384,546 @@ void Updater::creatediffupdate(DiffIndex::TypeUpdate type, std::string kbdir,
     delete q;
 }
 
+//Writes the coordinates of the rewritten tables directly in the tree
+class CoordinatesUpdater : public TreeInserter {
+    private:
+        Inserter *ins;
+        const int perm;
+
+    public:
+        CoordinatesUpdater(Inserter *ins, const int perm) : ins(ins),
+            perm(perm) {
+        }
+
+        void addEntry(nTerm key, int64_t nElements, short file, int pos,
+                      char strategy) {
+            ins->updateCoordinates(key, perm, file, pos, nElements, strategy);
+        }
+};
+
+Updater::Triple Updater::reorder(const int perm, const Triple &t) {
+    Triple out;
+    switch (perm) {
+    case IDX_SPO:
+        out.s = t.s; out.p = t.p; out.o = t.o;
+        break;
+    case IDX_SOP:
+        out.s = t.s; out.p = t.o; out.o = t.p;
+        break;
+    case IDX_POS:
+        out.s = t.p; out.p = t.o; out.o = t.s;
+        break;
+    case IDX_PSO:
+        out.s = t.p; out.p = t.s; out.o = t.o;
+        break;
+    case IDX_OSP:
+        out.s = t.o; out.p = t.s; out.o = t.p;
+        break;
+    case IDX_OPS:
+        out.s = t.o; out.p = t.p; out.o = t.s;
+        break;
+    default:
+        LOG(ERRORL) << "Idx " << perm << " not known";
+        throw 10;
+    }
+    return out;
+}
+
+int64_t Updater::mergePermutation(const int perm,
+                                  std::vector<Triple> &triples,
+                                  Querier *q,
+                                  const int64_t firstNewID,
+                                  std::string output,
+                                  int64_t &newtables,
+                                  int64_t &newfirstels,
+                                  int64_t &deadrows) {
+    std::vector<Triple> input;
+    input.reserve(triples.size());
+    for (auto &t : triples) {
+        input.push_back(reorder(perm, t));
+    }
+    std::sort(input.begin(), input.end(), Triple::sorter);
+
+    //Merge the new pairs of each key with its current table. The result is
+    //the new content of the table
+    LZ4Writer writer(output);
+    int64_t added = 0;
+    auto itr = input.begin();
+    while (itr != input.end()) {
+        const uint64_t key = itr->s;
+        //Terms that were just added to the dictionary have no table
+        PairItr *kbitr = NULL;
+        bool kbvalid = false;
+        if (key < firstNewID) {
+            kbitr = q->getPermuted(perm, key, -1, -1);
+            kbvalid = kbitr->hasNext();
+        }
+        if (kbvalid) {
+            kbitr->next();
+        } else {
+            newtables++;
+        }
+        int64_t lastv1 = -1;
+        int64_t lastkbv1 = -1;
+        while (itr != input.end() && itr->s == key) {
+            int64_t v1, v2;
+            if (kbvalid && (kbitr->getValue1() < itr->p ||
+                            (kbitr->getValue1() == itr->p &&
+                             kbitr->getValue2() <= itr->o))) {
+                v1 = kbitr->getValue1();
+                v2 = kbitr->getValue2();
+                deadrows++;
+                if (v1 == itr->p && v2 == itr->o) {
+                    itr++; //The triple is already in the KB
+                }
+                if (v1 != lastkbv1) {
+                    newfirstels--;
+                    lastkbv1 = v1;
+                }
+                kbvalid = kbitr->hasNext();
+                if (kbvalid) {
+                    kbitr->next();
+                }
+            } else {
+                v1 = itr->p;
+                v2 = itr->o;
+                added++;
+                itr++;
+            }
+            if (v1 != lastv1) {
+                newfirstels++;
+                lastv1 = v1;
+            }
+            writer.writeVLong(key);
+            writer.writeVLong(v1);
+            writer.writeVLong(v2);
+        }
+        //Copy the rest of the table
+        while (kbvalid) {
+            const int64_t v1 = kbitr->getValue1();
+            if (v1 != lastkbv1) {
+                newfirstels--;
+                lastkbv1 = v1;
+            }
+            if (v1 != lastv1) {
+                newfirstels++;
+                lastv1 = v1;
+            }
+            writer.writeVLong(key);
+            writer.writeVLong(v1);
+            writer.writeVLong(kbitr->getValue2());
+            deadrows++;
+            kbvalid = kbitr->hasNext();
+            if (kbvalid) {
+                kbitr->next();
+            }
+        }
+        if (kbitr != NULL) {
+            q->releaseItr(kbitr);
+        }
+    }
+    return added;
+}
+
+int64_t Updater::mergeAllPermutation(const int perm,
+                                     std::vector<Triple> &triples,
+                                     Querier *q,
+                                     std::string output,
+                                     int64_t &newtables,
+                                     int64_t &newfirstels) {
+    std::vector<Triple> input;
+    input.reserve(triples.size());
+    for (auto &t : triples) {
+        input.push_back(reorder(perm, t));
+    }
+    std::sort(input.begin(), input.end(), Triple::sorter);
+
+    //Count the tables and the first elements both in the KB and in the
+    //output. The differences are what the update adds
+    int64_t tables = 0, firstels = 0, kbtables = 0, kbfirstels = 0;
+    int64_t lastkey = -1, lastv1 = -1, lastkbkey = -1, lastkbv1 = -1;
+    LZ4Writer writer(output);
+    int64_t added = 0;
+    PairItr *kbitr = q->getPermuted(perm, -1, -1, -1);
+    bool kbvalid = kbitr->hasNext();
+    if (kbvalid) {
+        kbitr->next();
+    }
+    auto itr = input.begin();
+    while (kbvalid || itr != input.end()) {
+        int64_t key, v1, v2;
+        const int c = !kbvalid ? 1 : (itr == input.end() ? -1 :
+                                      cmp(kbitr, *itr));
+        if (c <= 0) {
+            key = kbitr->getKey();
+            v1 = kbitr->getValue1();
+            v2 = kbitr->getValue2();
+            if (c == 0) {
+                itr++; //The triple is already in the KB
+            }
+            if (key != lastkbkey) {
+                kbtables++;
+                kbfirstels++;
+                lastkbkey = key;
+                lastkbv1 = v1;
+            } else if (v1 != lastkbv1) {
+                kbfirstels++;
+                lastkbv1 = v1;
+            }
+            kbvalid = kbitr->hasNext();
+            if (kbvalid) {
+                kbitr->next();
+            }
+        } else {
+            key = itr->s;
+            v1 = itr->p;
+            v2 = itr->o;
+            added++;
+            itr++;
+        }
+        if (key != lastkey) {
+            tables++;
+            firstels++;
+            lastkey = key;
+            lastv1 = v1;
+        } else if (v1 != lastv1) {
+            firstels++;
+            lastv1 = v1;
+        }
+        writer.writeVLong(key);
+        writer.writeVLong(v1);
+        writer.writeVLong(v2);
+    }
+    q->releaseItr(kbitr);
+    newtables = tables - kbtables;
+    newfirstels = firstels - kbfirstels;
+    return added;
+}
+
+void Updater::appendPermutation(const int perm,
+                                std::string input,
+                                std::string storagedir,
+                                bool newStorage,
+                                Inserter *ins,
+                                const int64_t newtables,
+                                const int64_t newfirstels) {
+    TableStorage *files[N_PARTITIONS];
+    int64_t ntables[N_PARTITIONS];
+    int64_t nfirstels[N_PARTITIONS];
+    for (int i = 0; i < N_PARTITIONS; ++i) {
+        files[i] = NULL;
+        ntables[i] = 0;
+        nfirstels[i] = 0;
+    }
+    //The new tables go in new files. The old ones become unreachable once
+    //the tree points to the new tables
+    files[perm] = ins->createStorage(perm, storagedir);
+    if (!newStorage) {
+        files[perm]->startNewFile();
+    }
+    Inserter *part = ins->createPartition(files, ntables, nfirstels);
+    CoordinatesUpdater updater(ins, perm);
+    {
+        LZ4Reader reader(input);
+        while (!reader.isEof()) {
+            const int64_t key = reader.parseVLong();
+            const int64_t v1 = reader.parseVLong();
+            const int64_t v2 = reader.parseVLong();
+            part->insert(perm, key, v1, v2, 1, NULL, &updater, false, false);
+        }
+    }
+    part->flush(perm, NULL, &updater, false, false);
+    part->stopInserts(perm);
+    delete files[perm];
+
+    //The inserter counted also the tables that already existed
+    ntables[perm] = newtables;
+    nfirstels[perm] = newfirstels;
+    ins->mergePartition(perm, part);
+    delete part;
+    Utils::remove(input);
+}
+
+int Updater::getLastFileId(std::string dir) {
+    int last = -1;
+    if (Utils::exists(dir)) {
+        for (auto child : Utils::getFiles(dir)) {
+            const string name = Utils::filename(child);
+            if (!name.empty() && isdigit(name[0])) {
+                last = max(last, atoi(name.c_str()));
+            }
+        }
+    }
+    return last;
+}
+
+void Updater::copyPath(std::string from, std::string to) {
+    if (Utils::isDirectory(from)) {
+        Utils::create_directories(to);
+        for (auto child : Utils::getFiles(from)) {
+            copyPath(child, to + "/" + Utils::filename(child));
+        }
+    } else {
+        std::ifstream in(from, std::ios::binary);
+        std::ofstream out(to, std::ios::binary);
+        out << in.rdbuf();
+        if (!out.good()) {
+            LOG(ERRORL) << "Failed copying " << from << " to " << to;
+            throw 10;
+        }
+    }
+}
+
+void Updater::readAppendStats(std::string kbdir, int64_t *deadrows) {
+    const string file = kbdir + "/appendstats";
+    char data[8];
+    std::ifstream fis;
+    if (Utils::exists(file)) {
+        fis.open(file, std::ios::binary);
+    }
+    for (int i = 0; i < N_PARTITIONS; ++i) {
+        deadrows[i] = 0;
+        if (fis.is_open() && fis.read(data, 8)) {
+            deadrows[i] = Utils::decode_long(data, 0);
+        }
+    }
+}
+
+void Updater::writeAppendStats(std::string kbdir, const int64_t *deadrows) {
+    std::ofstream fos(kbdir + "/appendstats", std::ios::binary);
+    char data[8];
+    for (int i = 0; i < N_PARTITIONS; ++i) {
+        Utils::encode_long(data, 0, deadrows[i]);
+        fos.write(data, 8);
+    }
+}
+
+void Updater::beginAppendJournal(std::string kbdir, const bool *present) {
+    const string journal = kbdir + "/_append/journal";
+    Utils::create_directories(journal);
+    //The tree and the dictionary are changed in place
+    for (auto name : { "tree", "dict", "invdict", "kbstats", "appendstats" }) {
+        if (Utils::exists(kbdir + "/" + name)) {
+            copyPath(kbdir + "/" + name, journal + "/" + name);
+        }
+    }
+    //The tables are only added in new files
+    {
+        std::ofstream fos(journal + "/files", std::ios::binary);
+        char data[8];
+        for (int i = 0; i < N_PARTITIONS; ++i) {
+            Utils::encode_long(data, 0, present[i] ?
+                               getLastFileId(kbdir + "/p" + to_string(i)) : -1);
+            fos.write(data, 8);
+        }
+    }
+    //Written last, so that a journal without it is never used
+    std::ofstream marker(journal + "/BEGIN");
+}
+
+void Updater::endAppendJournal(std::string kbdir) {
+    Utils::remove(kbdir + "/_append/journal/BEGIN");
+    Utils::remove_all(kbdir + "/_append");
+}
+
+void Updater::recoverAppend(std::string kbdir) {
+    const string appenddir = kbdir + "/_append";
+    const string journal = appenddir + "/journal";
+    if (!Utils::exists(journal + "/BEGIN")) {
+        //The append failed before changing the KB
+        if (Utils::exists(appenddir)) {
+            Utils::remove_all(appenddir);
+        }
+        return;
+    }
+    LOG(WARNL) << "Rolling back an append to " << kbdir << " that did not complete";
+
+    std::ifstream fis(journal + "/files", std::ios::binary);
+    char data[8];
+    for (int i = 0; i < N_PARTITIONS; ++i) {
+        fis.read(data, 8);
+        const int64_t last = Utils::decode_long(data, 0);
+        const string permdir = kbdir + "/p" + to_string(i);
+        const string oldpermdir = journal + "/old_p" + to_string(i);
+        if (Utils::exists(oldpermdir)) {
+            //The permutation was compacted
+            if (Utils::exists(permdir)) {
+                Utils::remove_all(permdir);
+            }
+            Utils::rename(oldpermdir, permdir);
+        } else if (Utils::exists(permdir)) {
+            for (auto child : Utils::getFiles(permdir)) {
+                const string name = Utils::filename(child);
+                if (!name.empty() && isdigit(name[0]) &&
+                        atoi(name.c_str()) > last) {
+                    Utils::remove(child);
+                }
+            }
+        }
+    }
+    fis.close();
+
+    for (auto name : { "tree", "dict", "invdict", "kbstats", "appendstats" }) {
+        const string path = kbdir + "/" + name;
+        if (Utils::exists(path)) {
+            if (Utils::isDirectory(path)) {
+                Utils::remove_all(path);
+            } else {
+                Utils::remove(path);
+            }
+        }
+        if (Utils::exists(journal + "/" + name)) {
+            Utils::rename(journal + "/" + name, path);
+        }
+    }
+    endAppendJournal(kbdir);
+}
+
+void Updater::appendupdate(std::string kbdir, std::string updatedir) {
+    std::chrono::system_clock::time_point startappend = std::chrono::system_clock::now();
+    if (Utils::exists(kbdir + "/_diff")) {
+        LOG(ERRORL) << "The KB contains diff updates. Triples can be appended only to KBs without them";
+        throw 10;
+    }
+    recoverAppend(kbdir);
+
+    //Set up a tmp dictionary
+    StringCollection tmpdictsupport(8 * 1024 * 1024);
+    ByteArrayToNumberMap tmpdict;
+    tmpdict.set_empty_key(EMPTY_KEY);
+    tmpdict.set_deleted_key(DELETED_KEY);
+
+    const string appenddir = kbdir + "/_append";
+    int64_t added = -1;
+    int64_t newtables[N_PARTITIONS];
+    int64_t newfirstels[N_PARTITIONS];
+    int64_t deadrows[N_PARTITIONS];
+    bool present[N_PARTITIONS];
+    bool compact[N_PARTITIONS];
+    readAppendStats(kbdir, deadrows);
+    {
+        //Merge the update with the current tables, one key at a time
+        KBConfig config;
+        KB kb(kbdir.c_str(), true, false, true, config);
+        if (kb.areIndicesAggregated()) {
+            LOG(ERRORL) << "Triples cannot be appended to KBs with aggregated indices";
+            throw 10;
+        }
+        Querier *q = kb.query();
+        std::vector<Triple> triples;
+        compressTriples(DiffIndex::TypeUpdate::ADDITION_df, updatedir, &kb,
+                        tmpdict, tmpdictsupport, triples);
+
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        Utils::create_directories(appenddir);
+        for (int i = 0; i < N_PARTITIONS; ++i) {
+            newtables[i] = 0;
+            newfirstels[i] = 0;
+            present[i] = kb.isPresent(i);
+            compact[i] = false;
+            if (!present[i]) {
+                continue;
+            }
+            const string output = appenddir + "/p" + to_string(i);
+            int64_t dead = deadrows[i];
+            int64_t n = mergePermutation(i, triples, q, kb.getNextID(), output,
+                                         newtables[i], newfirstels[i], dead);
+            //Rewrite the whole permutation once the replaced tables take
+            //more space than the live ones, or the files run out
+            if (dead * 2 > kb.getSize() ||
+                    getLastFileId(kbdir + "/p" + to_string(i)) >= MAX_N_FILES / 2) {
+                LOG(INFOL) << "Compacting permutation " << i;
+                compact[i] = true;
+                n = mergeAllPermutation(i, triples, q, output, newtables[i],
+                                        newfirstels[i]);
+                dead = 0;
+            }
+            deadrows[i] = dead;
+            if (added == -1) {
+                added = n;
+            }
+        }
+        delete q;
+        std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+        LOG(DEBUGL) << "Runtime merging the update with the tables = " << sec.count() * 1000;
+    }
+
+    //From here on the KB is changed. If the append does not complete, the
+    //journal is used to restore the KB
+    beginAppendJournal(kbdir, present);
+    const string journal = appenddir + "/journal";
+    {
+        KBConfig config;
+        KB kb(kbdir.c_str(), false, false, true, config);
+
+        //Add the new terms to the dictionary
+        DictMgmt *dict = kb.getDictMgmt();
+        for (auto itr = tmpdict.begin(); itr != tmpdict.end(); ++itr) {
+            const char *term = itr->first;
+            nTerm id = itr->second;
+            dict->putPair(term + 2, Utils::decode_short(term), id);
+        }
+
+        //Rewrite the tables that have changed. The compacted permutations
+        //are written in a new directory
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        Inserter *ins = kb.insert();
+        for (int i = 0; i < N_PARTITIONS; ++i) {
+            if (present[i]) {
+                const string storagedir = compact[i] ?
+                                          appenddir + "/new_p" + to_string(i) :
+                                          kbdir + "/p" + to_string(i);
+                appendPermutation(i, appenddir + "/p" + to_string(i),
+                                  storagedir, compact[i], ins,
+                                  newtables[i], newfirstels[i]);
+            }
+        }
+        delete ins;
+        kb.addAppendedTriples(max(added, (int64_t) 0));
+        std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+        LOG(DEBUGL) << "Runtime rewriting the tables = " << sec.count() * 1000;
+        kb.close();
+
+        //Replace the compacted permutations. The old ones are kept in the
+        //journal until the append is completed
+        for (int i = 0; i < N_PARTITIONS; ++i) {
+            if (compact[i]) {
+                Utils::rename(kbdir + "/p" + to_string(i),
+                              journal + "/old_p" + to_string(i));
+                Utils::rename(appenddir + "/new_p" + to_string(i),
+                              kbdir + "/p" + to_string(i));
+            }
+        }
+
+        //The static and the flat trees must be rebuilt
+        const string treedir = kbdir + "/tree/";
+        if (Utils::exists(treedir + "static")) {
+            Utils::remove(treedir + "static");
+            std::unique_ptr<Root> root(kb.getRootTree());
+            StaticRoot::build(root.get(), treedir + "static");
+        }
+        if (Utils::exists(treedir + "flat")) {
+            Utils::remove(treedir + "flat");
+            std::unique_ptr<Root> root(kb.getRootTree());
+            FlatRoot::loadFlatTree(kbdir + "/p" + to_string(IDX_SOP),
+                                   kbdir + "/p" + to_string(IDX_OSP),
+                                   kbdir + "/p" + to_string(IDX_SPO),
+                                   kbdir + "/p" + to_string(IDX_OPS),
+                                   kbdir + "/p" + to_string(IDX_POS),
+                                   kbdir + "/p" + to_string(IDX_PSO),
+                                   treedir + "flat", root.get(),
+                                   kb.getGraphType() != GraphType::DEFAULT,
+                                   kb.getGraphType() == GraphType::UNDIRECTED);
+        }
+    }
+    writeAppendStats(kbdir, deadrows);
+    endAppendJournal(kbdir);
+
+    std::chrono::duration<double> secappend = std::chrono::system_clock::now() - startappend;
+    LOG(INFOL) << "Appended " << added << " triples and " << tmpdict.size() <<
+               " terms in " << secappend.count() * 1000 << " ms.";
+}
+
 std::string Updater::getPathForUpdate(std::string kbdir) {
     std::string diffdir = kbdir + "/_diff";
     if (!Utils::exists(diffdir)) {
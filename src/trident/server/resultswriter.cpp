@@ -0,0 +1,256 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/server/resultswriter.h>
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+SPARQLResultsWriter::SPARQLResultsWriter(HttpChunkedWriter &out,
+        Format format) : out(out), format(format), started(false),
+    firstRow(true) {
+    }
+
+std::string SPARQLResultsWriter::getContentType(Format format) {
+    switch (format) {
+        case TSVFORMAT:
+            return "text/tab-separated-values; charset=utf-8";
+        case CSVFORMAT:
+            return "text/csv; charset=utf-8";
+        default:
+            return "application/sparql-results+json";
+    }
+}
+
+void SPARQLResultsWriter::parseTerm(const std::string &term, Term &t) {
+    t.value = term.c_str();
+    t.valueLen = term.size();
+    t.lang = t.datatype = NULL;
+    t.langLen = t.datatypeLen = 0;
+    if (term.empty()) {
+        t.kind = Term::UNBOUND;
+    } else if (term[0] == '<' && term.back() == '>' && term.size() > 1) {
+        t.kind = Term::URI;
+        t.value++;
+        t.valueLen -= 2;
+    } else if (term.size() > 1 && term[0] == '_' && term[1] == ':') {
+        t.kind = Term::BNODE;
+        t.value += 2;
+        t.valueLen -= 2;
+    } else {
+        t.kind = Term::LITERAL;
+        size_t endValue;
+        if (term[0] == '"' && (endValue = term.rfind('"')) > 0) {
+            t.value++;
+            t.valueLen = endValue - 1;
+            const char *suffix = term.c_str() + endValue + 1;
+            const size_t suffixLen = term.size() - endValue - 1;
+            if (suffixLen > 1 && suffix[0] == '@') {
+                t.lang = suffix + 1;
+                t.langLen = suffixLen - 1;
+            } else if (suffixLen > 4 && suffix[0] == '^' && suffix[2] == '<') {
+                t.datatype = suffix + 3;
+                t.datatypeLen = suffixLen - 4;
+            }
+        }
+        //Otherwise it is a number, which is printed without quotes
+    }
+}
+
+void SPARQLResultsWriter::appendJSON(std::string &out, const char *s,
+        size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        const char c = s[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char) c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", (int) c);
+            out += code;
+        } else {
+            out += c;
+        }
+    }
+}
+
+void SPARQLResultsWriter::appendTSV(std::string &out,
+        const std::string &term) {
+    //The terms are already in the right syntax, but tabs and newlines
+    //would break the rows
+    for (const char c : term) {
+        if (c == '\t') {
+            out += "\\t";
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else {
+            out += c;
+        }
+    }
+}
+
+void SPARQLResultsWriter::appendCSV(std::string &out, const char *s,
+        size_t len) {
+    bool quote = false;
+    for (size_t i = 0; i < len && !quote; ++i) {
+        quote = s[i] == ',' || s[i] == '"' || s[i] == '\n' || s[i] == '\r';
+    }
+    if (!quote) {
+        out.append(s, len);
+        return;
+    }
+    out += '"';
+    for (size_t i = 0; i < len; ++i) {
+        if (s[i] == '"')
+            out += '"';
+        out += s[i];
+    }
+    out += '"';
+}
+
+void SPARQLResultsWriter::appendJSONRow(
+        const std::vector<std::string> &values) {
+    row += firstRow ? "{" : ",{";
+    bool firstBinding = true;
+    Term t;
+    for (size_t i = 0; i < values.size(); ++i) {
+        parseTerm(values[i], t);
+        if (t.kind == Term::UNBOUND) {
+            continue;
+        }
+        if (!firstBinding)
+            row += ',';
+        firstBinding = false;
+        row += '"';
+        appendJSON(row, vars[i].c_str(), vars[i].size());
+        row += "\":{\"type\":\"";
+        row += t.kind == Term::URI ? "uri" :
+            (t.kind == Term::BNODE ? "bnode" : "literal");
+        row += "\",\"value\":\"";
+        appendJSON(row, t.value, t.valueLen);
+        row += '"';
+        if (t.lang) {
+            row += ",\"xml:lang\":\"";
+            appendJSON(row, t.lang, t.langLen);
+            row += '"';
+        } else if (t.datatype) {
+            row += ",\"datatype\":\"";
+            appendJSON(row, t.datatype, t.datatypeLen);
+            row += '"';
+        }
+        row += '}';
+    }
+    row += '}';
+}
+
+bool SPARQLResultsWriter::begin(const std::vector<std::string> &vars) {
+    if (started) {
+        return !out.isBroken();
+    }
+    started = true;
+    this->vars = vars;
+    if (!out.start(getContentType(format))) {
+        return false;
+    }
+    row.clear();
+    for (size_t i = 0; i < vars.size(); ++i) {
+        switch (format) {
+            case JSONFORMAT:
+                row += i == 0 ? "{\"head\":{\"vars\":[\"" : ",\"";
+                appendJSON(row, vars[i].c_str(), vars[i].size());
+                row += '"';
+                break;
+            case TSVFORMAT:
+                row += i == 0 ? "?" : "\t?";
+                row += vars[i];
+                break;
+            case CSVFORMAT:
+                if (i > 0)
+                    row += ',';
+                appendCSV(row, vars[i].c_str(), vars[i].size());
+                break;
+        }
+    }
+    if (format == JSONFORMAT) {
+        if (vars.empty())
+            row += "{\"head\":{\"vars\":[";
+        row += "]},\"results\":{\"bindings\":[";
+    } else {
+        row += format == CSVFORMAT ? "\r\n" : "\n";
+    }
+    //Send the header immediately, so the client knows the query is running
+    return out.write(row) && out.flush();
+}
+
+bool SPARQLResultsWriter::writeRow(const std::vector<std::string> &values) {
+    row.clear();
+    Term t;
+    switch (format) {
+        case JSONFORMAT:
+            appendJSONRow(values);
+            break;
+        case TSVFORMAT:
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (i > 0)
+                    row += '\t';
+                appendTSV(row, values[i]);
+            }
+            row += '\n';
+            break;
+        case CSVFORMAT:
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (i > 0)
+                    row += ',';
+                parseTerm(values[i], t);
+                if (t.kind == Term::BNODE) {
+                    row += "_:";
+                }
+                appendCSV(row, t.value, t.valueLen);
+            }
+            row += "\r\n";
+            break;
+    }
+    firstRow = false;
+    return out.write(row);
+}
+
+bool SPARQLResultsWriter::end(JSON *stats) {
+    if (!started && !begin(std::vector<std::string>())) {
+        return false;
+    }
+    if (format == JSONFORMAT) {
+        std::string tail = "]}";
+        if (stats) {
+            std::ostringstream buf;
+            JSON::write(buf, *stats);
+            tail += ",\"stats\":" + buf.str();
+        }
+        tail += "}";
+        if (!out.write(tail)) {
+            return false;
+        }
+    }
+    return out.finish();
+}
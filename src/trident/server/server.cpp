@@ -16,15 +16,21 @@
 //#include <curl/curl.h>
 
 #include <string>
+#include <algorithm>
 #include <fstream>
 #include <chrono>
 #include <thread>
 #include <regex>
+#include <sstream>
 
-TridentServer::TridentServer(KB &kb, string htmlfiles, int nthreads) :
+TridentServer::TridentServer(KB &kb, string htmlfiles, int nthreads,
+        int queryThreads, size_t planCacheSize, size_t maxQueuedRequests,
+        uint64_t requestTimeout) :
     kb(kb),
     dirhtmlfiles(htmlfiles),
-    isActive(false), nthreads(nthreads) {
+    isActive(false), nthreads(nthreads), queryThreads(queryThreads),
+    planCache(planCacheSize), maxQueuedRequests(maxQueuedRequests),
+    requestTimeout(requestTimeout) {
 
     }
 
@@ -36,9 +42,10 @@ void TridentServer::startThread(int port) {
 void TridentServer::start(int port) {
     auto f = std::bind(&TridentServer::processRequest, this,
             std::placeholders::_1,
-            std::placeholders::_2);
+            std::placeholders::_2,
+            std::placeholders::_3);
     server = std::shared_ptr<HttpServer>(new HttpServer(port,
-                f, nthreads));
+                f, nthreads, 7000, maxQueuedRequests, requestTimeout));
     t = std::thread(&TridentServer::startThread, this, port);
 }
 
@@ -76,7 +83,71 @@ string TridentServer::lookup(string sId, TridentLayer &db) {
     return string(start, end - start);
 }
 
-void TridentServer::processRequest(std::string req, std::string &res) {
+string _trim(const string &s) {
+    size_t start = s.find_first_not_of(" \t");
+    if (start == string::npos) {
+        return "";
+    }
+    return s.substr(start, s.find_last_not_of(" \t") - start + 1);
+}
+
+//Returns false if the media type (or its short name) is not supported
+bool _getFormatOfType(string type, SPARQLResultsWriter::Format &format) {
+    std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+    type = _trim(type);
+    if (type == "csv" || type == "text/csv") {
+        format = SPARQLResultsWriter::CSVFORMAT;
+    } else if (type == "tsv" || type == "text/tab-separated-values") {
+        format = SPARQLResultsWriter::TSVFORMAT;
+    } else if (type == "json" || type == "application/sparql-results+json" ||
+            type == "application/json" || type == "application/*" ||
+            type == "*/*") {
+        format = SPARQLResultsWriter::JSONFORMAT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SPARQLResultsWriter::Format TridentServer::getFormat(const string &req,
+        const string &form) {
+    SPARQLResultsWriter::Format format = SPARQLResultsWriter::JSONFORMAT;
+    if (_getFormatOfType(_getValueParam(form, "format"), format)) {
+        return format;
+    }
+    //Otherwise take the supported media range of the Accept header with
+    //the highest q-value. With equal values, the first one wins
+    size_t pos = HttpServer::findHeader(req, "Accept:");
+    if (pos == string::npos) {
+        return format;
+    }
+    std::stringstream accept(req.substr(pos, req.find("\r\n", pos) - pos));
+    string range;
+    double bestq = 0;
+    while (std::getline(accept, range, ',')) {
+        size_t param = range.find(';');
+        string type = range.substr(0, param);
+        double q = 1;
+        while (param != string::npos) {
+            size_t next = range.find(';', param + 1);
+            string p = _trim(range.substr(param + 1, next == string::npos ?
+                        string::npos : next - param - 1));
+            if (p.size() > 2 && (p[0] == 'q' || p[0] == 'Q') && p[1] == '=') {
+                q = atof(p.c_str() + 2);
+            }
+            param = next;
+        }
+        SPARQLResultsWriter::Format f;
+        if (q > bestq && _getFormatOfType(type, f)) {
+            bestq = q;
+            format = f;
+        }
+    }
+    return format;
+}
+
+void TridentServer::processRequest(std::string req, std::string &res,
+        HttpChunkedWriter &writer) {
     setActive();
     //Get the page
     string page;
@@ -91,6 +162,12 @@ void TridentServer::processRequest(std::string req, std::string &res) {
             string form = req.substr(req.find("application/x-www-form-urlencoded"));
             string printresults = _getValueParam(form, "print");
             string sparqlquery = _getValueParam(form, "query");
+            //The request can use fewer threads than the server allows
+            int threads = queryThreads;
+            string sthreads = _getValueParam(form, "threads");
+            if (sthreads != "") {
+                threads = std::max(1, std::min(queryThreads, atoi(sthreads.c_str())));
+            }
             sparqlquery = HttpClient::unescape(sparqlquery);
             std::regex e1("\\+");
             std::string replacedString;
@@ -110,6 +187,25 @@ void TridentServer::processRequest(std::string req, std::string &res) {
             JSON bindings;
             JSON stats;
             bool jsonoutput = printresults != string("false");
+            if (jsonoutput) {
+                //Stream the results while they are produced
+                SPARQLResultsWriter results(writer, getFormat(req, form));
+                SPARQLUtils::execSPARQLQuery(sparqlquery,
+                        false,
+                        kb.getNTerms(),
+                        kb,
+                        false,
+                        jsonoutput,
+                        &vars,
+                        &bindings,
+                        &stats,
+                        threads,
+                        &planCache,
+                        &results);
+                results.end(&stats);
+                setInactive();
+                return;
+            }
             SPARQLUtils::execSPARQLQuery(sparqlquery,
                     false,
                     kb.getNTerms(),
@@ -118,7 +214,9 @@ void TridentServer::processRequest(std::string req, std::string &res) {
                     jsonoutput,
                     &vars,
                     &bindings,
-                    &stats);
+                    &stats,
+                    threads,
+                    &planCache);
             JSON head;
             head.add_child("vars", vars);
             pt.add_child("head", head);
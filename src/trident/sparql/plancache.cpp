@@ -0,0 +1,190 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/sparql/plancache.h>
+
+#include <sstream>
+
+bool PlanCache::isSimpleGraph(const QueryGraph &graph) {
+    const QueryGraph::SubQuery &query = graph.getQuery();
+    return query.filters.empty() && query.optional.empty() &&
+        query.unions.empty() && query.tableFunctions.empty() &&
+        query.subqueries.empty() && query.minuses.empty() &&
+        query.valueNodes.empty() &&
+        graph.c_getGlobalAssignments().empty() &&
+        graph.getGroupBy().empty() && graph.getHavings().empty() &&
+        graph.c_getAggredateHandler().empty();
+}
+
+bool PlanCache::getKey(const QueryGraph &graph, std::string &key) {
+    if (graph.knownEmpty() || !isSimpleGraph(graph)) {
+        return false;
+    }
+    //The constants are left out. Everything else that the plan depends
+    //on is in the key
+    std::ostringstream out;
+    for (const auto &node : graph.getQuery().nodes) {
+        out << (node.constSubject ? "c" : "v" + std::to_string(node.subject));
+        out << " ";
+        out << (node.constPredicate ? "c" : "v" + std::to_string(node.predicate));
+        out << " ";
+        out << (node.constObject ? "c" : "v" + std::to_string(node.object));
+        out << ";";
+    }
+    out << "|";
+    for (QueryGraph::projection_iterator itr = graph.projectionBegin();
+            itr != graph.projectionEnd(); ++itr) {
+        out << *itr << " ";
+    }
+    out << "|";
+    for (QueryGraph::order_iterator itr = graph.orderBegin();
+            itr != graph.orderEnd(); ++itr) {
+        out << itr->id << (itr->descending ? "d " : "a ");
+    }
+    out << "|" << (int) graph.getDuplicateHandling() << "|" <<
+        graph.getLimit() << "|" << graph.getOffset();
+    key = out.str();
+    return true;
+}
+
+bool PlanCache::canCache(const Plan *plan) {
+    if (plan == NULL) {
+        return true;
+    }
+    switch (plan->op) {
+        case Plan::IndexScan:
+        case Plan::AggregatedIndexScan:
+        case Plan::FullyAggregatedIndexScan:
+            return true;
+        case Plan::NestedLoopJoin:
+        case Plan::MergeJoin:
+        case Plan::HashJoin:
+        case Plan::CartProd:
+            return canCache(plan->left) && canCache(plan->right);
+        case Plan::HashGroupify:
+            return canCache(plan->left);
+        default:
+            //The other operators point to parts of the graph that are
+            //not moved by copyPlan
+            return false;
+    }
+}
+
+Plan *PlanCache::copyPlan(const Plan *plan, const QueryGraph &from,
+        const QueryGraph &to, PlanContainer &container) {
+    if (plan == NULL) {
+        return NULL;
+    }
+    Plan *copy = container.alloc();
+    *copy = *plan;
+    copy->next = NULL;
+    switch (plan->op) {
+        case Plan::IndexScan:
+        case Plan::AggregatedIndexScan:
+        case Plan::FullyAggregatedIndexScan: {
+            //The scans point to a node of the graph
+            const QueryGraph::Node *node =
+                reinterpret_cast<const QueryGraph::Node*>(plan->right);
+            const size_t idx = node - &from.getQuery().nodes[0];
+            copy->right = reinterpret_cast<Plan*>(
+                    const_cast<QueryGraph::Node*>(&to.getQuery().nodes[idx]));
+            break;
+        }
+        case Plan::HashGroupify:
+            copy->left = copyPlan(plan->left, from, to, container);
+            break;
+        default:
+            copy->left = copyPlan(plan->left, from, to, container);
+            copy->right = copyPlan(plan->right, from, to, container);
+            break;
+    }
+    return copy;
+}
+
+Plan *PlanCache::rebind(const Entry &entry, const QueryGraph &graph,
+        PlanContainer &container) {
+    return copyPlan(entry.plan, *entry.graph, graph, container);
+}
+
+void PlanCache::checkVersion(const uint64_t version) {
+    if (version != kbVersion) {
+        entries.clear();
+        index.clear();
+        kbVersion = version;
+    }
+}
+
+std::shared_ptr<const PlanCache::Entry> PlanCache::get(const std::string &key,
+        const uint64_t version) {
+    std::lock_guard<std::mutex> guard(lock);
+    checkVersion(version);
+    auto itr = index.find(key);
+    if (itr == index.end()) {
+        misses++;
+        return std::shared_ptr<const Entry>();
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, itr->second);
+    return itr->second->second;
+}
+
+void PlanCache::put(const std::string &key, const uint64_t version,
+        std::shared_ptr<const Entry> entry) {
+    std::lock_guard<std::mutex> guard(lock);
+    checkVersion(version);
+    if (maxEntries == 0) {
+        return;
+    }
+    auto itr = index.find(key);
+    if (itr != index.end()) {
+        itr->second->second = entry;
+        entries.splice(entries.begin(), entries, itr->second);
+        return;
+    }
+    entries.push_front(std::make_pair(key, entry));
+    index.insert(std::make_pair(key, entries.begin()));
+    while (entries.size() > maxEntries) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+void PlanCache::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    entries.clear();
+    index.clear();
+}
+
+size_t PlanCache::size() {
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+}
+
+uint64_t PlanCache::getHits() {
+    std::lock_guard<std::mutex> guard(lock);
+    return hits;
+}
+
+uint64_t PlanCache::getMisses() {
+    std::lock_guard<std::mutex> guard(lock);
+    return misses;
+}
@@ -8,6 +8,7 @@
 #include <rts/operator/Operator.hpp>
 #include <rts/operator/PlanPrinter.hpp>
 #include <rts/operator/ResultsPrinter.hpp>
+#include <rts/operator/Scheduler.hpp>
 
 void SPARQLUtils::parseQuery(bool &success,
         SPARQLParser &parser,
@@ -44,100 +45,153 @@ void SPARQLUtils::parseQuery(bool &success,
     return;
 }
 
-void SPARQLUtils::execSPARQLQuery(string sparqlquery,
-        bool explain,
+std::shared_ptr<SPARQLUtils::PreparedQuery> SPARQLUtils::prepareQuery(
+        string sparqlquery,
         int64_t nterms,
         TridentLayer &db,
-        bool printstdout,
-        bool jsonoutput,
-        JSON *jsonvars,
-        JSON *jsonresults,
-        JSON *jsonstats) {
-    std::unique_ptr<QueryDict> queryDict = std::unique_ptr<QueryDict>(
-            new QueryDict(nterms));
+        PlanCache *cache) {
+    std::shared_ptr<PreparedQuery> query(new PreparedQuery());
+    query->queryDict = std::unique_ptr<QueryDict>(new QueryDict(nterms));
     std::unique_ptr<QueryGraph> queryGraph;
     bool parsingOk;
 
-    std::unique_ptr<SPARQLLexer> lexer =
-        std::unique_ptr<SPARQLLexer>(new SPARQLLexer(sparqlquery));
-    std::unique_ptr<SPARQLParser> parser = std::unique_ptr<SPARQLParser>(
-            new SPARQLParser(*lexer.get()));
-    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-    parseQuery(parsingOk, *parser.get(), queryGraph, *queryDict.get(), db);
+    SPARQLLexer lexer(sparqlquery);
+    SPARQLParser parser(lexer);
+    parseQuery(parsingOk, parser, queryGraph, *query->queryDict.get(), db);
     if (!parsingOk) {
+        return query;
+    }
+    query->parsed = true;
+    query->queryGraph = std::shared_ptr<QueryGraph>(queryGraph.release());
+    for (QueryGraph::projection_iterator itr = query->queryGraph->projectionBegin();
+            itr != query->queryGraph->projectionEnd(); ++itr) {
+        query->variables.push_back(parser.getVariableName(*itr));
+    }
+
+    //Re-use the plan of a query with the same shape
+    std::string key;
+    const uint64_t version = db.getKB()->getUpdateVersion();
+    const bool cacheable = cache && PlanCache::getKey(*query->queryGraph.get(), key);
+    if (cacheable) {
+        std::shared_ptr<const PlanCache::Entry> entry = cache->get(key, version);
+        if (entry) {
+            query->plan = PlanCache::rebind(*entry.get(),
+                    *query->queryGraph.get(), query->cachedPlans);
+            query->cachedPlan = true;
+            return query;
+        }
+    }
+
+    // Run the optimizer
+    query->plangen = std::shared_ptr<PlanGen>(new PlanGen());
+    query->plan = query->plangen->translate(db, *query->queryGraph.get(), false);
+    if (!query->plan) {
+        cerr << "internal error plan generation failed" << endl;
+        return query;
+    }
+    if (cacheable && PlanCache::canCache(query->plan)) {
+        std::shared_ptr<PlanCache::Entry> entry(new PlanCache::Entry());
+        entry->graph = query->queryGraph;
+        entry->plangen = query->plangen;
+        entry->plan = query->plan;
+        cache->put(key, version, entry);
+    }
+    return query;
+}
+
+void SPARQLUtils::execPreparedQuery(PreparedQuery &query,
+        TridentLayer &db,
+        bool printstdout,
+        bool jsonoutput,
+        JSON *jsonvars,
+        JSON *jsonresults,
+        JSON *jsonstats,
+        unsigned threads,
+        ResultsWriter *writer,
+        std::chrono::system_clock::time_point start) {
+    if (!query.isParsed()) {
         std::chrono::duration<double> duration = std::chrono::system_clock::now() - start;
         LOG(INFOL) << "Runtime query: 0ms.";
         LOG(INFOL) << "Runtime total: " << duration.count() * 1000 << "ms.";
         LOG(INFOL) << "# rows = 0";
         return;
     }
-
-    std::vector<string> jsonnamevars;
     if (jsonvars) {
-        //Copy the output of the query in the json vars
-        for (QueryGraph::projection_iterator itr = queryGraph->projectionBegin();
-                itr != queryGraph->projectionEnd(); ++itr) {
-            string namevar = parser->getVariableName(*itr);
+        for (const auto &namevar : query.variables) {
             jsonvars->push_back(namevar);
-            jsonnamevars.push_back(namevar);
         }
     }
-
-    // Run the optimizer
-    PlanGen *plangen = new PlanGen();
-    Plan* plan = plangen->translate(db, *queryGraph.get(), false);
-    // delete plangen;  Commented out, because this also deletes all plans!
-    // In particular, it corrupts the current plan.
-    // --Ceriel
-    if (!plan) {
-        cerr << "internal error plan generation failed" << endl;
-        delete plangen;
+    if (!query.isPlanned()) {
+        if (writer) {
+            writer->begin(query.variables);
+        }
         return;
     }
-    if (explain)
-        plan->print(0);
 
     // Build a physical plan
-    Runtime runtime(db, NULL, queryDict.get());
-    Operator* operatorTree = CodeGen().translate(runtime, *queryGraph.get(), plan, false);
-
-    // Execute it
-    if (explain) {
-        DebugPlanPrinter out(runtime, false);
-        operatorTree->print(out);
-        delete operatorTree;
-    } else {
+    Runtime runtime(db, NULL, query.queryDict.get());
+    Operator* operatorTree = CodeGen().translate(runtime, *query.queryGraph.get(),
+            query.plan, false);
 #if DEBUG
-        DebugPlanPrinter out(runtime, false);
-        operatorTree->print(out);
+    DebugPlanPrinter out(runtime, false);
+    operatorTree->print(out);
 #endif
-        //set up output options for the last operators
-        ResultsPrinter *p = (ResultsPrinter*) operatorTree;
-        p->setSilent(!printstdout);
-        if (jsonoutput) {
-            p->setJSONOutput(jsonresults, jsonnamevars);
-        }
-
-        std::chrono::system_clock::time_point startQ = std::chrono::system_clock::now();
-        if (operatorTree->first()) {
-            while (operatorTree->next());
-        }
-        std::chrono::duration<double> durationQ = std::chrono::system_clock::now() - startQ;
-        std::chrono::duration<double> duration = std::chrono::system_clock::now() - start;
-        LOG(INFOL) << "Runtime query: " << durationQ.count() * 1000 << "ms.";
-        LOG(INFOL) << "Runtime total: " << duration.count() * 1000 << "ms.";
-        if (jsonstats) {
-            jsonstats->put("runtime", to_string(durationQ.count()));
-            jsonstats->put("nresults", to_string(p->getPrintedRows()));
+    //set up output options for the last operators
+    ResultsPrinter *p = (ResultsPrinter*) operatorTree;
+    p->setSilent(!printstdout);
+    if (writer) {
+        //The rows are sent to the writer, instead of being collected
+        p->setStreamOutput(writer, query.variables);
+    } else if (jsonoutput) {
+        p->setJSONOutput(jsonresults, query.variables);
+    }
 
-        }
-        if (printstdout) {
-            uint64_t nElements = p->getPrintedRows();
-            LOG(INFOL) << "# rows = " << nElements;
-        }
-        delete operatorTree;
+    std::chrono::system_clock::time_point startQ = std::chrono::system_clock::now();
+    //The hash tables are built by up to "threads" threads
+    Scheduler scheduler(threads);
+    scheduler.execute(operatorTree);
+    std::chrono::duration<double> durationQ = std::chrono::system_clock::now() - startQ;
+    std::chrono::duration<double> duration = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Runtime query: " << durationQ.count() * 1000 << "ms.";
+    LOG(INFOL) << "Runtime total: " << duration.count() * 1000 << "ms.";
+    if (jsonstats) {
+        jsonstats->put("runtime", to_string(durationQ.count()));
+        jsonstats->put("nresults", to_string(p->getPrintedRows()));
+        jsonstats->put("cachedplan", query.isPlanCached() ? "true" : "false");
+    }
+    if (printstdout) {
+        uint64_t nElements = p->getPrintedRows();
+        LOG(INFOL) << "# rows = " << nElements;
     }
-    delete plangen;
+    delete operatorTree;
 }
 
+void SPARQLUtils::execSPARQLQuery(string sparqlquery,
+        bool explain,
+        int64_t nterms,
+        TridentLayer &db,
+        bool printstdout,
+        bool jsonoutput,
+        JSON *jsonvars,
+        JSON *jsonresults,
+        JSON *jsonstats,
+        unsigned threads,
+        PlanCache *cache,
+        ResultsWriter *writer) {
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    std::shared_ptr<PreparedQuery> query = prepareQuery(sparqlquery, nterms,
+            db, cache);
 
+    if (explain && query->isPlanned()) {
+        query->plan->print(0);
+        Runtime runtime(db, NULL, query->queryDict.get());
+        Operator* operatorTree = CodeGen().translate(runtime,
+                *query->queryGraph.get(), query->plan, false);
+        DebugPlanPrinter out(runtime, false);
+        operatorTree->print(out);
+        delete operatorTree;
+    } else if (!explain) {
+        execPreparedQuery(*query.get(), db, printstdout, jsonoutput, jsonvars,
+                jsonresults, jsonstats, threads, writer, start);
+    }
+}
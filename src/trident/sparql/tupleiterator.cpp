@@ -94,6 +94,13 @@ void TupleKBItr::init(Querier *querier, const Tuple *t,
     nextProcessed = false;
     nextOutcome = false;
     processedValues = 0;
+    if (!batch) {
+        batch = std::unique_ptr<int64_t[]>(new int64_t[ITR_BATCH_SIZE * 3]);
+        batchValues[0] = batch.get();
+        batchValues[1] = batchValues[0] + ITR_BATCH_SIZE;
+        batchValues[2] = batchValues[1] + ITR_BATCH_SIZE;
+    }
+    batchSize = batchPos = 0;
 
     //If some variables have the same name, then we must change it
     equalFields = t->getRepeatedVars();
@@ -113,23 +120,27 @@ bool TupleKBItr::checkFields() {
     return true;
 }
 
+bool TupleKBItr::advance() {
+    if (batchPos + 1 < batchSize) {
+        batchPos++;
+        return true;
+    }
+    batchSize = physIterator->nextBatch(batchValues[0], batchValues[1],
+            batchValues[2], ITR_BATCH_SIZE);
+    batchPos = 0;
+    return batchSize > 0;
+}
+
 bool TupleKBItr::hasNext() {
     if (!nextProcessed) {
-        if (physIterator->hasNext()) {
-            physIterator->next();
-            nextOutcome = true;
-            if (equalFields.size() > 0) {
-                while (!checkFields()) {
-                    if (!physIterator->hasNext()) {
-                        nextOutcome = false;
-                        break;
-                    } else {
-                        physIterator->next();
-                    }
+        nextOutcome = advance();
+        if (nextOutcome && equalFields.size() > 0) {
+            while (!checkFields()) {
+                if (!advance()) {
+                    nextOutcome = false;
+                    break;
                 }
             }
-        } else {
-            nextOutcome = false;
         }
         nextProcessed = true;
     }
@@ -140,7 +151,7 @@ void TupleKBItr::next() {
     if (nextProcessed) {
         nextProcessed = false;
     } else {
-        physIterator->next();
+        advance();
     }
 }
 
@@ -151,13 +162,8 @@ size_t TupleKBItr::getTupleSize() {
 uint64_t TupleKBItr::getElementAt(const int p) {
     const uint8_t pos = onlyVars ? varsPos[p] : (uint8_t) invPerm[p];
 
-    switch (pos) {
-    case 0:
-        return physIterator->getKey();
-    case 1:
-        return physIterator->getValue1();
-    case 2:
-        return physIterator->getValue2();
+    if (pos < 3) {
+        return batchValues[pos][batchPos];
     }
     LOG(ERRORL) << "This should not happen";
     throw 10;
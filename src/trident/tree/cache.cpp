@@ -33,7 +33,7 @@ using namespace std;
 
 void Cache::init(TreeContext *context, std::string path, int fileMaxSize,
         int maxNFiles, int64_t cacheMaxSize, int sizeLeavesFactory,
-        int sizePreallLeavesFactory, int nodeMinBytes) {
+        int sizePreallLeavesFactory, int nodeMinBytes, int mappingHints) {
     //      LOG(DEBUGL) << "file_max_size: " << fileMaxSize << " cache_max_size: " << cacheMaxSize << " size_leaf_factory: " << sizeLeavesFactory <<
     //      " preall: " << sizePreallLeavesFactory <<
     //      " nodes_min_bytes: " << nodeMinBytes;
@@ -42,7 +42,7 @@ void Cache::init(TreeContext *context, std::string path, int fileMaxSize,
     this->factory = new LeafFactory(context, sizePreallLeavesFactory,
             sizeLeavesFactory);
     this->manager = new NodeManager(context, nodeMinBytes, fileMaxSize,
-            maxNFiles, cacheMaxSize, path);
+            maxNFiles, cacheMaxSize, path, mappingHints);
 }
 
 Node *Cache::getNodeFromCache(int64_t id) {
@@ -115,12 +115,36 @@ void Cache::registerNode(Node *node) {
         registeredNodes.pop_front();
 
         if (n->getParent() != NULL) {
+#ifdef MT
+            if (context->isReadOnly()) {
+                retireNode(n);
+            } else {
+                flushNode(n, true);
+            }
+#else
             flushNode(n, true);
+#endif
         }
     }
     registeredNodes.push_back(node);
 }
 
+#ifdef MT
+void Cache::retireNode(Node *node) {
+    //Lookups on a read-only tree do not lock, so other threads might still
+    //be reading the leaf. It is unlinked now and reused only when all
+    //readers that could have seen it are gone.
+    node->getParent()->cacheChild(node);
+    EpochManager &epochs = context->getEpochs();
+    epochs.retire(node);
+    epochs.collect(reclaimed);
+    for (auto n : reclaimed) {
+        factory->release((Leaf *) n);
+    }
+    reclaimed.clear();
+}
+#endif
+
 void Cache::flushAllCache() {
     while (!registeredNodes.empty()) {
         Node *n = registeredNodes.front();
@@ -136,3 +160,27 @@ IntermediateNode *Cache::newIntermediateNode() {
 IntermediateNode *Cache::newIntermediateNode(Node *child1, Node *child2) {
     return new IntermediateNode(context, child1, child2);
 }
+
+Cache::~Cache() {
+    Node *node = NULL;
+    while (!registeredNodes.empty()) {
+        node = registeredNodes.front();
+        registeredNodes.pop_front();
+        if (node->shouldDeallocate())
+            delete node;
+    }
+    registeredNodes.clear();
+
+#ifdef MT
+    if (context != NULL) {
+        context->getEpochs().collectAll(reclaimed);
+        for (auto n : reclaimed) {
+            factory->release((Leaf *) n);
+        }
+        reclaimed.clear();
+    }
+#endif
+
+    delete factory;
+    delete manager;
+}
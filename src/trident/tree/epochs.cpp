@@ -0,0 +1,93 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/tree/epochs.h>
+
+#include <thread>
+
+EpochManager::EpochManager() : globalEpoch(1) {
+    for (int i = 0; i < EPOCH_MAX_READERS; ++i) {
+        slots[i].epoch.store(0);
+    }
+}
+
+int EpochManager::enter() {
+    //Every thread starts from its own slot, so that normally the first CAS
+    //succeeds and threads do not write on the same cache line
+    static std::atomic<int> threadCounter(0);
+    static thread_local int hint = threadCounter.fetch_add(1) %
+        EPOCH_MAX_READERS;
+
+    int i = hint;
+    int attempts = 0;
+    while (true) {
+        const uint64_t e = globalEpoch.load();
+        uint64_t expected = 0;
+        if (slots[i].epoch.compare_exchange_strong(expected, e)) {
+            //Orders the following loads of the tree after the announcement
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            hint = i;
+            return i;
+        }
+        i = (i + 1) % EPOCH_MAX_READERS;
+        if (++attempts == EPOCH_MAX_READERS) {
+            attempts = 0;
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint64_t EpochManager::minActiveEpoch() {
+    uint64_t min = globalEpoch.load();
+    for (int i = 0; i < EPOCH_MAX_READERS; ++i) {
+        const uint64_t e = slots[i].epoch.load();
+        if (e != 0 && e < min) {
+            min = e;
+        }
+    }
+    return min;
+}
+
+void EpochManager::retire(Node *node) {
+    //The node was unlinked before. Readers that enter from now on get the
+    //new epoch and cannot find it anymore.
+    const uint64_t e = globalEpoch.fetch_add(1);
+    retired.push_back(std::make_pair(e, node));
+}
+
+void EpochManager::collect(std::vector<Node*> &out) {
+    if (retired.empty()) {
+        return;
+    }
+    const uint64_t min = minActiveEpoch();
+    while (!retired.empty() && retired.front().first < min) {
+        out.push_back(retired.front().second);
+        retired.pop_front();
+    }
+}
+
+void EpochManager::collectAll(std::vector<Node*> &out) {
+    while (!retired.empty()) {
+        out.push_back(retired.front().second);
+        retired.pop_front();
+    }
+}
@@ -1,10 +1,12 @@
 #include <trident/tree/flatroot.h>
 #include <trident/tree/flattreeitr.h>
 #include <trident/binarytables/storagestrat.h>
+#include <trident/files/mappingpolicy.h>
 
 FlatRoot::FlatRoot(string path, bool unlabeled, bool undirected) :
     unlabeled(unlabeled), undirected(undirected) {
-        file = std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(path, true));
+        file = std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(path, true,
+                    MappingPolicy::getIndexFlags()));
         raw = file->getData();
         len = file->getLength();
         if (unlabeled) {
@@ -29,9 +29,23 @@
 #include <iostream>
 #include <assert.h>
 #include <mutex>
+#include <atomic>
 
 #define CHILD_NOT_FOUND -1
 
+//The children of a read-only tree are loaded and evicted while other
+//threads traverse the node without locks. The pointers are published with
+//release semantics and read with acquire semantics.
+static inline Node *loadChild(Node **slot) {
+    return reinterpret_cast<std::atomic<Node*>*>(slot)->load(
+            std::memory_order_acquire);
+}
+
+static inline void publishChild(Node **slot, Node *child) {
+    reinterpret_cast<std::atomic<Node*>*>(slot)->store(child,
+            std::memory_order_release);
+}
+
 IntermediateNode::IntermediateNode(TreeContext *context, Node *child1,
         Node *child2) :
     Node(context) {
@@ -93,13 +107,11 @@ Node *IntermediateNode::getChildForKey(int64_t key) {
     if (p < 0) {
         p = -p - 1;
     }
-    ensureChildIsLoaded(p);
-    return children[p];
+    return ensureChildIsLoaded(p);
 }
 
 Node *IntermediateNode::getChildAtPos(int p) {
-    ensureChildIsLoaded(p);
-    return children[p];
+    return ensureChildIsLoaded(p);
 }
 
 int IntermediateNode::getPosChild(Node *child) {
@@ -127,23 +139,19 @@ int IntermediateNode::getPosChild(Node *child) {
 }
 
 int64_t IntermediateNode::smallestNumericKey() {
-    ensureChildIsLoaded(0);
-    return children[0]->smallestNumericKey();
+    return ensureChildIsLoaded(0)->smallestNumericKey();
 }
 
 int64_t IntermediateNode::largestNumericKey() {
-    ensureChildIsLoaded(getCurrentSize());
-    return children[getCurrentSize()]->largestNumericKey();
+    return ensureChildIsLoaded(getCurrentSize())->largestNumericKey();
 }
 
 tTerm *IntermediateNode::smallestTextualKey(int *size) {
-    ensureChildIsLoaded(0);
-    return children[0]->smallestTextualKey(size);
+    return ensureChildIsLoaded(0)->smallestTextualKey(size);
 }
 
 tTerm *IntermediateNode::largestTextualKey(int *size) {
-    ensureChildIsLoaded(getCurrentSize());
-    return children[getCurrentSize()]->largestTextualKey(size);
+    return ensureChildIsLoaded(getCurrentSize())->largestTextualKey(size);
 }
 
 void IntermediateNode::cacheChild(Node *child) {
@@ -152,8 +160,10 @@ void IntermediateNode::cacheChild(Node *child) {
         LOG(ERRORL) << "Child: " << child->getId() << " is not found on node " << getId();
         LOG(ERRORL) << "CacheChild(): Position not found!";
     }
-    children[p] = NULL;
     idChildren[p] = child->getId();
+    //Sequentially consistent, so that readers that entered an epoch after
+    //the node was retired cannot see it (see EpochManager)
+    reinterpret_cast<std::atomic<Node*>*>(children + p)->store(NULL);
     lastUpdatedChild = p;
 }
 
@@ -162,8 +172,7 @@ bool IntermediateNode::get(tTerm *key, const int sizeKey, nTerm *value) {
     if (p < 0) {
         p = -p - 1;
     }
-    ensureChildIsLoaded(p);
-    return children[p]->get(key, sizeKey, value);
+    return ensureChildIsLoaded(p)->get(key, sizeKey, value);
 }
 
 //bool IntermediateNode::get(nTerm key, tTerm *container) {
@@ -179,8 +188,7 @@ bool IntermediateNode::get(nTerm key, int64_t &coordinates) {
     if (p < 0) {
         p = -p - 1;
     }
-    ensureChildIsLoaded(p);
-    return children[p]->get(key, coordinates);
+    return ensureChildIsLoaded(p)->get(key, coordinates);
 }
 
 bool IntermediateNode::get(nTerm key, TermCoordinates *value) {
@@ -188,8 +196,7 @@ bool IntermediateNode::get(nTerm key, TermCoordinates *value) {
     if (p < 0) {
         p = -p - 1;
     }
-    ensureChildIsLoaded(p);
-    return children[p]->get(key, value);
+    return ensureChildIsLoaded(p)->get(key, value);
 }
 
 void numAvg(Node *parent, int p, Node *child1, Node *child2) {
@@ -391,21 +398,28 @@ Node *IntermediateNode::putOrGet(tTerm *key, int sizeKey, nTerm &value,
     }
 }
 
-void IntermediateNode::ensureChildIsLoaded(int p) {
-    if (children[p] == NULL) {
+Node *IntermediateNode::ensureChildIsLoaded(int p) {
+    //Fast path: the child is already there and no lock is needed. The
+    //pointer is returned because the child might be evicted by another
+    //thread right after (it remains valid until the reader exits its epoch)
+    Node *child = loadChild(children + p);
+    if (child == NULL) {
 #ifdef MT
         std::recursive_mutex &mutex = getContext()->getMutex();
         std::unique_lock<std::recursive_mutex> lock(mutex);
-        if (children[p] == NULL) {
+        child = children[p];
+        if (child == NULL) {
 #endif
-            children[p] = getContext()->getCache()->getNodeFromCache(idChildren[p]);
-            children[p]->setParent(this);
-            getContext()->getCache()->registerNode(children[p]);
+            child = getContext()->getCache()->getNodeFromCache(idChildren[p]);
+            child->setParent(this);
+            publishChild(children + p, child);
+            getContext()->getCache()->registerNode(child);
 #ifdef MT
         }
         lock.unlock();
 #endif
     }
+    return child;
 }
 
 Node *IntermediateNode::getChild(const int p) {
@@ -417,8 +431,7 @@ Node *IntermediateNode::getChildForKey(tTerm *key, const int sizeKey) {
     if (p < 0) {
         p = -p - 1;
     }
-    ensureChildIsLoaded(p);
-    return children[p];
+    return ensureChildIsLoaded(p);
 }
 
 IntermediateNode::~IntermediateNode() {
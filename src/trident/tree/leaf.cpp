@@ -648,10 +648,6 @@ const char NCOMBS[64] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2
 //const uint8_t COMBS[29] = {0, 1, 2, 0, 2, 0, 3, 1, 4, 2, 5, 0, 1, 3, 4, 1, 2, 4, 5, 0, 2, 3, 5, 0, 1, 2, 3, 4, 5};
 
 Coordinates *Leaf::parseInternalLine(const int pos) {
-#ifdef MT
-        std::recursive_mutex &mutex = getContext()->getMutex();
-        std::unique_lock<std::recursive_mutex> lock(mutex);
-#endif
 
     unsigned char permutations = rawNode[pos];
     int startPos = (unsigned short) Utils::decode_short((const char*)rawNode,
@@ -697,13 +693,32 @@ Coordinates *Leaf::parseInternalLine(const int pos) {
         }
     }
 
-#ifdef MT
-        lock.unlock();
-#endif
-
     return first;
 }
 
+void Leaf::decodeInternalLine(const int pos, TermCoordinates *value) {
+    value->clear();
+    unsigned char permutations = rawNode[pos];
+    int startPos = (unsigned short) Utils::decode_short((const char*)rawNode,
+                   getCurrentSize() + pos * 2);
+    startPos += getCurrentSize() * 3;
+
+    int idx = 0;
+    for (int i = 0; i < NCOMBS[(int)rawNode[pos]]; ++i) {
+        const int64_t nElements = Utils::decode_vlong2(rawNode, &startPos);
+        const short file = (uint16_t) Utils::decode_vint2(rawNode, &startPos);
+        const int64_t posInFile = Utils::decode_vlong2(rawNode, &startPos);
+        const char strategy = rawNode[startPos++];
+        while (!(permutations & 1)) {
+            permutations >>= 1;
+            idx++;
+        }
+        value->set(idx, file, posInFile, nElements, strategy);
+        permutations >>= 1;
+        idx++;
+    }
+}
+
 int64_t Leaf::getKey(int pos) {
     return keyAt(pos);
 }
@@ -725,6 +740,14 @@ tTerm *Leaf::largestTextualKey(int *size) {
 }
 
 void Leaf::getValueAtPos(int pos, TermCoordinates * value) {
+    if (getContext()->isReadOnly()) {
+        //The node is immutable. Decoding the line again is cheap and does
+        //not need to lock the factories or to publish the parsed line to
+        //the other readers.
+        decodeInternalLine(pos, value);
+        return;
+    }
+
     Coordinates *el = NULL;
 
     if (pos >= getContext()->getMinElementsPerNode()) {
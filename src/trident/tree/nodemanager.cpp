@@ -30,7 +30,8 @@ char one[1] = { 1 };
 char zero[1] = { 0 };
 
 NodeManager::NodeManager(TreeContext *context, int nodeMinBytes,
-        int fileMaxSize, int maxNFiles, int64_t cacheMaxSize, std::string path) :
+        int fileMaxSize, int maxNFiles, int64_t cacheMaxSize, std::string path,
+        int mappingHints) :
     readOnly(context->isReadOnly()), path(path), nodeMinSize(nodeMinBytes) {
         lastNodeInserted = NULL;
 
@@ -47,10 +48,21 @@ NodeManager::NodeManager(TreeContext *context, int nodeMinBytes,
                 }
             }
         }
-        bytesTracker = new MemoryManager<FileDescriptor>(cacheMaxSize);
+        //The lookups on a read-only tree read the mapped files without
+        //pinning them (see Root::get), so these files are never unmapped
+        //while the tree is open
+        if (readOnly) {
+            bytesTracker = NULL;
+        } else {
+            bytesTracker = new MemoryManager<FileDescriptor>(cacheMaxSize);
+        }
         this->manager = new FileManager<FileDescriptor, FileDescriptor>(path,
                 context->isReadOnly(), fileMaxSize, maxNFiles, lastCreatedFile,
                 bytesTracker, NULL);
+        if (readOnly && mappingHints != 0) {
+            manager->setAdvice(mappingHints);
+            manager->setPopulate(mappingHints & MAPPING_POPULATE);
+        }
 
         //Init storedNodes and firstElementPerFile
         string file = path + DIR_SEP + string("idx");
@@ -74,7 +86,8 @@ NodeManager::NodeManager(TreeContext *context, int nodeMinBytes,
         } else {
             //Load the nodes in the array
             if (Utils::exists(file) && Utils::fileSize(file) > 0) {
-                mappedFile = std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(file));
+                mappedFile = std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(
+                            file, true, mappingHints));
                 rawInput = mappedFile->getData();
 
                 int nNodes = Utils::decode_int(rawInput, 0);
@@ -72,7 +72,8 @@ Root::Root(string path, StringBuffer *buffer, bool readOnly, PropertyMap &conf)
         cache->init(context, path, conf.getInt(FILE_MAX_SIZE, 64 * 1024 * 1024),
                 conf.getInt(MAX_N_OPENED_FILES, 2), conf.getLong(CACHE_MAX_SIZE, 32 * 1024 * 1024),
                 conf.getInt(LEAF_SIZE_FACTORY, 1),
-                conf.getInt(LEAF_SIZE_PREALL_FACTORY, 10), conf.getInt(NODE_MIN_BYTES, 0));
+                conf.getInt(LEAF_SIZE_PREALL_FACTORY, 10), conf.getInt(NODE_MIN_BYTES, 0),
+                conf.getInt(MAPPING_HINTS, 0));
 
         // Check the directory to see whether the intermediate nodes are stored
         // on disk
@@ -104,6 +105,11 @@ Root::Root(string path, StringBuffer *buffer, bool readOnly, PropertyMap &conf)
     }
 
 bool Root::get(nTerm key, TermCoordinates *value) {
+#ifdef MT
+    //Lookups do not lock. The epoch prevents that the nodes we traverse are
+    //reused while we read them.
+    EpochGuard guard(context->getEpochs());
+#endif
     Node *node = rootNode;
     while (node->canHaveChildren()) {
         node = node->getChildForKey(key);
@@ -113,6 +119,9 @@ bool Root::get(nTerm key, TermCoordinates *value) {
 }
 
 bool Root::get(nTerm key, int64_t &coordinates) {
+#ifdef MT
+    EpochGuard guard(context->getEpochs());
+#endif
     Node *node = rootNode;
     while (node->canHaveChildren()) {
         node = node->getChildForKey(key);
@@ -121,6 +130,9 @@ bool Root::get(nTerm key, int64_t &coordinates) {
 }
 
 bool Root::get(tTerm *key, const int sizeKey, nTerm *value) {
+#ifdef MT
+    EpochGuard guard(context->getEpochs());
+#endif
     Node *node = rootNode;
     while (node->canHaveChildren()) {
         node = node->getChildForKey(key, sizeKey);
@@ -0,0 +1,273 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/tree/staticroot.h>
+#include <trident/tree/statictreeitr.h>
+#include <trident/tree/coordinates.h>
+#include <trident/files/mappingpolicy.h>
+#include <trident/utils/fixedbytes.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <cstring>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STATICTREE_X86 1
+#include <immintrin.h>
+#endif
+
+//Number of keys in the node that are not larger than key
+static inline int _countLE(const int64_t *node, const int64_t key) {
+    int c = 0;
+    for (int i = 0; i < STATICTREE_NODE_KEYS; ++i) {
+        c += node[i] <= key;
+    }
+    return c;
+}
+
+#ifdef STATICTREE_X86
+__attribute__((target("avx2")))
+static int _countLE_avx2(const int64_t *node, const int64_t key) {
+    const __m256i k = _mm256_set1_epi64x(key);
+    const __m256i a = _mm256_loadu_si256((const __m256i*) node);
+    const __m256i b = _mm256_loadu_si256((const __m256i*) (node + 4));
+    const int gt = _mm256_movemask_pd(_mm256_castsi256_pd(
+                _mm256_cmpgt_epi64(a, k))) |
+        (_mm256_movemask_pd(_mm256_castsi256_pd(
+                                _mm256_cmpgt_epi64(b, k))) << 4);
+    return STATICTREE_NODE_KEYS - __builtin_popcount(gt);
+}
+#endif
+
+StaticRoot::StaticRoot(string path) : useAVX2(FixedBytesDecoder::hasAVX2()) {
+    file = std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(path, true,
+                MappingPolicy::getIndexFlags()));
+    raw = file->getData();
+    int64_t header[STATICTREE_HEADER_SIZE / 8];
+    memcpy(header, raw, STATICTREE_HEADER_SIZE);
+    if (header[0] != STATICTREE_VERSION) {
+        LOG(ERRORL) << "The static tree " << path << " has an unknown format";
+        throw 10;
+    }
+    nKeys = header[1];
+    nLayers = (int) header[2];
+    offsets = raw + header[3];
+    records = raw + header[4];
+    const int64_t *nodes = (const int64_t*) (raw + STATICTREE_HEADER_SIZE);
+    for (int i = 0; i < nLayers; ++i) {
+        layers[i] = nodes + header[5 + i] * STATICTREE_NODE_KEYS;
+    }
+}
+
+int64_t StaticRoot::find(const nTerm key) const {
+    if (nKeys == 0) {
+        return -1;
+    }
+    int64_t j = 0;
+    int c;
+    for (int l = 0; l < nLayers; ++l) {
+        const int64_t *node = layers[l] + j * STATICTREE_NODE_KEYS;
+#ifdef STATICTREE_X86
+        c = useAVX2 ? _countLE_avx2(node, key) : _countLE(node, key);
+#else
+        c = _countLE(node, key);
+#endif
+        if (l < nLayers - 1) {
+            j = j * STATICTREE_FANOUT + c;
+        }
+    }
+    //j is the leaf. The key, if it exists, is the last one not larger
+    const int64_t pos = j * STATICTREE_NODE_KEYS + c - 1;
+    if (c > 0 && layers[nLayers - 1][pos] == key) {
+        return pos;
+    }
+    return -1;
+}
+
+void StaticRoot::readRecord(const char *record, TermCoordinates *value) {
+    value->clear();
+    const uint8_t mask = (uint8_t) record[0];
+    const char *p = record + 1;
+    for (int perm = 0; perm < N_PARTITIONS; ++perm) {
+        if (mask & (1 << perm)) {
+            int64_t nElements = 0, pos = 0;
+            short file;
+            memcpy(&nElements, p, 5);
+            memcpy(&file, p + 6, 2);
+            memcpy(&pos, p + 8, 5);
+            value->set(perm, file, pos, nElements, p[5]);
+            p += STATICTREE_PERM_SIZE;
+        }
+    }
+}
+
+bool StaticRoot::get(nTerm key, TermCoordinates *value) {
+    const int64_t pos = find(key);
+    if (pos == -1) {
+        return false;
+    }
+    uint64_t offset;
+    memcpy(&offset, offsets + pos * 8, 8);
+    readRecord(records + offset, value);
+    return true;
+}
+
+TreeItr *StaticRoot::itr() {
+    return new StaticTreeItr(nLayers > 0 ? layers[nLayers - 1] : NULL,
+            offsets, records, nKeys);
+}
+
+void StaticRoot::build(Root *root, string path) {
+    //First pass: count the keys and the size of the records
+    TermCoordinates coord;
+    int64_t nKeys = 0;
+    uint64_t sizeRecords = 0;
+    TreeItr *itr = root->itr();
+    while (itr->hasNext()) {
+        itr->next(&coord);
+        nKeys++;
+        sizeRecords++;
+        for (int perm = 0; perm < N_PARTITIONS; ++perm) {
+            if (coord.exists(perm)) {
+                sizeRecords += STATICTREE_PERM_SIZE;
+            }
+        }
+    }
+    delete itr;
+
+    //Size of the layers, from the leaves to the root
+    std::vector<int64_t> layerSizes;
+    if (nKeys > 0) {
+        layerSizes.push_back((nKeys + STATICTREE_NODE_KEYS - 1) /
+                STATICTREE_NODE_KEYS);
+        while (layerSizes.back() > 1) {
+            layerSizes.push_back((layerSizes.back() + STATICTREE_FANOUT - 1)
+                    / STATICTREE_FANOUT);
+        }
+    }
+    const int nLayers = layerSizes.size();
+    if (nLayers > STATICTREE_MAX_LAYERS) {
+        LOG(ERRORL) << "Too many keys to build a static tree";
+        throw 10;
+    }
+    int64_t header[STATICTREE_HEADER_SIZE / 8];
+    memset(header, 0, STATICTREE_HEADER_SIZE);
+    int64_t nNodes = 0;
+    for (int i = 0; i < nLayers; ++i) {
+        header[5 + i] = nNodes;
+        nNodes += layerSizes[nLayers - 1 - i];
+    }
+    header[0] = STATICTREE_VERSION;
+    header[1] = nKeys;
+    header[2] = nLayers;
+    header[3] = STATICTREE_HEADER_SIZE + nNodes * STATICTREE_NODE_KEYS * 8;
+    header[4] = header[3] + nKeys * 8;
+    const uint64_t size = header[4] + sizeRecords;
+
+    //The tree is written in a temporary file, so that an interrupted
+    //build is never opened
+    const string tmpPath = path + "-tmp";
+    {
+        ofstream ofs(tmpPath, ios_base::binary);
+        ofs.write((char*) header, STATICTREE_HEADER_SIZE);
+    }
+    Utils::resizeFile(tmpPath, size);
+    {
+        MemoryMappedFile mf(tmpPath, false);
+        char *out = mf.getData();
+        int64_t *nodes = (int64_t*) (out + STATICTREE_HEADER_SIZE);
+        int64_t *leaves = nLayers > 0 ? nodes + header[5 + nLayers - 1] *
+            STATICTREE_NODE_KEYS : NULL;
+        char *outOffsets = out + header[3];
+        char *outRecords = out + header[4];
+
+        //Second pass: write the leaves and the records
+        uint64_t offset = 0;
+        int64_t i = 0;
+        itr = root->itr();
+        while (itr->hasNext()) {
+            const int64_t key = itr->next(&coord);
+            if (i == nKeys || (i > 0 && key <= leaves[i - 1])) {
+                LOG(ERRORL) << "The tree changed while building the static tree";
+                throw 10;
+            }
+            leaves[i] = key;
+            memcpy(outOffsets + i * 8, &offset, 8);
+            char *p = outRecords + offset;
+            uint8_t mask = 0;
+            char *perms = p + 1;
+            for (int perm = 0; perm < N_PARTITIONS; ++perm) {
+                if (coord.exists(perm)) {
+                    mask |= 1 << perm;
+                    const int64_t nElements = coord.getNElements(perm);
+                    const short file = coord.getFileIdx(perm);
+                    const int64_t pos = coord.getMark(perm);
+                    memcpy(perms, &nElements, 5);
+                    perms[5] = coord.getStrategy(perm);
+                    memcpy(perms + 6, &file, 2);
+                    memcpy(perms + 8, &pos, 5);
+                    perms += STATICTREE_PERM_SIZE;
+                }
+            }
+            p[0] = mask;
+            offset += perms - p;
+            i++;
+        }
+        delete itr;
+        if (i != nKeys) {
+            LOG(ERRORL) << "The tree changed while building the static tree";
+            throw 10;
+        }
+        if (nLayers > 0) {
+            std::fill(leaves + nKeys, leaves + layerSizes[0] * STATICTREE_NODE_KEYS,
+                    std::numeric_limits<int64_t>::max());
+        }
+
+        //Build the internal layers. The smallest key under the j-th node of
+        //the layer at height h is the first key of the leaf j * FANOUT^h.
+        int64_t leavesPerNode = 1;
+        for (int h = 1; h < nLayers; ++h) {
+            const int64_t nChildren = layerSizes[h - 1];
+            int64_t *layer = nodes + header[5 + nLayers - 1 - h] *
+                STATICTREE_NODE_KEYS;
+            for (int64_t j = 0; j < layerSizes[h]; ++j) {
+                for (int k = 0; k < STATICTREE_NODE_KEYS; ++k) {
+                    const int64_t child = j * STATICTREE_FANOUT + k + 1;
+                    layer[j * STATICTREE_NODE_KEYS + k] = child < nChildren ?
+                        leaves[child * leavesPerNode * STATICTREE_NODE_KEYS] :
+                        std::numeric_limits<int64_t>::max();
+                }
+            }
+            leavesPerNode *= STATICTREE_FANOUT;
+        }
+        mf.flushAll();
+    }
+    Utils::rename(tmpPath, path);
+    LOG(DEBUGL) << "Static tree with " << nKeys << " keys and " << nLayers
+        << " layers written in " << path;
+}
+
+StaticRoot::~StaticRoot() {
+}
@@ -33,10 +33,9 @@
 
 using namespace std;
 
-char StringBuffer::FINISH_THREAD[1];
-
 StringBuffer::StringBuffer(string dir, bool readOnly, int factorySize,
-                           int64_t cacheSize, Stats *stats) :
+                           int64_t cacheSize, Stats *stats,
+                           int nCompressionThreads) :
     dir(dir), factory(SB_BLOCK_SIZE, 2, factorySize), readOnly(readOnly), maxElementsInCache(
         max(5, (int) (cacheSize / SB_BLOCK_SIZE))) {
 
@@ -44,8 +43,12 @@ StringBuffer::StringBuffer(string dir, bool readOnly, int factorySize,
 
     uncompressedSize = 0;
     writingCurrentBufferSize = 0;
-    bufferToCompress = NULL;
-    sizeBufferToCompress = 0;
+    nQueuedBlocks = nWrittenBlocks = 0;
+    stopCompression = false;
+    //The blocks that are not written yet must stay in the cache
+    nCompressionThreads = max(1, nCompressionThreads);
+    maxPendingBlocks = max(2, min(2 * nCompressionThreads,
+                maxElementsInCache - 3));
     elementsInCache = 0;
     this->stats = stats;
     firstBlockInCache = -1;
@@ -64,6 +67,42 @@ StringBuffer::StringBuffer(string dir, bool readOnly, int factorySize,
     if (!Utils::exists(dir)) {
         Utils::create_directories(dir);
     }
+
+    //When an existing buffer is opened for writing, new strings are
+    //appended after the existing ones. The last block is reopened if it is
+    //not full
+    char *lastBlock = NULL;
+    int sizeLastBlock = 0;
+    if (!readOnly && Utils::exists(dir + string("/sb.idx"))) {
+        std::ifstream file(dir + string("/sb.idx"), std::ios::binary);
+        file.read(reinterpret_cast<char*>(&uncompressedSize), sizeof(int64_t));
+        int64_t pos;
+        while (file.read(reinterpret_cast<char*>(&pos), sizeof(int64_t))) {
+            sizeCompressedBlocks.push_back(pos);
+        }
+        file.close();
+
+        sizeLastBlock = uncompressedSize % SB_BLOCK_SIZE;
+        if (sizeLastBlock > 0 && !sizeCompressedBlocks.empty()) {
+            const int64_t start = sizeCompressedBlocks.size() > 1 ?
+                sizeCompressedBlocks[sizeCompressedBlocks.size() - 2] : 0;
+            const int length = sizeCompressedBlocks.back() - start;
+            std::ifstream fsb(dir + string("/sb"), std::ios::binary);
+            fsb.seekg(start);
+            fsb.read(uncompressSupportBuffer, length);
+            fsb.close();
+            lastBlock = factory.get();
+            if (LZ4_decompress_safe(uncompressSupportBuffer, lastBlock, length,
+                        sizeLastBlock) < 0) {
+                LOG(ERRORL) << "Decompression of the last block of " << dir
+                    << " has failed";
+                throw 10;
+            }
+            //The block is compressed again when it is full
+            sizeCompressedBlocks.pop_back();
+            Utils::resizeFile(dir + string("/sb"), start);
+        }
+    }
     sb.open((dir + string("/sb")).c_str(), mode);
 
     if (readOnly) {
@@ -80,14 +119,18 @@ StringBuffer::StringBuffer(string dir, bool readOnly, int factorySize,
         cacheVector.resize(sizeCompressedBlocks.size());
         file.close();
     } else {
-        currentBuffer = factory.get();
+        blocks.resize(sizeCompressedBlocks.size());
+        cacheVector.resize(sizeCompressedBlocks.size(), std::make_pair(-1, -1));
+        currentBuffer = lastBlock != NULL ? lastBlock : factory.get();
+        writingCurrentBufferSize = sizeLastBlock;
         blocks.push_back(currentBuffer);
-        addCache(0);
+        addCache(blocks.size() - 1);
 
-        //Start a compression thread
-        threadRunning = true;
-        compressionThread = std::thread(
-                                std::bind(&StringBuffer::compressBlocks, this));
+        //Start the compression threads
+        for (int i = 0; i < nCompressionThreads; ++i) {
+            compressionThreads.push_back(std::thread(
+                        std::bind(&StringBuffer::compressBlocks, this)));
+        }
     }
 }
 
@@ -107,8 +150,9 @@ void StringBuffer::addCache(int idx) {
             lastBlockInCache = -1;
         cacheVector[firstBlockInCache].first = -1;
 
-        //Do not remove one of the last three blocks inserted
-        while (!readOnly && idxToRemove >= blocks.size() - 3) {
+        //Do not remove the last block nor the ones that are not written yet
+        while (!readOnly &&
+                idxToRemove >= (int) blocks.size() - 1 - maxPendingBlocks) {
             //Put back the previous vector
 	    // LOG(DEBUGL) << "addCache, re-instating " << idxToRemove;
             if (lastBlockInCache != -1)
@@ -138,9 +182,8 @@ void StringBuffer::addCache(int idx) {
     if (idx == cacheVector.size()) { //It's a new block (writing mode)
         if (lastBlockInCache == -1) {
             assert(firstBlockInCache == -1);
-            assert(cacheVector.size() == 0);
-            firstBlockInCache = lastBlockInCache = 0;
             cacheVector.push_back(std::make_pair(-1, -1));
+            firstBlockInCache = lastBlockInCache = cacheVector.size() - 1;
         } else {
             cacheVector.push_back(std::make_pair(lastBlockInCache, -1));
             cacheVector[lastBlockInCache].second = cacheVector.size() - 1;
@@ -173,35 +216,36 @@ void StringBuffer::addCache(int idx) {
 }
 
 void StringBuffer::compressBlocks() {
-    threadRunning = true;
     const int maxSize = LZ4_compressBound(SB_BLOCK_SIZE);
     char *compressedBuffer = new char[maxSize];
     while (true) {
-
         std::unique_lock<std::mutex> lock(_compressMutex);
-        while (bufferToCompress == NULL) {
+        while (blocksToCompress.empty() && !stopCompression) {
             compressWait.wait(lock);
         }
-        char *currentUncompressedBuffer = bufferToCompress;
-        int sCurrentUncompressedBuffer = sizeBufferToCompress;
-        bufferToCompress = NULL;
-        lock.unlock();
-
-        compressWait.notify_one();
-
-        if (currentUncompressedBuffer == FINISH_THREAD) {
+        if (blocksToCompress.empty()) {
             break;
         }
+        BlockToCompress block = blocksToCompress.front();
+        blocksToCompress.pop_front();
+        lock.unlock();
 
 #if LZ4_VERSION_MAJOR > 1 || LZ4_VERSION_MINOR > 2 || (LZ4_VERSION_MINOR == 2 && LZ4_VERSION_RELEASE >= 9)
         // LZ4_compress_HC does not exist in older lz4 versions
-        int cs = LZ4_compress_HC(currentUncompressedBuffer, compressedBuffer,
-                                sCurrentUncompressedBuffer, maxSize,  4);
+        int cs = LZ4_compress_HC(block.buffer, compressedBuffer,
+                                block.size, maxSize,  4);
 #else
-        int cs = LZ4_compressHC2_limitedOutput(currentUncompressedBuffer, compressedBuffer,
-                                sCurrentUncompressedBuffer, maxSize,  4);
+        int cs = LZ4_compressHC2_limitedOutput(block.buffer, compressedBuffer,
+                                block.size, maxSize,  4);
 #endif
 
+        //Wait until the previous blocks are written
+        lock.lock();
+        while (nWrittenBlocks != block.id) {
+            compressWait.wait(lock);
+        }
+        lock.unlock();
+
         int64_t totalSize = 0;
 
         sizeLock.lock();
@@ -218,10 +262,13 @@ void StringBuffer::compressBlocks() {
         sb.seekp(totalSize);
         sb.write(compressedBuffer, cs);
         fileLock.unlock();
+
+        lock.lock();
+        nWrittenBlocks++;
+        lock.unlock();
+        compressWait.notify_all();
     }
     delete[] compressedBuffer;
-    threadRunning = false;
-    compressTerm.notify_one();
 }
 
 void StringBuffer::setCurrentAsBaseEntry(int size) {
@@ -326,15 +373,18 @@ int64_t StringBuffer::getSize() {
 
 void StringBuffer::compressLastBlock() {
     std::unique_lock<std::mutex> lock(_compressMutex);
-    while (bufferToCompress != NULL) {
+    while (nQueuedBlocks - nWrittenBlocks >= maxPendingBlocks) {
         compressWait.wait(lock);
     }
-    bufferToCompress = currentBuffer;
-    sizeBufferToCompress = writingCurrentBufferSize;
+    BlockToCompress block;
+    block.id = nQueuedBlocks++;
+    block.buffer = currentBuffer;
+    block.size = writingCurrentBufferSize;
+    blocksToCompress.push_back(block);
     lock.unlock();
 
-//Notify the compression thread in case it is waiting
-    compressWait.notify_one();
+    //Notify the compression threads in case they are waiting
+    compressWait.notify_all();
 
     addCache(blocks.size());
 
@@ -380,7 +430,8 @@ void StringBuffer::uncompressBlock(int b) {
 
     char *uncompressedBuffer = factory.get();
     int sizeUncompressed = SB_BLOCK_SIZE;
-    if (b == sizeCompressedBlocks.size() - 1) {
+    //When writing, all the compressed blocks are full
+    if (readOnly && b == sizeCompressedBlocks.size() - 1) {
         sizeUncompressed = uncompressedSize % SB_BLOCK_SIZE;
     }
     int bytesUncompressed = LZ4_decompress_safe(uncompressSupportBuffer,
@@ -588,17 +639,12 @@ StringBuffer::~StringBuffer() {
         }
 
         std::unique_lock<std::mutex> lock(_compressMutex);
-        while (bufferToCompress != NULL) {
-            compressWait.wait(lock);
-        }
+        stopCompression = true;
         lock.unlock();
-
-        compressionThread.detach();
-        bufferToCompress = FINISH_THREAD;
-        compressWait.notify_one();
-
-        std::unique_lock<std::mutex> lock2(_compressTerm);
-        compressTerm.wait(lock2, std::bind(&StringBuffer::isThreadFinished, this));
+        compressWait.notify_all();
+        for (auto &t : compressionThreads) {
+            t.join();
+        }
 
         sb.flush();
         sb.close();
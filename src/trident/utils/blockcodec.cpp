@@ -0,0 +1,218 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+#include <trident/utils/blockcodec.h>
+#include <trident/utils/fixedbytes.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <lz4.h>
+
+#include <algorithm>
+#include <assert.h>
+
+//Values that need more bits are always stored as exceptions, so that the
+//bit-packing can use a 64 bit accumulator
+#define MAX_PACKED_BITS 56
+//Upper bound of the bytes used by one exception (position + vlong2)
+#define MAX_EXCEPTION_SIZE 11
+
+static inline int _nbits(uint64_t v) {
+    int n = 0;
+    while (v != 0) {
+        n++;
+        v >>= 1;
+    }
+    return n;
+}
+
+size_t BlockCodec::maxEncodedSize(const size_t n) {
+    //Two columns, each with two bytes of header, at most 56 bits per value
+    //and an exception per value. This is also larger than the bound of LZ4.
+    return 2 * (3 + 7 * n + MAX_EXCEPTION_SIZE * n) + 1;
+}
+
+size_t BlockCodec::scratchSize(const size_t n) {
+    return 16 * n;
+}
+
+size_t BlockCodec::packPFOR(const uint64_t *in, const size_t n, char *out) {
+    //Pick the width that minimizes the size of the column
+    size_t histogram[65];
+    for (int i = 0; i < 65; ++i) {
+        histogram[i] = 0;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        histogram[_nbits(in[i])]++;
+    }
+    size_t exceptions = n - histogram[0];
+    int width = 0;
+    size_t bestSize = exceptions * MAX_EXCEPTION_SIZE;
+    for (int w = 1; w <= MAX_PACKED_BITS; ++w) {
+        exceptions -= histogram[w];
+        const size_t size = (n * w + 7) / 8 + exceptions * MAX_EXCEPTION_SIZE;
+        if (size < bestSize) {
+            bestSize = size;
+            width = w;
+        }
+    }
+    const uint64_t mask = width == 0 ? 0 : (((uint64_t) 1) << width) - 1;
+
+    //Bit-pack the lowest "width" bits of each value
+    out[0] = (char) width;
+    int nexceptions = 0;
+    char *o = out + 2;
+    uint64_t acc = 0;
+    int accbits = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (_nbits(in[i]) > width) {
+            nexceptions++;
+        }
+        acc |= (in[i] & mask) << accbits;
+        accbits += width;
+        while (accbits >= 8) {
+            *o++ = (char) (acc & 0xFF);
+            acc >>= 8;
+            accbits -= 8;
+        }
+    }
+    if (accbits > 0) {
+        *o++ = (char) acc;
+    }
+    out[1] = (char) nexceptions;
+
+    //Store the remaining bits of the exceptions
+    int pos = o - out;
+    for (size_t i = 0; i < n; ++i) {
+        if (_nbits(in[i]) > width) {
+            out[pos++] = (char) i;
+            pos = Utils::encode_vlong2(out, pos, in[i] >> width);
+        }
+    }
+    return pos;
+}
+
+const char *BlockCodec::unpackPFOR(const char *in, const size_t n,
+        int64_t *out) {
+    const int width = (uint8_t) in[0];
+    const int nexceptions = (uint8_t) in[1];
+    const uint64_t mask = width == 0 ? 0 : (((uint64_t) 1) << width) - 1;
+    const char *p = in + 2;
+    uint64_t acc = 0;
+    int accbits = 0;
+    for (size_t i = 0; i < n; ++i) {
+        while (accbits < width) {
+            acc |= ((uint64_t) (uint8_t) *p++) << accbits;
+            accbits += 8;
+        }
+        out[i] = acc & mask;
+        acc >>= width;
+        accbits -= width;
+    }
+
+    //Patch the exceptions
+    int pos = p - in;
+    for (int i = 0; i < nexceptions; ++i) {
+        const uint8_t idx = (uint8_t) in[pos++];
+        const uint64_t high = Utils::decode_vlong2(in, &pos);
+        out[idx] |= high << width;
+    }
+    return in + pos;
+}
+
+size_t BlockCodec::encode(const int codec, const int64_t *v1,
+        const int64_t *v2, const size_t n, char *out) {
+    assert(n > 0 && n <= COMPR_BLOCK_ROWS);
+    uint64_t d1[COMPR_BLOCK_ROWS];
+    uint64_t d2[COMPR_BLOCK_ROWS];
+    d1[0] = v1[0];
+    d2[0] = v2[0];
+    for (size_t i = 1; i < n; ++i) {
+        d1[i] = v1[i] - v1[i - 1];
+        d2[i] = d1[i] == 0 ? v2[i] - v2[i - 1] : v2[i];
+    }
+
+    if (codec == BLOCKCODEC_PFOR) {
+        const size_t size = packPFOR(d1, n, out);
+        return size + packPFOR(d2, n, out + size);
+    } else if (codec == BLOCKCODEC_LZ4) {
+        //The first byte records how many bytes are used for each column
+        uint64_t max1 = 0, max2 = 0;
+        for (size_t i = 0; i < n; ++i) {
+            max1 = std::max(max1, d1[i]);
+            max2 = std::max(max2, d2[i]);
+        }
+        const uint8_t b1 = std::max(1, (_nbits(max1) + 7) / 8);
+        const uint8_t b2 = std::max(1, (_nbits(max2) + 7) / 8);
+        out[0] = (char) ((b1 << 4) | b2);
+
+        char raw[COMPR_BLOCK_ROWS * 16];
+        char *p = raw;
+        for (size_t i = 0; i < n; ++i) {
+            Utils::encode_longNBytes(p, b1, d1[i]);
+            p += b1;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            Utils::encode_longNBytes(p, b2, d2[i]);
+            p += b2;
+        }
+        const int size = LZ4_compress_default(raw, out + 1, p - raw,
+                maxEncodedSize(n) - 1);
+        if (size <= 0) {
+            LOG(ERRORL) << "LZ4 failed in compressing the block";
+            throw 10;
+        }
+        return size + 1;
+    } else {
+        LOG(ERRORL) << "Codec " << codec << " is not supported";
+        throw 10;
+    }
+}
+
+void BlockCodec::decode(const int codec, const char *in, const size_t len,
+        const size_t n, int64_t *v1, int64_t *v2, char *scratch) {
+    if (codec == BLOCKCODEC_PFOR) {
+        const char *p = unpackPFOR(in, n, v1);
+        unpackPFOR(p, n, v2);
+    } else if (codec == BLOCKCODEC_LZ4) {
+        const uint8_t b1 = ((uint8_t) in[0]) >> 4;
+        const uint8_t b2 = in[0] & 15;
+        const int rawsize = n * (b1 + b2);
+        if (LZ4_decompress_safe(in + 1, scratch, len - 1, rawsize) != rawsize) {
+            LOG(ERRORL) << "The compressed block is corrupted";
+            throw 10;
+        }
+        FixedBytesDecoder::decode(scratch, scratch + rawsize, b1, v1, n);
+        FixedBytesDecoder::decode(scratch + n * b1, scratch + rawsize, b2, v2, n);
+    } else {
+        LOG(ERRORL) << "Codec " << codec << " is not supported";
+        throw 10;
+    }
+
+    //Undo the differences
+    for (size_t i = 1; i < n; ++i) {
+        if (v1[i] == 0) {
+            v2[i] += v2[i - 1];
+        }
+        v1[i] += v1[i - 1];
+    }
+}
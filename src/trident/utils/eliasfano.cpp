@@ -0,0 +1,253 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/utils/eliasfano.h>
+
+#include <cstring>
+
+#define EF_HEADER_WORDS 7
+
+static inline int _popcount(uint64_t w) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(w);
+#else
+    int c = 0;
+    while (w) {
+        w &= w - 1;
+        c++;
+    }
+    return c;
+#endif
+}
+
+static inline int _ctz(uint64_t w) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(w);
+#else
+    int c = 0;
+    while (!(w & 1)) {
+        w >>= 1;
+        c++;
+    }
+    return c;
+#endif
+}
+
+//Position of the k-th (starting from 0) bit set in w
+static inline int _selectInWord(uint64_t w, int k) {
+    while (k-- > 0) {
+        w &= w - 1;
+    }
+    return _ctz(w);
+}
+
+void EliasFano::encode(const uint64_t *values, const uint64_t n,
+        std::vector<uint64_t> &out) {
+    uint8_t l = 0;
+    uint64_t maxHigh = 0;
+    if (n > 0) {
+        const uint64_t universe = values[n - 1] + 1;
+        while ((universe >> (l + 1)) >= n) {
+            l++;
+        }
+        maxHigh = values[n - 1] >> l;
+    }
+    const uint64_t nlower = (n * l + 63) / 64;
+    const uint64_t upperBits = n + maxHigh + 1;
+    const uint64_t nupper = (upperBits + 63) / 64;
+    const uint64_t nsamples1 = (n + EF_SAMPLING - 1) / EF_SAMPLING;
+    const uint64_t nsamples0 = (maxHigh + 1 + EF_SAMPLING - 1) / EF_SAMPLING;
+
+    const size_t base = out.size();
+    out.resize(base + EF_HEADER_WORDS + nlower + nupper + nsamples1 +
+            nsamples0, 0);
+    uint64_t *header = out.data() + base;
+    header[0] = n;
+    header[1] = l;
+    header[2] = maxHigh;
+    header[3] = nlower;
+    header[4] = nupper;
+    header[5] = nsamples1;
+    header[6] = nsamples0;
+    uint64_t *lower = header + EF_HEADER_WORDS;
+    uint64_t *upper = lower + nlower;
+    uint64_t *samples1 = upper + nupper;
+    uint64_t *samples0 = samples1 + nsamples1;
+
+    const uint64_t mask = l == 0 ? 0 : (~(uint64_t) 0) >> (64 - l);
+    for (uint64_t i = 0; i < n; ++i) {
+        if (l > 0) {
+            const uint64_t low = values[i] & mask;
+            const uint64_t bit = i * l;
+            const uint64_t off = bit % 64;
+            lower[bit / 64] |= low << off;
+            if (off + l > 64) {
+                lower[bit / 64 + 1] |= low >> (64 - off);
+            }
+        }
+        const uint64_t pos = (values[i] >> l) + i;
+        upper[pos / 64] |= (uint64_t) 1 << (pos % 64);
+        if (i % EF_SAMPLING == 0) {
+            samples1[i / EF_SAMPLING] = pos;
+        }
+    }
+
+    //The b-th zero follows all the values whose high part is <= b
+    uint64_t i = 0;
+    for (uint64_t b = 0; b <= maxHigh; ++b) {
+        while (i < n && (values[i] >> l) <= b) {
+            i++;
+        }
+        if (b % EF_SAMPLING == 0) {
+            samples0[b / EF_SAMPLING] = b + i;
+        }
+    }
+}
+
+uint64_t EliasFano::readWord(const char *p, const uint64_t idx) {
+    uint64_t w;
+    memcpy(&w, p + idx * 8, 8);
+    return w;
+}
+
+void EliasFano::init(const char *data) {
+    this->data = data;
+    n = readWord(data, 0);
+    l = (uint8_t) readWord(data, 1);
+    maxHigh = readWord(data, 2);
+    nlower = readWord(data, 3);
+    nupper = readWord(data, 4);
+    nsamples1 = readWord(data, 5);
+    nsamples0 = readWord(data, 6);
+    lower = data + EF_HEADER_WORDS * 8;
+    upper = lower + nlower * 8;
+    samples1 = upper + nupper * 8;
+    samples0 = samples1 + nsamples1 * 8;
+    lastIdx = lastPos = 0;
+    if (n > 0) {
+        lastPos = readWord(samples1, 0);
+    }
+}
+
+size_t EliasFano::sizeInBytes() const {
+    return (EF_HEADER_WORDS + nlower + nupper + nsamples1 + nsamples0) * 8;
+}
+
+uint64_t EliasFano::getLow(const uint64_t i) const {
+    if (l == 0) {
+        return 0;
+    }
+    const uint64_t bit = i * l;
+    const uint64_t off = bit % 64;
+    uint64_t v = readWord(lower, bit / 64) >> off;
+    if (off + l > 64) {
+        v |= readWord(lower, bit / 64 + 1) << (64 - off);
+    }
+    return v & ((~(uint64_t) 0) >> (64 - l));
+}
+
+uint64_t EliasFano::nextOne(uint64_t pos) const {
+    uint64_t w = pos / 64;
+    uint64_t word = readWord(upper, w) & ((~(uint64_t) 0) << (pos % 64));
+    while (word == 0) {
+        word = readWord(upper, ++w);
+    }
+    return w * 64 + _ctz(word);
+}
+
+uint64_t EliasFano::select1(const uint64_t k) const {
+    const uint64_t pos = readWord(samples1, k / EF_SAMPLING);
+    uint64_t r = k % EF_SAMPLING;
+    if (r == 0) {
+        return pos;
+    }
+    //Look for the r-th one after pos
+    uint64_t w = (pos + 1) / 64;
+    uint64_t word = readWord(upper, w) & ((~(uint64_t) 0) << ((pos + 1) % 64));
+    while (true) {
+        const int c = _popcount(word);
+        if (r <= (uint64_t) c) {
+            return w * 64 + _selectInWord(word, r - 1);
+        }
+        r -= c;
+        word = readWord(upper, ++w);
+    }
+}
+
+uint64_t EliasFano::select0(const uint64_t k) const {
+    const uint64_t pos = readWord(samples0, k / EF_SAMPLING);
+    uint64_t r = k % EF_SAMPLING;
+    if (r == 0) {
+        return pos;
+    }
+    uint64_t w = (pos + 1) / 64;
+    uint64_t word = ~readWord(upper, w) & ((~(uint64_t) 0) << ((pos + 1) % 64));
+    while (true) {
+        const int c = _popcount(word);
+        if (r <= (uint64_t) c) {
+            return w * 64 + _selectInWord(word, r - 1);
+        }
+        r -= c;
+        word = ~readWord(upper, ++w);
+    }
+}
+
+uint64_t EliasFano::select(const uint64_t i) {
+    uint64_t pos;
+    if (i == lastIdx) {
+        pos = lastPos;
+    } else if (i == lastIdx + 1) {
+        pos = nextOne(lastPos + 1);
+    } else {
+        pos = select1(i);
+    }
+    lastIdx = i;
+    lastPos = pos;
+    return ((pos - i) << l) | getLow(i);
+}
+
+uint64_t EliasFano::nextGEQ(const uint64_t x) {
+    const uint64_t h = x >> l;
+    if (n == 0 || h > maxHigh) {
+        return n;
+    }
+    //Skip the values whose high part is smaller than h
+    uint64_t i = 0;
+    uint64_t pos = 0;
+    if (h > 0) {
+        const uint64_t p0 = select0(h - 1);
+        i = p0 - (h - 1);
+        pos = p0 + 1;
+    }
+    while (i < n) {
+        pos = nextOne(pos);
+        const uint64_t high = pos - i;
+        if (high > h || ((high << l) | getLow(i)) >= x) {
+            lastIdx = i;
+            lastPos = pos;
+            return i;
+        }
+        i++;
+        pos++;
+    }
+    return n;
+}
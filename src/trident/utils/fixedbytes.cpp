@@ -0,0 +1,208 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+#include <trident/utils/fixedbytes.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FIXEDBYTES_X86 1
+#include <immintrin.h>
+#endif
+
+template<int W>
+static inline int64_t _decodeBE(const char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < W; ++i) {
+        v = (v << 8) | (uint8_t) p[i];
+    }
+    return (int64_t) v;
+}
+
+template<int W>
+static void _decode_scalar(const char *in, int64_t *out, const size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = _decodeBE<W>(in);
+        in += W;
+    }
+}
+
+#ifdef FIXEDBYTES_X86
+//The shuffle mask moves two consecutive values of W bytes into two 64bit
+//lanes, reversing the byte order and setting the unused bytes to zero.
+template<int W>
+static void _buildMask(char *mask) {
+    for (int lane = 0; lane < 2; ++lane) {
+        for (int k = 0; k < 8; ++k) {
+            mask[lane * 8 + k] = k < W ? (char) (lane * W + W - 1 - k) :
+                (char) 0x80;
+        }
+    }
+}
+
+template<int W>
+__attribute__((target("ssse3")))
+static size_t _decode_ssse3(const char *in, const char *limit,
+        int64_t *out, const size_t n) {
+    char m[16];
+    _buildMask<W>(m);
+    const __m128i mask = _mm_loadu_si128((const __m128i*) m);
+    size_t i = 0;
+    //Every iteration loads 16 bytes and decodes two values
+    while (i + 2 <= n && in + 16 <= limit) {
+        const __m128i raw = _mm_loadu_si128((const __m128i*) in);
+        _mm_storeu_si128((__m128i*) (out + i), _mm_shuffle_epi8(raw, mask));
+        in += 2 * W;
+        i += 2;
+    }
+    return i;
+}
+
+template<int W>
+__attribute__((target("avx2")))
+static size_t _decode_avx2(const char *in, const char *limit,
+        int64_t *out, const size_t n) {
+    char m[16];
+    _buildMask<W>(m);
+    const __m128i m128 = _mm_loadu_si128((const __m128i*) m);
+    //vpshufb works within 128bit lanes, so the mask is replicated
+    const __m256i mask = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(m128), m128, 1);
+    size_t i = 0;
+    //Every iteration decodes four values: the first two are taken from
+    //the 16 bytes at "in", the other two from the 16 bytes at in + 2W.
+    while (i + 4 <= n && in + 2 * W + 16 <= limit) {
+        const __m128i lo = _mm_loadu_si128((const __m128i*) in);
+        const __m128i hi = _mm_loadu_si128((const __m128i*) (in + 2 * W));
+        const __m256i raw = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(lo), hi, 1);
+        _mm256_storeu_si256((__m256i*) (out + i),
+                _mm256_shuffle_epi8(raw, mask));
+        in += 4 * W;
+        i += 4;
+    }
+    return i;
+}
+
+static bool _cpuSupports(int avx2) {
+    __builtin_cpu_init();
+    if (avx2) {
+        return __builtin_cpu_supports("avx2");
+    } else {
+        return __builtin_cpu_supports("ssse3");
+    }
+}
+
+static const bool _hasAVX2 = _cpuSupports(1);
+static const bool _hasSSSE3 = _cpuSupports(0);
+#endif
+
+template<int W>
+static void _decode(const char *in, const char *limit, int64_t *out,
+        const size_t n) {
+    size_t done = 0;
+#ifdef FIXEDBYTES_X86
+    if (_hasAVX2) {
+        done = _decode_avx2<W>(in, limit, out, n);
+    } else if (_hasSSSE3) {
+        done = _decode_ssse3<W>(in, limit, out, n);
+    }
+#endif
+    _decode_scalar<W>(in + done * W, out + done, n - done);
+}
+
+void FixedBytesDecoder::decode(const char *in, const char *limit,
+        const uint8_t nbytes, int64_t *out, const size_t n) {
+    switch (nbytes) {
+        case 1:
+            _decode<1>(in, limit, out, n);
+            break;
+        case 2:
+            _decode<2>(in, limit, out, n);
+            break;
+        case 3:
+            _decode<3>(in, limit, out, n);
+            break;
+        case 4:
+            _decode<4>(in, limit, out, n);
+            break;
+        case 5:
+            _decode<5>(in, limit, out, n);
+            break;
+        case 6:
+            _decode<6>(in, limit, out, n);
+            break;
+        case 7:
+            _decode<7>(in, limit, out, n);
+            break;
+        case 8:
+            _decode<8>(in, limit, out, n);
+            break;
+        default:
+            throw 10;
+    }
+}
+
+void FixedBytesDecoder::decode_scalar(const char *in, const uint8_t nbytes,
+        int64_t *out, const size_t n) {
+    switch (nbytes) {
+        case 1:
+            _decode_scalar<1>(in, out, n);
+            break;
+        case 2:
+            _decode_scalar<2>(in, out, n);
+            break;
+        case 3:
+            _decode_scalar<3>(in, out, n);
+            break;
+        case 4:
+            _decode_scalar<4>(in, out, n);
+            break;
+        case 5:
+            _decode_scalar<5>(in, out, n);
+            break;
+        case 6:
+            _decode_scalar<6>(in, out, n);
+            break;
+        case 7:
+            _decode_scalar<7>(in, out, n);
+            break;
+        case 8:
+            _decode_scalar<8>(in, out, n);
+            break;
+        default:
+            throw 10;
+    }
+}
+
+bool FixedBytesDecoder::hasAVX2() {
+#ifdef FIXEDBYTES_X86
+    return _hasAVX2;
+#else
+    return false;
+#endif
+}
+
+bool FixedBytesDecoder::hasSSSE3() {
+#ifdef FIXEDBYTES_X86
+    return _hasSSSE3;
+#else
+    return false;
+#endif
+}
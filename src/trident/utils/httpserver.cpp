@@ -3,6 +3,9 @@
 #include <kognac/logs.h>
 
 #include <chrono>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
 
 #if defined(_WIN32)
 //The Http Client and Server are only supported under Linux/Mac
@@ -10,182 +13,567 @@
 
 namespace chr = std::chrono;
 
+//Requests larger than these limits are rejected
+#define HTTPSERVER_MAX_HEADER_SIZE (64 * 1024)
+#define HTTPSERVER_MAX_BODY_SIZE (16 * 1024 * 1024)
+
+static uint64_t _now() {
+    return chr::duration_cast<chr::milliseconds>(
+            chr::steady_clock::now().time_since_epoch()).count();
+}
+
+//Case-insensitive search of a header. Returns the position of its value
+static size_t _findHeader(const std::string &request, size_t headerEnd,
+        const char *name) {
+    const size_t len = strlen(name);
+    size_t pos = request.find("\r\n");
+    while (pos != std::string::npos && pos < headerEnd) {
+        pos += 2;
+        if (strncasecmp(request.c_str() + pos, name, len) == 0) {
+            pos += len;
+            while (pos < headerEnd && request[pos] == ' ') {
+                pos++;
+            }
+            return pos;
+        }
+        pos = request.find("\r\n", pos);
+    }
+    return std::string::npos;
+}
+
+HttpChunkedWriter::HttpChunkedWriter(int connFd, bool keepAlive,
+        uint64_t timeout, size_t chunkSize, bool chunked) :
+    connFd(connFd), keepAlive(keepAlive && chunked), timeout(timeout),
+    chunkSize(chunkSize), chunked(chunked), started(false), finished(false),
+    broken(false) {
+#ifdef SO_NOSIGPIPE
+        int set = 1;
+        setsockopt(connFd, SOL_SOCKET, SO_NOSIGPIPE, &set, sizeof(set));
+#endif
+    }
+
+bool HttpChunkedWriter::sendAll(int connFd, const char *data, size_t size,
+        uint64_t timeout) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    size_t sent = 0;
+    while (sent < size) {
+        auto len = send(connFd, data + sent, size - sent, flags);
+        if (len > 0) {
+            sent += len;
+        } else if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+                    errno == EINTR)) {
+            //The client does not read fast enough. Wait until it does
+            pollfd pf;
+            pf.fd = connFd;
+            pf.events = POLLOUT;
+            pf.revents = 0;
+            if (poll(&pf, 1, timeout) <= 0 || (pf.revents & (POLLERR | POLLHUP))) {
+                LOG(DEBUGL) << "The client does not receive the response";
+                return false;
+            }
+        } else {
+            LOG(DEBUGL) << "The client has closed the connection";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HttpChunkedWriter::sendChunk() {
+    if (buffer.empty() || broken) {
+        return !broken;
+    }
+    if (chunked) {
+        char header[32];
+        int headerSize = snprintf(header, sizeof(header), "%zx\r\n",
+                buffer.size());
+        buffer += "\r\n";
+        broken = !sendAll(connFd, header, headerSize, timeout);
+    }
+    broken = broken || !sendAll(connFd, buffer.c_str(), buffer.size(), timeout);
+    buffer.clear();
+    return !broken;
+}
+
+bool HttpChunkedWriter::start(const std::string &contentType) {
+    if (started) {
+        LOG(ERRORL) << "The headers of the response were already sent";
+        throw 10;
+    }
+    started = true;
+    std::string headers = "HTTP/1.1 200 OK\r\nContent-Type: " + contentType +
+        "\r\n";
+    if (chunked) {
+        headers += "Transfer-Encoding: chunked\r\n";
+    }
+    if (!keepAlive) {
+        headers += "Connection: close\r\n";
+    }
+    headers += "\r\n";
+    broken = !sendAll(connFd, headers.c_str(), headers.size(), timeout);
+    return !broken;
+}
+
+bool HttpChunkedWriter::write(const char *data, size_t size) {
+    if (!started || finished) {
+        LOG(ERRORL) << "Data can be written only between start() and finish()";
+        throw 10;
+    }
+    buffer.append(data, size);
+    if (buffer.size() >= chunkSize) {
+        return sendChunk();
+    }
+    return !broken;
+}
+
+bool HttpChunkedWriter::flush() {
+    return sendChunk();
+}
+
+bool HttpChunkedWriter::finish() {
+    if (finished) {
+        return !broken;
+    }
+    finished = true;
+    if (sendChunk() && chunked) {
+        broken = !sendAll(connFd, "0\r\n\r\n", 5, timeout);
+    }
+    return !broken;
+}
+
 HttpServer::HttpServer(uint32_t port,
-        std::function<void(const std::string&, std::string&)> handler,
+        std::function<void(const std::string&, std::string&,
+            HttpChunkedWriter&)> handler,
         uint32_t nthreads,
-        uint64_t maxLifeConn) : port(port),
-    maxLifeConn(maxLifeConn), handlerFunction(handler) {
+        uint64_t maxLifeConn,
+        size_t maxQueuedRequests,
+        uint64_t requestTimeout) : port(port), launched(false),
+    stopped(false), maxLifeConn(maxLifeConn),
+    maxQueuedRequests(maxQueuedRequests), requestTimeout(requestTimeout),
+    listenFd(-1), pollFd(-1), handlerFunction(handler) {
+        wakeFds[0] = wakeFds[1] = -1;
         threads.resize(nthreads);
         for(uint32_t i = 0; i < nthreads; ++i) {
-            threads[i] = std::thread(&HttpServer::processSocket, this);
+            threads[i] = std::thread(&HttpServer::processRequests, this);
         }
     }
 
 uint64_t HttpServer::getMessageBodyLength(std::string& request) {
-    size_t pos = request.find("Content-Length:");
+    size_t pos = _findHeader(request, request.find("\r\n\r\n"),
+            "Content-Length:");
     if (pos == std::string::npos) {
         // For GET requests, usually message body is not present. Hence Content-Length field can be omitted
         // For POST requests, if message body is not present, then it Content-Length is 0
         return 0;
     }
-    size_t endpos = request.find("\r\n", pos);
-    std::string bodyLen = request.substr(pos + 16, endpos - pos - 16);
-    uint64_t ret = std::stoul(bodyLen);
-    return ret;
+    return std::stoul(request.substr(pos, request.find("\r\n", pos) - pos));
 }
 
-void HttpServer::processSocket() {
+size_t HttpServer::getRequestLength(const std::string &buffer) {
+    size_t headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+        if (buffer.size() > HTTPSERVER_MAX_HEADER_SIZE) {
+            throw 431;
+        }
+        return 0;
+    }
+    //The bodies are delimited only by Content-Length. A request with a
+    //Transfer-Encoding would be split differently by a proxy in front of
+    //the server, so it is rejected instead of guessing its length
+    size_t pos = _findHeader(buffer, headerEnd, "Transfer-Encoding:");
+    if (pos != std::string::npos) {
+        if (strncasecmp(buffer.c_str() + pos, "chunked", 7) == 0) {
+            throw 411;
+        }
+        throw 501;
+    }
+    uint64_t bodyLength = 0;
+    pos = _findHeader(buffer, headerEnd, "Content-Length:");
+    if (pos != std::string::npos) {
+        char *end;
+        bodyLength = strtoull(buffer.c_str() + pos, &end, 10);
+        if (end == buffer.c_str() + pos) {
+            throw 400;
+        }
+    }
+    if (bodyLength > HTTPSERVER_MAX_BODY_SIZE) {
+        throw 413;
+    }
+    size_t length = headerEnd + 4 + bodyLength;
+    return buffer.size() >= length ? length : 0;
+}
+
+size_t HttpServer::findHeader(const std::string &request, const char *name) {
+    return _findHeader(request, request.find("\r\n\r\n"), name);
+}
+
+bool HttpServer::isHttp10(const std::string &request) {
+    size_t endLine = request.find("\r\n");
+    return endLine != std::string::npos && endLine >= 8 &&
+        request.compare(endLine - 8, 8, "HTTP/1.0") == 0;
+}
+
+bool HttpServer::isKeepAlive(const std::string &request) {
+    size_t headerEnd = request.find("\r\n\r\n");
+    size_t pos = _findHeader(request, headerEnd, "Connection:");
+    bool http10 = isHttp10(request);
+    if (pos == std::string::npos) {
+        return !http10;
+    }
+    if (strncasecmp(request.c_str() + pos, "close", 5) == 0) {
+        return false;
+    }
+    return !http10 || strncasecmp(request.c_str() + pos, "keep-alive", 10) == 0;
+}
+
+const char *HttpServer::getReasonPhrase(int code) {
+    switch (code) {
+        case 400:
+            return "Bad Request";
+        case 404:
+            return "Not Found";
+        case 408:
+            return "Request Timeout";
+        case 411:
+            return "Length Required";
+        case 413:
+            return "Payload Too Large";
+        case 431:
+            return "Request Header Fields Too Large";
+        case 500:
+            return "Internal Server Error";
+        case 501:
+            return "Not Implemented";
+        case 503:
+            return "Service Unavailable";
+        default:
+            return "Error";
+    }
+}
+
+std::string HttpServer::errorResponse(int code) {
+    return "HTTP/1.1 " + std::to_string(code) + " " + getReasonPhrase(code) +
+        "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+}
+
+void HttpServer::processRequests() {
     while (true) {
-        Socket socket;
-        queueReady.pop_wait(socket);
-        if (socket.isEOF()) {
+        Request r;
+        queueRequests.pop_wait(r);
+        if (r.connFd == -1) {
             break;
         }
 
-        int connFd = socket.getFD();
-        //Read the data and print it on screen
-        try {
-            char buffer[1024];
-            std::string request = "";
-            auto len = read(connFd, buffer, 1024);
-            if (len == 0) { //Client has closed the conversation
-                socket.close();
-                queueWait.push(socket);
-            } else if (len == -1) {
-                //can happen. Put it back in the queue, unless there are errors
-                //TODO
-                queueWait.push(socket);
-            } else {
-                request += std::string(buffer, len);
-                int bodyLength = getMessageBodyLength(request);
-                int pos = request.find("\r\n\r\n");
-                int headerLength = 0;
-                if (pos == std::string::npos) {
-                    LOG(ERRORL) << "FATAL: End of header not found in the request";
-                }else {
-                    headerLength = pos;
+        bool close = !r.keepAlive;
+        if (_now() - r.arrival > requestTimeout) {
+            //Nobody could process the request in time
+            LOG(WARNL) << "Request rejected after waiting " << (_now() -
+                    r.arrival) << "ms in the queue";
+            std::string response = errorResponse(503);
+            HttpChunkedWriter::sendAll(r.connFd, response.c_str(),
+                    response.size(), requestTimeout);
+            close = true;
+        } else {
+            std::string response = "";
+            HttpChunkedWriter writer(r.connFd, r.keepAlive, requestTimeout,
+                    64 * 1024, !isHttp10(r.request));
+            bool failed = false;
+            try {
+                handlerFunction(r.request, response, writer);
+            } catch (...) {
+                LOG(ERRORL) << "The request could not be processed";
+                response = errorResponse(500);
+                failed = close = true;
+            }
+            if (writer.isStarted()) {
+                //The handler has streamed the response. A failed response
+                //is not terminated, so that the client sees it is truncated.
+                //Without chunks, only closing the connection ends the body
+                if (failed || !writer.finish() || !writer.isChunked()) {
+                    close = true;
                 }
-                if (bodyLength > 0) {
-                    int readBuffer = bodyLength - (1024 - headerLength);
-                    while (readBuffer > 0) {
-                        auto len = read(connFd, buffer, 1024);
-                        readBuffer -= len;
-                        request += std::string(buffer, len);
+            } else {
+                if (!r.keepAlive) {
+                    size_t pos = response.find("\r\n");
+                    if (pos != std::string::npos &&
+                            response.find("Connection: close") == std::string::npos) {
+                        response.insert(pos + 2, "Connection: close\r\n");
                     }
                 }
-                std::string response = "";
-                handlerFunction(request, response);
-                uint64_t size = 0;
-                do {
-                    size += send(connFd, response.c_str() + size,
-                            response.size() - size, 0);
-                } while (size < response.size());
-                queueWait.push(socket);
-            }
-        } catch (...) {
-            if (connFd != -1) {
-                socket.close();
-                queueWait.push(socket);
+                if (!HttpChunkedWriter::sendAll(r.connFd, response.c_str(),
+                            response.size(), requestTimeout)) {
+                    close = true;
+                }
             }
         }
+        Completion c;
+        c.connFd = r.connFd;
+        c.close = close;
+        queueCompleted.push(c);
+        wakeUp();
+    }
+}
+
+void HttpServer::wakeUp() {
+    char c = 0;
+    if (::write(wakeFds[1], &c, 1) < 0 && errno != EAGAIN) {
+        LOG(ERRORL) << "Failed to wake up the event loop";
+    }
+}
+
+#ifdef __linux__
+void HttpServer::watch(int fd, bool oneShot) {
+    epoll_event ev;
+    ev.events = EPOLLIN | (oneShot ? EPOLLONESHOT : 0);
+    ev.data.fd = fd;
+    if (epoll_ctl(pollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG(ERRORL) << "epoll_ctl failed: " << strerror(errno);
+    }
+}
+
+void HttpServer::rearm(int fd) {
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.fd = fd;
+    epoll_ctl(pollFd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void HttpServer::unwatch(int fd) {
+    epoll_ctl(pollFd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+void HttpServer::waitEvents(std::vector<int> &ready, int timeout) {
+    epoll_event events[256];
+    int n = epoll_wait(pollFd, events, 256, timeout);
+    if (n < 0 && errno != EINTR) {
+        LOG(ERRORL) << "epoll_wait failed: " << strerror(errno);
     }
+    for (int i = 0; i < n; ++i) {
+        ready.push_back(events[i].data.fd);
+    }
+}
+#else
+//Without epoll, the armed sockets are collected at every iteration
+void HttpServer::watch(int fd, bool oneShot) {
+    if (oneShot) {
+        armed.insert(fd);
+    }
+}
+
+void HttpServer::rearm(int fd) {
+    armed.insert(fd);
 }
 
-void HttpServer::waitForData() {
+void HttpServer::unwatch(int fd) {
+    armed.erase(fd);
+}
+
+void HttpServer::waitEvents(std::vector<int> &ready, int timeout) {
     std::vector<pollfd> events;
-    std::vector<uint64_t > idletime;
+    pollfd pf;
+    pf.events = POLLIN;
+    pf.revents = 0;
+    pf.fd = listenFd;
+    events.push_back(pf);
+    pf.fd = wakeFds[0];
+    events.push_back(pf);
+    for (int fd : armed) {
+        pf.fd = fd;
+        events.push_back(pf);
+    }
+    int n = poll(events.data(), events.size(), timeout);
+    if (n < 0 && errno != EINTR) {
+        LOG(ERRORL) << "poll failed: " << strerror(errno);
+    }
+    for (size_t i = 0; n > 0 && i < events.size(); ++i) {
+        if (events[i].revents != 0) {
+            if (i > 1) {
+                armed.erase(events[i].fd);
+            }
+            ready.push_back(events[i].fd);
+            n--;
+        }
+    }
+}
+#endif
 
+void HttpServer::acceptConnections() {
     while (true) {
-        while (!queueWait.isEmpty()) {
-            //Process the sockets
-            Socket s;
-            queueWait.pop(s);
-            if (s.shouldBeClosed()) {
-                //Remove the FD from the list of monitored ones
-                for(auto &el : events) {
-                    if (el.fd == s.getFD()) {
-                        el.fd = -1;
-                        break;
-                    }
-                }
-                //Close the FD
-                shutdown(s.getFD(), 2);
-                close(s.getFD());
-            } else {
-                uint64_t time = chr::duration_cast<chr::milliseconds>(
-                        chr::steady_clock::now().time_since_epoch()).count();
-                //Is the FD already monitored?
-                bool found = false;
-                int validIdx = -1;
-                int i = 0;
-                for(auto &el : events) {
-                    if (el.fd == s.getFD()) {
-                        found = true;
-                        //Update its idle count
-                        idletime[i] = time;
-                        break;
-                    } else if (el.fd == -1) {
-                        validIdx = i;
-                    }
-                    i++;
-                }
-                if (!found) {
-
-                    //Reuse a valid slot or add a new one
-                    if (validIdx == -1) {
-                        pollfd pf;
-                        pf.fd = s.getFD();
-                        pf.events = POLLIN | POLLERR | POLLHUP;
-                        events.push_back(pf);
-                        idletime.push_back(time);
-                    } else {
-                        events[validIdx].fd = s.getFD();
-                        idletime[validIdx] = time;
-                    }
-                }
+        socklen_t len = sizeof(clntAdd);
+        int connFd = accept(listenFd, (struct sockaddr *)&clntAdd, &len);
+        if (connFd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG(ERRORL) << "accept failed: " << strerror(errno);
             }
+            return;
         }
+        fcntl(connFd, F_SETFL, fcntl(connFd, F_GETFL, 0) | O_NONBLOCK);
+        //The responses to small requests should not be delayed
+        int set = 1;
+        setsockopt(connFd, IPPROTO_TCP, TCP_NODELAY, &set, sizeof(set));
+        Connection &conn = connections[connFd];
+        conn = Connection();
+        conn.lastActivity = _now();
+        watch(connFd, true);
+    }
+}
 
-        int retval = poll(events.data(), events.size(), 1000); //Wait max 1sec
-        if (retval > 0) {
-            //Add to queueReady all sockets which have data
-            for(int i = 0; i < events.size(); ++i) {
-                auto &el = events[i];
-                if (el.fd == -1)
-                    continue;
-                if (el.revents & POLLIN) {
-                    queueReady.push(Socket(el.fd));
-                    el.fd = -1; //Remove it from the list...
-                } else if (el.revents != 0) {
-                    shutdown(el.fd, 2);
-                    close(el.fd);
-                    el.fd = -1;
-                } else {
-                    //No update ...
+void HttpServer::closeConnection(int connFd) {
+    unwatch(connFd);
+    shutdown(connFd, 2);
+    close(connFd);
+    connections.erase(connFd);
+}
+
+bool HttpServer::dispatch(int connFd, Connection &conn) {
+    size_t length;
+    try {
+        length = getRequestLength(conn.buffer);
+    } catch (int code) {
+        LOG(WARNL) << "Malformed request (" << code << ")";
+        std::string response = errorResponse(code);
+        send(connFd, response.c_str(), response.size(), 0);
+        closeConnection(connFd);
+        return true;
+    }
+    if (length == 0) {
+        if (!conn.buffer.empty() && conn.requestStart == 0) {
+            conn.requestStart = _now();
+        }
+        return false;
+    }
+
+    Request r;
+    r.connFd = connFd;
+    r.request = conn.buffer.substr(0, length);
+    r.arrival = _now();
+    r.keepAlive = isKeepAlive(r.request);
+    conn.buffer.erase(0, length);
+    conn.requestStart = conn.buffer.empty() ? 0 : r.arrival;
+    if (!queueRequests.push_bounded(r, maxQueuedRequests)) {
+        //Admission control: the server is overloaded
+        LOG(WARNL) << "Too many requests in the queue. Request rejected";
+        std::string response = errorResponse(503);
+        send(connFd, response.c_str(), response.size(), 0);
+        closeConnection(connFd);
+        return true;
+    }
+    conn.busy = true;
+    return true;
+}
+
+void HttpServer::readConnection(int connFd) {
+    auto it = connections.find(connFd);
+    if (it == connections.end()) {
+        return;
+    }
+    Connection &conn = it->second;
+    char buffer[16 * 1024];
+    while (true) {
+        auto len = read(connFd, buffer, sizeof(buffer));
+        if (len > 0) {
+            conn.buffer.append(buffer, len);
+        } else if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (len < 0 && errno == EINTR) {
+            continue;
+        } else {
+            //The client has closed the connection (or there was an error).
+            //The requests received so far are still answered
+            conn.eof = true;
+            break;
+        }
+    }
+    conn.lastActivity = _now();
+    if (!conn.busy && !dispatch(connFd, conn)) {
+        if (conn.eof) {
+            closeConnection(connFd);
+        } else {
+            rearm(connFd);
+        }
+    }
+}
+
+void HttpServer::checkTimeouts() {
+    const uint64_t now = _now();
+    std::vector<int> toClose;
+    for (auto &pair : connections) {
+        const Connection &conn = pair.second;
+        if (conn.busy) {
+            continue;
+        }
+        if (conn.requestStart != 0 && now - conn.requestStart > requestTimeout) {
+            //The request was not received in time
+            std::string response = errorResponse(408);
+            send(pair.first, response.c_str(), response.size(), 0);
+            toClose.push_back(pair.first);
+        } else if (conn.buffer.empty() && now - conn.lastActivity > maxLifeConn) {
+            toClose.push_back(pair.first);
+        }
+    }
+    for (int fd : toClose) {
+        closeConnection(fd);
+    }
+}
+
+void HttpServer::eventLoop() {
+    std::vector<int> ready;
+    uint64_t lastCheck = _now();
+    while (!stopped) {
+        ready.clear();
+        waitEvents(ready, 500);
+        for (int fd : ready) {
+            if (fd == listenFd) {
+                acceptConnections();
+            } else if (fd == wakeFds[0]) {
+                char buffer[256];
+                while (read(wakeFds[0], buffer, sizeof(buffer)) > 0) {
                 }
-            }
-        } else if (retval == 0) {
-            if (!events.empty() && events.back().fd == -1) {
-                events.pop_back();
-                idletime.pop_back();
-            }
-            //Remove connections that were idle for too long
-            uint64_t time = chr::duration_cast<chr::milliseconds>(
-                    chr::steady_clock::now().time_since_epoch()).count();
-            for(int i = 0; i < events.size(); ++i) {
-                if (events[i].fd != -1) {
-                    if ((idletime[i] + maxLifeConn) < time) {
-                        //Remove it...
-                        shutdown(events[i].fd, 2);
-                        close(events[i].fd);
-                        events[i].fd = -1;
+                //Resume the connections whose request was answered
+                while (!queueCompleted.isEmpty()) {
+                    Completion c;
+                    queueCompleted.pop(c);
+                    auto it = connections.find(c.connFd);
+                    if (it == connections.end()) {
+                        continue;
+                    }
+                    if (c.close) {
+                        closeConnection(c.connFd);
+                        continue;
+                    }
+                    it->second.busy = false;
+                    it->second.lastActivity = _now();
+                    //Pipelined requests may be already in the buffer
+                    if (!dispatch(c.connFd, it->second)) {
+                        if (it->second.eof) {
+                            closeConnection(c.connFd);
+                        } else {
+                            rearm(c.connFd);
+                        }
                     }
                 }
+            } else {
+                readConnection(fd);
             }
-        } else {
-            LOG(ERRORL) << "Pool failed";
+        }
+        if (_now() - lastCheck >= 500) {
+            checkTimeouts();
+            lastCheck = _now();
         }
     }
+
+    //Close all connections
+    std::vector<int> fds;
+    for (auto &pair : connections) {
+        fds.push_back(pair.first);
+    }
+    for (int fd : fds) {
+        closeConnection(fd);
+    }
 }
 
 bool HttpServer::listn() {
@@ -194,6 +582,8 @@ bool HttpServer::listn() {
     if(listenFd < 0) {
         return false;
     }
+    int set = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &set, sizeof(set));
 
     bzero((char*) &svrAdd, sizeof(svrAdd));
     svrAdd.sin_family = AF_INET;
@@ -202,40 +592,56 @@ bool HttpServer::listn() {
     if(bind(listenFd, (struct sockaddr *)&svrAdd, sizeof(svrAdd)) < 0) {
         return false;
     }
-    listen(listenFd, 10);
+    listen(listenFd, SOMAXCONN);
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL, 0) | O_NONBLOCK);
 
-    //Start the thread that process the incoming sockets
-    threadWait = std::thread(&HttpServer::waitForData, this);
-    launched = true;
-    while (true) {
-        //this is where client connects.
-        socklen_t len = sizeof(clntAdd);
-        int connFd = accept(listenFd, (struct sockaddr *)&clntAdd, &len);
-        if (connFd < 0) {
-            return false;
-        }
-        //Make the socket non-blocking
-        //fcntl(connFd, F_SETFL, fcntl(connFd, F_GETFL, 0) | O_NONBLOCK);
-        queueReady.push(Socket(connFd));
+    if (pipe(wakeFds) < 0) {
+        return false;
     }
+    fcntl(wakeFds[0], F_SETFL, fcntl(wakeFds[0], F_GETFL, 0) | O_NONBLOCK);
+    fcntl(wakeFds[1], F_SETFL, fcntl(wakeFds[1], F_GETFL, 0) | O_NONBLOCK);
+#ifdef __linux__
+    pollFd = epoll_create1(0);
+    if (pollFd < 0) {
+        return false;
+    }
+#endif
+    watch(listenFd, false);
+    watch(wakeFds[0], false);
+
+    //A single thread reads the requests and a pool of threads answers them
+    launched = true;
+    eventLoop();
+
+#ifdef __linux__
+    close(pollFd);
+#endif
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+    close(listenFd);
     launched = false;
+    return true;
 }
 
 void HttpServer::start() {
     launched = false;
-    listn();
+    if (!listn()) {
+        LOG(ERRORL) << "The server could not listen to port " << port <<
+            ": " << strerror(errno);
+    }
 }
 
 void HttpServer::stop() {
     //Stop all processing threads
     for(int i = 0; i < threads.size(); ++i)
-        queueReady.push(Socket());
+        queueRequests.push(Request());
     for(auto &t : threads) {
         t.join();
     }
-    close(listenFd);
+    //Stop the event loop
+    stopped = true;
     while (launched) {
-        //TODO Wait until the thread has stopped
+        std::this_thread::sleep_for(chr::milliseconds(10));
     }
 }
 
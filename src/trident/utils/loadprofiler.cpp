@@ -0,0 +1,202 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+#include <trident/utils/loadprofiler.h>
+#include <trident/utils/tridentutils.h>
+
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <iomanip>
+
+#if defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+#include <sys/resource.h>
+#endif
+
+bool LoadProfiler::enabled = false;
+std::mutex LoadProfiler::mutex;
+std::chrono::steady_clock::time_point LoadProfiler::startTime;
+std::vector<LoadProfiler::Phase> LoadProfiler::phases;
+std::map<std::thread::id, int> LoadProfiler::threadIds;
+std::map<int, int> LoadProfiler::openPhases;
+
+static std::string escapeName(const std::string &s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+double LoadProfiler::now() {
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() -
+        startTime;
+    return d.count();
+}
+
+LoadProfiler::Usage LoadProfiler::getUsage() {
+    Usage u;
+    u.cpu = 0;
+    u.bytesRead = u.bytesWritten = u.rss = u.peakRSS = 0;
+#if defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+    struct rusage r;
+    if (getrusage(RUSAGE_SELF, &r) == 0) {
+        u.cpu = r.ru_utime.tv_sec + r.ru_stime.tv_sec +
+            (r.ru_utime.tv_usec + r.ru_stime.tv_usec) / 1000000.0;
+    }
+#endif
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+    u.bytesRead = TridentUtils::diskread();
+    u.bytesWritten = TridentUtils::diskwrite();
+    u.rss = TridentUtils::getVmRSS();
+    u.peakRSS = TridentUtils::getVmHWM();
+#endif
+    return u;
+}
+
+void LoadProfiler::enable() {
+    std::lock_guard<std::mutex> lock(mutex);
+    enabled = true;
+    startTime = std::chrono::steady_clock::now();
+    phases.clear();
+    threadIds.clear();
+    openPhases.clear();
+}
+
+int64_t LoadProfiler::begin(std::string name, std::string category) {
+    if (!enabled) {
+        return -1;
+    }
+    Usage u = getUsage();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto tid = std::this_thread::get_id();
+    if (!threadIds.count(tid)) {
+        const int id = threadIds.size();
+        threadIds[tid] = id;
+    }
+    Phase p;
+    p.name = name;
+    p.category = category;
+    p.thread = threadIds[tid];
+    p.depth = openPhases[p.thread]++;
+    p.start = now();
+    p.end = -1;
+    p.startUsage = u;
+    p.endUsage = u;
+    phases.push_back(p);
+    return phases.size() - 1;
+}
+
+void LoadProfiler::end(int64_t id) {
+    if (id < 0) {
+        return;
+    }
+    Usage u = getUsage();
+    std::lock_guard<std::mutex> lock(mutex);
+    Phase &p = phases[id];
+    p.end = now();
+    p.endUsage = u;
+    openPhases[p.thread]--;
+}
+
+void LoadProfiler::writeReport(std::string file, std::string params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const int hwThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::ofstream out(file);
+    if (!out) {
+        LOG(ERRORL) << "Cannot write the profile " << file;
+        return;
+    }
+    out << std::fixed << std::setprecision(6);
+    out << "{\n  \"params\": \"" << escapeName(params) << "\",\n";
+    out << "  \"hardwareThreads\": " << hwThreads << ",\n";
+    out << "  \"totalWallSec\": " << now() << ",\n";
+    out << "  \"peakRSSKB\": " << getUsage().peakRSS << ",\n";
+    out << "  \"phases\": [";
+    bool first = true;
+    for (const auto &p : phases) {
+        if (p.end < 0) {
+            continue; //The phase did not finish
+        }
+        const double wall = p.end - p.start;
+        const double cpu = p.endUsage.cpu - p.startUsage.cpu;
+        const double threads = wall > 0 ? cpu / wall : 0;
+        out << (first ? "\n" : ",\n");
+        out << "    {\"name\": \"" << escapeName(p.name) << "\", ";
+        out << "\"category\": \"" << escapeName(p.category) << "\", ";
+        out << "\"thread\": " << p.thread << ", ";
+        out << "\"depth\": " << p.depth << ", ";
+        out << "\"startSec\": " << p.start << ", ";
+        out << "\"wallSec\": " << wall << ", ";
+        out << "\"cpuSec\": " << cpu << ", ";
+        out << "\"avgBusyThreads\": " << threads << ", ";
+        out << "\"utilization\": " << threads / hwThreads << ", ";
+        out << "\"bytesRead\": " <<
+            p.endUsage.bytesRead - p.startUsage.bytesRead << ", ";
+        out << "\"bytesWritten\": " <<
+            p.endUsage.bytesWritten - p.startUsage.bytesWritten << ", ";
+        out << "\"rssKB\": " << p.endUsage.rss << ", ";
+        out << "\"peakRSSKB\": " << p.endUsage.peakRSS << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+}
+
+void LoadProfiler::writeTrace(std::string file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream out(file);
+    if (!out) {
+        LOG(ERRORL) << "Cannot write the trace " << file;
+        return;
+    }
+    out << std::fixed << std::setprecision(0);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const auto &p : phases) {
+        if (p.end < 0) {
+            continue;
+        }
+        const double wall = p.end - p.start;
+        const double cpu = p.endUsage.cpu - p.startUsage.cpu;
+        //One complete event per phase
+        out << (first ? "\n" : ",\n");
+        out << "{\"name\": \"" << escapeName(p.name) << "\", \"cat\": \"" <<
+            escapeName(p.category) << "\", \"ph\": \"X\", \"pid\": 1, " <<
+            "\"tid\": " << p.thread << ", \"ts\": " << p.start * 1000000 <<
+            ", \"dur\": " << wall * 1000000 << ", \"args\": {" <<
+            "\"cpuMs\": " << cpu * 1000 << ", \"bytesRead\": " <<
+            p.endUsage.bytesRead - p.startUsage.bytesRead <<
+            ", \"bytesWritten\": " <<
+            p.endUsage.bytesWritten - p.startUsage.bytesWritten << "}}";
+        //Memory counters at the beginning and at the end of the phase
+        out << ",\n{\"name\": \"memory\", \"ph\": \"C\", \"pid\": 1, " <<
+            "\"ts\": " << p.start * 1000000 << ", \"args\": {\"rssMB\": " <<
+            p.startUsage.rss / 1024 << "}}";
+        out << ",\n{\"name\": \"memory\", \"ph\": \"C\", \"pid\": 1, " <<
+            "\"ts\": " << p.end * 1000000 << ", \"args\": {\"rssMB\": " <<
+            p.endUsage.rss / 1024 << "}}";
+        first = false;
+    }
+    out << "\n]}\n";
+}
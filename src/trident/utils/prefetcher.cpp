@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/utils/prefetcher.h>
+
+#if defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+Prefetcher::Prefetcher(const uint64_t maxBytes) : maxBytes(maxBytes),
+    bytesAhead(0), stop(false), lastPage(NULL) {
+#if defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+        pagesize = sysconf(_SC_PAGESIZE);
+#else
+        pagesize = 4096;
+#endif
+        thread = std::thread(&Prefetcher::run, this);
+    }
+
+bool Prefetcher::push(const char *begin, const char *end) {
+    const uint64_t size = end - begin;
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!ahead.empty() && bytesAhead + size > maxBytes) {
+        return false;
+    }
+    ahead.push_back(size);
+    bytesAhead += size;
+    Range r;
+    r.begin = begin;
+    r.end = end;
+    toLoad.push_back(r);
+    lock.unlock();
+    cond.notify_one();
+    return true;
+}
+
+void Prefetcher::consume() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!ahead.empty()) {
+        bytesAhead -= ahead.front();
+        ahead.pop_front();
+        //If the scan has already reached a range, there is no point in
+        //loading it anymore
+        if (toLoad.size() > ahead.size()) {
+            toLoad.pop_front();
+        }
+    }
+}
+
+size_t Prefetcher::getNAhead() {
+    std::unique_lock<std::mutex> lock(mutex);
+    return ahead.size();
+}
+
+void Prefetcher::load(const char *begin, const char *end) {
+    //Align the range to the pages and skip the ones already touched. The
+    //tables are consecutive inside a file, so only the first page of a
+    //range can overlap with the previous one
+    const char *first = begin - ((uintptr_t) begin % pagesize);
+    if (lastPage != NULL && first <= lastPage && lastPage < end) {
+        first = lastPage + pagesize;
+    }
+    if (first >= end) {
+        return;
+    }
+#if defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+    madvise((void*) first, end - first, MADV_WILLNEED);
+#endif
+    volatile char sink = 0;
+    const char *p = first;
+    for (; p < end; p += pagesize) {
+        sink ^= *p;
+        lastPage = p;
+    }
+    (void) sink;
+}
+
+void Prefetcher::run() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this] { return stop || !toLoad.empty(); });
+        if (stop) {
+            break;
+        }
+        Range r = toLoad.front();
+        toLoad.pop_front();
+        lock.unlock();
+        load(r.begin, r.end);
+    }
+}
+
+Prefetcher::~Prefetcher() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cond.notify_one();
+    thread.join();
+}
@@ -0,0 +1,512 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ **/
+
+
+#include <trident/utils/textreader.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <zlib.h>
+#include <lz4.h>
+
+#include <fstream>
+#include <thread>
+#include <condition_variable>
+#include <cstring>
+
+#define LZ4_FRAME_MAGIC 0x184D2204
+#define LZ4_SKIPPABLE_MAGIC 0x184D2A50
+#define LZ4_SKIPPABLE_MASK 0xFFFFFFF0
+
+static uint64_t __readLE(const char *buffer, const int nbytes) {
+    uint64_t n = 0;
+    for (int i = nbytes - 1; i >= 0; --i) {
+        n = (n << 8) | (uint8_t) buffer[i];
+    }
+    return n;
+}
+
+//Returns the size of the BGZF block that starts at buffer (0 if the gzip
+//member does not contain the size)
+static uint64_t __getBGZFBlockSize(const char *buffer, uint64_t len) {
+    if (len < 18 || (uint8_t) buffer[0] != 0x1f ||
+            (uint8_t) buffer[1] != 0x8b || !(buffer[3] & 4)) {
+        return 0;
+    }
+    const uint64_t xlen = __readLE(buffer + 10, 2);
+    if (12 + xlen > len) {
+        return 0;
+    }
+    const char *field = buffer + 12;
+    const char *endExtra = field + xlen;
+    while (field + 4 <= endExtra) {
+        const uint64_t slen = __readLE(field + 2, 2);
+        if (field[0] == 'B' && field[1] == 'C' && slen == 2 &&
+                field + 6 <= endExtra) {
+            return __readLE(field + 4, 2) + 1;
+        }
+        field += 4 + slen;
+    }
+    return 0;
+}
+
+ParallelTextReader::ParallelTextReader(std::string file) : file(file),
+    start(NULL), end(NULL), pos(NULL), insideFrame(false), lz4BlockSize(0),
+    lz4BlockChecksum(false), lz4ContentChecksum(false), lz4Linked(false) {
+        format = getFormat(file);
+        if (Utils::fileSize(file) > 0) {
+            mapping = std::unique_ptr<MemoryMappedFile>(
+                    new MemoryMappedFile(file, true, MAPPING_SEQUENTIAL));
+            start = mapping->getData();
+            end = start + mapping->getLength();
+        }
+    }
+
+ParallelTextReader::Format ParallelTextReader::getFormat(std::string file) {
+    char buffer[1024];
+    std::ifstream in(file, std::ios_base::binary);
+    in.read(buffer, sizeof(buffer));
+    const uint64_t len = in.gcount();
+    if (len >= 4 && __readLE(buffer, 4) == LZ4_FRAME_MAGIC) {
+        return LZ4;
+    }
+    if (len >= 2 && (uint8_t) buffer[0] == 0x1f &&
+            (uint8_t) buffer[1] == 0x8b) {
+        return __getBGZFBlockSize(buffer, len) ? BGZF : GZIP;
+    }
+    return PLAIN;
+}
+
+bool ParallelTextReader::isSplittable(std::string file) {
+    Format format = getFormat(file);
+    if (format == LZ4) {
+        char buffer[5] = { 0 };
+        std::ifstream in(file, std::ios_base::binary);
+        in.read(buffer, 5);
+        return buffer[4] & 0x20; //Independent blocks
+    }
+    return format != GZIP;
+}
+
+bool ParallelTextReader::readLZ4FrameHeader() {
+    while (pos + 4 <= end) {
+        const uint64_t magic = __readLE(pos, 4);
+        if ((magic & LZ4_SKIPPABLE_MASK) == LZ4_SKIPPABLE_MAGIC) {
+            if (pos + 8 > end) {
+                break;
+            }
+            pos += 8 + __readLE(pos + 4, 4);
+            continue;
+        }
+        if (magic != LZ4_FRAME_MAGIC || pos + 7 > end) {
+            break;
+        }
+        const uint8_t flags = pos[4];
+        const uint8_t bd = pos[5];
+        if ((flags >> 6) != 1 || (flags & 1)) {
+            LOG(ERRORL) << "The LZ4 frame in " << file << " uses a version "
+                "or a dictionary that is not supported";
+            throw 10;
+        }
+        const int blockSizeID = (bd >> 4) & 7;
+        if (blockSizeID < 4) {
+            break;
+        }
+        lz4BlockSize = (uint64_t)1 << (2 * blockSizeID + 8);
+        lz4Linked = !(flags & 0x20);
+        lz4BlockChecksum = flags & 0x10;
+        lz4ContentChecksum = flags & 0x04;
+        pos += 7 + ((flags & 0x08) ? 8 : 0);
+        insideFrame = true;
+        return true;
+    }
+    if (pos < end) {
+        LOG(ERRORL) << "The file " << file << " contains an invalid LZ4 frame";
+        throw 10;
+    }
+    return false;
+}
+
+bool ParallelTextReader::nextBlock(Block &block) {
+    switch (format) {
+        case PLAIN:
+            if (pos == end) {
+                return false;
+            }
+            block.data = pos;
+            block.size = std::min((uint64_t)(end - pos),
+                    (uint64_t)TEXTREADER_CHUNK_SIZE);
+            block.rawSize = block.size;
+            block.compressed = false;
+            pos += block.size;
+            return true;
+        case BGZF:
+            if (pos == end) {
+                return false;
+            }
+            block.data = pos;
+            block.size = __getBGZFBlockSize(pos, end - pos);
+            if (block.size < 18 || block.size > (uint64_t)(end - pos)) {
+                LOG(ERRORL) << "The file " << file << " contains a gzip "
+                    "member that is not in the BGZF format";
+                throw 10;
+            }
+            block.rawSize = __readLE(pos + block.size - 4, 4);
+            block.compressed = true;
+            pos += block.size;
+            return true;
+        case LZ4:
+            while (true) {
+                if (!insideFrame && !readLZ4FrameHeader()) {
+                    return false;
+                }
+                if (pos + 4 > end) {
+                    break;
+                }
+                const uint64_t size = __readLE(pos, 4);
+                pos += 4;
+                if (size == 0) {
+                    //End of the frame
+                    pos += lz4ContentChecksum ? 4 : 0;
+                    insideFrame = false;
+                    continue;
+                }
+                block.data = pos;
+                block.size = size & 0x7FFFFFFF;
+                block.compressed = !(size & 0x80000000);
+                block.rawSize = block.compressed ? lz4BlockSize : block.size;
+                if (block.size > (uint64_t)(end - pos)) {
+                    break;
+                }
+                pos += block.size + (lz4BlockChecksum ? 4 : 0);
+                return true;
+            }
+            LOG(ERRORL) << "The LZ4 file " << file << " is truncated";
+            throw 10;
+        default:
+            LOG(ERRORL) << "A gzip file cannot be split in blocks";
+            throw 10;
+    }
+}
+
+bool ParallelTextReader::nextChunk(std::vector<Block> &blocks,
+        Fragments *&frags) {
+    std::lock_guard<std::mutex> l(lock);
+    blocks.clear();
+    uint64_t rawSize = 0;
+    Block block;
+    while (rawSize < TEXTREADER_CHUNK_SIZE && nextBlock(block)) {
+        if (format == LZ4 && lz4Linked) {
+            LOG(ERRORL) << "The file " << file << " mixes LZ4 frames with "
+                "independent and linked blocks";
+            throw 10;
+        }
+        blocks.push_back(block);
+        rawSize += block.rawSize;
+    }
+    if (blocks.empty()) {
+        return false;
+    }
+    fragments.push_back(Fragments());
+    frags = &fragments.back();
+    return true;
+}
+
+void ParallelTextReader::decodeBlock(const Block &block, void *zstream,
+        char *out, uint64_t &outsize) {
+    if (!block.compressed) {
+        memcpy(out, block.data, block.size);
+        outsize = block.size;
+    } else if (format == BGZF) {
+        z_stream *zs = (z_stream*) zstream;
+        inflateReset(zs);
+        zs->next_in = (Bytef*) block.data;
+        zs->avail_in = block.size;
+        zs->next_out = (Bytef*) out;
+        zs->avail_out = block.rawSize;
+        if (inflate(zs, Z_FINISH) != Z_STREAM_END) {
+            LOG(ERRORL) << "Failed decompressing a BGZF block of " << file;
+            throw 10;
+        }
+        outsize = block.rawSize - zs->avail_out;
+    } else {
+        const int n = LZ4_decompress_safe(block.data, out, block.size,
+                block.rawSize);
+        if (n < 0) {
+            LOG(ERRORL) << "Failed decompressing a LZ4 block of " << file;
+            throw 10;
+        }
+        outsize = n;
+    }
+}
+
+void ParallelTextReader::readChunks(int thread, Consumer *consumer) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (format == BGZF && inflateInit2(&zs, 15 + 16) != Z_OK) {
+        LOG(ERRORL) << "Failed initializing zlib";
+        throw 10;
+    }
+    std::vector<char> buffer;
+    std::vector<Block> blocks;
+    Fragments *frags;
+    while (nextChunk(blocks, frags)) {
+        const char *text;
+        uint64_t len = 0;
+        if (blocks.size() == 1 && !blocks[0].compressed) {
+            //Read it directly from the mapped file
+            text = blocks[0].data;
+            len = blocks[0].size;
+        } else {
+            uint64_t rawSize = 0;
+            for (const auto &block : blocks) {
+                rawSize += block.rawSize;
+            }
+            if (buffer.size() < rawSize) {
+                buffer.resize(rawSize);
+            }
+            for (const auto &block : blocks) {
+                uint64_t size;
+                decodeBlock(block, &zs, buffer.data() + len, size);
+                len += size;
+            }
+            text = buffer.data();
+        }
+
+        //The text before the first newline and after the last one belongs
+        //to lines that continue in the other chunks
+        const char *first = (const char*) memchr(text, '\n', len);
+        if (first == NULL) {
+            frags->head.assign(text, len);
+            continue;
+        }
+        const char *last = text + len - 1;
+        while (*last != '\n') {
+            last--;
+        }
+        frags->head.assign(text, first + 1 - text);
+        frags->tail.assign(last + 1, text + len - last - 1);
+        if (first < last) {
+            (*consumer)(first + 1, last + 1, thread);
+        }
+    }
+    if (format == BGZF) {
+        inflateEnd(&zs);
+    }
+}
+
+void ParallelTextReader::readParallel(int nthreads, Consumer &consumer) {
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nthreads; ++i) {
+        threads.push_back(std::thread(&ParallelTextReader::readChunks, this,
+                    i, &consumer));
+    }
+    readChunks(0, &consumer);
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    //Glue the pieces of the lines that crossed the chunks
+    std::string rest;
+    for (const auto &frags : fragments) {
+        rest += frags.head;
+        rest += frags.tail;
+    }
+    fragments.clear();
+    if (!rest.empty()) {
+        consumer(rest.data(), rest.data() + rest.size(), 0);
+    }
+}
+
+void ParallelTextReader::readSequential(int nthreads, Consumer &consumer) {
+    //One thread decompresses the file and passes the text to the others
+    //in chunks of complete lines
+    std::mutex m;
+    std::condition_variable condFree, condReady;
+    std::deque<std::vector<char>*> freeBuffers, readyBuffers;
+    std::vector<std::unique_ptr<std::vector<char>>> buffers;
+    bool finished = false;
+    for (int i = 0; i < 2 * nthreads; ++i) {
+        buffers.push_back(std::unique_ptr<std::vector<char>>(
+                    new std::vector<char>()));
+        freeBuffers.push_back(buffers.back().get());
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; ++i) {
+        threads.push_back(std::thread([&, i]() {
+            std::unique_lock<std::mutex> l(m);
+            while (true) {
+                while (readyBuffers.empty() && !finished) {
+                    condReady.wait(l);
+                }
+                if (readyBuffers.empty()) {
+                    break;
+                }
+                std::vector<char> *b = readyBuffers.front();
+                readyBuffers.pop_front();
+                l.unlock();
+                consumer(b->data(), b->data() + b->size(), i);
+                l.lock();
+                freeBuffers.push_back(b);
+                condFree.notify_one();
+            }
+        }));
+    }
+    auto getFree = [&]() {
+        std::unique_lock<std::mutex> l(m);
+        while (freeBuffers.empty()) {
+            condFree.wait(l);
+        }
+        std::vector<char> *b = freeBuffers.front();
+        freeBuffers.pop_front();
+        b->clear();
+        return b;
+    };
+    auto push = [&](std::vector<char> *b) {
+        std::unique_lock<std::mutex> l(m);
+        readyBuffers.push_back(b);
+        condReady.notify_one();
+    };
+
+    std::vector<char> *current = getFree();
+    auto emit = [&](const char *text, uint64_t len) {
+        current->insert(current->end(), text, text + len);
+        if (current->size() >= TEXTREADER_CHUNK_SIZE) {
+            uint64_t last = current->size();
+            while (last > 0 && (*current)[last - 1] != '\n') {
+                last--;
+            }
+            if (last > 0) {
+                std::vector<char> *next = getFree();
+                next->insert(next->end(), current->begin() + last,
+                        current->end());
+                current->resize(last);
+                push(current);
+                current = next;
+            }
+        }
+    };
+
+    if (format == GZIP) {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (inflateInit2(&zs, 15 + 16) != Z_OK) {
+            LOG(ERRORL) << "Failed initializing zlib";
+            throw 10;
+        }
+        std::vector<char> out(1024 * 1024);
+        const char *fed = start;
+        while (true) {
+            if (zs.avail_in == 0 && fed < end) {
+                zs.next_in = (Bytef*) fed;
+                zs.avail_in = std::min((uint64_t)(end - fed),
+                        (uint64_t)1 << 30);
+                fed += zs.avail_in;
+            }
+            zs.next_out = (Bytef*) out.data();
+            zs.avail_out = out.size();
+            const int ret = inflate(&zs, Z_NO_FLUSH);
+            emit(out.data(), out.size() - zs.avail_out);
+            if (ret == Z_STREAM_END) {
+                if (zs.avail_in == 0 && fed == end) {
+                    break;
+                }
+                //Another gzip member follows, unless it is only padding
+                const char *next = zs.avail_in ? (const char*) zs.next_in : fed;
+                if ((uint8_t) next[0] != 0x1f) {
+                    LOG(WARNL) << "Ignoring the trailing bytes of " << file;
+                    break;
+                }
+                inflateReset(&zs);
+            } else if (ret != Z_OK &&
+                    (ret != Z_BUF_ERROR || (zs.avail_in == 0 && fed == end))) {
+                LOG(ERRORL) << "The gzip file " << file << " is corrupted "
+                    "or truncated";
+                throw 10;
+            }
+        }
+        inflateEnd(&zs);
+    } else {
+        //LZ4 frames with linked blocks. Every block can refer to the
+        //previous one, so the last two are kept in a double buffer
+        LZ4_streamDecode_t *stream = LZ4_createStreamDecode();
+        std::vector<char> out;
+        int slot = 0;
+        Block block;
+        while (true) {
+            const bool newFrame = !insideFrame;
+            if (!nextBlock(block)) {
+                break;
+            }
+            if (newFrame) {
+                LZ4_setStreamDecode(stream, NULL, 0);
+                out.resize(2 * lz4BlockSize);
+            }
+            char *dest = out.data() + slot * lz4BlockSize;
+            int n;
+            if (block.compressed) {
+                n = lz4Linked ? LZ4_decompress_safe_continue(stream,
+                        block.data, dest, block.size, lz4BlockSize) :
+                    LZ4_decompress_safe(block.data, dest, block.size,
+                            lz4BlockSize);
+            } else {
+                memcpy(dest, block.data, block.size);
+                n = block.size;
+                LZ4_setStreamDecode(stream, dest, n);
+            }
+            if (n < 0) {
+                LOG(ERRORL) << "Failed decompressing a LZ4 block of " << file;
+                throw 10;
+            }
+            emit(dest, n);
+            slot = 1 - slot;
+        }
+        LZ4_freeStreamDecode(stream);
+    }
+    if (!current->empty()) {
+        push(current);
+    }
+
+    {
+        std::unique_lock<std::mutex> l(m);
+        finished = true;
+        condReady.notify_all();
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+void ParallelTextReader::read(int nthreads, Consumer consumer) {
+    if (start == end) {
+        return;
+    }
+    nthreads = std::max(nthreads, 1);
+    pos = start;
+    insideFrame = false;
+    if (isSplittable(file)) {
+        readParallel(nthreads, consumer);
+    } else {
+        readSequential(nthreads, consumer);
+    }
+}
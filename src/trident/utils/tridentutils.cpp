@@ -65,6 +65,21 @@ int64_t TridentUtils::getVmRSS() {
     return result;
 }
 
+int64_t TridentUtils::getVmHWM() {
+    FILE* file = fopen("/proc/self/status", "r");
+    int64_t result = -1;
+    char line[128];
+
+    while (fgets(line, 128, file) != NULL){
+        if (strncmp(line, "VmHWM:", 6) == 0){
+            result = parseLine(line, 3);
+            break;
+        }
+    }
+    fclose(file);
+    return result;
+}
+
 static uint64_t lastTotalUser = 0, lastTotalUserLow = 0, lastTotalSys = 0, lastTotalIdle = 0;
 double TridentUtils::getCPUUsage() {
     double percent;
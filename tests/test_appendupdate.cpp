@@ -0,0 +1,188 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <set>
+#include <tuple>
+
+#include <kognac/utils.h>
+#include <trident/loader.h>
+#include <trident/kb/kb.h>
+#include <trident/kb/kbconfig.h>
+#include <trident/kb/querier.h>
+#include <trident/kb/dictmgmt.h>
+#include <trident/kb/updater.h>
+
+using namespace std;
+
+typedef std::tuple<string, string, string> TextTriple;
+
+static string term(const string &prefix, int i) {
+    return "<http://test/" + prefix + to_string(i) + ">";
+}
+
+static void writeTriples(const string &file, const std::set<TextTriple> &triples) {
+    ofstream out(file);
+    for (const auto &t : triples) {
+        out << get<0>(t) << " " << get<1>(t) << " " << get<2>(t) << " .\n";
+    }
+}
+
+//Brings the three values returned by an iterator back to (s, p, o)
+static void unpermute(const int perm, const int64_t k, const int64_t v1,
+        const int64_t v2, int64_t &s, int64_t &p, int64_t &o) {
+    switch (perm) {
+        case IDX_SPO:
+            s = k; p = v1; o = v2;
+            break;
+        case IDX_SOP:
+            s = k; o = v1; p = v2;
+            break;
+        case IDX_POS:
+            p = k; o = v1; s = v2;
+            break;
+        case IDX_PSO:
+            p = k; s = v1; o = v2;
+            break;
+        case IDX_OSP:
+            o = k; s = v1; p = v2;
+            break;
+        default:
+            o = k; p = v1; s = v2;
+    }
+}
+
+//The scans of all permutations and the lookups must return exactly the
+//expected triples
+static bool check(const string &kbdir, const std::set<TextTriple> &expected) {
+    if (Utils::exists(kbdir + "/_append")) {
+        cout << "ERROR: the append left its files in the KB" << endl;
+        return false;
+    }
+    KBConfig config;
+    KB kb(kbdir.c_str(), true, false, true, config);
+    if (kb.getSize() != (int64_t) expected.size()) {
+        cout << "ERROR: the KB has " << kb.getSize() << " triples, expected "
+            << expected.size() << endl;
+        return false;
+    }
+    DictMgmt *dict = kb.getDictMgmt();
+    Querier *q = kb.query();
+    bool ok = true;
+    for (int perm = 0; perm < 6 && ok; ++perm) {
+        std::set<TextTriple> found;
+        int64_t rows = 0;
+        PairItr *itr = q->getPermuted(perm, -1, -1, -1);
+        while (itr->hasNext()) {
+            itr->next();
+            int64_t s, p, o;
+            unpermute(perm, itr->getKey(), itr->getValue1(), itr->getValue2(),
+                    s, p, o);
+            string ts, tp, to;
+            if (!dict->getText(s, ts) || !dict->getText(p, tp) ||
+                    !dict->getText(o, to)) {
+                cout << "ERROR: perm " << perm << " returns unknown terms" << endl;
+                ok = false;
+                break;
+            }
+            found.insert(make_tuple(ts, tp, to));
+            rows++;
+        }
+        q->releaseItr(itr);
+        if (ok && (found != expected || rows != (int64_t) expected.size())) {
+            cout << "ERROR: the scan of perm " << perm << " returns " << rows <<
+                " rows, expected " << expected.size() << endl;
+            ok = false;
+        }
+    }
+    for (auto t = expected.begin(); t != expected.end() && ok; ++t) {
+        nTerm s, p, o;
+        if (!dict->getNumber(get<0>(*t).c_str(), get<0>(*t).size(), &s) ||
+                !dict->getNumber(get<1>(*t).c_str(), get<1>(*t).size(), &p) ||
+                !dict->getNumber(get<2>(*t).c_str(), get<2>(*t).size(), &o)) {
+            cout << "ERROR: the terms of " << get<0>(*t) << " " << get<1>(*t)
+                << " " << get<2>(*t) << " are not in the dictionary" << endl;
+            ok = false;
+            break;
+        }
+        PairItr *itr = q->getPermuted(IDX_SPO, s, p, o);
+        if (!itr->hasNext()) {
+            cout << "ERROR: the lookup of " << get<0>(*t) << " " << get<1>(*t)
+                << " " << get<2>(*t) << " failed" << endl;
+            ok = false;
+        }
+        q->releaseItr(itr);
+        //The same triple through another permutation
+        itr = q->getPermuted(IDX_POS, p, o, -1);
+        ok = ok && itr->hasNext();
+        q->releaseItr(itr);
+    }
+    delete q;
+    return ok;
+}
+
+int main(int argc, const char** argv) {
+    const string dir = argc > 1 ? argv[1] : "/tmp/test_appendupdate";
+    if (Utils::exists(dir)) {
+        Utils::remove_all(dir);
+    }
+    const string kbdir = dir + "/kb";
+    for (auto d : { "/input", "/update1", "/update2" }) {
+        Utils::create_directories(dir + d);
+    }
+
+    std::set<TextTriple> expected;
+    for (int i = 0; i < 300; ++i) {
+        expected.insert(make_tuple(term("s", i % 50), term("p", i % 3),
+                    term("o", i)));
+    }
+    writeTriples(dir + "/input/data.nt", expected);
+    ParamsLoad p;
+    p.triplesInputDir = dir + "/input";
+    p.kbDir = kbdir;
+    p.tmpDir = kbdir;
+    p.sample = false;
+    p.parallelThreads = 2;
+    p.maxReadingThreads = 1;
+    Loader loader;
+    loader.load(p);
+    if (!check(kbdir, expected)) {
+        return 1;
+    }
+
+    //New objects for some of the subjects, new subjects and a triple that
+    //is already in the KB. Only a few tables are replaced
+    std::set<TextTriple> update;
+    for (int i = 0; i < 10; ++i) {
+        update.insert(make_tuple(term("s", i), term("p", 0), term("n", i)));
+    }
+    for (int i = 50; i < 55; ++i) {
+        update.insert(make_tuple(term("s", i), term("p", 1), term("o", i)));
+    }
+    update.insert(make_tuple(term("s", 0), term("p", 0), term("o", 0)));
+    writeTriples(dir + "/update1/data.nt", update);
+    expected.insert(update.begin(), update.end());
+    Updater up;
+    up.appendupdate(kbdir, dir + "/update1");
+    if (!check(kbdir, expected)) {
+        return 1;
+    }
+    cout << "First append OK" << endl;
+
+    //A new predicate for every subject. The subject tables are all replaced,
+    //so the permutations are compacted
+    update.clear();
+    for (int i = 0; i < 55; ++i) {
+        update.insert(make_tuple(term("s", i), term("p", 3), term("m", i % 7)));
+    }
+    update.insert(make_tuple(term("s", 3), term("p", 0), term("n", 3)));
+    writeTriples(dir + "/update2/data.nt", update);
+    expected.insert(update.begin(), update.end());
+    up.appendupdate(kbdir, dir + "/update2");
+    if (!check(kbdir, expected)) {
+        return 1;
+    }
+    cout << "Second append OK" << endl;
+
+    Utils::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+#include <trident/utils/blockcodec.h>
+
+using namespace std;
+
+//Generates a table sorted by (v1, v2) where each first term has a group of
+//on average "groupSize" rows
+static void generate(const size_t n, const int groupSize, const int64_t maxGap,
+        std::vector<int64_t> &v1, std::vector<int64_t> &v2) {
+    int64_t first = rand() % 1000;
+    int64_t second = rand() % maxGap;
+    for (size_t i = 0; i < n; ++i) {
+        if (rand() % groupSize == 0) {
+            first += 1 + rand() % 100;
+            second = rand() % (maxGap * 1000);
+        } else {
+            second += 1 + rand() % maxGap;
+        }
+        v1.push_back(first);
+        v2.push_back(second);
+    }
+}
+
+int main(int argc, const char** argv) {
+    const size_t n = 10000000;
+    srand(0);
+    const int codecs[] = { BLOCKCODEC_PFOR, BLOCKCODEC_LZ4 };
+    const int groupSizes[] = { 1, 10, 1000 };
+    for (int groupSize : groupSizes) {
+        std::vector<int64_t> v1, v2;
+        generate(n, groupSize, 1000, v1, v2);
+        for (int codec : codecs) {
+            std::vector<char> buffer(BlockCodec::maxEncodedSize(COMPR_BLOCK_ROWS));
+            std::vector<char> scratch(BlockCodec::scratchSize(COMPR_BLOCK_ROWS));
+            int64_t out1[COMPR_BLOCK_ROWS];
+            int64_t out2[COMPR_BLOCK_ROWS];
+            size_t totalSize = 0;
+            std::chrono::duration<double> secDecode(0);
+            for (size_t i = 0; i < n; i += COMPR_BLOCK_ROWS) {
+                const size_t rows = std::min((size_t) COMPR_BLOCK_ROWS, n - i);
+                const size_t size = BlockCodec::encode(codec, v1.data() + i,
+                        v2.data() + i, rows, buffer.data());
+                totalSize += size;
+                std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+                BlockCodec::decode(codec, buffer.data(), size, rows, out1, out2,
+                        scratch.data());
+                secDecode += std::chrono::system_clock::now() - start;
+                for (size_t j = 0; j < rows; ++j) {
+                    if (out1[j] != v1[i + j] || out2[j] != v2[i + j]) {
+                        LOG(ERRORL) << "Mismatch at " << i + j << " codec=" << codec;
+                        return 1;
+                    }
+                }
+            }
+            cout << "codec=" << codec << " groupSize=" << groupSize <<
+                " bytes/row=" << (double) totalSize / n << " decode=" <<
+                secDecode.count() * 1000 << "ms" << endl;
+        }
+    }
+    return 0;
+}
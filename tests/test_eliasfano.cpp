@@ -0,0 +1,57 @@
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include <kognac/logs.h>
+#include <trident/utils/eliasfano.h>
+
+using namespace std;
+
+int main(int argc, const char** argv) {
+    const size_t n = 10000000;
+    srand(0);
+    const uint64_t maxGaps[] = { 1, 10, 1000 };
+    for (uint64_t maxGap : maxGaps) {
+        std::vector<uint64_t> values;
+        uint64_t v = rand() % 1000;
+        for (size_t i = 0; i < n; ++i) {
+            v += 1 + rand() % maxGap;
+            values.push_back(v);
+        }
+        std::vector<uint64_t> encoded;
+        EliasFano::encode(values.data(), n, encoded);
+        EliasFano ef;
+        ef.init((const char*) encoded.data());
+
+        //Sequential access
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            if (ef.select(i) != values[i]) {
+                LOG(ERRORL) << "Mismatch at " << i << " maxGap=" << maxGap;
+                return 1;
+            }
+        }
+        std::chrono::duration<double> secSelect = std::chrono::system_clock::now() - start;
+
+        //Random lookups
+        const size_t nlookups = 1000000;
+        start = std::chrono::system_clock::now();
+        for (size_t i = 0; i < nlookups; ++i) {
+            const uint64_t x = rand() % (values.back() + 2);
+            const uint64_t expected = std::lower_bound(values.begin(),
+                    values.end(), x) - values.begin();
+            if (ef.nextGEQ(x) != expected) {
+                LOG(ERRORL) << "nextGEQ(" << x << ") failed maxGap=" << maxGap;
+                return 1;
+            }
+        }
+        std::chrono::duration<double> secLookup = std::chrono::system_clock::now() - start;
+        cout << "maxGap=" << maxGap << " bits/value=" <<
+            (double) ef.sizeInBytes() * 8 / n << " select=" <<
+            secSelect.count() * 1000 << "ms nextGEQ=" <<
+            secLookup.count() * 1000 << "ms" << endl;
+    }
+    return 0;
+}
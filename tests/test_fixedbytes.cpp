@@ -0,0 +1,63 @@
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+#include <trident/utils/fixedbytes.h>
+
+using namespace std;
+
+int main(int argc, const char** argv) {
+    const size_t n = 10000000;
+    srand(0);
+    cout << "AVX2=" << FixedBytesDecoder::hasAVX2() << " SSSE3=" <<
+        FixedBytesDecoder::hasSSSE3() << endl;
+
+    for (int nbytes = 1; nbytes <= 8; ++nbytes) {
+        std::vector<char> buffer(n * nbytes);
+        for (size_t i = 0; i < n; ++i) {
+            Utils::encode_longNBytes(buffer.data() + i * nbytes, nbytes,
+                    ((uint64_t) rand() << 31 | rand()) &
+                    (nbytes == 8 ? ~0ul : ((1ul << (nbytes * 8)) - 1)));
+        }
+
+        std::vector<int64_t> expected(n);
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            expected[i] = Utils::decode_longFixedBytes(buffer.data() + i * nbytes,
+                    nbytes);
+        }
+        std::chrono::duration<double> secRef = std::chrono::system_clock::now() - start;
+
+        //The scalar kernel is the reference of the vectorized ones
+        std::vector<int64_t> scalar(n);
+        start = std::chrono::system_clock::now();
+        FixedBytesDecoder::decode_scalar(buffer.data(), nbytes, scalar.data(), n);
+        std::chrono::duration<double> secScalar = std::chrono::system_clock::now() - start;
+
+        std::vector<int64_t> output(n);
+        start = std::chrono::system_clock::now();
+        FixedBytesDecoder::decode(buffer.data(), buffer.data() + buffer.size(),
+                nbytes, output.data(), n);
+        std::chrono::duration<double> secBlock = std::chrono::system_clock::now() - start;
+
+        for (size_t i = 0; i < n; ++i) {
+            if (scalar[i] != expected[i]) {
+                LOG(ERRORL) << "Scalar mismatch at " << i << " nbytes=" <<
+                    nbytes << " " << scalar[i] << " " << expected[i];
+                return 1;
+            }
+            if (output[i] != scalar[i]) {
+                LOG(ERRORL) << "Mismatch at " << i << " nbytes=" << nbytes <<
+                    " " << output[i] << " " << scalar[i];
+                return 1;
+            }
+        }
+        cout << "nbytes=" << nbytes << " ref=" << secRef.count() * 1000 <<
+            "ms scalar=" << secScalar.count() * 1000 <<
+            "ms block=" << secBlock.count() * 1000 << "ms" << endl;
+    }
+    return 0;
+}
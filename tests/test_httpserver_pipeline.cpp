@@ -0,0 +1,252 @@
+#include <trident/utils/httpserver.h>
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <sys/time.h>
+
+using namespace std;
+
+//Answers with the request line and the body, so that the client can check
+//which request a response belongs to. The responses to /stream are
+//streamed with the writer
+static void processRequest(const string &request, string &response,
+        HttpChunkedWriter &writer) {
+    string line = request.substr(0, request.find("\r\n"));
+    string body = request.substr(request.find("\r\n\r\n") + 4);
+    string content = line + "|" + body;
+    if (line.find(" /stream ") != string::npos) {
+        writer.start("text/plain");
+        writer.write(line);
+        writer.flush();
+        writer.write("|" + body);
+        return;
+    }
+    response = "HTTP/1.1 200 OK\r\nContent-Length: " +
+        to_string(content.size()) + "\r\n\r\n" + content;
+}
+
+static int connectTo(uint32_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    struct timeval tv;
+    tv.tv_sec = 5;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+static bool sendString(int fd, const string &data) {
+    return send(fd, data.c_str(), data.size(), 0) == (ssize_t) data.size();
+}
+
+//Reads one response. Returns false if the connection was closed (or the
+//read timed out) before a complete response arrived
+static bool readResponse(int fd, string &buffer, string &status,
+        string &body, bool &close) {
+    while (true) {
+        size_t headerEnd = buffer.find("\r\n\r\n");
+        if (headerEnd != string::npos) {
+            string headers = buffer.substr(0, headerEnd);
+            size_t pos = headers.find("Content-Length: ");
+            size_t length = pos == string::npos ? 0 :
+                stoul(headers.substr(pos + 16));
+            if (buffer.size() >= headerEnd + 4 + length) {
+                status = headers.substr(0, headers.find("\r\n"));
+                body = buffer.substr(headerEnd + 4, length);
+                close = headers.find("Connection: close") != string::npos;
+                buffer.erase(0, headerEnd + 4 + length);
+                return true;
+            }
+        }
+        char tmp[4096];
+        ssize_t len = recv(fd, tmp, sizeof(tmp), 0);
+        if (len <= 0) {
+            return false;
+        }
+        buffer.append(tmp, len);
+    }
+}
+
+//True if the server has closed the connection
+static bool isClosed(int fd) {
+    char tmp;
+    return recv(fd, &tmp, 1, 0) == 0;
+}
+
+static bool expect(int fd, string &buffer, const string &status,
+        const string &body, bool close) {
+    string s, b;
+    bool c;
+    if (!readResponse(fd, buffer, s, b, c)) {
+        cout << "ERROR: no response, expected " << status << endl;
+        return false;
+    }
+    if (s != status || (!body.empty() && b != body) || c != close) {
+        cout << "ERROR: got \"" << s << "\" \"" << b << "\" close=" << c <<
+            ", expected \"" << status << "\" \"" << body << "\" close=" <<
+            close << endl;
+        return false;
+    }
+    return true;
+}
+
+//Several requests in the same packet are answered in order, and the
+//connection stays open until the client asks to close it
+static bool testPipeline(uint32_t port) {
+    int fd = connectTo(port);
+    if (fd < 0) {
+        cout << "ERROR: could not connect" << endl;
+        return false;
+    }
+    string buffer;
+    bool ok = sendString(fd,
+            "GET /a HTTP/1.1\r\nHost: x\r\n\r\n"
+            "POST /b HTTP/1.1\r\nHost: x\r\nContent-Length: 5\r\n\r\nhello"
+            "GET /c HTTP/1.1\r\nHost: x\r\n\r\n") &&
+        expect(fd, buffer, "HTTP/1.1 200 OK", "GET /a HTTP/1.1|", false) &&
+        expect(fd, buffer, "HTTP/1.1 200 OK", "POST /b HTTP/1.1|hello", false) &&
+        expect(fd, buffer, "HTTP/1.1 200 OK", "GET /c HTTP/1.1|", false);
+    //The connection is kept alive
+    ok = ok && sendString(fd, "GET /d HTTP/1.1\r\nHost: x\r\n\r\n") &&
+        expect(fd, buffer, "HTTP/1.1 200 OK", "GET /d HTTP/1.1|", false);
+    //A request split in several packets
+    ok = ok && sendString(fd, "POST /e HTTP/1.1\r\nContent-Le");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ok = ok && sendString(fd, "ngth: 3\r\n\r\nab");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ok = ok && sendString(fd, "c") &&
+        expect(fd, buffer, "HTTP/1.1 200 OK", "POST /e HTTP/1.1|abc", false);
+    //The last request closes the connection
+    ok = ok && sendString(fd,
+            "GET /f HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n") &&
+        expect(fd, buffer, "HTTP/1.1 200 OK", "GET /f HTTP/1.1|", true) &&
+        isClosed(fd);
+    close(fd);
+    if (ok) {
+        cout << "Pipelining and keep-alive OK" << endl;
+    }
+    return ok;
+}
+
+//HTTP/1.0 closes the connection unless the client asks to keep it
+static bool testHttp10(uint32_t port) {
+    int fd = connectTo(port);
+    string buffer;
+    bool ok = fd >= 0 &&
+        sendString(fd, "GET /a HTTP/1.0\r\nConnection: keep-alive\r\n\r\n") &&
+        expect(fd, buffer, "HTTP/1.1 200 OK", "GET /a HTTP/1.0|", false) &&
+        sendString(fd, "GET /b HTTP/1.0\r\n\r\n") &&
+        expect(fd, buffer, "HTTP/1.1 200 OK", "GET /b HTTP/1.0|", true) &&
+        isClosed(fd);
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (ok) {
+        cout << "HTTP/1.0 OK" << endl;
+    }
+    return ok;
+}
+
+//Reads everything until the server closes the connection
+static string readAll(int fd) {
+    string data;
+    char tmp[4096];
+    ssize_t len;
+    while ((len = recv(fd, tmp, sizeof(tmp), 0)) > 0) {
+        data.append(tmp, len);
+    }
+    return len == 0 ? data : "";
+}
+
+//The streamed responses are chunked for HTTP/1.1. HTTP/1.0 clients do not
+//know chunks, so they get the plain body followed by the end of the
+//connection, even if they asked to keep it alive
+static bool testStream(uint32_t port) {
+    int fd = connectTo(port);
+    bool ok = fd >= 0 &&
+        sendString(fd, "GET /stream HTTP/1.1\r\nConnection: close\r\n\r\n") &&
+        readAll(fd) == "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+        "Transfer-Encoding: chunked\r\nConnection: close\r\n\r\n"
+        "14\r\nGET /stream HTTP/1.1\r\n1\r\n|\r\n0\r\n\r\n";
+    if (fd >= 0) {
+        close(fd);
+    }
+    fd = connectTo(port);
+    ok = ok && fd >= 0 &&
+        sendString(fd, "GET /stream HTTP/1.0\r\nConnection: keep-alive\r\n\r\n") &&
+        readAll(fd) == "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+        "Connection: close\r\n\r\nGET /stream HTTP/1.0|";
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (ok) {
+        cout << "Streaming OK" << endl;
+    } else {
+        cout << "ERROR: wrong streamed response" << endl;
+    }
+    return ok;
+}
+
+//The malformed requests are rejected with the right status and the
+//connection is closed, also if they follow a valid request
+static bool testError(uint32_t port, const string &request,
+        const string &status) {
+    int fd = connectTo(port);
+    string buffer;
+    bool ok = fd >= 0 &&
+        sendString(fd, "GET /a HTTP/1.1\r\n\r\n" + request) &&
+        expect(fd, buffer, "HTTP/1.1 200 OK", "GET /a HTTP/1.1|", false) &&
+        expect(fd, buffer, status, "", true) && isClosed(fd);
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (ok) {
+        cout << status << " OK" << endl;
+    }
+    return ok;
+}
+
+int main(int argc, const char** argv) {
+    uint32_t port = argc > 1 ? stoi(argv[1]) : 8089;
+    HttpServer server(port, &processRequest, 2);
+    std::thread t(&HttpServer::start, &server);
+    for (int i = 0; i < 500 && !server.isLaunched(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    bool ok = server.isLaunched();
+    if (!ok) {
+        cout << "ERROR: the server did not start" << endl;
+    }
+    ok = ok && testPipeline(port) && testHttp10(port) &&
+        testStream(port) &&
+        testError(port, "POST /b HTTP/1.1\r\nTransfer-Encoding: chunked\r\n"
+                "\r\n5\r\nhello\r\n0\r\n\r\n",
+                "HTTP/1.1 411 Length Required") &&
+        testError(port, "POST /b HTTP/1.1\r\nContent-Length: 4\r\n"
+                "Transfer-Encoding: chunked\r\n\r\n0\r\n\r\n",
+                "HTTP/1.1 411 Length Required") &&
+        testError(port, "POST /b HTTP/1.1\r\nTransfer-Encoding: gzip\r\n"
+                "Content-Length: 4\r\n\r\nabcd",
+                "HTTP/1.1 501 Not Implemented") &&
+        testError(port, "POST /b HTTP/1.1\r\nContent-Length: x\r\n\r\n",
+                "HTTP/1.1 400 Bad Request") &&
+        testError(port, "POST /b HTTP/1.1\r\nContent-Length: "
+                "99999999999\r\n\r\n",
+                "HTTP/1.1 413 Payload Too Large");
+    server.stop();
+    t.join();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include <kognac/utils.h>
+#include <trident/binarytables/newcolumntable.h>
+
+using namespace std;
+
+//Creates a NewColumnTable with nkeys first terms, which start from "first"
+//and are "keyGap" apart. Each of them has "perkey" second terms, which are
+//consecutive multiples of "gap" (plus "first")
+void createTable(std::vector<char> &buffer, const int64_t nkeys,
+        const int64_t perkey, const int64_t gap, const int64_t keyGap = 1,
+        const int64_t first = 0) {
+    const uint8_t b1 = 4, b2 = 5, bc = 4, bs = 5;
+    const int64_t nterms = nkeys * perkey;
+    buffer.resize(2 + 20 + (b1 + bc + bs) * nkeys + b2 * nterms);
+    buffer[0] = (b1 << 3) | b2;
+    buffer[1] = (bc << 3) | bs;
+    int offset = 2;
+    offset = Utils::encode_vlong2(buffer.data(), offset, nkeys);
+    offset = Utils::encode_vlong2(buffer.data(), offset, nterms);
+    char *pos1 = buffer.data() + offset;
+    char *pos2 = pos1 + (b1 + bc + bs) * nkeys;
+    for (int64_t i = 0; i < nkeys; ++i) {
+        Utils::encode_longNBytes(pos1, b1, first + i * keyGap);
+        Utils::encode_longNBytes(pos1 + b1, bc, perkey);
+        Utils::encode_longNBytes(pos1 + b1 + bc, bs, i * perkey);
+        pos1 += b1 + bc + bs;
+        for (int64_t j = 0; j < perkey; ++j) {
+            Utils::encode_longNBytes(pos2, b2, first + j * gap);
+            pos2 += b2;
+        }
+    }
+    buffer.resize(pos2 - buffer.data());
+}
+
+//Emulates the right side of a merge join: the left side produces a target
+//every "skip" entries of the right side, and the right side must move to it
+int64_t join(std::vector<char> &buffer, const int64_t nkeys,
+        const int64_t perkey, const int64_t gap, const int64_t skip,
+        const bool onFirstColumn) {
+    NewColumnTable table;
+    table.setup(buffer.data(), buffer.data() + buffer.size());
+    int64_t matches = 0;
+    table.hasNext();
+    table.next();
+    if (onFirstColumn) {
+        for (int64_t k = skip; k < nkeys; k += skip) {
+            table.moveto(k, 0);
+            if (!table.hasNext())
+                break;
+            table.next();
+            matches += table.getValue1() == k;
+        }
+    } else {
+        for (int64_t j = skip; j < perkey; j += skip) {
+            table.moveto(0, j * gap);
+            if (!table.hasNext())
+                break;
+            table.next();
+            matches += table.getValue2() == j * gap;
+        }
+    }
+    return matches;
+}
+
+//Binary search over all the entries in [s, e), as moveto did before the
+//galloping search. Returns the first entry that is not less than target
+const char *binarySearch(const char *s, const char *e, const size_t stride,
+        const uint8_t bytes, const int64_t target) {
+    while (s < e) {
+        const char *middle = s + ((e - s) / stride / 2) * stride;
+        if (Utils::decode_longFixedBytes(middle, bytes) < target) {
+            s = middle + stride;
+        } else {
+            e = middle;
+        }
+    }
+    return s;
+}
+
+//Same join as above, but every move searches the whole remaining range.
+//It reads the table created by createTable directly
+int64_t baselineJoin(std::vector<char> &buffer, const int64_t nkeys,
+        const int64_t perkey, const int64_t gap, const int64_t skip,
+        const bool onFirstColumn) {
+    const uint8_t b1 = 4, b2 = 5, bc = 4, bs = 5;
+    int offset = 2;
+    Utils::decode_vlong2(buffer.data(), &offset);
+    Utils::decode_vlong2(buffer.data(), &offset);
+    const char *start1 = buffer.data() + offset;
+    const char *end1 = start1 + (b1 + bc + bs) * nkeys;
+    const char *end2 = buffer.data() + buffer.size();
+    int64_t matches = 0;
+    if (onFirstColumn) {
+        const char *current = start1;
+        for (int64_t k = skip; k < nkeys; k += skip) {
+            current = binarySearch(current, end1, b1 + bc + bs, b1, k);
+            if (current == end1)
+                break;
+            matches += Utils::decode_longFixedBytes(current, b1) == k;
+        }
+    } else {
+        const char *current = end1;
+        for (int64_t j = skip; j < perkey; j += skip) {
+            current = binarySearch(current, end2, b2, b2, j * gap);
+            if (current == end2)
+                break;
+            matches += Utils::decode_longFixedBytes(current, b2) == j * gap;
+        }
+    }
+    return matches;
+}
+
+//Position of the binary search in the table created by createTable: the
+//entry of the first term and the row in the second column
+struct Cursor {
+    const char *key;
+    const char *row;
+};
+
+//Moves the cursor to the first row that is not less than (c1, c2), as
+//moveto did before the galloping search. The cursor never goes back, and
+//key == end1 means that there are no more rows
+static void baselineMoveto(Cursor &c, const char *end1, const char *start2,
+        const int64_t c1, const int64_t c2) {
+    const uint8_t b1 = 4, b2 = 5, bc = 4, bs = 5;
+    const size_t stride = b1 + bc + bs;
+    if (c1 > Utils::decode_longFixedBytes(c.key, b1)) {
+        c.key = binarySearch(c.key, end1, stride, b1, c1);
+        if (c.key == end1) {
+            return;
+        }
+        c.row = start2 + Utils::decode_longFixedBytes(c.key + b1 + bc, bs) * b2;
+        if (Utils::decode_longFixedBytes(c.key, b1) != c1) {
+            return;
+        }
+    } else if (c1 < Utils::decode_longFixedBytes(c.key, b1)) {
+        return;
+    }
+    const char *blockEnd = start2 +
+        (Utils::decode_longFixedBytes(c.key + b1 + bc, bs) +
+         Utils::decode_longFixedBytes(c.key + b1, bc)) * b2;
+    c.row = binarySearch(c.row, blockEnd, b2, b2, c2);
+    if (c.row == blockEnd) {
+        c.key += stride;
+    }
+}
+
+//Moves the table and the binary search to random targets and checks that
+//they always land on the same row. The targets fall before the first key,
+//between the keys and past the end. If "sorted", the targets only grow, as
+//in a merge join. Otherwise, many of them are behind the current row, and
+//the table must stay where it is
+static bool checkRows(const int64_t nkeys, const int64_t perkey,
+        const int64_t gap, const int64_t keyGap, const int64_t first,
+        const bool sorted, const int seed) {
+    std::vector<char> buffer;
+    createTable(buffer, nkeys, perkey, gap, keyGap, first);
+    const uint8_t b1 = 4, b2 = 5, bc = 4, bs = 5;
+    int offset = 2;
+    Utils::decode_vlong2(buffer.data(), &offset);
+    Utils::decode_vlong2(buffer.data(), &offset);
+    const char *start1 = buffer.data() + offset;
+    const char *end1 = start1 + (b1 + bc + bs) * nkeys;
+    const char *end2 = buffer.data() + buffer.size();
+
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int64_t> key(0, first + (nkeys + 1) * keyGap);
+    std::uniform_int_distribution<int64_t> value(0, first + (perkey + 1) * gap);
+    std::uniform_int_distribution<int> steps(0, 2);
+    std::vector<std::pair<int64_t, int64_t>> targets;
+    for (int i = 0; i < 2000; ++i) {
+        targets.push_back(make_pair(key(gen), value(gen)));
+    }
+    if (sorted) {
+        std::sort(targets.begin(), targets.end());
+    }
+
+    NewColumnTable table;
+    table.setup(buffer.data(), buffer.data() + buffer.size());
+    table.hasNext();
+    table.next();
+    Cursor c = { start1, end1 };
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const int64_t c1 = targets[i].first;
+        const int64_t c2 = targets[i].second;
+        table.moveto(c1, c2);
+        baselineMoveto(c, end1, end1, c1, c2);
+        const bool expectedEnd = c.key == end1;
+        if (table.hasNext() == expectedEnd) {
+            cout << "ERROR: after moveto(" << c1 << "," << c2 << ") hasNext()"
+                " returns " << !expectedEnd << endl;
+            return false;
+        }
+        if (expectedEnd) {
+            break;
+        }
+        table.next();
+        const int64_t v1 = Utils::decode_longFixedBytes(c.key, b1);
+        const int64_t v2 = Utils::decode_longFixedBytes(c.row, b2);
+        if (table.getValue1() != v1 || table.getValue2() != v2) {
+            cout << "ERROR: moveto(" << c1 << "," << c2 << ") lands on (" <<
+                table.getValue1() << "," << table.getValue2() <<
+                "), the binary search on (" << v1 << "," << v2 << ")" << endl;
+            return false;
+        }
+        //Scan some rows, so that the next move does not always start
+        //right after the previous one
+        for (int s = steps(gen); s > 0 && c.row + b2 < end2; --s) {
+            c.row += b2;
+            if (c.row == end1 + (Utils::decode_longFixedBytes(c.key + b1 + bc, bs)
+                        + Utils::decode_longFixedBytes(c.key + b1, bc)) * b2) {
+                c.key += b1 + bc + bs;
+            }
+            table.hasNext();
+            table.next();
+        }
+    }
+    cout << "Rows of " << nkeys << "x" << perkey << (sorted ? " sorted" : "") <<
+        " OK" << endl;
+    return true;
+}
+
+//Runs the join with the galloping search and with the binary search
+bool compare(std::vector<char> &buffer, const int64_t nkeys,
+        const int64_t perkey, const int64_t gap, const int64_t skip,
+        const bool onFirstColumn) {
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    int64_t m = join(buffer, nkeys, perkey, gap, skip, onFirstColumn);
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    start = std::chrono::system_clock::now();
+    int64_t mBase = baselineJoin(buffer, nkeys, perkey, gap, skip, onFirstColumn);
+    std::chrono::duration<double> secBase = std::chrono::system_clock::now() - start;
+    cout << (onFirstColumn ? "First" : "Second") << " column: skip=" << skip <<
+        " matches=" << m << " galloping=" << sec.count() * 1000 <<
+        "ms binary=" << secBase.count() * 1000 << "ms speedup=" <<
+        secBase.count() / sec.count() << endl;
+    if (m != mBase) {
+        cout << "ERROR: the binary search found " << mBase << " matches" << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, const char** argv) {
+    //Many keys, few rows per key, one hub key and a single row
+    for (int seed = 0; seed < 10; ++seed) {
+        for (bool sorted : { true, false }) {
+            if (!checkRows(5000, 3, 2, 3, 10, sorted, seed) ||
+                    !checkRows(4, 5000, 2, 5, 7, sorted, seed) ||
+                    !checkRows(1, 20000, 3, 1, 5, sorted, seed) ||
+                    !checkRows(1, 1, 1, 1, 5, sorted, seed))
+                return 1;
+        }
+    }
+
+    const int64_t skips[] = { 1, 2, 4, 16, 64, 256, 4096 };
+
+    //Many first terms (e.g., PSO with many predicates)
+    std::vector<char> buffer;
+    int64_t nkeys = 4000000;
+    createTable(buffer, nkeys, 2, 1);
+    for (auto skip : skips) {
+        if (!compare(buffer, nkeys, 2, 1, skip, true))
+            return 1;
+    }
+
+    //One hub term with many second terms
+    int64_t perkey = 20000000;
+    createTable(buffer, 1, perkey, 3);
+    for (auto skip : skips) {
+        if (!compare(buffer, 1, perkey, 3, skip, false))
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <trident/kb/kb.h>
+#include <trident/kb/kbconfig.h>
+#include <trident/kb/querier.h>
+#include <trident/sparql/sparql.h>
+#include <trident/sparql/plancache.h>
+#include <layers/TridentLayer.hpp>
+#include <rts/operator/ResultsPrinter.hpp>
+
+using namespace std;
+
+//Collects the rows of a query
+class RowsWriter : public ResultsWriter {
+    public:
+        std::vector<std::string> rows;
+
+        bool begin(const std::vector<std::string>& vars) {
+            return true;
+        }
+
+        bool writeRow(const std::vector<std::string>& values) {
+            string row;
+            for (const auto &v : values) {
+                row += v + "\t";
+            }
+            rows.push_back(row);
+            return true;
+        }
+};
+
+//Executes the query and returns its rows, sorted because a plan taken from
+//the cache may produce them in a different order than a fresh plan
+bool run(KB &kb, TridentLayer &db, const string &query, PlanCache *cache,
+        std::vector<string> &rows, bool &cachedPlan) {
+    std::shared_ptr<SPARQLUtils::PreparedQuery> q =
+        SPARQLUtils::prepareQuery(query, kb.getNTerms(), db, cache);
+    if (!q->isParsed()) {
+        cout << "ERROR: the query " << query << " could not be parsed" << endl;
+        return false;
+    }
+    RowsWriter writer;
+    JSON stats;
+    SPARQLUtils::execPreparedQuery(*q.get(), db, false, true, NULL, NULL,
+            &stats, 1, &writer);
+    rows = writer.rows;
+    std::sort(rows.begin(), rows.end());
+    cachedPlan = q->isPlanCached();
+    if (cachedPlan != (stats.get("cachedplan") == "true")) {
+        cout << "ERROR: the statistics do not report the cached plan" << endl;
+        return false;
+    }
+    return true;
+}
+
+//Runs two queries with the same shape, first without the cache and then
+//with it. The results must be the same, and the plan of the second query
+//must come from the cache
+bool check(KB &kb, TridentLayer &db, const string &q1, const string &q2) {
+    std::vector<string> expected1, expected2, rows1, rows2;
+    bool cached;
+    if (!run(kb, db, q1, NULL, expected1, cached) ||
+            !run(kb, db, q2, NULL, expected2, cached)) {
+        return false;
+    }
+
+    PlanCache cache;
+    if (!run(kb, db, q1, &cache, rows1, cached)) {
+        return false;
+    }
+    if (cached) {
+        cout << "ERROR: the first query cannot use a cached plan" << endl;
+        return false;
+    }
+    if (!run(kb, db, q2, &cache, rows2, cached)) {
+        return false;
+    }
+    if (!cached) {
+        cout << "ERROR: the plan of " << q2 << " was not taken from the cache"
+            << endl;
+        return false;
+    }
+    if (rows1 != expected1 || rows2 != expected2) {
+        cout << "ERROR: the results with the cache are different (" <<
+            rows1.size() << "/" << expected1.size() << " and " <<
+            rows2.size() << "/" << expected2.size() << " rows)" << endl;
+        return false;
+    }
+    cout << q2 << ": " << rows2.size() << " rows OK" << endl;
+    return true;
+}
+
+int main(int argc, const char** argv) {
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <kb> [<query1> <query2>]" << endl;
+        return 1;
+    }
+    KBConfig config;
+    KB kb(argv[1], true, false, true, config);
+    TridentLayer db(kb);
+
+    if (argc > 3) {
+        return check(kb, db, argv[2], argv[3]) ? 0 : 1;
+    }
+
+    //Take the constants from the first two subjects of the KB
+    std::vector<string> subjects;
+    Querier *q = kb.query();
+    PairItr *itr = q->getTermList(IDX_SPO);
+    while (itr->hasNext() && subjects.size() < 2) {
+        itr->next();
+        string text;
+        if (kb.getDictMgmt()->getText(itr->getKey(), text)) {
+            subjects.push_back(text);
+        }
+    }
+    q->releaseItr(itr);
+    delete q;
+    if (subjects.size() < 2) {
+        cout << "ERROR: the KB must contain at least two subjects" << endl;
+        return 1;
+    }
+
+    //A scan and a join
+    const string shapes[] = {
+        "SELECT ?p ?o WHERE { # ?p ?o . }",
+        "SELECT ?p ?o ?p2 ?o2 WHERE { # ?p ?o . ?o ?p2 ?o2 . }"
+    };
+    for (const auto &shape : shapes) {
+        const size_t pos = shape.find('#');
+        string q1 = shape, q2 = shape;
+        q1.replace(pos, 1, subjects[0]);
+        q2.replace(pos, 1, subjects[1]);
+        if (!check(kb, db, q1, q2)) {
+            return 1;
+        }
+    }
+    return 0;
+}
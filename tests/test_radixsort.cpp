@@ -0,0 +1,69 @@
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <cstring>
+
+#include <kognac/logs.h>
+#include <trident/utils/parallel.h>
+#include <trident/utils/radixsort.h>
+
+using namespace std;
+
+static void writeTerm(unsigned char *buffer, const int64_t n) {
+    buffer[0] = (n >> 32) & 0xFF;
+    buffer[1] = (n >> 24) & 0xFF;
+    buffer[2] = (n >> 16) & 0xFF;
+    buffer[3] = (n >> 8) & 0xFF;
+    buffer[4] = n & 0xFF;
+}
+
+//Sorts triples of SIZE bytes. The records of 23 bytes are the triples with
+//their counts
+template<size_t SIZE>
+static bool test(const size_t n, const int nthreads) {
+    typedef std::array<unsigned char, SIZE> Triple;
+    std::mt19937_64 gen(0);
+    //Skewed distributions of the first term, like the predicates in POS
+    std::uniform_int_distribution<int64_t> small(0, 100);
+    std::uniform_int_distribution<int64_t> large(0, 1000000000);
+    std::vector<Triple> triples(n);
+    for (size_t i = 0; i < n; ++i) {
+        writeTerm(triples[i].data(), i % 3 == 0 ? 0 : small(gen));
+        writeTerm(triples[i].data() + 5, large(gen));
+        writeTerm(triples[i].data() + 10, i % 7 == 0 ? large(gen) : small(gen));
+        for (size_t j = 15; j < SIZE; ++j) {
+            triples[i][j] = j == SIZE - 1 ? small(gen) : 0;
+        }
+    }
+    std::vector<Triple> copy = triples;
+
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    RadixSorter<SIZE>::sort((char*) triples.data(), n, nthreads);
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Radix sort (" << SIZE << " bytes): " << sec.count() * 1000 << "ms";
+
+    start = std::chrono::system_clock::now();
+    ParallelTasks::sort_int(copy.begin(), copy.end(), nthreads);
+    sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Comparison sort (" << SIZE << " bytes): " << sec.count() * 1000 << "ms";
+
+    if (triples != copy) {
+        LOG(ERRORL) << "The two sorts of " << SIZE << " bytes returned different results";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, const char** argv) {
+    const size_t n = argc > 1 ? atol(argv[1]) : 50000000;
+    const int nthreads = argc > 2 ? atoi(argv[2]) : 8;
+    if (!test<15>(n, nthreads) || !test<23>(n, nthreads)) {
+        return 1;
+    }
+    LOG(INFOL) << "OK";
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <trident/server/resultswriter.h>
+#include <trident/utils/httpserver.h>
+#include <trident/utils/json.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const vector<string> vars = { "s", "o" };
+
+//Terms in N-Triples syntax. They contain the characters that must be
+//escaped in each format, a language tag, a datatype, a blank node, a
+//number and an unbound value
+static const vector<vector<string>> rows = {
+    { "<http://x/a>", "\"say \"hi\"\"@en" },
+    { "_:b1", "\"5\"^^<http://www.w3.org/2001/XMLSchema#integer>" },
+    { "<http://x/b,c>", "\"l1\nl2\ttab\"" },
+    { "", "42" },
+};
+
+static const string json =
+    "{\"head\":{\"vars\":[\"s\",\"o\"]},\"results\":{\"bindings\":["
+    "{\"s\":{\"type\":\"uri\",\"value\":\"http://x/a\"},"
+    "\"o\":{\"type\":\"literal\",\"value\":\"say \\\"hi\\\"\",\"xml:lang\":\"en\"}},"
+    "{\"s\":{\"type\":\"bnode\",\"value\":\"b1\"},"
+    "\"o\":{\"type\":\"literal\",\"value\":\"5\","
+    "\"datatype\":\"http://www.w3.org/2001/XMLSchema#integer\"}},"
+    "{\"s\":{\"type\":\"uri\",\"value\":\"http://x/b,c\"},"
+    "\"o\":{\"type\":\"literal\",\"value\":\"l1\\u000al2\\u0009tab\"}},"
+    "{\"o\":{\"type\":\"literal\",\"value\":\"42\"}}"
+    "]}";
+
+static const string tsv =
+    "?s\t?o\n"
+    "<http://x/a>\t\"say \"hi\"\"@en\n"
+    "_:b1\t\"5\"^^<http://www.w3.org/2001/XMLSchema#integer>\n"
+    "<http://x/b,c>\t\"l1\\nl2\\ttab\"\n"
+    "\t42\n";
+
+static const string csv =
+    "s,o\r\n"
+    "http://x/a,\"say \"\"hi\"\"\"\r\n"
+    "_:b1,5\r\n"
+    "\"http://x/b,c\",\"l1\nl2\ttab\"\r\n"
+    ",42\r\n";
+
+static string chunk(const string &data) {
+    char size[32];
+    snprintf(size, sizeof(size), "%zx\r\n", data.size());
+    return size + data + "\r\n";
+}
+
+//Writes the rows to one end of a socket pair and returns what arrives at
+//the other end
+static string write(SPARQLResultsWriter::Format format, bool chunked,
+        JSON *stats) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        cout << "ERROR: could not create the sockets" << endl;
+        return "";
+    }
+    {
+        HttpChunkedWriter out(fds[0], true, 1000, 64 * 1024, chunked);
+        SPARQLResultsWriter writer(out, format);
+        writer.begin(vars);
+        for (const auto &row : rows) {
+            writer.writeRow(row);
+        }
+        writer.end(stats);
+    }
+    close(fds[0]);
+    string data;
+    char tmp[4096];
+    ssize_t len;
+    while ((len = read(fds[1], tmp, sizeof(tmp))) > 0) {
+        data.append(tmp, len);
+    }
+    close(fds[1]);
+    return data;
+}
+
+//The header of the results is sent in its own chunk, as soon as the
+//query starts. The rows follow in the next chunk
+static bool check(const string &name, SPARQLResultsWriter::Format format,
+        const string &body, size_t headerSize, JSON *stats) {
+    const string headers = "HTTP/1.1 200 OK\r\nContent-Type: " +
+        SPARQLResultsWriter::getContentType(format) + "\r\n";
+    const string expected = headers + "Transfer-Encoding: chunked\r\n\r\n" +
+        chunk(body.substr(0, headerSize)) + chunk(body.substr(headerSize)) +
+        "0\r\n\r\n";
+    string output = write(format, true, stats);
+    if (output != expected) {
+        cout << "ERROR: the " << name << " output is" << endl << output <<
+            endl << "instead of" << endl << expected << endl;
+        return false;
+    }
+    //Without chunks (HTTP/1.0) the body is sent as it is
+    const string expectedPlain = headers + "Connection: close\r\n\r\n" + body;
+    output = write(format, false, stats);
+    if (output != expectedPlain) {
+        cout << "ERROR: the unchunked " << name << " output is" << endl <<
+            output << endl << "instead of" << endl << expectedPlain << endl;
+        return false;
+    }
+    cout << name << " OK" << endl;
+    return true;
+}
+
+int main(int argc, const char** argv) {
+    JSON stats;
+    stats.put("rows", "4");
+    std::ostringstream buf;
+    JSON::write(buf, stats);
+    const string jsonHeader = "{\"head\":{\"vars\":[\"s\",\"o\"]},"
+        "\"results\":{\"bindings\":[";
+    bool ok = check("JSON", SPARQLResultsWriter::JSONFORMAT, json + "}",
+            jsonHeader.size(), NULL) &&
+        check("JSON with statistics", SPARQLResultsWriter::JSONFORMAT,
+                json + ",\"stats\":" + buf.str() + "}", jsonHeader.size(),
+                &stats) &&
+        check("TSV", SPARQLResultsWriter::TSVFORMAT, tsv, 6, NULL) &&
+        check("CSV", SPARQLResultsWriter::CSVFORMAT, csv, 5, NULL);
+    return ok ? 0 : 1;
+}
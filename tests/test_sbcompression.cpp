@@ -0,0 +1,129 @@
+#include <trident/tree/stringbuffer.h>
+#include <trident/kb/statistics.h>
+
+#include <kognac/utils.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+
+using namespace std;
+
+//Strings with long common prefixes, like the sorted terms of a dictionary
+static void generate(size_t n, vector<string> &strings) {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(1, 40);
+    for (size_t i = 0; i < n; ++i) {
+        string s = "<http://example.org/resource/" + to_string(i / 100) + "/";
+        const int len = length(gen);
+        for (int j = 0; j < len; ++j) {
+            s += (char) letter(gen);
+        }
+        strings.push_back(s + ">");
+    }
+}
+
+static bool equals(const char *s, int size, const string &expected) {
+    return size == (int) expected.size() &&
+        memcmp(s, expected.c_str(), size) == 0;
+}
+
+static string readFile(const string &file) {
+    std::ifstream in(file, std::ios::binary);
+    std::stringstream buf;
+    buf << in.rdbuf();
+    return buf.str();
+}
+
+//Fills the buffer with the given number of threads and cache. While the
+//blocks are compressed, it reads strings in old blocks, so that blocks
+//are evicted from the cache while others are waiting to be written
+static bool run(const string &dir, const vector<string> &strings,
+        int threads, int cacheBlocks, string &file, string &index) {
+    if (Utils::exists(dir)) {
+        Utils::remove_all(dir);
+    }
+    std::mt19937 gen(threads * 100 + cacheBlocks);
+    vector<int64_t> positions;
+    Stats stats;
+    StringBuffer *b = new StringBuffer(dir, false, 16,
+            (int64_t) cacheBlocks * SB_BLOCK_SIZE, &stats, threads);
+    for (size_t i = 0; i < strings.size(); ++i) {
+        positions.push_back(b->getSize());
+        b->append((char*) strings[i].c_str(), strings[i].size());
+        if (i % 500 == 0) {
+            std::uniform_int_distribution<size_t> prev(0, i);
+            for (int j = 0; j < 10; ++j) {
+                const size_t idx = prev(gen);
+                int size;
+                char *s = b->get(positions[idx], size);
+                if (!equals(s, size, strings[idx])) {
+                    cout << "ERROR: threads=" << threads << " cache=" <<
+                        cacheBlocks << ": string " << idx <<
+                        " is wrong while writing" << endl;
+                    delete b;
+                    return false;
+                }
+            }
+        }
+    }
+    delete b;
+
+    //The blocks must be in the file in the order they were filled, so the
+    //file does not depend on the number of threads
+    file = readFile(dir + "/sb");
+    index = readFile(dir + "/sb.idx");
+
+    b = new StringBuffer(dir, true, 16, (int64_t) cacheBlocks * SB_BLOCK_SIZE,
+            &stats);
+    std::uniform_int_distribution<size_t> any(0, strings.size() - 1);
+    for (size_t i = 0; i < strings.size(); ++i) {
+        const size_t idx = i % 2 == 0 ? i : any(gen);
+        int size;
+        char *s = b->get(positions[idx], size);
+        if (!equals(s, size, strings[idx])) {
+            cout << "ERROR: threads=" << threads << " cache=" << cacheBlocks <<
+                ": string " << idx << " is wrong after reopening" << endl;
+            delete b;
+            return false;
+        }
+    }
+    delete b;
+    Utils::remove_all(dir);
+    return true;
+}
+
+int main(int argc, const char** argv) {
+    const string dir = argc > 1 ? argv[1] : "/tmp/test_sbcompression";
+    const size_t n = argc > 2 ? atol(argv[2]) : 100000;
+    vector<string> strings;
+    generate(n, strings);
+
+    string expectedFile, expectedIndex;
+    bool first = true;
+    for (int threads : { 1, 2, 3, 8 }) {
+        for (int cacheBlocks : { 5, 6, 16, 64 }) {
+            string file, index;
+            if (!run(dir, strings, threads, cacheBlocks, file, index)) {
+                return 1;
+            }
+            if (first) {
+                expectedFile = file;
+                expectedIndex = index;
+                first = false;
+            } else if (file != expectedFile || index != expectedIndex) {
+                cout << "ERROR: threads=" << threads << " cache=" <<
+                    cacheBlocks << ": the file differs from the one written "
+                    "with one thread" << endl;
+                return 1;
+            }
+            cout << "threads=" << threads << " cache=" << cacheBlocks <<
+                " OK" << endl;
+        }
+    }
+    return 0;
+}
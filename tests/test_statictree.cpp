@@ -0,0 +1,155 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include <kognac/utils.h>
+#include <trident/tree/staticroot.h>
+#include <trident/tree/coordinates.h>
+#include <trident/tree/treeitr.h>
+
+using namespace std;
+
+struct Entry {
+    int64_t key;
+    int perms; //Bitmask of the permutations that exist
+    int64_t nElements[6];
+    short file[6];
+    int64_t mark[6];
+    char strategy[6];
+};
+
+//Iterates over the entries of a FakeRoot
+class VectorItr : public TreeItr {
+    private:
+        std::vector<Entry> &entries;
+        size_t pos;
+    public:
+        VectorItr(std::vector<Entry> &entries) : entries(entries), pos(0) {
+        }
+
+        bool hasNext() {
+            return pos < entries.size();
+        }
+
+        int64_t next(TermCoordinates *value) {
+            const Entry &e = entries[pos++];
+            value->clear();
+            for (int p = 0; p < 6; ++p) {
+                if (e.perms & (1 << p)) {
+                    value->set(p, e.file[p], e.mark[p], e.nElements[p],
+                            e.strategy[p]);
+                }
+            }
+            return e.key;
+        }
+};
+
+//The static tree is built from an iterator over the tree, so it is enough
+//to emulate one
+class FakeRoot : public Root {
+    public:
+        std::vector<Entry> entries;
+
+        TreeItr *itr() {
+            return new VectorItr(entries);
+        }
+};
+
+void createEntries(std::vector<Entry> &entries, const int n) {
+    int64_t key = rand() % 5;
+    for (int i = 0; i < n; ++i) {
+        //Mix dense and sparse ranges of keys
+        key += 1 + rand() % (i % 3 == 0 ? 1 : 1000);
+        Entry e;
+        e.key = key;
+        e.perms = 1 + rand() % 63;
+        for (int p = 0; p < 6; ++p) {
+            e.nElements[p] = ((int64_t) rand() * rand()) & 0xFFFFFFFFFF;
+            e.file[p] = rand() % 30000;
+            e.mark[p] = ((int64_t) rand() * rand()) & 0xFFFFFFFFFF;
+            e.strategy[p] = rand();
+        }
+        entries.push_back(e);
+    }
+}
+
+bool check(const int n, const string &path) {
+    FakeRoot root;
+    createEntries(root.entries, n);
+    StaticRoot::build(&root, path);
+    StaticRoot tree(path);
+    std::vector<Entry> &entries = root.entries;
+
+    //All the keys must be found with the same coordinates
+    TermCoordinates value;
+    for (auto &e : entries) {
+        if (!tree.get(e.key, &value)) {
+            cout << "ERROR n=" << n << ": key " << e.key << " not found" << endl;
+            return false;
+        }
+        for (int p = 0; p < 6; ++p) {
+            const bool exists = e.perms & (1 << p);
+            if (value.exists(p) != exists || (exists &&
+                        (value.getNElements(p) != e.nElements[p] ||
+                         value.getFileIdx(p) != e.file[p] ||
+                         value.getMark(p) != e.mark[p] ||
+                         value.getStrategy(p) != e.strategy[p]))) {
+                cout << "ERROR n=" << n << ": wrong coordinates for key " <<
+                    e.key << " in permutation " << p << endl;
+                return false;
+            }
+        }
+    }
+
+    //Random keys, most of them missing
+    const int64_t maxKey = entries.empty() ? 0 : entries.back().key;
+    for (int i = 0; i < 20000; ++i) {
+        Entry e;
+        e.key = rand() % (maxKey + 10) - 2;
+        const bool exists = std::binary_search(entries.begin(), entries.end(),
+                e, [](const Entry &a, const Entry &b) { return a.key < b.key; });
+        if (tree.get(e.key, &value) != exists) {
+            cout << "ERROR n=" << n << ": lookup of key " << e.key <<
+                " should return " << exists << endl;
+            return false;
+        }
+    }
+
+    //The iterator must return all the keys in order
+    TreeItr *itr = tree.itr();
+    size_t i = 0;
+    while (itr->hasNext()) {
+        const int64_t key = itr->next(&value);
+        if (i >= entries.size() || key != entries[i].key) {
+            cout << "ERROR n=" << n << ": wrong key " << key <<
+                " at position " << i << endl;
+            delete itr;
+            return false;
+        }
+        i++;
+    }
+    delete itr;
+    if (i != entries.size()) {
+        cout << "ERROR n=" << n << ": the iterator returned " << i <<
+            " keys" << endl;
+        return false;
+    }
+    cout << "n=" << n << " OK" << endl;
+    return true;
+}
+
+int main(int argc, const char** argv) {
+    string path = argc > 1 ? argv[1] : "statictree.tmp";
+    srand(3);
+    //Sizes around the boundaries of the nodes (8 keys) and of the layers
+    const int sizes[] = { 0, 1, 7, 8, 9, 72, 73, 80, 81, 82, 700, 5000, 100000 };
+    for (auto n : sizes) {
+        if (!check(n, path)) {
+            Utils::remove(path);
+            return 1;
+        }
+    }
+    Utils::remove(path);
+    return 0;
+}
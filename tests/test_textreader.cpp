@@ -0,0 +1,120 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+
+#include <kognac/logs.h>
+#include <trident/utils/textreader.h>
+
+#include <zlib.h>
+#include <lz4.h>
+
+using namespace std;
+
+static void writeLE(std::string &out, uint64_t n, int nbytes) {
+    for (int i = 0; i < nbytes; ++i) {
+        out.push_back((char) ((n >> (8 * i)) & 0xFF));
+    }
+}
+
+//A BGZF file is a sequence of gzip members that store their size
+static std::string toBGZF(const std::string &text) {
+    std::string out;
+    const size_t blockSize = 65280;
+    std::vector<char> buffer(compressBound(blockSize) + 64);
+    for (size_t i = 0; i <= text.size(); i += blockSize) {
+        const size_t len = std::min(blockSize, text.size() - i);
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        deflateInit2(&zs, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+        zs.next_in = (Bytef*) text.data() + i;
+        zs.avail_in = len;
+        zs.next_out = (Bytef*) buffer.data();
+        zs.avail_out = buffer.size();
+        deflate(&zs, Z_FINISH);
+        const size_t csize = buffer.size() - zs.avail_out;
+        deflateEnd(&zs);
+        const char header[] = { 31, (char)139, 8, 4, 0, 0, 0, 0, 0, (char)255,
+            6, 0, 'B', 'C', 2, 0 };
+        out.append(header, sizeof(header));
+        writeLE(out, csize + 25, 2);
+        out.append(buffer.data(), csize);
+        writeLE(out, crc32(0, (Bytef*) text.data() + i, len), 4);
+        writeLE(out, len, 4);
+    }
+    return out;
+}
+
+//LZ4 frame with independent blocks of 64KB
+static std::string toLZ4(const std::string &text) {
+    std::string out;
+    writeLE(out, 0x184D2204, 4);
+    out.push_back((char) 0x60);
+    out.push_back((char) 0x40);
+    out.push_back(0); //Header checksum (not verified)
+    const size_t blockSize = 65536;
+    std::vector<char> buffer(LZ4_compressBound(blockSize));
+    for (size_t i = 0; i < text.size(); i += blockSize) {
+        const size_t len = std::min(blockSize, text.size() - i);
+        const int csize = LZ4_compress_default(text.data() + i, buffer.data(),
+                len, buffer.size());
+        writeLE(out, csize, 4);
+        out.append(buffer.data(), csize);
+    }
+    writeLE(out, 0, 4);
+    return out;
+}
+
+static bool check(std::string file, int nthreads, int64_t nlines) {
+    ParallelTextReader reader(file);
+    std::atomic<int64_t> lines(0), sum(0);
+    reader.read(nthreads, [&](const char *start, const char *end, int thread) {
+        const char *line = start;
+        while (line < end) {
+            const char *eol = (const char*) memchr(line, '\n', end - line);
+            if (eol == NULL) {
+                eol = end;
+            }
+            lines++;
+            sum += atol(std::string(line, eol).c_str());
+            line = eol + 1;
+        }
+    });
+    const int64_t expectedSum = nlines * (nlines - 1) / 2;
+    cout << file << " format=" << reader.getFormat() << " lines=" << lines <<
+        " sum=" << sum << endl;
+    return lines == nlines && sum == expectedSum;
+}
+
+int main(int argc, const char** argv) {
+    const int64_t nlines = 5000000;
+    std::string text;
+    for (int64_t i = 0; i < nlines; ++i) {
+        text += to_string(i) + " " + std::string(i % 40, 'x') + "\n";
+    }
+    text.pop_back(); //The last line has no newline
+
+    std::ofstream("textreader.txt", ios_base::binary) << text;
+    gzFile gz = gzopen("textreader.txt.gz", "wb");
+    gzwrite(gz, text.data(), text.size());
+    gzclose(gz);
+    std::ofstream("textreader.txt.bgz", ios_base::binary) << toBGZF(text);
+    std::ofstream("textreader.txt.lz4", ios_base::binary) << toLZ4(text);
+
+    const char *files[] = { "textreader.txt", "textreader.txt.gz",
+        "textreader.txt.bgz", "textreader.txt.lz4" };
+    bool ok = true;
+    for (const char *file : files) {
+        for (int nthreads : { 1, 4 }) {
+            if (!check(file, nthreads, nlines)) {
+                LOG(ERRORL) << "Wrong content read from " << file;
+                ok = false;
+            }
+        }
+        remove(file);
+    }
+    return ok ? 0 : 1;
+}
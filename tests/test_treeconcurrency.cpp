@@ -0,0 +1,120 @@
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+
+#include <kognac/logs.h>
+#include <kognac/utils.h>
+#include <trident/tree/root.h>
+#include <trident/tree/coordinates.h>
+#include <trident/utils/propertymap.h>
+
+using namespace std;
+
+//Stress test for the lock-free lookups on a read-only tree. The cache is
+//much smaller than the tree, so that the threads continuously load and
+//evict leaves while the others are reading them.
+
+static PropertyMap getConfig(int maxNodesInCache) {
+    PropertyMap config;
+    config.setBool(TEXT_KEYS, false);
+    config.setBool(TEXT_VALUES, false);
+    config.setBool(COMPRESSED_NODES, false);
+    config.setInt(MAX_EL_PER_NODE, 256);
+    config.setInt(FILE_MAX_SIZE, 64 * 1024 * 1024);
+    config.setLong(CACHE_MAX_SIZE, 64 * 1024 * 1024);
+    config.setInt(NODE_MIN_BYTES, 1);
+    config.setInt(MAX_NODES_IN_CACHE, maxNodesInCache);
+    config.setInt(LEAF_SIZE_FACTORY, 1000);
+    config.setInt(LEAF_SIZE_PREALL_FACTORY, 100);
+    config.setInt(LEAF_ARRAYS_FACTORY_SIZE, 1000);
+    config.setInt(LEAF_ARRAYS_PREALL_FACTORY_SIZE, 100);
+    config.setInt(LEAF_MAX_INTERNAL_LINES, 100000);
+    config.setInt(LEAF_MAX_PREALL_INTERNAL_LINES, 100000);
+    config.setInt(NODE_KEYS_FACTORY_SIZE, 1000);
+    config.setInt(NODE_KEYS_PREALL_FACTORY_SIZE, 100);
+    config.setInt(MAX_N_OPENED_FILES, 1024);
+    return config;
+}
+
+static void fill(int64_t key, TermCoordinates *value) {
+    value->clear();
+    value->set(0, key % 100, key * 7, key + 1, key % 64);
+    if (key % 3 == 0) {
+        value->set(4, key % 50, key * 3, key * 2 + 1, 1);
+    }
+}
+
+int main(int argc, const char** argv) {
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <dir> [nthreads] [nkeys]" << endl;
+        return 1;
+    }
+    string dir = string(argv[1]);
+    const int nthreads = argc > 2 ? atoi(argv[2]) : 8;
+    const int64_t nkeys = argc > 3 ? atol(argv[3]) : 1000000;
+    const int64_t lookupsPerThread = 2000000;
+
+    if (Utils::exists(dir)) {
+        Utils::remove_all(dir);
+    }
+    Utils::create_directories(dir);
+
+    //Create the tree. Every other key is missing.
+    PropertyMap writeConfig = getConfig(1000);
+    Root *root = new Root(dir, NULL, false, writeConfig);
+    TermCoordinates value;
+    for (int64_t i = 0; i < nkeys; ++i) {
+        fill(i * 2, &value);
+        root->append(i * 2, &value);
+    }
+    delete root;
+
+    //Reopen it read-only with a tiny cache
+    PropertyMap readConfig = getConfig(8);
+    root = new Root(dir, NULL, true, readConfig);
+    std::atomic<int64_t> errors(0);
+    std::vector<std::thread> threads;
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    for (int t = 0; t < nthreads; ++t) {
+        threads.push_back(std::thread([&, t]() {
+            std::mt19937_64 gen(t);
+            std::uniform_int_distribution<int64_t> dist(0, nkeys * 2 - 1);
+            TermCoordinates found, expected;
+            for (int64_t i = 0; i < lookupsPerThread; ++i) {
+                const int64_t key = dist(gen);
+                const bool ok = root->get(key, &found);
+                if (ok != (key % 2 == 0)) {
+                    errors++;
+                    continue;
+                }
+                if (ok) {
+                    fill(key, &expected);
+                    for (int perm = 0; perm < 6; ++perm) {
+                        if (found.exists(perm) != expected.exists(perm) ||
+                                (expected.exists(perm) &&
+                                 (found.getFileIdx(perm) != expected.getFileIdx(perm) ||
+                                  found.getMark(perm) != expected.getMark(perm) ||
+                                  found.getNElements(perm) != expected.getNElements(perm) ||
+                                  found.getStrategy(perm) != expected.getStrategy(perm)))) {
+                            errors++;
+                            break;
+                        }
+                    }
+                }
+            }
+        }));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Lookups: " << nthreads * lookupsPerThread << " in " <<
+        sec.count() * 1000 << "ms errors: " << errors.load();
+    delete root;
+    Utils::remove_all(dir);
+    return errors.load() == 0 ? 0 : 1;
+}